@@ -6,9 +6,22 @@ extern "C" {
 #endif
 
 #include "m64p_types.h"
+#include "m64p_debugger.h"
 
 typedef m64p_error (*core_do_command_func)(m64p_command, int, void*);
 
+// Core sampling profiler entry points; any of them may be NULL with older cores.
+typedef struct {
+    ptr_DebugProfileStart start;
+    ptr_DebugProfileStop stop;
+    ptr_DebugProfileReset reset;
+    ptr_DebugProfileGetHotFunctions get_hot_functions;
+    ptr_DebugProfileGetOpcodeCounts get_opcode_counts;
+    ptr_DebugProfileGetOpcodeName get_opcode_name;
+} analysis_profiler_funcs;
+
+// Must be called before analysis_window_start; the profiler runs while the window is open.
+void analysis_window_set_profiler(const analysis_profiler_funcs* funcs);
 void analysis_window_start(core_do_command_func core_cmd);
 void analysis_window_stop(void);
 
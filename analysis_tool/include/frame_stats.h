@@ -0,0 +1,36 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include "m64p_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Rolling window of per-VI timing records fetched from the core with
+// M64CMD_GET_FRAME_TIMINGS, with percentile queries over total frame time.
+class FrameStats
+{
+public:
+    explicit FrameStats(size_t capacity);
+
+    void push(const m64p_frame_timing& t);
+    void clear();
+
+    size_t size() const { return count; }
+    size_t capacity() const { return records.size(); }
+
+    // i = 0 is the oldest record in the window
+    const m64p_frame_timing& at(size_t i) const;
+
+    // p in [0, 100], nearest-rank on total_ns; 0 when empty
+    uint32_t percentile(double p) const;
+    uint32_t max() const;
+
+private:
+    std::vector<m64p_frame_timing> records;
+    mutable std::vector<uint32_t> scratch;
+    size_t head = 0;
+    size_t count = 0;
+};
+
+#endif // FRAME_STATS_H
@@ -1,20 +1,503 @@
 #include "analysis_window.h"
+#include "frame_stats.h"
 #include <SDL.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <thread>
+#include <utility>
+#include <vector>
 #include <stdio.h>
 
 static std::atomic<bool> running{false};
 static std::thread windowThread;
 static core_do_command_func coreCmd = nullptr;
 
+// Telemetry drained from the core's lock-free event ring. Only touched by
+// the window thread, which is the ring's single consumer.
+static constexpr size_t kDrainBatch = 256;
+static constexpr size_t kViHistory = 300;
+
+static std::array<m64p_telemetry_event, kDrainBatch> drainBuffer;
+static std::array<float, kViHistory> viIntervalsMs{};
+static size_t viHead = 0;
+static uint64_t lastViTimestamp = 0;
+static uint64_t droppedEvents = 0;
+
+// Per-VI timing breakdown fetched from the core's history.
+static constexpr size_t kTimingBatch = 256;
+static constexpr size_t kTimingWindow = 4096;
+
+static std::array<m64p_frame_timing, kTimingBatch> timingBuffer;
+static FrameStats frameStats(kTimingWindow);
+static unsigned int nextTiming = 0;
+
+// Decayed per-page RDRAM activity, refreshed every redraw.
+static m64p_rdram_heatmap heatmap;
+static bool heatmapValid = false;
+
+// Guest profile aggregated by the core's sampling profiler. The window thread
+// is the profiler's only consumer.
+static constexpr size_t kHotFunctions = 16;
+static constexpr size_t kHotOpcodes = 12;
+
+static analysis_profiler_funcs profiler{};
+static std::array<m64p_profile_function, kHotFunctions> hotFunctions;
+static unsigned int hotCount = 0;
+static unsigned int profileSamples = 0;
+static std::vector<unsigned int> opcodeCounts;
+static std::vector<std::pair<unsigned int, int>> hotOpcodes; // (samples, opcode), hottest first
+
+// Core rewind history, scrubbed by clicking its track or with the left arrow.
+static constexpr int kScrubX = 330;
+static constexpr int kScrubY = 300;
+static constexpr int kScrubWidth = 300;
+static constexpr int kScrubHeight = 12;
+
+static m64p_rewind rewindInfo{};
+static bool rewindValid = false;
+
+// Cached interpreter code cache; the recompile rate is averaged over a second.
+static m64p_code_cache_stats codeCache{};
+static bool codeCacheValid = false;
+static uint32_t rateRecompiles = 0;
+static Uint32 rateTicks = 0;
+static float recompilesPerSecond = 0.0f;
+
+// 3x5 glyphs, one row per byte with the leftmost pixel in bit 2
+static const Uint8* glyph(char c)
+{
+    static const Uint8 digits[10][5] = {
+        {7,5,5,5,7}, {2,6,2,2,7}, {7,1,7,4,7}, {7,1,7,1,7}, {5,5,7,1,1},
+        {7,4,7,1,7}, {7,4,7,5,7}, {7,1,1,1,1}, {7,5,7,5,7}, {7,5,7,1,7},
+    };
+    static const Uint8 letters[26][5] = {
+        {2,5,7,5,5}, {6,5,6,5,6}, {3,4,4,4,3}, {6,5,5,5,6}, {7,4,6,4,7}, {7,4,6,4,4},
+        {3,4,5,5,3}, {5,5,7,5,5}, {7,2,2,2,7}, {1,1,1,5,2}, {5,5,6,5,5}, {4,4,4,4,7},
+        {5,7,7,5,5}, {6,5,5,5,5}, {2,5,5,5,2}, {6,5,6,4,4}, {2,5,5,6,3}, {6,5,6,5,5},
+        {3,4,2,1,6}, {7,2,2,2,2}, {5,5,5,5,7}, {5,5,5,5,2}, {5,5,7,7,5}, {5,5,2,5,5},
+        {5,5,2,2,2}, {7,1,2,4,7},
+    };
+    static const Uint8 underscore[5] = {0,0,0,0,7};
+    static const Uint8 dot[5] = {0,0,0,0,2};
+    static const Uint8 blank[5] = {0,0,0,0,0};
+
+    if (c >= '0' && c <= '9')
+        return digits[c - '0'];
+    if (c >= 'A' && c <= 'Z')
+        return letters[c - 'A'];
+    if (c >= 'a' && c <= 'z')
+        return letters[c - 'a'];
+    if (c == '_')
+        return underscore;
+    if (c == '.')
+        return dot;
+    return blank;
+}
+
+static void draw_text(SDL_Surface* surf, int x, int y, const char* text, Uint32 color)
+{
+    for (; *text != '\0'; ++text, x += 4)
+    {
+        const Uint8* rows = glyph(*text);
+        for (int r = 0; r < 5; ++r)
+            for (int b = 0; b < 3; ++b)
+                if (rows[r] & (4 >> b))
+                {
+                    SDL_Rect px = {x + b, y + r, 1, 1};
+                    SDL_FillRect(surf, &px, color);
+                }
+    }
+}
+
+static void handle_event(const m64p_telemetry_event& ev)
+{
+    if (ev.type == M64TELEM_VI)
+    {
+        if (lastViTimestamp != 0)
+        {
+            viIntervalsMs[viHead] = (ev.timestamp_ns - lastViTimestamp) / 1e6f;
+            viHead = (viHead + 1) % kViHistory;
+        }
+        lastViTimestamp = ev.timestamp_ns;
+    }
+}
+
+static void drain_telemetry()
+{
+    if (!coreCmd)
+        return;
+
+    m64p_telemetry_drain drain{};
+    do
+    {
+        drain.events = drainBuffer.data();
+        drain.capacity = (unsigned int)drainBuffer.size();
+        if (coreCmd(M64CMD_TELEMETRY_DRAIN, sizeof(drain), &drain) != M64ERR_SUCCESS)
+            return;
+        droppedEvents += drain.dropped;
+        for (unsigned int i = 0; i < drain.count; ++i)
+            handle_event(drainBuffer[i]);
+    } while (drain.count == drain.capacity && running.load());
+}
+
+static void fetch_frame_timings()
+{
+    if (!coreCmd)
+        return;
+
+    m64p_frame_timing_query query{};
+    do
+    {
+        query.timings = timingBuffer.data();
+        query.capacity = (unsigned int)timingBuffer.size();
+        query.first = nextTiming;
+        if (coreCmd(M64CMD_GET_FRAME_TIMINGS, sizeof(query), &query) != M64ERR_SUCCESS)
+            return;
+        for (unsigned int i = 0; i < query.count; ++i)
+            frameStats.push(timingBuffer[i]);
+        nextTiming = query.first + query.count;
+    } while (query.count == query.capacity && running.load());
+}
+
+static void fetch_rdram_heatmap()
+{
+    if (!coreCmd)
+        return;
+
+    heatmapValid = coreCmd(M64CMD_GET_RDRAM_HEATMAP, sizeof(heatmap), &heatmap) == M64ERR_SUCCESS;
+}
+
+static void fetch_rewind()
+{
+    if (!coreCmd)
+        return;
+
+    m64p_rewind query{};
+    rewindValid = coreCmd(M64CMD_REWIND, sizeof(query), &query) == M64ERR_SUCCESS
+        && query.capacity_bytes != 0;
+    if (rewindValid)
+        rewindInfo = query;
+}
+
+static void fetch_code_cache()
+{
+    if (!coreCmd)
+        return;
+
+    m64p_code_cache_stats stats{};
+    codeCacheValid = coreCmd(M64CMD_GET_CODE_CACHE_STATS, sizeof(stats), &stats) == M64ERR_SUCCESS;
+    if (!codeCacheValid)
+        return;
+
+    Uint32 now = SDL_GetTicks();
+    if (rateTicks == 0 || stats.recompiles < codeCache.recompiles)
+    {
+        // first sample, or the counter restarted with a new emulation
+        rateTicks = now;
+        rateRecompiles = stats.recompiles;
+        recompilesPerSecond = 0.0f;
+    }
+    else if (now - rateTicks >= 1000)
+    {
+        recompilesPerSecond = (float)(stats.recompiles - rateRecompiles) * 1000.0f / (float)(now - rateTicks);
+        rateTicks = now;
+        rateRecompiles = stats.recompiles;
+    }
+    codeCache = stats;
+}
+
+static void request_rewind(uint32_t frames)
+{
+    if (!coreCmd || !rewindValid)
+        return;
+
+    m64p_rewind request{};
+    request.frames = std::min(frames, rewindInfo.depth);
+    if (request.frames != 0)
+        coreCmd(M64CMD_REWIND, sizeof(request), &request);
+}
+
+static void scrub_to(int x)
+{
+    // the track spans the whole history, newest frame on the right
+    if (!rewindValid || rewindInfo.depth == 0)
+        return;
+
+    int fromRight = kScrubX + kScrubWidth - std::clamp(x, kScrubX, kScrubX + kScrubWidth);
+    request_rewind((uint32_t)(((uint64_t)fromRight * rewindInfo.depth + kScrubWidth - 1) / kScrubWidth));
+}
+
+static void fetch_profile()
+{
+    if (!profiler.get_hot_functions)
+        return;
+
+    m64p_profile_query query{};
+    query.functions = hotFunctions.data();
+    query.capacity = (unsigned int)hotFunctions.size();
+    if (profiler.get_hot_functions(&query) != M64ERR_SUCCESS)
+        return;
+    hotCount = query.count;
+    profileSamples = query.samples;
+
+    if (!profiler.get_opcode_counts)
+        return;
+
+    if (opcodeCounts.empty())
+    {
+        int n = profiler.get_opcode_counts(nullptr, 0);
+        if (n <= 0)
+            return;
+        opcodeCounts.resize(n);
+    }
+    profiler.get_opcode_counts(opcodeCounts.data(), (int)opcodeCounts.size());
+
+    hotOpcodes.clear();
+    for (size_t i = 0; i < opcodeCounts.size(); ++i)
+        if (opcodeCounts[i] != 0)
+            hotOpcodes.emplace_back(opcodeCounts[i], (int)i);
+    size_t top = std::min(hotOpcodes.size(), kHotOpcodes);
+    std::partial_sort(hotOpcodes.begin(), hotOpcodes.begin() + top, hotOpcodes.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+    hotOpcodes.resize(top);
+}
+
+static Uint8 heat_level(uint32_t heat)
+{
+    // log scale so that a handful of accesses is still visible next to hot pages
+    return (Uint8)std::min(255.0f, 12.0f * std::log2(1.0f + heat));
+}
+
+static void draw_rdram_heatmap(SDL_Surface* surf)
+{
+    // 64 x 32 pages of 4 KB, 4 px each; red = writes, green = reads, blue = DMA writes
+    const int originX = 32;
+    const int originY = 360;
+    const int columns = 64;
+    const int cell = 4;
+
+    if (!heatmapValid)
+        return;
+
+    for (int page = 0; page < M64P_RDRAM_HEATMAP_PAGES; ++page)
+    {
+        Uint8 r = heat_level(heatmap.writes[page]);
+        Uint8 g = heat_level(heatmap.reads[page]);
+        Uint8 b = heat_level(heatmap.dma_writes[page]);
+        if ((r | g | b) == 0)
+            continue;
+        SDL_Rect c = {originX + (page % columns) * cell, originY + (page / columns) * cell, cell, cell};
+        SDL_FillRect(surf, &c, SDL_MapRGB(surf->format, r, g, b));
+    }
+}
+
+static void draw_profile(SDL_Surface* surf)
+{
+    // hottest guest functions then hottest opcodes, bar length is the share of all samples
+    const int originX = 330;
+    const int barX = 380;
+    const int barWidth = 250;
+    const int rowHeight = 8;
+
+    Uint32 text = SDL_MapRGB(surf->format, 220, 220, 220);
+    Uint32 functionBar = SDL_MapRGB(surf->format, 230, 130, 30);
+    Uint32 opcodeBar = SDL_MapRGB(surf->format, 60, 110, 220);
+
+    if (profileSamples == 0)
+        return;
+
+    int y = 20;
+    draw_text(surf, originX, y, "FUNCTIONS", text);
+    for (unsigned int i = 0; i < hotCount; ++i)
+    {
+        y += rowHeight;
+        char addr[9];
+        snprintf(addr, sizeof(addr), "%08X", (unsigned int)hotFunctions[i].address);
+        draw_text(surf, originX, y, addr, text);
+        SDL_Rect bar = {barX, y, std::max(1, (int)((uint64_t)barWidth * hotFunctions[i].samples / profileSamples)), 5};
+        SDL_FillRect(surf, &bar, functionBar);
+    }
+
+    y = 20 + (int)(kHotFunctions + 2) * rowHeight;
+    draw_text(surf, originX, y, "OPCODES", text);
+    for (const auto& [samples, opcode] : hotOpcodes)
+    {
+        y += rowHeight;
+        const char* name = profiler.get_opcode_name ? profiler.get_opcode_name(opcode) : nullptr;
+        draw_text(surf, originX, y, name ? name : "", text);
+        SDL_Rect bar = {barX, y, std::max(1, (int)((uint64_t)barWidth * samples / profileSamples)), 5};
+        SDL_FillRect(surf, &bar, opcodeBar);
+    }
+}
+
+static void draw_rewind(SDL_Surface* surf)
+{
+    // history track with the oldest and newest frames under it; the thin bar is buffer use
+    if (!rewindValid)
+        return;
+
+    Uint32 text = SDL_MapRGB(surf->format, 220, 220, 220);
+    draw_text(surf, kScrubX, kScrubY - 8, "REWIND", text);
+
+    SDL_Rect track = {kScrubX, kScrubY, kScrubWidth, kScrubHeight};
+    SDL_FillRect(surf, &track, SDL_MapRGB(surf->format, 80, 80, 80));
+    if (rewindInfo.depth != 0)
+    {
+        SDL_Rect head = {kScrubX + kScrubWidth - 2, kScrubY, 2, kScrubHeight};
+        SDL_FillRect(surf, &head, SDL_MapRGB(surf->format, 240, 240, 240));
+    }
+
+    int used = (int)((uint64_t)kScrubWidth * rewindInfo.used_bytes / rewindInfo.capacity_bytes);
+    SDL_Rect fill = {kScrubX, kScrubY + kScrubHeight + 2, std::min(used, kScrubWidth), 2};
+    SDL_FillRect(surf, &fill, SDL_MapRGB(surf->format, 60, 110, 220));
+
+    char label[16];
+    snprintf(label, sizeof(label), "%u", rewindInfo.frame - rewindInfo.depth);
+    draw_text(surf, kScrubX, kScrubY + kScrubHeight + 6, label, text);
+    snprintf(label, sizeof(label), "%u", rewindInfo.frame);
+    draw_text(surf, kScrubX + kScrubWidth - 4 * (int)strlen(label), kScrubY + kScrubHeight + 6, label, text);
+}
+
+static void draw_code_cache(SDL_Surface* surf)
+{
+    const int originX = 330;
+    const int originY = 340;
+    const int rowHeight = 8;
+
+    if (!codeCacheValid)
+        return;
+
+    Uint32 text = SDL_MapRGB(surf->format, 220, 220, 220);
+    char line[48];
+
+    draw_text(surf, originX, originY, "CODE CACHE", text);
+    snprintf(line, sizeof(line), "BLOCKS %u", codeCache.live_blocks);
+    draw_text(surf, originX, originY + rowHeight, line, text);
+    snprintf(line, sizeof(line), "USED %u KB OF %u KB", codeCache.bytes_used / 1024, codeCache.bytes_reserved / 1024);
+    draw_text(surf, originX, originY + 2 * rowHeight, line, text);
+    snprintf(line, sizeof(line), "RECOMPILES %.1f PER S", recompilesPerSecond);
+    draw_text(surf, originX, originY + 3 * rowHeight, line, text);
+}
+
+static void draw_frame_timings(SDL_Surface* surf)
+{
+    // one stacked column per VI, oldest on the left; 4 px per millisecond
+    const int baseY = 190;
+    const int maxHeight = 130;
+    const float pxPerNs = 4.0f / 1e6f;
+
+    const Uint32 colors[] = {
+        SDL_MapRGB(surf->format, 60, 110, 220),  // cpu
+        SDL_MapRGB(surf->format, 40, 180, 60),   // rsp gfx
+        SDL_MapRGB(surf->format, 220, 200, 40),  // rsp audio
+        SDL_MapRGB(surf->format, 200, 60, 200),  // compiler
+        SDL_MapRGB(surf->format, 40, 200, 200),  // input
+        SDL_MapRGB(surf->format, 90, 90, 90),    // idle
+    };
+
+    size_t n = std::min(frameStats.size(), kViHistory);
+    size_t start = frameStats.size() - n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const m64p_frame_timing& t = frameStats.at(start + i);
+        const uint32_t parts[] = { t.cpu_ns, t.rsp_gfx_ns, t.rsp_audio_ns, t.compiler_ns, t.input_ns, t.idle_ns };
+        int y = baseY;
+        for (size_t k = 0; k < sizeof(parts) / sizeof(parts[0]) && y > baseY - maxHeight; ++k)
+        {
+            int h = std::min((int)(parts[k] * pxPerNs), y - (baseY - maxHeight));
+            if (h <= 0)
+                continue;
+            y -= h;
+            SDL_Rect seg = {10 + (int)(kViHistory - n + i), y, 1, h};
+            SDL_FillRect(surf, &seg, colors[k]);
+        }
+    }
+
+    // p50, p99 and max over the whole window
+    const uint32_t marks[] = { frameStats.percentile(50), frameStats.percentile(99), frameStats.max() };
+    const Uint32 markColors[] = {
+        SDL_MapRGB(surf->format, 255, 255, 255),
+        SDL_MapRGB(surf->format, 255, 140, 0),
+        SDL_MapRGB(surf->format, 255, 0, 0),
+    };
+    for (size_t k = 0; k < 3; ++k)
+    {
+        int h = std::min((int)(marks[k] * pxPerNs), maxHeight);
+        if (h <= 0)
+            continue;
+        SDL_Rect line = {10, baseY - h, (int)kViHistory, 1};
+        SDL_FillRect(surf, &line, markColors[k]);
+    }
+}
+
+static void draw_pacing_error(SDL_Surface* surf)
+{
+    // centred on the VI deadline, late above and early below; 10 px per millisecond
+    const int centreY = 325;
+    const int maxHeight = 25;
+    const float pxPerNs = 10.0f / 1e6f;
+
+    SDL_Rect axis = {10, centreY, (int)kViHistory, 1};
+    SDL_FillRect(surf, &axis, SDL_MapRGB(surf->format, 120, 120, 120));
+
+    Uint32 onTime = SDL_MapRGB(surf->format, 40, 200, 120);
+    Uint32 late = SDL_MapRGB(surf->format, 220, 40, 40);
+    size_t n = std::min(frameStats.size(), kViHistory);
+    size_t start = frameStats.size() - n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        int32_t err = frameStats.at(start + i).pacing_error_ns;
+        int h = std::clamp((int)(err * pxPerNs), -maxHeight, maxHeight);
+        if (h == 0)
+            continue;
+        SDL_Rect bar = {10 + (int)(kViHistory - n + i), (h > 0) ? centreY - h : centreY + 1, 1, std::abs(h)};
+        SDL_FillRect(surf, &bar, (err > 1000000) ? late : onTime);
+    }
+}
+
+static void draw_vi_intervals(SDL_Surface* surf)
+{
+    // one column per VI, oldest on the left; 2 px per millisecond
+    const int baseY = 290;
+    const int maxHeight = 90;
+
+    float mean = 0.0f;
+    for (float ms : viIntervalsMs)
+        mean += ms;
+    mean /= kViHistory;
+
+    Uint32 normal = SDL_MapRGB(surf->format, 0, 160, 220);
+    Uint32 spike = SDL_MapRGB(surf->format, 220, 40, 40);
+    for (size_t i = 0; i < kViHistory; ++i)
+    {
+        float ms = viIntervalsMs[(viHead + i) % kViHistory];
+        int h = (int)(ms * 2.0f);
+        if (h > maxHeight)
+            h = maxHeight;
+        if (h <= 0)
+            continue;
+        SDL_Rect bar = {10 + (int)i, baseY - h, 1, h};
+        SDL_FillRect(surf, &bar, (ms > mean * 1.5f) ? spike : normal);
+    }
+
+    if (droppedEvents != 0)
+    {
+        SDL_Rect lost = {305, 195, 10, 5};
+        SDL_FillRect(surf, &lost, spike);
+    }
+}
+
 static void window_loop()
 {
     int prevCursorState = SDL_ShowCursor(SDL_QUERY);
     SDL_bool prevRelativeMode = SDL_GetRelativeMouseMode();
 
     SDL_Window* win = SDL_CreateWindow("Analysis Tool", SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED, 320, 240, SDL_WINDOW_SHOWN);
+        SDL_WINDOWPOS_CENTERED, 640, 500, SDL_WINDOW_SHOWN);
     if (!win)
     {
         fprintf(stderr, "Failed to create analysis window: %s\n", SDL_GetError());
@@ -24,6 +507,13 @@ static void window_loop()
     SDL_ShowCursor(SDL_ENABLE);
     Uint32 windowID = SDL_GetWindowID(win);
 
+    if (profiler.start)
+    {
+        if (profiler.reset)
+            profiler.reset();
+        profiler.start(0);
+    }
+
     while (running.load())
     {
         SDL_Event e;
@@ -50,26 +540,56 @@ static void window_loop()
                     else if (x > 170)
                         coreCmd(M64CMD_PAUSE, 0, nullptr);
                 }
+                else if (y >= kScrubY && y < kScrubY + kScrubHeight && x >= kScrubX)
+                {
+                    scrub_to(x);
+                }
+            }
+            else if (e.type == SDL_KEYDOWN && e.key.windowID == windowID)
+            {
+                if (e.key.keysym.sym == SDLK_LEFT)
+                    request_rewind(1);
             }
             else
             {
                 SDL_PushEvent(&e); // return event for emulator
             }
         }
+        drain_telemetry();
+        fetch_frame_timings();
+        fetch_rdram_heatmap();
+        fetch_profile();
+        fetch_rewind();
+        fetch_code_cache();
+
         SDL_Surface* surf = SDL_GetWindowSurface(win);
         SDL_FillRect(surf, NULL, SDL_MapRGB(surf->format, 50, 50, 50));
         SDL_Rect resume = {20, 10, 100, 30};
         SDL_FillRect(surf, &resume, SDL_MapRGB(surf->format, 0, 128, 0));
         SDL_Rect pause = {200, 10, 100, 30};
         SDL_FillRect(surf, &pause, SDL_MapRGB(surf->format, 128, 0, 0));
+        draw_frame_timings(surf);
+        draw_vi_intervals(surf);
+        draw_pacing_error(surf);
+        draw_rdram_heatmap(surf);
+        draw_profile(surf);
+        draw_rewind(surf);
+        draw_code_cache(surf);
         SDL_UpdateWindowSurface(win);
         SDL_Delay(16);
     }
+    if (profiler.stop)
+        profiler.stop();
     SDL_DestroyWindow(win);
     SDL_SetRelativeMouseMode(prevRelativeMode);
     SDL_ShowCursor(prevCursorState ? SDL_ENABLE : SDL_DISABLE);
 }
 
+extern "C" void analysis_window_set_profiler(const analysis_profiler_funcs* funcs)
+{
+    profiler = funcs ? *funcs : analysis_profiler_funcs{};
+}
+
 extern "C" void analysis_window_start(core_do_command_func cmd)
 {
     coreCmd = cmd;
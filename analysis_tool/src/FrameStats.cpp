@@ -0,0 +1,53 @@
+#include "frame_stats.h"
+#include <algorithm>
+#include <cmath>
+
+FrameStats::FrameStats(size_t capacity)
+    : records(capacity)
+{
+    scratch.reserve(capacity);
+}
+
+void FrameStats::push(const m64p_frame_timing& t)
+{
+    if (records.empty())
+        return;
+    records[head] = t;
+    head = (head + 1) % records.size();
+    if (count < records.size())
+        ++count;
+}
+
+void FrameStats::clear()
+{
+    head = 0;
+    count = 0;
+}
+
+const m64p_frame_timing& FrameStats::at(size_t i) const
+{
+    return records[(head + records.size() - count + i) % records.size()];
+}
+
+uint32_t FrameStats::percentile(double p) const
+{
+    if (count == 0)
+        return 0;
+
+    scratch.clear();
+    for (size_t i = 0; i < count; ++i)
+        scratch.push_back(at(i).total_ns);
+
+    double rank = std::ceil(p / 100.0 * count);
+    size_t k = (rank < 1.0) ? 0 : std::min(count, (size_t)rank) - 1;
+    std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+    return scratch[k];
+}
+
+uint32_t FrameStats::max() const
+{
+    uint32_t m = 0;
+    for (size_t i = 0; i < count; ++i)
+        m = std::max(m, at(i).total_ns);
+    return m;
+}
@@ -0,0 +1,203 @@
+extern "C" {
+#include "main/rdram_checkpoint.h"
+}
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Save, load, undo and revert of the RDRAM pages of the savestate
+// checkpoints, and how the checkpoints find the pages written by the
+// writers the dirty bitmap can't see.
+static const size_t PAGE_WORDS = RDRAM_CHECKPOINT_PAGE_SIZE / 4;
+static const size_t DRAM_WORDS = RDRAM_DIRTY_PAGES * PAGE_WORDS;
+
+static std::mt19937 rng(0xc4e3);
+
+static void scribble(std::vector<uint32_t>& dram, uint32_t page)
+{
+    dram[page * PAGE_WORDS + rng() % PAGE_WORDS] ^= 1 + rng() % 0xffff;
+}
+
+// what the RDRAM write handler and the DMA paths do
+static void tracked_write(std::vector<uint32_t>& dram, uint32_t page)
+{
+    scribble(dram, page);
+    rdram_dirty_mark(page << RDRAM_DIRTY_PAGE_SHIFT);
+}
+
+static std::vector<unsigned char> save(const std::vector<uint32_t>& dram, int untracked, int xor_previous, uint32_t* pages)
+{
+    *pages = rdram_checkpoint_collect(dram.data(), untracked);
+
+    std::vector<unsigned char> records((size_t)*pages * RDRAM_CHECKPOINT_RECORD_SIZE);
+    rdram_checkpoint_write(records.data(), dram.data(), xor_previous);
+    return records;
+}
+
+static bool expect(const char* what, uint32_t got, uint32_t expected)
+{
+    if (got != expected)
+        std::printf("%s: %u pages, expected %u\n", what, got, expected);
+    return got == expected;
+}
+
+static bool same(const char* what, const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i] != b[i])
+        {
+            std::printf("%s: RDRAM differs at 0x%zx\n", what, i * 4);
+            return false;
+        }
+    return true;
+}
+
+static bool save_and_load(std::vector<uint32_t>& dram)
+{
+    uint32_t pages;
+
+    // the first checkpoint after a reset holds everything
+    if (!rdram_checkpoint_reset())
+        return false;
+    std::vector<unsigned char> full = save(dram, 0, 0, &pages);
+    if (!expect("first checkpoint", pages, RDRAM_DIRTY_PAGES))
+        return false;
+
+    // records are little endian page index and words
+    uint32_t index;
+    std::memcpy(&index, full.data() + 5 * RDRAM_CHECKPOINT_RECORD_SIZE, 4);
+    if (index != 5)
+        return false;
+
+    // nothing written since
+    save(dram, 0, 0, &pages);
+    if (!expect("unchanged", pages, 0))
+        return false;
+
+    std::vector<uint32_t> loaded(DRAM_WORDS, 0);
+    rdram_checkpoint_load(loaded.data(), full.data(), RDRAM_DIRTY_PAGES);
+    if (!same("full load", loaded, dram))
+        return false;
+
+    // a later checkpoint only carries the written pages, and loading it
+    // over the first one gives the same RDRAM
+    tracked_write(dram, 3);
+    tracked_write(dram, 3);
+    tracked_write(dram, 2047);
+    std::vector<unsigned char> partial = save(dram, 0, 0, &pages);
+    if (!expect("tracked writes", pages, 2))
+        return false;
+
+    rdram_checkpoint_load(loaded.data(), partial.data(), pages);
+    return same("partial load", loaded, dram);
+}
+
+static bool writers_behind_the_bitmap(std::vector<uint32_t>& dram)
+{
+    uint32_t pages;
+
+    // checked pages are compared, and only count if they changed
+    scribble(dram, 10);
+    rdram_dirty_check_range(10 << RDRAM_DIRTY_PAGE_SHIFT, 1);
+    rdram_dirty_check_range(20 << RDRAM_DIRTY_PAGE_SHIFT, 3 * RDRAM_CHECKPOINT_PAGE_SIZE);
+    scribble(dram, 21);
+    // nobody told about this one
+    scribble(dram, 30);
+    save(dram, 0, 0, &pages);
+    if (!expect("checked pages", pages, 2))
+        return false;
+
+    // an untracked writer makes the next checkpoint compare everything,
+    // which also catches up with the page missed above
+    scribble(dram, 40);
+    rdram_dirty_untracked();
+    save(dram, 0, 0, &pages);
+    if (!expect("untracked", pages, 2))
+        return false;
+    if (!expect("untracked cleared", g_rdram_dirty_untracked, 0))
+        return false;
+
+    // the dynarecs are always untracked
+    scribble(dram, 50);
+    save(dram, 1, 0, &pages);
+    if (!expect("dynarec", pages, 1))
+        return false;
+
+    // a debugger holding the RDRAM pointer gets whole checkpoints until the
+    // next power-on
+    rdram_dirty_disable();
+    save(dram, 0, 0, &pages);
+    if (!expect("disabled", pages, RDRAM_DIRTY_PAGES))
+        return false;
+    save(dram, 0, 0, &pages);
+    if (!expect("still disabled", pages, RDRAM_DIRTY_PAGES))
+        return false;
+    rdram_dirty_poweron();
+    save(dram, 0, 0, &pages);
+    save(dram, 0, 0, &pages);
+    return expect("after power-on", pages, 0);
+}
+
+static bool undo_and_revert(std::vector<uint32_t>& dram)
+{
+    const int steps = 8;
+    std::vector<std::vector<uint32_t> > states;
+    std::vector<std::vector<unsigned char> > deltas;
+    std::vector<uint32_t> counts;
+    uint32_t pages;
+
+    if (!rdram_checkpoint_reset())
+        return false;
+    save(dram, 0, 0, &pages);
+    states.push_back(dram);
+
+    for (int i = 0; i < steps; ++i)
+    {
+        for (int j = 0; j < 20; ++j)
+            tracked_write(dram, rng() % RDRAM_DIRTY_PAGES);
+        for (int j = 0; j < 5; ++j)
+            scribble(dram, rng() % RDRAM_DIRTY_PAGES);
+        rdram_dirty_untracked();
+
+        deltas.push_back(save(dram, 0, 1, &pages));
+        counts.push_back(pages);
+        states.push_back(dram);
+    }
+
+    // writes since the last checkpoint are dropped by revert, tracked or not
+    tracked_write(dram, 7);
+    scribble(dram, 8);
+    rdram_dirty_check_range(8 << RDRAM_DIRTY_PAGE_SHIFT, 4);
+    rdram_checkpoint_revert(dram.data(), 0);
+    if (!same("revert", dram, states[steps]))
+        return false;
+
+    // undoing deltas from the latest walks RDRAM back in time
+    for (int i = steps - 1; i >= 0; --i)
+    {
+        rdram_checkpoint_undo(deltas[i].data(), counts[i]);
+        rdram_checkpoint_revert(dram.data(), 0);
+        if (!same("undo", dram, states[i]))
+            return false;
+    }
+
+    // and the next checkpoint is against the reverted RDRAM
+    save(dram, 0, 0, &pages);
+    return expect("after undo", pages, 0);
+}
+
+int main()
+{
+    std::vector<uint32_t> dram(DRAM_WORDS);
+
+    for (uint32_t& w : dram)
+        w = static_cast<uint32_t>(rng());
+
+    if (!save_and_load(dram) || !writers_behind_the_bitmap(dram) || !undo_and_revert(dram))
+        return 1;
+
+    rdram_checkpoint_free();
+    return 0;
+}
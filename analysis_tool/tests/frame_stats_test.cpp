@@ -0,0 +1,41 @@
+#include "frame_stats.h"
+
+static m64p_frame_timing timing(uint32_t total)
+{
+    m64p_frame_timing t{};
+    t.total_ns = total;
+    return t;
+}
+
+int main() {
+    FrameStats stats(100);
+
+    if (stats.percentile(50) != 0 || stats.max() != 0)
+        return 1;
+
+    // 1..100 ms
+    for (uint32_t i = 1; i <= 100; ++i)
+        stats.push(timing(i * 1000000));
+
+    if (stats.size() != 100)
+        return 1;
+    if (stats.percentile(50) != 50000000 || stats.percentile(99) != 99000000)
+        return 1;
+    if (stats.percentile(0) != 1000000 || stats.max() != 100000000)
+        return 1;
+
+    // window rolls over: oldest records are dropped first
+    for (uint32_t i = 0; i < 10; ++i)
+        stats.push(timing(500000));
+
+    if (stats.size() != 100 || stats.at(0).total_ns != 11000000)
+        return 1;
+    if (stats.at(99).total_ns != 500000 || stats.percentile(10) != 500000)
+        return 1;
+
+    stats.clear();
+    if (stats.size() != 0)
+        return 1;
+
+    return 0;
+}
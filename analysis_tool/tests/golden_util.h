@@ -0,0 +1,176 @@
+#ifndef GOLDEN_UTIL_H
+#define GOLDEN_UTIL_H
+
+// Shared scaffolding of the golden tests, which replay a fixed pseudo-random
+// workload through the SIMD and the scalar builds of a plugin and compare a
+// hash of the resulting memory against a value taken from the scalar code.
+//
+// A hash only tells that something changed, so the regions that go into it
+// can also be recorded to a file by the scalar build (--record file) and
+// streamed against by the SIMD build (--compare file), which then reports the
+// first byte that differs. The tests are registered so that each scalar build
+// runs and records before its SIMD build.
+//
+// Define GOLDEN_HLE_STUBS or GOLDEN_RSP_STUBS before including this header to
+// get the message callbacks the RSP HLE or LLE sources call into.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(GOLDEN_HLE_STUBS)
+extern "C" {
+void HleVerboseMessage(void*, const char*, ...) {}
+void HleInfoMessage(void*, const char*, ...) {}
+void HleErrorMessage(void*, const char*, ...) {}
+void HleWarnMessage(void*, const char*, ...) {}
+void rsp_break(struct hle_t*, unsigned int) {}
+}
+#endif
+
+#if defined(GOLDEN_RSP_STUBS)
+extern "C" {
+void RspVerboseMessage(void*, const char*, ...) {}
+void RspInfoMessage(void*, const char*, ...) {}
+void RspErrorMessage(void*, const char*, ...) {}
+void RspWarnMessage(void*, const char*, ...) {}
+void RspCheckInterrupts(void*) {}
+void RspProcessDlistList(void*) {}
+void RspProcessAlistList(void*) {}
+void RspProcessRdpList(void*) {}
+}
+#endif
+
+// xorshift32, seeded per test so that each workload stays fixed
+struct xorshift32
+{
+    uint32_t state;
+
+    uint32_t operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+};
+
+static inline uint64_t fnv1a(uint64_t h, const void* data, size_t size)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+        h = (h ^ p[i]) * UINT64_C(0x100000001b3);
+    return h;
+}
+
+class golden_check
+{
+public:
+    golden_check(const char* name, uint64_t golden, int argc, char* argv[])
+        : name_(name), golden_(golden)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            if (std::strcmp(argv[i], "--record") == 0)
+                record_ = std::fopen(argv[i + 1], "wb");
+            else if (std::strcmp(argv[i], "--compare") == 0)
+            {
+                reference_ = std::fopen(argv[i + 1], "rb");
+                reference_name_ = argv[i + 1];
+            }
+        }
+    }
+
+    ~golden_check()
+    {
+        if (record_ != nullptr)
+            std::fclose(record_);
+        if (reference_ != nullptr)
+            std::fclose(reference_);
+    }
+
+    golden_check(const golden_check&) = delete;
+    golden_check& operator=(const golden_check&) = delete;
+
+    // the first difference is reported with the round it happened in
+    void next_round() { ++round_; }
+
+    void add(const char* what, const void* data, size_t size)
+    {
+        hash_ = fnv1a(hash_, data, size);
+
+        if (record_ != nullptr)
+            std::fwrite(data, 1, size, record_);
+        if (reference_ != nullptr && !found_ && !reference_short_)
+            compare(what, static_cast<const unsigned char*>(data), size);
+    }
+
+    // returns the exit code of the test
+    int finish() const
+    {
+        if (hash_ == golden_)
+            return 0;
+
+        std::fprintf(stderr, "%s hash %016llx, expected %016llx\n", name_,
+                     static_cast<unsigned long long>(hash_), static_cast<unsigned long long>(golden_));
+        if (found_)
+            std::fprintf(stderr, "%s: first difference from %s in %s of round %u, at offset 0x%zx: 0x%02x, reference 0x%02x\n",
+                         name_, reference_name_, diff_what_, diff_round_, diff_offset_, diff_got_, diff_expected_);
+        else if (reference_short_)
+            std::fprintf(stderr, "%s: %s ends before the first difference\n", name_, reference_name_);
+        else if (reference_ != nullptr)
+            std::fprintf(stderr, "%s: no difference from %s\n", name_, reference_name_);
+        return 1;
+    }
+
+private:
+    void compare(const char* what, const unsigned char* data, size_t size)
+    {
+        unsigned char expected[4096];
+
+        for (size_t offset = 0; offset < size; )
+        {
+            size_t n = size - offset < sizeof(expected) ? size - offset : sizeof(expected);
+            size_t got = std::fread(expected, 1, n, reference_);
+
+            for (size_t i = 0; i < got; ++i)
+                if (data[offset + i] != expected[i])
+                {
+                    found_ = true;
+                    diff_what_ = what;
+                    diff_round_ = round_;
+                    diff_offset_ = offset + i;
+                    diff_got_ = data[offset + i];
+                    diff_expected_ = expected[i];
+                    return;
+                }
+
+            // a shorter reference was recorded from another workload
+            if (got != n)
+            {
+                reference_short_ = true;
+                return;
+            }
+            offset += n;
+        }
+    }
+
+    const char* name_;
+    uint64_t golden_;
+    uint64_t hash_ = UINT64_C(0xcbf29ce484222325);
+    unsigned round_ = 0;
+
+    std::FILE* record_ = nullptr;
+    std::FILE* reference_ = nullptr;
+    const char* reference_name_ = nullptr;
+    bool reference_short_ = false;
+
+    bool found_ = false;
+    const char* diff_what_ = nullptr;
+    unsigned diff_round_ = 0;
+    size_t diff_offset_ = 0;
+    unsigned diff_got_ = 0;
+    unsigned diff_expected_ = 0;
+};
+
+#endif
@@ -0,0 +1,138 @@
+extern "C" {
+#include "hle_external.h"
+#include "hle_internal.h"
+#include "memory.h"
+#include "ucodes.h"
+}
+#define GOLDEN_HLE_STUBS
+#include "golden_util.h"
+
+#include <cstdint>
+#include <vector>
+
+// Builds a fixed set of pseudo-random PS0, PS and OB JPEG tasks (both
+// macroblock modes, custom and scaled quantization tables, DC prediction),
+// runs them through the RSP HLE JPEG decoder and compares a hash of RDRAM
+// against the output of the scalar code. Built with and without HLE_NO_SIMD.
+static const uint64_t GOLDEN = UINT64_C(0x4ed705edbff8933c);
+
+static xorshift32 rng{0x2545f491};
+
+static hle_t hle;
+
+static void w16(uint32_t address, uint16_t v) { *dram_u16(&hle, address) = v; }
+static void w32(uint32_t address, uint32_t v) { *dram_u32(&hle, address) = v; }
+
+static uint32_t heap;
+
+static uint32_t alloc(uint32_t size)
+{
+    uint32_t address = heap;
+    heap += (size + 15) & ~15u;
+    return address;
+}
+
+// mostly photo-like coefficients, with the occasional block that overflows
+// the IDCT and the colour conversion
+static int16_t coefficient(unsigned range)
+{
+    switch (range) {
+    case 0: return static_cast<int16_t>(static_cast<int32_t>(rng() % 129) - 64);
+    case 1: return static_cast<int16_t>(static_cast<int32_t>(rng() % 4097) - 2048);
+    default: return static_cast<int16_t>(rng());
+    }
+}
+
+static void fill_macroblocks(uint32_t address, unsigned count, unsigned subblocks)
+{
+    for (unsigned mb = 0; mb < count; ++mb)
+    {
+        unsigned range = (rng() % 8 < 5) ? 0 : (rng() % 3 == 0) ? 2 : 1;
+
+        for (unsigned i = 0; i < subblocks * 64; ++i)
+        {
+            // high frequencies are mostly zero
+            bool zero = (i % 64) > 8 && (rng() % 4) != 0;
+            w16(address + 2 * (mb * subblocks * 64 + i), zero ? 0 : static_cast<uint16_t>(coefficient(range)));
+        }
+    }
+}
+
+static void run_std_task(bool ps0)
+{
+    const uint32_t mode = (rng() & 1) ? 2 : 0;
+    const unsigned count = 1 + rng() % 8;
+    uint32_t data = alloc(24);
+    uint32_t blocks = alloc(count * (mode + 4) * 128);
+    uint32_t qtables[3];
+
+    for (auto& q : qtables)
+    {
+        bool small = (rng() % 4) != 0;
+
+        q = alloc(128);
+        for (unsigned i = 0; i < 64; ++i)
+            w16(q + 2 * i, static_cast<uint16_t>(small ? 1 + rng() % 32 : rng()));
+    }
+
+    fill_macroblocks(blocks, count, mode + 4);
+
+    w32(data + 0, blocks);
+    w32(data + 4, count);
+    w32(data + 8, mode);
+    w32(data + 12, qtables[0]);
+    w32(data + 16, qtables[1]);
+    w32(data + 20, qtables[2]);
+
+    *dmem_u32(&hle, TASK_FLAGS) = 0;
+    *dmem_u32(&hle, TASK_DATA_PTR) = data;
+
+    if (ps0)
+        jpeg_decode_PS0(&hle);
+    else
+        jpeg_decode_PS(&hle);
+}
+
+static void run_ob_task()
+{
+    const unsigned count = 1 + rng() % 8;
+    uint32_t blocks = alloc(count * 6 * 128);
+    int32_t qscale;
+
+    switch (rng() % 4) {
+    case 0: qscale = 0; break;
+    case 1: qscale = -static_cast<int32_t>(rng() % 8); break;
+    default: qscale = static_cast<int32_t>(1 + rng() % 8); break;
+    }
+
+    fill_macroblocks(blocks, count, 6);
+
+    *dmem_u32(&hle, TASK_DATA_PTR) = blocks;
+    *dmem_u32(&hle, TASK_DATA_SIZE) = count;
+    *dmem_u32(&hle, TASK_YIELD_DATA_SIZE) = static_cast<uint32_t>(qscale);
+
+    jpeg_decode_OB(&hle);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<unsigned char> dram(0x100000);
+    std::vector<unsigned char> dmem(0x1000);
+    golden_check golden("jpeg", GOLDEN, argc, argv);
+
+    hle.dram = dram.data();
+    hle.dmem = dmem.data();
+
+    for (int task = 0; task < 600; ++task)
+    {
+        heap = 0x1000;
+        switch (task % 3) {
+        case 0: run_std_task(true); break;
+        case 1: run_std_task(false); break;
+        case 2: run_ob_task(); break;
+        }
+        golden.add("RDRAM", dram.data(), heap);
+        golden.next_round();
+    }
+
+    return golden.finish();
+}
@@ -0,0 +1,147 @@
+extern "C" {
+#include "main/lz.h"
+}
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Round trips for the savestate checkpoint codec, on the kind of data it
+// gets (sparse XOR deltas, zero pages) and on data it can't compress, plus
+// the decoder's bounds checks on truncated and corrupted blocks.
+static const size_t GUARD = 64;
+static const uint8_t CANARY = 0xa5;
+
+static bool round_trip(const char* name, const std::vector<uint8_t>& src)
+{
+    std::vector<uint8_t> packed(lz_compress_bound(src.size()));
+    std::vector<uint8_t> out(src.size() + GUARD, CANARY);
+
+    size_t packed_size = lz_compress(src.data(), src.size(), packed.data(), packed.size());
+    if (packed_size == 0 || packed_size > lz_compress_bound(src.size()))
+    {
+        std::printf("%s: compressed %zu bytes to %zu\n", name, src.size(), packed_size);
+        return false;
+    }
+
+    size_t size = lz_decompress(packed.data(), packed_size, out.data(), src.size());
+    if (size != src.size() || std::memcmp(out.data(), src.data(), src.size()) != 0)
+    {
+        std::printf("%s: %zu bytes came back as %zu different ones\n", name, src.size(), size);
+        return false;
+    }
+    for (size_t i = src.size(); i < out.size(); ++i)
+        if (out[i] != CANARY)
+        {
+            std::printf("%s: decoder wrote past the output at +%zu\n", name, i - src.size());
+            return false;
+        }
+
+    // one byte short of room must be refused, not overrun
+    if (!src.empty() && lz_decompress(packed.data(), packed_size, out.data(), src.size() - 1) != 0)
+    {
+        std::printf("%s: decoded into a too small buffer\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Every prefix of a block is either rejected or decodes to a prefix of the
+// data, without writing past the output. A block ending in a match carries
+// an empty literal token, so dropping that last byte still decodes in full.
+static bool truncated(const char* name, const std::vector<uint8_t>& src)
+{
+    std::vector<uint8_t> packed(lz_compress_bound(src.size()));
+    size_t packed_size = lz_compress(src.data(), src.size(), packed.data(), packed.size());
+
+    for (size_t n = 0; n < packed_size; ++n)
+    {
+        std::vector<uint8_t> in(packed.begin(), packed.begin() + n);
+        std::vector<uint8_t> out(src.size() + GUARD, CANARY);
+
+        size_t size = lz_decompress(in.data(), n, out.data(), src.size());
+        if (size > src.size() || std::memcmp(out.data(), src.data(), size) != 0)
+        {
+            std::printf("%s: %zu of %zu block bytes decoded to wrong data\n", name, n, packed_size);
+            return false;
+        }
+        for (size_t i = src.size(); i < out.size(); ++i)
+            if (out[i] != CANARY)
+            {
+                std::printf("%s: decoder wrote past the output at +%zu\n", name, i - src.size());
+                return false;
+            }
+    }
+    return true;
+}
+
+static bool malformed()
+{
+    uint8_t out[64];
+
+    // a match reaching back before the start of the output
+    static const uint8_t before_start[] = { 0x20, 'a', 'b', 0x03, 0x00, 0x00 };
+    // a zero offset
+    static const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+    // a literal run longer than the block
+    static const uint8_t long_literals[] = { 0x80, 'a', 'b', 'c' };
+    // a length continuation cut off
+    static const uint8_t cut_length[] = { 0xf0, 0xff };
+
+    return lz_decompress(before_start, sizeof(before_start), out, sizeof(out)) == 0
+        && lz_decompress(zero_offset, sizeof(zero_offset), out, sizeof(out)) == 0
+        && lz_decompress(long_literals, sizeof(long_literals), out, sizeof(out)) == 0
+        && lz_decompress(cut_length, sizeof(cut_length), out, sizeof(out)) == 0;
+}
+
+int main()
+{
+    std::mt19937 rng(0x5eed);
+    std::vector<uint8_t> noise(1 << 20);
+    std::vector<uint8_t> zeros(1 << 20, 0);
+    std::vector<uint8_t> delta(1 << 20, 0);
+
+    for (uint8_t& b : noise)
+        b = static_cast<uint8_t>(rng());
+
+    // what a checkpoint delta looks like: a few short runs of changed bytes
+    // and long runs of unchanged ones, some of them repeating
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        size_t at = rng() % (delta.size() - 64);
+        size_t len = 1 + rng() % 48;
+        for (size_t j = 0; j < len; ++j)
+            delta[at + j] = (i & 1) ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>(at);
+    }
+
+    if (!round_trip("zeros", zeros) || !round_trip("delta", delta) || !round_trip("noise", noise))
+        return 1;
+
+    // all-zero input must actually shrink, incompressible input must fit the bound
+    std::vector<uint8_t> packed(lz_compress_bound(zeros.size()));
+    if (lz_compress(zeros.data(), zeros.size(), packed.data(), packed.size()) > zeros.size() / 200)
+        return 1;
+    if (lz_compress(noise.data(), noise.size(), packed.data(), packed.size() - 1) != 0)
+        return 1;
+
+    // short inputs around the minimum match and nibble boundaries
+    for (size_t n = 1; n <= 300; ++n)
+    {
+        std::vector<uint8_t> small(noise.begin(), noise.begin() + n);
+        std::vector<uint8_t> runs(n, static_cast<uint8_t>(n));
+        if (!round_trip("short noise", small) || !round_trip("short run", runs))
+            return 1;
+    }
+
+    std::vector<uint8_t> short_delta(delta.begin(), delta.begin() + 4096);
+    std::vector<uint8_t> short_noise(noise.begin(), noise.begin() + 1024);
+    std::vector<uint8_t> short_zeros(4096, 0);
+    if (!truncated("delta", short_delta) || !truncated("noise", short_noise) || !truncated("zeros", short_zeros))
+        return 1;
+
+    if (!malformed())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+extern "C" {
+#include "hle_external.h"
+#include "hle_internal.h"
+#include "memory.h"
+#include "ucodes.h"
+}
+#define GOLDEN_HLE_STUBS
+#include "golden_util.h"
+
+#include <cstdint>
+#include <vector>
+
+// Builds a fixed set of pseudo-random MusyX v1 and v2 tasks (PCM16 and ADPCM
+// voices, delay taps, FIR4, interleave stages), runs them through the RSP HLE
+// MusyX code and compares a hash of RDRAM against the output of the scalar
+// code. Built with and without HLE_NO_SIMD.
+static const uint64_t GOLDEN = UINT64_C(0x775cd5005f4f496c);
+
+static xorshift32 rng{0x9e3779b9};
+
+static hle_t hle;
+
+static void w8(uint32_t address, uint8_t v) { *dram_u8(&hle, address) = v; }
+static void w16(uint32_t address, uint16_t v) { *dram_u16(&hle, address) = v; }
+static void w32(uint32_t address, uint32_t v) { *dram_u32(&hle, address) = v; }
+
+static void fill16(uint32_t address, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        w16(address + 2 * i, static_cast<uint16_t>(rng()));
+}
+
+static uint32_t heap;
+
+static uint32_t alloc(uint32_t size)
+{
+    uint32_t address = heap;
+    heap += (size + 15) & ~15u;
+    return address;
+}
+
+// small signed 16.16 value
+static uint32_t small_vol()
+{
+    return static_cast<uint32_t>(static_cast<int32_t>(rng() % 0x8000) - 0x4000);
+}
+
+static void write_voice(uint32_t voice, uint32_t output_ptr)
+{
+    for (unsigned k = 0; k < 4; ++k)
+    {
+        w32(voice + 0x00 + 4 * k, static_cast<uint32_t>(static_cast<int32_t>(rng() % 0x60000000) - 0x30000000));
+        w32(voice + 0x10 + 4 * k, static_cast<uint32_t>(static_cast<int32_t>(rng() % 0x200000) - 0x100000));
+    }
+
+    w16(voice + 0x20, static_cast<uint16_t>(rng()));
+    w16(voice + 0x22, static_cast<uint16_t>(0x400 + rng() % 0xc00)); // pitch <= 1.0
+
+    unsigned count;
+    if (rng() & 1)
+    {
+        // PCM16
+        uint8_t skip = rng() % 4;
+        uint16_t samples = static_cast<uint16_t>(64 + rng() % 320);
+        count = (samples + skip + 3) & ~3u;
+        uint32_t data = alloc(count * 2);
+
+        fill16(data, count);
+        w8(voice + 0x3c, 0);
+        w8(voice + 0x3e, skip);
+        w16(voice + 0x40, samples);
+        w16(voice + 0x42, 0);
+        w32(voice + 0x24, data);
+        w32(voice + 0x28, 0);
+        w16(voice + 0x2c, static_cast<uint16_t>(count * 2));
+        w16(voice + 0x2e, 0);
+    }
+    else
+    {
+        // ADPCM
+        // whole frame pairs, an odd count would read past the DMAed bytes
+        uint8_t frames = static_cast<uint8_t>(2 * (1 + rng() % 5));
+        uint32_t table = alloc(256);
+        uint32_t data = alloc(frames * 20);
+
+        count = frames * 32;
+        for (unsigned i = 0; i < 128; ++i)
+            w16(table + 2 * i, static_cast<uint16_t>(static_cast<int16_t>(rng() % 0x1000) - 0x800));
+        for (unsigned i = 0; i < frames * 20; ++i)
+        {
+            // the frame headers select one of the 8 codebooks of the table
+            bool header = (i % 40) == 8 || (i % 40) == 24;
+            w8(data + i, static_cast<uint8_t>(rng() & (header ? 0x7f : 0xff)));
+        }
+
+        w8(voice + 0x3c, frames);
+        w8(voice + 0x3d, 0);
+        w8(voice + 0x3e, rng() % 32);
+        w8(voice + 0x3f, 0);
+        w32(voice + 0x40, table);
+        w32(voice + 0x24, data);
+        w32(voice + 0x28, 0);
+        w16(voice + 0x2c, static_cast<uint16_t>(frames * 20));
+        w16(voice + 0x2e, 0);
+    }
+
+    uint16_t end_point = static_cast<uint16_t>(count - 4 - rng() % 8);
+    w16(voice + 0x48, end_point);
+    w16(voice + 0x4a, static_cast<uint16_t>(rng() % (end_point / 2)));
+    w16(voice + 0x4e, 0);
+    w32(voice + 0x44, output_ptr);
+}
+
+static uint32_t write_sfx()
+{
+    if ((rng() % 4) == 0)
+        return 0;
+
+    uint32_t sfx = alloc(0x48);
+    uint32_t length = 0x600;
+    uint32_t cbuffer = alloc(length * 2);
+
+    fill16(cbuffer, length);
+    w32(sfx + 0x00, cbuffer);
+    w32(sfx + 0x04, length);
+    w16(sfx + 0x08, static_cast<uint16_t>(rng() % 9));
+    w16(sfx + 0x0a, static_cast<uint16_t>(rng()));
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        w32(sfx + 0x0c + 4 * i, 1 + rng() % (length - 1));
+        w16(sfx + 0x2c + 2 * i, static_cast<uint16_t>(rng()));
+    }
+    w16(sfx + 0x3c, static_cast<uint16_t>(rng()));
+    w16(sfx + 0x3e, static_cast<uint16_t>(rng()));
+    fill16(sfx + 0x40, 4);
+
+    return sfx;
+}
+
+static void write_state(uint32_t state)
+{
+    fill16(state, 0x300 / 2);
+    // keep the base volumes small, the 3% decay is computed on 32 bits
+    for (unsigned k = 0; k < 4; ++k)
+    {
+        uint32_t v = small_vol();
+        w16(state + 0x100 + 2 * k, static_cast<uint16_t>(v >> 16));
+        w16(state + 0x108 + 2 * k, static_cast<uint16_t>(v));
+    }
+    for (unsigned i = 0; i < 32 * 4; ++i)
+        w16(state + 2 * i, static_cast<uint16_t>(static_cast<int16_t>(rng() % 0x1000) - 0x800));
+}
+
+static void run_task(bool v2)
+{
+    const uint32_t voices_offset = v2 ? 0x28 : 0x10;
+    const uint32_t sfd_size = voices_offset + 32 * 0x50;
+    const uint32_t sfd_count = 1 + rng() % 3;
+    uint32_t sfd = alloc(sfd_count * sfd_size);
+    uint32_t state = alloc(0x300);
+
+    write_state(state);
+
+    for (uint32_t n = 0; n < sfd_count; ++n, sfd += sfd_size)
+    {
+        uint32_t voice_count = 1 + rng() % 4;
+        uint32_t output = alloc(v2 ? 6 * 192 : 4 * 192);
+
+        if (n == 0)
+        {
+            *dmem_u32(&hle, TASK_DATA_PTR) = sfd;
+            *dmem_u32(&hle, TASK_DATA_SIZE) = sfd_count;
+        }
+
+        w16(sfd + 0x02, static_cast<uint16_t>(rng() % 7));
+        w32(sfd + 0x04, rng() & ((1u << voice_count) - 1));
+        w32(sfd + 0x08, state);
+        w32(sfd + 0x0c, write_sfx());
+
+        for (uint32_t i = 0; i < voice_count; ++i)
+            write_voice(sfd + voices_offset + i * 0x50, (i + 1 == voice_count) ? output : 0);
+
+        if (!v2)
+            continue;
+
+        uint32_t ptr_18 = alloc(8 * 8);
+        uint32_t ptr_1c = alloc(2 * 192);
+        uint32_t ptr_24 = alloc(4 * 8);
+
+        w32(sfd + 0x10, 0);
+        w8(sfd + 0x14, 0);
+        w8(sfd + 0x15, static_cast<uint8_t>(rng() & 0xf));
+        w16(sfd + 0x16, static_cast<uint16_t>(rng() & 0xff));
+        w32(sfd + 0x18, ptr_18);
+        w32(sfd + 0x1c, ptr_1c);
+        w32(sfd + 0x20, alloc(4 * 192));
+        w32(sfd + 0x24, ptr_24);
+
+        fill16(ptr_1c, 192);
+        for (unsigned i = 0; i < 16; ++i)
+            w16(ptr_24 + 2 * i, static_cast<uint16_t>(static_cast<int16_t>(rng() % 0x1000) - 0x800));
+        for (unsigned k = 0; k < 8; ++k)
+        {
+            uint32_t source = alloc(6 * 192);
+            fill16(source, 3 * 192);
+            w32(ptr_18 + 8 * k, source);
+            w16(ptr_18 + 8 * k + 4, static_cast<uint16_t>(rng()));
+        }
+    }
+
+    if (v2)
+        musyx_v2_task(&hle);
+    else
+        musyx_v1_task(&hle);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<unsigned char> dram(0x800000);
+    std::vector<unsigned char> dmem(0x1000);
+    golden_check golden("musyx", GOLDEN, argc, argv);
+
+    hle.dram = dram.data();
+    hle.dmem = dmem.data();
+
+    for (int task = 0; task < 200; ++task)
+    {
+        heap = 0x1000;
+        run_task((task & 1) != 0);
+        golden.add("RDRAM", dram.data(), heap);
+        golden.next_round();
+    }
+
+    return golden.finish();
+}
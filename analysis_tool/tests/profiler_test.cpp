@@ -0,0 +1,86 @@
+#include "analysis_window.h"
+#include <SDL.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Fake core profiler: checks the window starts it, queries it from its own
+// thread with sane parameters and stops it again when closed.
+static std::atomic<int> starts{0};
+static std::atomic<int> stops{0};
+static std::atomic<int> queries{0};
+static std::atomic<int> opcodeQueries{0};
+static std::atomic<bool> badParam{false};
+
+static m64p_error fake_start(unsigned int period)
+{
+    if (period != 0)
+        badParam = true;
+    ++starts;
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error fake_stop()
+{
+    ++stops;
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error fake_reset()
+{
+    return M64ERR_SUCCESS;
+}
+
+static m64p_error fake_hot_functions(m64p_profile_query* query)
+{
+    if (query == nullptr || query->functions == nullptr || query->capacity == 0)
+    {
+        badParam = true;
+        return M64ERR_INPUT_INVALID;
+    }
+
+    query->count = 2;
+    query->functions[0] = m64p_profile_function{0x80001000, 75};
+    query->functions[1] = m64p_profile_function{0x80002040, 25};
+    query->samples = 100;
+    query->dropped = 0;
+    ++queries;
+    return M64ERR_SUCCESS;
+}
+
+static int fake_opcode_counts(unsigned int* counts, int size)
+{
+    if (counts == nullptr && size != 0)
+        badParam = true;
+    for (int i = 0; i < size && i < 3; ++i)
+        counts[i] = 10 * (i + 1);
+    ++opcodeQueries;
+    return 3;
+}
+
+static const char* fake_opcode_name(int opcode)
+{
+    static const char* names[] = { "ADDIU", "LW", "CP1_ADD_S" };
+    return (opcode >= 0 && opcode < 3) ? names[opcode] : nullptr;
+}
+
+int main() {
+    setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+        return 1;
+
+    analysis_profiler_funcs funcs = {
+        fake_start, fake_stop, fake_reset, fake_hot_functions, fake_opcode_counts, fake_opcode_name
+    };
+    analysis_window_set_profiler(&funcs);
+    analysis_window_start(nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    analysis_window_stop();
+    analysis_window_set_profiler(nullptr);
+    SDL_Quit();
+
+    if (badParam || starts != 1 || stops != 1 || queries < 1 || opcodeQueries < 2)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+extern "C" {
+#include "device/rcp/rdp/rdp_images.h"
+#include "main/rdram_dirty.h"
+}
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// The pages the savestate checkpoints are told to compare after the RDP
+// commands went by: the color and Z images down to the scissor box, across
+// command lists and commands cut at DPC_END.
+struct command_list
+{
+    std::vector<uint32_t> words;
+
+    uint32_t size() const { return static_cast<uint32_t>(words.size() * 4); }
+
+    void add(uint32_t w0, uint32_t w1) { words.push_back(w0); words.push_back(w1); }
+
+    void color_image(uint32_t address, uint32_t width, uint32_t size)
+    {
+        add((0x3fu << 24) | (size << 19) | (width - 1), address);
+    }
+    void z_image(uint32_t address) { add(0x3eu << 24, address); }
+    void scissor(uint32_t rows) { add(0x2du << 24, (rows - 1) << 2); }
+    void other_modes(bool z_update) { add(0x2fu << 24, z_update ? 0x20 : 0); }
+    void fill_rectangle() { add(0x36u << 24, 0); }
+
+    // shaded, textured and Z-buffered, with a body that looks like commands
+    void triangle()
+    {
+        add(0x0fu << 24, 0);
+        for (int i = 0; i < 21; ++i)
+            add(0x3f000000, 0x00700000);
+    }
+};
+
+static void clear()
+{
+    rdram_dirty_clear();
+}
+
+static bool checked(uint32_t address, uint32_t length)
+{
+    for (uint32_t page = address >> RDRAM_DIRTY_PAGE_SHIFT; page <= (address + length - 1) >> RDRAM_DIRTY_PAGE_SHIFT; ++page)
+        if (!rdram_dirty_test_check(page))
+            return false;
+    return true;
+}
+
+static uint32_t checked_pages()
+{
+    uint32_t pages = 0;
+    for (uint32_t page = 0; page < RDRAM_DIRTY_PAGES; ++page)
+        pages += rdram_dirty_test_check(page);
+    return pages;
+}
+
+static bool fail(const char* what)
+{
+    std::printf("%s\n", what);
+    return false;
+}
+
+static bool images()
+{
+    rdp_images images = {};
+    command_list list;
+
+    // 320x240 16-bit color image, no Z updates
+    list.color_image(0x100000, 320, 2);
+    list.scissor(240);
+    list.other_modes(false);
+    list.fill_rectangle();
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+    if (g_rdram_dirty_untracked || !checked(0x100000, 320 * 2 * 240) || checked_pages() != 38)
+        return fail("color image");
+
+    // Z updates on: the Z image is drawn to as well
+    list.words.clear();
+    list.z_image(0x200000);
+    list.other_modes(true);
+    list.triangle();
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+    if (g_rdram_dirty_untracked || !checked(0x100000, 320 * 2 * 240) || !checked(0x200000, 320 * 2 * 240))
+        return fail("Z image");
+
+    // the triangle body is not taken for commands
+    list.words.clear();
+    list.fill_rectangle();
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+    if (g_rdram_dirty_untracked || checked(0x700000, 1))
+        return fail("triangle body");
+
+    // a 32-bit image and a smaller scissor box
+    list.words.clear();
+    list.color_image(0x300000, 640, 3);
+    list.scissor(10);
+    list.other_modes(false);
+    list.fill_rectangle();
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+    if (!checked(0x300000, 640 * 4 * 10) || checked(0x300000 + 640 * 4 * 12, 1))
+        return fail("scissor");
+
+    // nothing drawn, nothing checked
+    list.words.clear();
+    list.color_image(0x400000, 320, 2);
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+    if (g_rdram_dirty_untracked || checked_pages() != 0)
+        return fail("no draw");
+    return true;
+}
+
+static bool unknown()
+{
+    command_list list;
+
+    // after a state load nothing is known yet
+    {
+        rdp_images images = {};
+        list.fill_rectangle();
+        clear();
+        check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+        if (!g_rdram_dirty_untracked)
+            return fail("unknown color image");
+    }
+
+    // Z updates may be on but the Z image isn't known
+    {
+        rdp_images images = {};
+        list.words.clear();
+        list.color_image(0x100000, 320, 2);
+        list.scissor(240);
+        list.triangle();
+        clear();
+        check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+        if (!g_rdram_dirty_untracked)
+            return fail("unknown Z image");
+    }
+
+    // a list running backwards
+    {
+        rdp_images images = {};
+        clear();
+        check_rdp_images(&images, list.words.data(), 0x7fffff, 16, 8);
+        if (!g_rdram_dirty_untracked)
+            return fail("backwards list");
+    }
+    return true;
+}
+
+static bool cut_commands()
+{
+    rdp_images images = {};
+    command_list list;
+
+    list.color_image(0x100000, 320, 2);
+    list.scissor(240);
+    list.other_modes(false);
+    list.triangle();
+    list.color_image(0x500000, 320, 2);
+    list.fill_rectangle();
+
+    // DPC_END in the middle of the triangle, the rest comes with the next
+    // run, which starts where the previous one ended
+    uint32_t cut = 3 * 8 + 40;
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, cut);
+    if (!checked(0x100000, 1) || checked(0x700000, 1))
+        return fail("before the cut");
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, cut, list.size());
+    if (g_rdram_dirty_untracked || !checked(0x500000, 320 * 2 * 240) || checked(0x700000, 1))
+        return fail("after the cut");
+
+    // a plugin leaving DPC_CURRENT alone sends the same commands again
+    clear();
+    check_rdp_images(&images, list.words.data(), 0x7fffff, 0, list.size());
+    if (g_rdram_dirty_untracked || !checked(0x100000, 1) || !checked(0x500000, 1) || checked(0x700000, 1))
+        return fail("sent again");
+
+    // DMEM command lists wrap at 4KB
+    std::vector<uint32_t> dmem(0x1000 / 4);
+    list.words.clear();
+    list.color_image(0x600000, 320, 2);
+    list.fill_rectangle();
+    std::memcpy(&dmem[(0x1000 - 8) / 4], &list.words[0], 8);
+    std::memcpy(&dmem[0], &list.words[2], 8);
+    clear();
+    check_rdp_images(&images, dmem.data(), 0xfff, 0x1000 - 8, 0x1000 + 8);
+    if (g_rdram_dirty_untracked || !checked(0x600000, 1))
+        return fail("DMEM");
+    return true;
+}
+
+int main()
+{
+    if (!images() || !unknown() || !cut_commands())
+        return 1;
+    return 0;
+}
@@ -0,0 +1,405 @@
+extern "C" {
+#include "rsp.h"
+#include "rsp_external.h"
+#include "rsp_internal.h"
+}
+#define GOLDEN_RSP_STUBS
+#include "golden_util.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+// Runs hand-assembled scalar programs (ALU, branches, unaligned memory
+// accesses, DMA, waiting on the CPU) through the RSP LLE interpreter, checks
+// the vector unit against hand-computed results, then runs a fixed set of
+// pseudo-random vector unit programs, and compares a hash of the
+// whole RSP state against the output of the scalar code. Built with and
+// without RSP_NO_SIMD.
+static const uint64_t GOLDEN = UINT64_C(0x4c417ecebe8c2aa6);
+
+static xorshift32 rng{0x6b43a9b5};
+
+static std::vector<unsigned char> dram(0x100000);
+static std::vector<unsigned char> dmem(0x1000);
+static std::vector<unsigned char> imem(0x1000);
+
+static unsigned int mi_intr;
+static unsigned int sp_regs[9];
+static unsigned int sp_pc;
+static unsigned int dpc_regs[8];
+
+static rsp_t rsp;
+
+// instruction encoders
+static uint32_t i_type(unsigned op, unsigned rs, unsigned rt, uint32_t imm)
+{
+    return (op << 26) | (rs << 21) | (rt << 16) | (imm & 0xffff);
+}
+
+static uint32_t r_type(unsigned rs, unsigned rt, unsigned rd, unsigned sa, unsigned funct)
+{
+    return (rs << 21) | (rt << 16) | (rd << 11) | (sa << 6) | funct;
+}
+
+static uint32_t ori(unsigned rt, unsigned rs, uint32_t imm) { return i_type(0x0d, rs, rt, imm); }
+static uint32_t lui(unsigned rt, uint32_t imm) { return i_type(0x0f, 0, rt, imm); }
+static uint32_t addiu(unsigned rt, unsigned rs, uint32_t imm) { return i_type(0x09, rs, rt, imm); }
+static uint32_t bne(unsigned rs, unsigned rt, int off) { return i_type(0x05, rs, rt, static_cast<uint32_t>(off)); }
+static uint32_t beq(unsigned rs, unsigned rt, int off) { return i_type(0x04, rs, rt, static_cast<uint32_t>(off)); }
+static uint32_t mfc0(unsigned rt, unsigned rd) { return (0x10u << 26) | (rt << 16) | (rd << 11); }
+static uint32_t mtc0(unsigned rt, unsigned rd) { return (0x10u << 26) | (4u << 21) | (rt << 16) | (rd << 11); }
+static const uint32_t NOP = 0;
+static const uint32_t BREAK = 0x0d;
+
+static unsigned assemble(const std::vector<uint32_t>& program)
+{
+    for (size_t i = 0; i < program.size(); ++i)
+        *reinterpret_cast<uint32_t*>(&imem[4 * i]) = program[i];
+    return static_cast<unsigned>(program.size());
+}
+
+static void start(uint32_t pc)
+{
+    sp_pc = pc;
+    sp_regs[4] &= ~(SP_STATUS_HALT | SP_STATUS_BROKE);
+    rsp_execute(&rsp);
+}
+
+static void hash_state(golden_check& golden)
+{
+    const vu_t& vu = rsp.vu;
+    const vreg_t* flags[] = { &vu.acc_h, &vu.acc_m, &vu.acc_l, &vu.vco_c, &vu.vco_ne, &vu.vcc_lo, &vu.vcc_hi, &vu.vce };
+    static const char* flag_names[] = { "ACC_H", "ACC_M", "ACC_L", "VCO carry", "VCO ne", "VCC lo", "VCC hi", "VCE" };
+
+    golden.add("scalar registers", rsp.r, sizeof(rsp.r));
+    golden.add("vector registers", vu.vr, sizeof(vu.vr));
+    for (unsigned i = 0; i < 8; ++i)
+        golden.add(flag_names[i], flags[i]->u, sizeof(flags[i]->u));
+    golden.add("DIV_IN", &vu.div_in, sizeof(vu.div_in));
+    golden.add("DIV_OUT", &vu.div_out, sizeof(vu.div_out));
+    golden.add("DIV_DP", &vu.div_dp, sizeof(vu.div_dp));
+    golden.add("SP_PC", &sp_pc, sizeof(sp_pc));
+    golden.add("DMEM", dmem.data(), dmem.size());
+}
+
+static int failures;
+
+static void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::fprintf(stderr, "%s\n", what);
+        ++failures;
+    }
+}
+
+// sum 1..100 in a loop, unaligned halfword / word accesses and a call
+static void scalar_program()
+{
+    assemble({
+        ori(1, 0, 100),             // 0x00: r1 = 100
+        ori(2, 0, 0),               // 0x04: r2 = 0
+        r_type(2, 1, 2, 0, 0x21),   // 0x08: loop: r2 += r1
+        addiu(1, 1, 0xffff),        // 0x0c: r1 -= 1
+        bne(1, 0, -3),              // 0x10: bne r1, r0, loop
+        NOP,                        // 0x14
+        lui(3, 0x1234),             // 0x18
+        ori(3, 3, 0x5678),          // 0x1c: r3 = 0x12345678
+        i_type(0x2b, 0, 3, 0x101),  // 0x20: sw r3, 0x101(r0)
+        i_type(0x25, 0, 4, 0x102),  // 0x24: lhu r4, 0x102(r0)
+        i_type(0x20, 0, 5, 0x104),  // 0x28: lb r5, 0x104(r0)
+        i_type(0x03, 0, 0, 0x0c),   // 0x2c: jal 0x30
+        ori(6, 0, 7),               // 0x30: delay slot, then target
+        r_type(0, 3, 7, 4, 0x03),   // 0x34: sra r7, r3, 4
+        BREAK,
+    });
+
+    start(0);
+
+    check(rsp.r[2] == 5050, "loop sum");
+    check(rsp.r[4] == 0x3456, "unaligned lhu");
+    check(rsp.r[5] == 0x78, "unaligned lb");
+    check(rsp.r[31] == 0x34, "jal link");
+    check(rsp.r[6] == 7 && rsp.r[7] == 0x01234567, "jal delay slot");
+    check((sp_regs[4] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == (SP_STATUS_HALT | SP_STATUS_BROKE), "break status");
+}
+
+// DMA 64 bytes from DRAM, add one to every word and DMA them back elsewhere
+static void dma_program()
+{
+    for (uint32_t i = 0; i < 16; ++i)
+        *reinterpret_cast<uint32_t*>(&dram[0x2000 + 4 * i]) = 0x1000 * i;
+
+    assemble({
+        ori(1, 0, 0x200), mtc0(1, 0),       // mem addr
+        ori(1, 0, 0x2000), mtc0(1, 1),      // dram addr
+        ori(1, 0, 63), mtc0(1, 2),          // read 64 bytes
+        ori(2, 0, 0x200),
+        ori(3, 0, 0x240),
+        i_type(0x23, 2, 4, 0),              // loop: lw r4, 0(r2)
+        addiu(4, 4, 1),
+        i_type(0x2b, 2, 4, 0),              // sw r4, 0(r2)
+        addiu(2, 2, 4),
+        bne(2, 3, -5),
+        NOP,
+        ori(1, 0, 0x200), mtc0(1, 0),
+        ori(1, 0, 0x3000), mtc0(1, 1),
+        ori(1, 0, 63), mtc0(1, 3),          // write 64 bytes
+        BREAK,
+    });
+
+    std::memset(rsp.dram_written, 0, sizeof(rsp.dram_written));
+    start(0);
+
+    bool ok = true;
+    for (uint32_t i = 0; i < 16; ++i)
+        ok = ok && *reinterpret_cast<uint32_t*>(&dram[0x3000 + 4 * i]) == 0x1000 * i + 1;
+    check(ok, "dma round trip");
+    check(sp_regs[0] == 0x240 && sp_regs[1] == 0x3040, "dma addresses");
+
+    // only the page written back is reported to the savestate checkpoints
+    bool others_clean = true;
+    for (size_t i = 1; i < sizeof(rsp.dram_written) / sizeof(rsp.dram_written[0]); ++i)
+        others_clean = others_clean && rsp.dram_written[i] == 0;
+    check(rsp.dram_written[0] == (1u << 3) && others_clean, "dma written pages");
+}
+
+// spin on signal 0 until the CPU sets it, then resume
+static void wait_program()
+{
+    assemble({
+        mfc0(1, 4),                         // 0x00: wait: r1 = SP_STATUS
+        i_type(0x0c, 1, 1, 0x80),           // 0x04: andi r1, r1, SIG0
+        beq(1, 0, -3),                      // 0x08
+        NOP,
+        ori(2, 0, 0x200), mtc0(2, 4),       // clear signal 0
+        BREAK,
+    });
+
+    start(0);
+    check(rsp.waiting && sp_pc == 0 && !(sp_regs[4] & SP_STATUS_HALT), "wait for cpu");
+
+    sp_regs[4] |= 0x80;
+    rsp_execute(&rsp);
+    check(!rsp.waiting && (sp_regs[4] & SP_STATUS_BROKE) && !(sp_regs[4] & 0x80), "resume after wait");
+}
+
+static void vmulf_program()
+{
+    for (unsigned i = 0; i < 8; ++i)
+        rsp.vu.vr[1].e[i] = rsp.vu.vr[2].e[i] = 0x4000;
+
+    assemble({ 0x4a0208c0 /* vmulf v3, v1, v2 */, BREAK });
+    start(0);
+
+    check(rsp.vu.vr[3].e[0] == 0x2000 && rsp.vu.vr[3].e[7] == 0x2000, "vmulf");
+}
+
+static uint32_t vop(unsigned funct, unsigned vd, unsigned vs, unsigned vt, unsigned e)
+{
+    return 0x4a000000 | (e << 21) | (vt << 16) | (vs << 11) | (vd << 6) | funct;
+}
+
+static void set_lanes(vreg_t& v, std::initializer_list<int> lanes)
+{
+    unsigned i = 0;
+    for (int lane : lanes)
+        v.u[i++] = static_cast<uint16_t>(lane);
+}
+
+static bool lanes_are(const vreg_t& v, std::initializer_list<int> lanes)
+{
+    unsigned i = 0;
+    for (int lane : lanes)
+        if (v.u[i++] != static_cast<uint16_t>(lane))
+            return false;
+    return true;
+}
+
+static void clear_acc(vu_t& vu)
+{
+    set_lanes(vu.acc_h, { 0, 0, 0, 0, 0, 0, 0, 0 });
+    set_lanes(vu.acc_m, { 0, 0, 0, 0, 0, 0, 0, 0 });
+    set_lanes(vu.acc_l, { 0, 0, 0, 0, 0, 0, 0, 0 });
+}
+
+// accumulator clamping of VMACU / VMADL / VMADN, the VCH / VCL / VCR flags
+// and the VRCP / VRSQ edge inputs, against values worked out by hand. The
+// vector unit state is restored afterwards so the hash below is unaffected.
+static void vu_known_answers()
+{
+    const vu_t saved = rsp.vu;
+    vu_t& vu = rsp.vu;
+
+    // VMACU: acc += s * t * 2, then 0 when negative, 0xffff when bits 47..31
+    // are not all clear, the middle slice otherwise
+    clear_acc(vu);
+    set_lanes(vu.acc_h, { 0, 0, 0, 0xffff, 0, 0, 0, 0 });
+    set_lanes(vu.acc_m, { 0, 0, 0x7000, 0xffff, 0, 0, 0, 0 });
+    set_lanes(vu.vr[1], { 0x4000, 0x4000, 0x4000, 0x0001, 0, 0, 0, 0 });
+    set_lanes(vu.vr[2], { 0x4000, 0xc000, 0x4000, 0x4000, 0, 0, 0, 0 });
+    vu_execute(&vu, vop(0x09, 3, 1, 2, 0));
+    check(lanes_are(vu.vr[3], { 0x2000, 0, 0xffff, 0, 0, 0, 0, 0 }), "vmacu clamp");
+    check(lanes_are(vu.acc_m, { 0x2000, 0xe000, 0x9000, 0xffff, 0, 0, 0, 0 })
+          && lanes_are(vu.acc_l, { 0, 0, 0, 0x8000, 0, 0, 0, 0 }), "vmacu accumulator");
+
+    // VMADL: acc += (unsigned s * unsigned t) >> 16, then the low slice when
+    // bits 47..16 fit 16 bits, 0 or 0xffff by sign otherwise
+    clear_acc(vu);
+    set_lanes(vu.acc_h, { 0, 0, 0xffff, 0xffff, 0, 0, 0, 0 });
+    set_lanes(vu.acc_m, { 0, 0x7fff, 0x7fff, 0xffff, 0, 0, 0, 0 });
+    set_lanes(vu.acc_l, { 0, 0xffff, 0, 0x1234, 0, 0, 0, 0 });
+    set_lanes(vu.vr[1], { 0xffff, 0x0100, 0, 0, 0, 0, 0, 0 });
+    set_lanes(vu.vr[2], { 0xffff, 0x0100, 0, 0, 0, 0, 0, 0 });
+    vu_execute(&vu, vop(0x0c, 3, 1, 2, 0));
+    check(lanes_are(vu.vr[3], { 0xfffe, 0xffff, 0, 0x1234, 0, 0, 0, 0 }), "vmadl clamp");
+    check(lanes_are(vu.acc_m, { 0, 0x8000, 0x7fff, 0xffff, 0, 0, 0, 0 }), "vmadl accumulator");
+
+    // VMADN: acc += unsigned s * signed t, clamped as VMADL
+    clear_acc(vu);
+    set_lanes(vu.acc_h, { 0, 0, 0, 0, 0xffff, 0, 0, 0 });
+    set_lanes(vu.acc_m, { 0, 0, 0, 0x7fff, 0x8000, 0, 0, 0 });
+    set_lanes(vu.acc_l, { 0, 0, 0, 0xffff, 0, 0, 0, 0 });
+    set_lanes(vu.vr[1], { 0xffff, 0x8000, 0xffff, 0x0001, 0x0001, 0, 0, 0 });
+    set_lanes(vu.vr[2], { 0x0002, 0xffff, 0x7fff, 0x0001, 0xffff, 0, 0, 0 });
+    vu_execute(&vu, vop(0x0e, 3, 1, 2, 0));
+    check(lanes_are(vu.vr[3], { 0xfffe, 0x8000, 0x8001, 0xffff, 0, 0, 0, 0 }), "vmadn clamp");
+    check(lanes_are(vu.acc_h, { 0, 0xffff, 0, 0, 0xffff, 0, 0, 0 })
+          && lanes_are(vu.acc_m, { 0x0001, 0xffff, 0x7ffe, 0x8000, 0x7fff, 0, 0, 0 }), "vmadn accumulator");
+
+    // VCH: same signs clip against t, opposite signs against -t
+    set_lanes(vu.vr[1], { 5, 2, 3, -5, -4, -2, 4, 2 });
+    set_lanes(vu.vr[2], { 3, 3, 3, 3, 3, 3, -3, -3 });
+    vu_execute(&vu, vop(0x25, 3, 1, 2, 0));
+    check(lanes_are(vu.vr[3], { 3, 2, 3, -3, -3, -2, 4, 3 }), "vch result");
+    check((vu_cfc2(&vu, 0u << 11) & 0xffff) == 0x6bf8, "vch vco");
+    check((vu_cfc2(&vu, 1u << 11) & 0xffff) == 0xc598, "vch vcc");
+    check(vu_cfc2(&vu, 2u << 11) == 0x90, "vch vce");
+
+    // VCL: lanes with VCO.ne set keep their VCC bit, the others compare
+    // unsigned, using VCE on carry lanes
+    vu_ctc2(&vu, 0u << 11, 0xc80f);
+    vu_ctc2(&vu, 1u << 11, 0x8228);
+    vu_ctc2(&vu, 2u << 11, 0x06);
+    set_lanes(vu.vr[1], { 0xfff0, 0x0005, 0xfff0, 0x1234, 0x8000, 0x0001, 0x4444, 0x3333 });
+    set_lanes(vu.vr[2], { 0x0010, 0x0003, 0x0020, 0x0007, 0x7fff, 0xffff, 0x1111, 0x2222 });
+    vu_execute(&vu, vop(0x24, 3, 1, 2, 0));
+    check(lanes_are(vu.vr[3], { 0xfff0, 0xfffd, 0xfff0, 0xfff9, 0x7fff, 0x0001, 0x4444, 0x2222 }), "vcl result");
+    check((vu_cfc2(&vu, 1u << 11) & 0xffff) == 0x922a, "vcl vcc");
+    check(vu_cfc2(&vu, 0u << 11) == 0 && vu_cfc2(&vu, 2u << 11) == 0, "vcl clears vco and vce");
+
+    // VCR: ones' complement clip, always clearing VCO and VCE
+    vu_ctc2(&vu, 0u << 11, 0xffff);
+    vu_ctc2(&vu, 2u << 11, 0xff);
+    set_lanes(vu.vr[1], { 5, 2, -2, -5, -4, -6, 4, 1 });
+    set_lanes(vu.vr[2], { 3, 3, -3, 3, 4, 5, -3, -3 });
+    vu_execute(&vu, vop(0x26, 3, 1, 2, 0));
+    check(lanes_are(vu.vr[3], { 3, 2, -3, 0xfffc, -4, 0xfffa, 4, 2 }), "vcr result");
+    check((vu_cfc2(&vu, 1u << 11) & 0xffff) == 0xc5ac, "vcr vcc");
+    check(vu_cfc2(&vu, 0u << 11) == 0 && vu_cfc2(&vu, 2u << 11) == 0, "vcr clears vco and vce");
+
+    // VRCP / VRSQ: the result's low half goes to the lane, the high half to
+    // DIV_OUT, read back by VRCPH / VRSQH
+    struct { unsigned funct; int in; uint16_t lane, high; const char* what; } divides[] = {
+        { 0x30, 0, 0xffff, 0x7fff, "vrcp 0" },
+        { 0x30, -0x8000, 0x0000, 0xffff, "vrcp 0x8000" },
+        { 0x30, 1, 0xc000, 0x7fff, "vrcp 1" },
+        { 0x30, 2, 0xe000, 0x3fff, "vrcp 2" },
+        { 0x30, -1, 0x3fff, 0x8000, "vrcp -1" },
+        { 0x34, 0, 0xffff, 0x7fff, "vrsq 0" },
+        { 0x34, -0x8000, 0x0000, 0xffff, "vrsq 0x8000" },
+        { 0x34, 1, 0xc000, 0x7fff, "vrsq 1" },
+        { 0x34, 4, 0xe000, 0x3fff, "vrsq 4" },
+    };
+    for (const auto& d : divides)
+    {
+        vu.vr[2].u[5] = static_cast<uint16_t>(d.in);
+        vu_execute(&vu, vop(d.funct, 3, 2, 2, 8 | 5));
+        vu_execute(&vu, vop(d.funct + 2, 4, 6, 0, 0));
+        check(vu.vr[3].u[2] == d.lane && vu.vr[4].u[6] == d.high, d.what);
+    }
+
+    // double precision: VRCPH loads the high half, VRCPL divides 0x10000
+    vu.vr[2].u[0] = 1;
+    vu.vr[2].u[1] = 0;
+    vu_execute(&vu, vop(0x32, 3, 0, 2, 8 | 0));
+    vu_execute(&vu, vop(0x31, 3, 1, 2, 8 | 1));
+    vu_execute(&vu, vop(0x32, 4, 1, 0, 0));
+    check(vu.vr[3].u[1] == 0x7fff && vu.vr[4].u[1] == 0, "vrcpl 0x10000");
+
+    rsp.vu = saved;
+}
+
+// a random stream of computational, move and load / store instructions
+static void vector_program()
+{
+    std::vector<uint32_t> program;
+
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        unsigned kind = rng() % 16;
+        unsigned vt = rng() % 32, vs = rng() % 32, vd = rng() % 32, e = rng() % 16;
+
+        if (kind < 10)
+            program.push_back(0x4a000000 | (e << 21) | (vt << 16) | (vs << 11) | (vd << 6) | (rng() % 64));
+        else if (kind < 14)
+        {
+            // base register pointing anywhere in DMEM, then a load or a store
+            program.push_back(ori(1, 0, rng() & 0xfff));
+            program.push_back(((kind < 12 ? 0x32u : 0x3au) << 26) | (1u << 21) | (vt << 16) | ((rng() % 12) << 11)
+                              | ((rng() % 16) << 7) | (rng() & 0x7f));
+        }
+        else
+        {
+            static const uint32_t moves[] = { 0x48000000, 0x48800000, 0x48400000, 0x48c00000 };
+            uint32_t op = moves[rng() % 4];
+            unsigned rt = 2 + rng() % 4;
+
+            if (op == 0x48400000 || op == 0x48c00000)
+                vs = rng() % 3;
+            if (op == 0x48800000 || op == 0x48c00000)
+                program.push_back(ori(rt, 0, rng() & 0xffff));
+            program.push_back(op | (rt << 16) | (vs << 11) | ((rng() % 16) << 7));
+        }
+    }
+    program.push_back(BREAK);
+
+    assemble(program);
+    start(0);
+}
+
+int main(int argc, char* argv[]) {
+    golden_check golden("rsp lle", GOLDEN, argc, argv);
+
+    sp_regs[4] = SP_STATUS_HALT;
+
+    rsp_init(&rsp, dram.data(), dmem.data(), imem.data(), &mi_intr,
+             &sp_regs[0], &sp_regs[1], &sp_regs[2], &sp_regs[3], &sp_regs[4],
+             &sp_regs[5], &sp_regs[6], &sp_pc, &sp_regs[7],
+             &dpc_regs[0], &dpc_regs[1], &dpc_regs[2], &dpc_regs[3],
+             &dpc_regs[4], &dpc_regs[5], &dpc_regs[6], &dpc_regs[7], nullptr);
+
+    scalar_program();
+    dma_program();
+    wait_program();
+    vmulf_program();
+    vu_known_answers();
+
+    for (size_t i = 0; i < dmem.size(); i += 4)
+        *reinterpret_cast<uint32_t*>(&dmem[i]) = rng();
+    for (vreg_t& v : rsp.vu.vr)
+        for (auto& lane : v.u)
+            lane = static_cast<uint16_t>(rng());
+
+    for (int program = 0; program < 400; ++program)
+    {
+        vector_program();
+        hash_state(golden);
+        golden.next_round();
+    }
+
+    return golden.finish() != 0 || failures != 0;
+}
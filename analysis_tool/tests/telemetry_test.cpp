@@ -0,0 +1,49 @@
+#include "analysis_window.h"
+#include <SDL.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Fake core: the first drain returns a full batch so the window has to keep
+// draining within the same iteration, later drains return a few VIs.
+static std::atomic<int> drainCalls{0};
+static std::atomic<bool> badParam{false};
+static uint64_t fakeTime = 0;
+
+static m64p_error fake_core(m64p_command cmd, int paramInt, void* paramPtr)
+{
+    if (cmd != M64CMD_TELEMETRY_DRAIN)
+        return M64ERR_SUCCESS;
+    if (paramInt != sizeof(m64p_telemetry_drain) || paramPtr == nullptr)
+    {
+        badParam = true;
+        return M64ERR_INPUT_INVALID;
+    }
+
+    auto* drain = static_cast<m64p_telemetry_drain*>(paramPtr);
+    unsigned int n = (drainCalls.fetch_add(1) == 0) ? drain->capacity : 3;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        fakeTime += 16666667;
+        drain->events[i] = m64p_telemetry_event{fakeTime, M64TELEM_VI, 0, 0, 0};
+    }
+    drain->count = n;
+    drain->dropped = 1;
+    return M64ERR_SUCCESS;
+}
+
+int main() {
+    setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+        return 1;
+
+    analysis_window_start(fake_core);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    analysis_window_stop();
+    SDL_Quit();
+
+    if (badParam || drainCalls < 2)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+extern "C" {
+#include "device/device.h"
+#include "device/r4300/cached_interp.h"
+#include "device/r4300/r4300_core.h"
+#include "device/r4300/recomp_types.h"
+}
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Runs a loop covering every fused pair of the threaded-dispatch mode (LUI+ADDIU,
+// LUI+ORI, LW+BEQ, LW+BNE, ADDIU+BNE) through the plain cached interpreter and
+// the threaded one, and checks that both end with the same registers after
+// executing the same number of instructions.
+
+struct device g_dev;
+
+static uint32_t ram[0x40000]; // 1MB mirrored at 0x80000000
+static uint32_t cp0_regs[32];
+static int cycle_count;
+static long executed;
+
+static const int LOOPS = 100000;
+
+extern "C" {
+void DebugMessage(int, const char* message, ...)
+{
+    va_list ap;
+    va_start(ap, message);
+    std::vfprintf(stderr, message, ap);
+    va_end(ap);
+    std::fputc('\n', stderr);
+}
+
+uint32_t* r4300_cp0_regs(struct cp0*) { return cp0_regs; }
+int* r4300_cp0_cycle_count(struct cp0*) { return &cycle_count; }
+
+void cp0_update_count(struct r4300_core* r4300)
+{
+    uint32_t n = (*r4300_pc(r4300) - r4300->cp0.last_addr) / 4;
+    cycle_count += static_cast<int>(n);
+    executed += n;
+    r4300->cp0.last_addr = *r4300_pc(r4300);
+}
+
+// the test program never reaches these
+void exception_general(struct r4300_core*) { std::abort(); }
+uint32_t virtual_to_physical_address(struct r4300_core*, uint32_t, int) { std::abort(); }
+int check_cop1_unusable(struct r4300_core*) { return 0; }
+int check_cop2_unusable(struct r4300_core*) { std::abort(); }
+void add_interrupt_event_count(struct cp0*, int, unsigned int) { std::abort(); }
+void remove_event(struct interrupt_queue*, int) { std::abort(); }
+void translate_event_queue(struct cp0*, unsigned int) { std::abort(); }
+void r4300_check_interrupt(struct r4300_core*, uint32_t, int) { std::abort(); }
+uint64_t* r4300_cp0_latch(struct cp0*) { std::abort(); }
+uint64_t* r4300_cp2_latch(struct cp2*) { std::abort(); }
+uint32_t* r4300_cp1_fcr0(struct cp1*) { std::abort(); }
+uint32_t* r4300_cp1_fcr31(struct cp1*) { std::abort(); }
+double** r4300_cp1_regs_double(struct cp1*) { std::abort(); }
+float** r4300_cp1_regs_simple(struct cp1*) { std::abort(); }
+void set_fpr_pointers(struct cp1*, uint32_t) { std::abort(); }
+void update_x86_rounding_mode(struct cp1*) { std::abort(); }
+int r4300_read_aligned_dword(struct r4300_core*, uint32_t, uint64_t*) { std::abort(); }
+int r4300_write_aligned_dword(struct r4300_core*, uint32_t, uint64_t, uint64_t) { std::abort(); }
+int64_t* r4300_mult_hi(struct r4300_core*) { std::abort(); }
+int64_t* r4300_mult_lo(struct r4300_core*) { std::abort(); }
+void tlb_map(struct tlb*, size_t) { std::abort(); }
+void tlb_unmap(struct tlb*, size_t) { std::abort(); }
+
+// the first count interrupt ends the run
+void gen_interrupt(struct r4300_core* r4300) { r4300->stop = 1; }
+void generic_jump_to(struct r4300_core* r4300, unsigned int address) { cached_interpreter_jump_to(r4300, address); }
+
+uint32_t* fast_mem_access(struct r4300_core*, uint32_t address) { return &ram[(address & 0xfffff) / 4]; }
+
+int r4300_read_aligned_word(struct r4300_core*, uint32_t address, uint32_t* value)
+{
+    *value = ram[(address & 0xfffff) / 4];
+    return 1;
+}
+
+int r4300_write_aligned_word(struct r4300_core*, uint32_t address, uint32_t value, uint32_t mask)
+{
+    uint32_t* p = &ram[(address & 0xfffff) / 4];
+    *p = (*p & ~mask) | (value & mask);
+    return 1;
+}
+
+int64_t* r4300_regs(struct r4300_core* r4300) { return r4300->regs; }
+uint32_t* r4300_pc(struct r4300_core* r4300) { return &r4300->pc->addr; }
+struct precomp_instr** r4300_pc_struct(struct r4300_core* r4300) { return &r4300->pc; }
+int* r4300_stop(struct r4300_core* r4300) { return &r4300->stop; }
+}
+
+static uint32_t i_type(uint32_t op, uint32_t rs, uint32_t rt, int32_t imm)
+{
+    return (op << 26) | (rs << 21) | (rt << 16) | (static_cast<uint32_t>(imm) & 0xffff);
+}
+
+static uint32_t r_type(uint32_t rs, uint32_t rt, uint32_t rd, uint32_t sa, uint32_t funct)
+{
+    return (rs << 21) | (rt << 16) | (rd << 11) | (sa << 6) | funct;
+}
+
+enum { T0 = 8, T1, T2, T3, T4, T5 };
+
+// sums a table through LW+BEQ (zero entries skip the xor), mixes in a
+// LUI+ADDIU constant, loops with ADDIU+BNE and leaves through LW+BNE / J
+static int assemble()
+{
+    uint32_t p[64];
+    int n = 0;
+
+    p[n++] = i_type(0x0f, 0, T0, 0x8000);                  // lui t0, 0x8000
+    p[n++] = i_type(0x0d, T0, T0, 0x1000);                 // ori t0, t0, 0x1000
+    p[n++] = i_type(0x0f, 0, T1, LOOPS >> 16);             // lui t1, hi(LOOPS)
+    p[n++] = i_type(0x0d, T1, T1, LOOPS & 0xffff);         // ori t1, t1, lo(LOOPS)
+    p[n++] = i_type(0x09, 0, T2, 0);                       // addiu t2, r0, 0
+    const int loop = n;
+    p[n++] = i_type(0x23, T0, T3, 0);                      // loop: lw t3, 0(t0)
+    const int skip_branch = n++;                           // beq t3, r0, skip
+    p[n++] = i_type(0x09, T0, T0, 4);                      // addiu t0, t0, 4 (delay slot)
+    p[n++] = r_type(T2, T3, T2, 0, 0x21);                  // addu t2, t2, t3
+    const int skip = n;
+    p[n++] = i_type(0x0f, 0, T4, 0x1234);                  // skip: lui t4, 0x1234
+    p[n++] = i_type(0x09, T4, T4, 0x5678);                 // addiu t4, t4, 0x5678
+    p[n++] = r_type(T2, T4, T2, 0, 0x26);                  // xor t2, t2, t4
+    p[n++] = r_type(0, T2, T2, 1, 0x00);                   // sll t2, t2, 1
+    p[n++] = i_type(0x09, T1, T1, -1);                     // addiu t1, t1, -1
+    p[n] = i_type(0x05, T1, 0, loop - (n + 1)); ++n;       // bne t1, r0, loop
+    p[n++] = 0;
+    p[n++] = i_type(0x23, T0, T5, 0);                      // lw t5, 0(t0)
+    const int exit_branch = n++;                           // bne t5, r0, end
+    p[n++] = 0;
+    const int end = n;
+    p[n++] = (0x02u << 26) | (((0x80000000u + end * 4) >> 2) & 0x3ffffff); // end: j end
+    p[n++] = 0;
+
+    p[skip_branch] = i_type(0x04, T3, 0, skip - (skip_branch + 1));
+    p[exit_branch] = i_type(0x05, T5, 0, end - (exit_branch + 1));
+
+    std::memcpy(ram, p, n * sizeof(p[0]));
+    for (int i = 0; i < 0x100; ++i)
+        ram[0x1000 / 4 + i] = (i % 7 == 0) ? 0 : i * 0x01010101u;
+    return n;
+}
+
+static long run(unsigned int emumode, int64_t regs[32])
+{
+    struct r4300_core* r4300 = &g_dev.r4300;
+
+    std::memset(ram, 0, sizeof(ram));
+    assemble();
+
+    std::memset(r4300, 0, sizeof(*r4300));
+    r4300->emumode = emumode;
+    r4300->cached_interp.fin_block = cached_interp_FIN_BLOCK;
+    r4300->cached_interp.not_compiled = cached_interp_NOTCOMPILED;
+    r4300->cached_interp.not_compiled2 = cached_interp_NOTCOMPILED2;
+    r4300->cached_interp.init_block = cached_interp_init_block;
+    r4300->cached_interp.free_block = cached_interp_free_block;
+    r4300->cached_interp.recompile_block = cached_interp_recompile_block;
+
+    init_blocks(&r4300->cached_interp);
+    cached_interpreter_jump_to(r4300, 0x80000000);
+    r4300->cp0.last_addr = 0x80000000;
+    cycle_count = -0x7fffffff;
+    executed = 0;
+
+    run_cached_interpreter(r4300);
+
+    std::memcpy(regs, r4300->regs, sizeof(r4300->regs));
+    free_blocks(&r4300->cached_interp);
+    return executed;
+}
+
+int main() {
+    int64_t cached[32], threaded[32];
+
+    if (!cached_interp_threaded_init())
+    {
+        std::fprintf(stderr, "threaded dispatch not available in this build\n");
+        return 0;
+    }
+
+    long cached_count = run(EMUMODE_INTERPRETER, cached);
+    long threaded_count = run(EMUMODE_THREADED_INTERPRETER, threaded);
+
+    int failures = 0;
+    for (int i = 0; i < 32; ++i)
+    {
+        if (cached[i] != threaded[i])
+        {
+            std::fprintf(stderr, "r%d: cached %016llx, threaded %016llx\n", i,
+                         static_cast<unsigned long long>(cached[i]), static_cast<unsigned long long>(threaded[i]));
+            ++failures;
+        }
+    }
+
+    if (cached_count != threaded_count || cached_count < 10L * LOOPS)
+    {
+        std::fprintf(stderr, "executed %ld instructions cached, %ld threaded\n", cached_count, threaded_count);
+        ++failures;
+    }
+
+    return failures != 0;
+}
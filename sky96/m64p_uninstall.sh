@@ -28,7 +28,7 @@ if [ -z "$MAKE" ]; then
 fi
 
 if [ -z "$M64P_COMPONENTS" ]; then
-	M64P_COMPONENTS="core rom ui-console audio-sdl input-sdl rsp-hle video-rice video-glide64mk2"
+	M64P_COMPONENTS="core rom ui-console audio-sdl input-sdl rsp-hle rsp-lle video-rice video-glide64mk2"
 fi
 
 for component in ${M64P_COMPONENTS}; do
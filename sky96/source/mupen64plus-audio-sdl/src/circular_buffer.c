@@ -23,12 +23,61 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #include "circular_buffer.h"
 
+/* Indices are published with release stores and read with acquire loads,
+ * so that the bytes behind an index are visible before the index itself. */
+#if defined(_MSC_VER)
+#if defined(_M_ARM) || defined(_M_ARM64)
+#define CBUFF_FENCE() __dmb(0xB) /* _ARM_BARRIER_ISH */
+#else
+/* x86 loads have acquire and stores have release semantics */
+#define CBUFF_FENCE() _ReadWriteBarrier()
+#endif
+
+static uint32_t load_acquire(const uint32_t* p)
+{
+    uint32_t v = *(const volatile uint32_t*)p;
+    CBUFF_FENCE();
+    return v;
+}
+
+static void store_release(uint32_t* p, uint32_t v)
+{
+    CBUFF_FENCE();
+    *(volatile uint32_t*)p = v;
+}
+#else
+static uint32_t load_acquire(const uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store_release(uint32_t* p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+#endif
+
+static size_t round_up_pot(size_t capacity)
+{
+    size_t size = 16;
+
+    while (size < capacity)
+        size <<= 1;
+
+    return size;
+}
+
 
 int init_cbuff(struct circular_buffer* cbuff, size_t capacity)
 {
-    void* data = malloc(capacity);
+    size_t size = round_up_pot(capacity);
+    void* data = calloc(2, size);
 
     if (data == NULL)
     {
@@ -36,8 +85,46 @@ int init_cbuff(struct circular_buffer* cbuff, size_t capacity)
     }
 
     cbuff->data = data;
-    cbuff->size = capacity;
+    cbuff->size = size;
     cbuff->head = 0;
+    cbuff->tail = 0;
+
+    return 0;
+}
+
+int resize_cbuff(struct circular_buffer* cbuff, size_t capacity)
+{
+    size_t size = round_up_pot(capacity);
+    size_t fill;
+    const void* src;
+    unsigned char* data;
+
+    if (cbuff->data == NULL)
+    {
+        return init_cbuff(cbuff, capacity);
+    }
+
+    /* only grows the buffer */
+    if (size <= cbuff->size)
+    {
+        return 0;
+    }
+
+    data = calloc(2, size);
+    if (data == NULL)
+    {
+        return -1;
+    }
+
+    src = cbuff_tail(cbuff, &fill);
+    memcpy(data, src, fill);
+    memcpy(data + size, src, fill);
+
+    free(cbuff->data);
+    cbuff->data = data;
+    cbuff->size = size;
+    cbuff->head = (uint32_t)fill;
+    cbuff->tail = 0;
 
     return 0;
 }
@@ -51,33 +138,55 @@ void release_cbuff(struct circular_buffer* cbuff)
 
 void* cbuff_head(const struct circular_buffer* cbuff, size_t* available)
 {
-    assert(cbuff->head <= cbuff->size);
+    uint32_t head = load_acquire(&cbuff->head);
+    uint32_t fill = head - load_acquire(&cbuff->tail);
+
+    assert(fill <= cbuff->size);
 
-    *available = cbuff->size - cbuff->head;
-    return (unsigned char*)cbuff->data + cbuff->head;
+    *available = cbuff->size - fill;
+    return (unsigned char*)cbuff->data + (head & (cbuff->size - 1));
 }
 
 
 void* cbuff_tail(const struct circular_buffer* cbuff, size_t* available)
 {
-    *available = cbuff->head;
-    return cbuff->data;
+    uint32_t tail = load_acquire(&cbuff->tail);
+
+    *available = load_acquire(&cbuff->head) - tail;
+    return (unsigned char*)cbuff->data + (tail & (cbuff->size - 1));
 }
 
 
 void produce_cbuff_data(struct circular_buffer* cbuff, size_t amount)
 {
-    assert(cbuff->head + amount <= cbuff->size);
+    unsigned char* data = (unsigned char*)cbuff->data;
+    size_t pos = cbuff->head & (cbuff->size - 1);
+    size_t available;
 
-    cbuff->head += amount;
+    cbuff_head(cbuff, &available);
+    assert(amount <= available);
+
+    /* mirror what was written, the part past the end goes to the start */
+    if (pos + amount <= cbuff->size)
+    {
+        memcpy(data + pos + cbuff->size, data + pos, amount);
+    }
+    else
+    {
+        memcpy(data + pos + cbuff->size, data + pos, cbuff->size - pos);
+        memcpy(data, data + cbuff->size, pos + amount - cbuff->size);
+    }
+
+    store_release(&cbuff->head, cbuff->head + (uint32_t)amount);
 }
 
 
 void consume_cbuff_data(struct circular_buffer* cbuff, size_t amount)
 {
-    assert(cbuff->head >= amount);
+    size_t available;
 
-    memmove(cbuff->data, (unsigned char*)cbuff->data + amount, cbuff->head - amount);
-    cbuff->head -= amount;
-}
+    cbuff_tail(cbuff, &available);
+    assert(amount <= available);
 
+    store_release(&cbuff->tail, cbuff->tail + (uint32_t)amount);
+}
@@ -23,24 +23,40 @@
 #define M64P_CIRCULAR_BUFFER_H
 
 #include <stddef.h>
-
+#include <stdint.h>
+
+/* Single producer, single consumer byte ring. The producer and the consumer
+ * may run on different threads without locking, as each index is only
+ * written by its own side.
+ *
+ * The storage is followed by a mirror of itself, which the producer keeps
+ * up to date, so both the free and the filled parts can always be accessed
+ * as a single contiguous span. */
 struct circular_buffer
 {
     void* data;
-    size_t size;
-    size_t head;
+    size_t size;        /* a power of two, data holds twice as much */
+    uint32_t head;      /* bytes produced so far, wraps around */
+    uint32_t tail;      /* bytes consumed so far, wraps around */
 };
 
+/* capacity is rounded up to a power of two */
 int init_cbuff(struct circular_buffer* cbuff, size_t capacity);
 
+/* Grows the buffer, keeping its contents. Neither side may access the
+ * buffer meanwhile. */
+int resize_cbuff(struct circular_buffer* cbuff, size_t capacity);
+
 void release_cbuff(struct circular_buffer* cbuff);
 
+/* producer side */
 void* cbuff_head(const struct circular_buffer* cbuff, size_t* available);
 
-void* cbuff_tail(const struct circular_buffer* cbuff, size_t* available);
-
 void produce_cbuff_data(struct circular_buffer* cbuff, size_t amount);
 
+/* consumer side, available is the fill level and may be read by either side */
+void* cbuff_tail(const struct circular_buffer* cbuff, size_t* available);
+
 void consume_cbuff_data(struct circular_buffer* cbuff, size_t amount);
 
 #endif
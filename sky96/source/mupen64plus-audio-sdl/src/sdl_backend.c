@@ -149,10 +149,11 @@ static void resize_primary_buffer(struct sdl_backend* sdl_backend, size_t new_si
 {
     /* only grows the buffer */
     if (new_size > sdl_backend->primary_buffer.size) {
+        /* the audio callback is the consumer, keep it out while the data moves */
         SDL_LockAudio();
-        sdl_backend->primary_buffer.data = realloc(sdl_backend->primary_buffer.data, new_size);
-        memset((unsigned char*)sdl_backend->primary_buffer.data + sdl_backend->primary_buffer.size, 0, new_size - sdl_backend->primary_buffer.size);
-        sdl_backend->primary_buffer.size = new_size;
+        if (resize_cbuff(&sdl_backend->primary_buffer, new_size) != 0) {
+            DebugMessage(M64MSG_ERROR, "Couldn't grow primary buffer to %zu bytes.", new_size);
+        }
         SDL_UnlockAudio();
     }
 }
@@ -370,8 +371,7 @@ void sdl_push_samples(struct sdl_backend* sdl_backend, const void* src, size_t s
     }
     size = (size / 4) * 4;
 
-    /* We need to lock audio before accessing cbuff */
-    SDL_LockAudio();
+    /* The audio callback only consumes, so pushing needs no lock */
     unsigned char* dst = cbuff_head(&sdl_backend->primary_buffer, &available);
     if (size <= available)
     {
@@ -400,7 +400,6 @@ void sdl_push_samples(struct sdl_backend* sdl_backend, const void* src, size_t s
 
         produce_cbuff_data(&sdl_backend->primary_buffer, size);
     }
-    SDL_UnlockAudio();
 
     if (size > available)
     {
@@ -414,7 +413,7 @@ static size_t estimate_level_at_next_audio_cb(struct sdl_backend* sdl_backend)
     size_t available;
     unsigned int now = SDL_GetTicks();
 
-    /* NOTE: given that we only access "available" counter from cbuff, we don't need to protect it's access with LockAudio/UnlockAudio */
+    /* NOTE: the fill level may be read from either side of cbuff */
     cbuff_tail(&sdl_backend->primary_buffer, &available);
 
     /* Start by calculating the current Primary buffer fullness in terms of output samples */
@@ -23,7 +23,9 @@
  * outside of the core library.
  */
 
+#include <ctype.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -50,6 +52,7 @@ struct external_config {
 
 typedef struct _config_var {
   char                 *name;
+  uint32_t              hash;
   m64p_type             type;
   union {
     int integer;
@@ -58,6 +61,8 @@ typedef struct _config_var {
   } val;
   char                 *comment;
   struct _config_var   *next;
+  struct _config_var   *next_hash;
+  struct _config_param *params;
   } config_var;
 
 typedef struct _config_section {
@@ -65,10 +70,28 @@ typedef struct _config_section {
   char                   *name;
   struct _config_var     *first_var;
   struct _config_section *next;
+  /* hash index of the variables, by case-insensitive name */
+  struct _config_var    **buckets;
+  unsigned int            bucket_count;
+  unsigned int            var_count;
   } config_section;
 
 typedef config_section *config_list;
 
+/* A handle given by ConfigGetParamHandle(). When its variable is deleted, var
+ * is cleared and looked up again by name on the next read. */
+typedef struct _config_param {
+  unsigned int          magic;
+  char                 *section;
+  char                 *name;
+  m64p_type             type;
+  struct _config_var   *var;
+  struct _config_param *next;
+  struct _config_param *next_var;
+  } config_param;
+
+#define PARAM_MAGIC 0xDBDC0581
+
 /* local variables */
 static int         l_ConfigInit = 0;
 static char       *l_DataDirOverride = NULL;
@@ -77,6 +100,7 @@ static char       *l_UserCacheDirOverride = NULL;
 static char       *l_UserDataDirOverride = NULL;
 static config_list l_ConfigListActive = NULL;
 static config_list l_ConfigListSaved = NULL;
+static config_param *l_ConfigParams = NULL;
 
 /* --------------- */
 /* local functions */
@@ -136,6 +160,17 @@ static config_section *find_section(config_list list, const char *ParamName)
     return *find_section_link(&list, ParamName);
 }
 
+/* Case-insensitive FNV-1a hash of a parameter name */
+static uint32_t var_name_hash(const char *ParamName)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*ParamName != '\0')
+        hash = (hash ^ (uint32_t) tolower((unsigned char) *ParamName++)) * 16777619u;
+
+    return hash;
+}
+
 static config_var *config_var_create(const char *ParamName, const char *ParamHelp)
 {
     config_var *var;
@@ -155,6 +190,7 @@ static config_var *config_var_create(const char *ParamName, const char *ParamHel
         free(var);
         return NULL;
     }
+    var->hash = var_name_hash(ParamName);
 
     var->type = M64TYPE_INT;
     var->val.integer = 0;
@@ -176,14 +212,56 @@ static config_var *config_var_create(const char *ParamName, const char *ParamHel
     return var;
 }
 
+/* Rebuilds the hash index of a section from its list of variables, with
+ * room for at least 'count' variables. If memory runs out, the old index is
+ * kept (or lookups fall back to walking the list if there is none). */
+static void section_rebuild_index(config_section *section, unsigned int count)
+{
+    config_var **buckets, *curr_var;
+    unsigned int bucket_count = 16;
+
+    while (bucket_count < count)
+        bucket_count *= 2;
+
+    buckets = (config_var **) calloc(bucket_count, sizeof(config_var *));
+    if (buckets == NULL)
+        return;
+
+    free(section->buckets);
+    section->buckets = buckets;
+    section->bucket_count = bucket_count;
+    section->var_count = 0;
+
+    for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
+    {
+        config_var **bucket = &buckets[curr_var->hash & (bucket_count - 1)];
+        curr_var->next_hash = *bucket;
+        *bucket = curr_var;
+        section->var_count++;
+    }
+}
+
 static config_var *find_section_var(config_section *section, const char *ParamName)
 {
-    /* walk through the linked list of variables in the section */
+    uint32_t hash = var_name_hash(ParamName);
     config_var *curr_var;
-    for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
+
+    /* walk through the variables in the hash bucket, or the whole section without an index */
+    if (section->buckets != NULL)
     {
-        if (osal_insensitive_strcmp(ParamName, curr_var->name) == 0)
-            return curr_var;
+        for (curr_var = section->buckets[hash & (section->bucket_count - 1)]; curr_var != NULL; curr_var = curr_var->next_hash)
+        {
+            if (curr_var->hash == hash && osal_insensitive_strcmp(ParamName, curr_var->name) == 0)
+                return curr_var;
+        }
+    }
+    else
+    {
+        for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
+        {
+            if (osal_insensitive_strcmp(ParamName, curr_var->name) == 0)
+                return curr_var;
+        }
     }
 
     /* couldn't find this configuration parameter */
@@ -198,20 +276,36 @@ static void append_var_to_section(config_section *section, config_var *var)
         return;
 
     if (section->first_var == NULL)
-    {
         section->first_var = var;
-        return;
-    }
+    else
+    {
+        last_var = section->first_var;
+        while (last_var->next != NULL)
+            last_var = last_var->next;
 
-    last_var = section->first_var;
-    while (last_var->next != NULL)
-        last_var = last_var->next;
+        last_var->next = var;
+    }
 
-    last_var->next = var;
+    /* grow the index when it is full, otherwise just add the new variable to it */
+    if (section->buckets == NULL || section->var_count >= section->bucket_count)
+        section_rebuild_index(section, section->var_count + 1);
+    else
+    {
+        config_var **bucket = &section->buckets[var->hash & (section->bucket_count - 1)];
+        var->next_hash = *bucket;
+        *bucket = var;
+        section->var_count++;
+    }
 }
 
 static void delete_var(config_var *var)
 {
+    config_param *param;
+
+    /* handles to this variable will look it up again on their next read */
+    for (param = var->params; param != NULL; param = param->next_var)
+        param->var = NULL;
+
     if (var->type == M64TYPE_STRING)
         free(var->val.string);
     free(var->name);
@@ -234,6 +328,7 @@ static void delete_section(config_section *pSection)
         curr_var = next_var;
     }
 
+    free(pSection->buckets);
     free(pSection->name);
     free(pSection);
 }
@@ -273,6 +368,9 @@ static config_section *config_section_create(const char *ParamName)
     }
     sec->first_var = NULL;
     sec->next = NULL;
+    sec->buckets = NULL;
+    sec->bucket_count = 0;
+    sec->var_count = 0;
     return sec;
 }
 
@@ -341,6 +439,8 @@ static config_section * section_deepcopy(config_section *orig_section)
         orig_var = orig_var->next;
     }
 
+    section_rebuild_index(new_section, orig_section->var_count);
+
     return new_section;
 }
 
@@ -622,6 +722,16 @@ m64p_error ConfigShutdown(void)
     delete_list(&l_ConfigListActive);
     delete_list(&l_ConfigListSaved);
 
+    /* and the parameter handles */
+    while (l_ConfigParams != NULL)
+    {
+        config_param *next_param = l_ConfigParams->next;
+        free(l_ConfigParams->section);
+        free(l_ConfigParams->name);
+        free(l_ConfigParams);
+        l_ConfigParams = next_param;
+    }
+
     return M64ERR_SUCCESS;
 }
 
@@ -1044,6 +1154,86 @@ EXPORT m64p_error CALL ConfigRevertChanges(const char *SectionName)
 }
 
 
+/* Translate a variable to the type asked for by one of the ConfigGetParam***()
+ * or ConfigReadParam***() functions, named by 'caller' in error messages. */
+static int var_to_int(const config_var *var, const char *caller)
+{
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            return var->val.integer;
+        case M64TYPE_FLOAT:
+            return (int) var->val.number;
+        case M64TYPE_BOOL:
+            return (var->val.integer != 0);
+        case M64TYPE_STRING:
+            return atoi(var->val.string);
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", caller, var->name);
+            return 0;
+    }
+}
+
+static float var_to_float(const config_var *var, const char *caller)
+{
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            return (float) var->val.integer;
+        case M64TYPE_FLOAT:
+            return var->val.number;
+        case M64TYPE_BOOL:
+            return (var->val.integer != 0) ? 1.0f : 0.0f;
+        case M64TYPE_STRING:
+            return (float) atof(var->val.string);
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", caller, var->name);
+            return 0.0;
+    }
+}
+
+static int var_to_bool(const config_var *var, const char *caller)
+{
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            return (var->val.integer != 0);
+        case M64TYPE_FLOAT:
+            return (var->val.number != 0.0);
+        case M64TYPE_BOOL:
+            return var->val.integer;
+        case M64TYPE_STRING:
+            return (osal_insensitive_strcmp(var->val.string, "true") == 0);
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", caller, var->name);
+            return 0;
+    }
+}
+
+static const char *var_to_string(const config_var *var, const char *caller)
+{
+    static char outstr[64];  /* warning: not thread safe */
+
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            snprintf(outstr, 63, "%i", var->val.integer);
+            outstr[63] = 0;
+            return outstr;
+        case M64TYPE_FLOAT:
+            snprintf(outstr, 63, "%f", var->val.number);
+            outstr[63] = 0;
+            return outstr;
+        case M64TYPE_BOOL:
+            return (var->val.integer ? "True" : "False");
+        case M64TYPE_STRING:
+            return var->val.string;
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", caller, var->name);
+            return "";
+    }
+}
+
 /* ------------------------------------------------------- */
 /* Generic Get/Set functions, exported outside of the Core */
 /* ------------------------------------------------------- */
@@ -1412,21 +1602,7 @@ EXPORT int CALL ConfigGetParamInt(m64p_handle ConfigSectionHandle, const char *P
         return 0;
     }
 
-    /* translate the actual variable type to an int */
-    switch(var->type)
-    {
-        case M64TYPE_INT:
-            return var->val.integer;
-        case M64TYPE_FLOAT:
-            return (int) var->val.number;
-        case M64TYPE_BOOL:
-            return (var->val.integer != 0);
-        case M64TYPE_STRING:
-            return atoi(var->val.string);
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamInt(): invalid internal parameter type for '%s'", ParamName);
-            return 0;
-    }
+    return var_to_int(var, "ConfigGetParamInt");
 }
 
 EXPORT float CALL ConfigGetParamFloat(m64p_handle ConfigSectionHandle, const char *ParamName)
@@ -1456,21 +1632,7 @@ EXPORT float CALL ConfigGetParamFloat(m64p_handle ConfigSectionHandle, const cha
         return 0.0;
     }
 
-    /* translate the actual variable type to a float */
-    switch(var->type)
-    {
-        case M64TYPE_INT:
-            return (float) var->val.integer;
-        case M64TYPE_FLOAT:
-            return var->val.number;
-        case M64TYPE_BOOL:
-            return (var->val.integer != 0) ? 1.0f : 0.0f;
-        case M64TYPE_STRING:
-            return (float) atof(var->val.string);
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamFloat(): invalid internal parameter type for '%s'", ParamName);
-            return 0.0;
-    }
+    return var_to_float(var, "ConfigGetParamFloat");
 }
 
 EXPORT int CALL ConfigGetParamBool(m64p_handle ConfigSectionHandle, const char *ParamName)
@@ -1500,26 +1662,11 @@ EXPORT int CALL ConfigGetParamBool(m64p_handle ConfigSectionHandle, const char *
         return 0;
     }
 
-    /* translate the actual variable type to an int (0 or 1) */
-    switch(var->type)
-    {
-        case M64TYPE_INT:
-            return (var->val.integer != 0);
-        case M64TYPE_FLOAT:
-            return (var->val.number != 0.0);
-        case M64TYPE_BOOL:
-            return var->val.integer;
-        case M64TYPE_STRING:
-            return (osal_insensitive_strcmp(var->val.string, "true") == 0);
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamBool(): invalid internal parameter type for '%s'", ParamName);
-            return 0;
-    }
+    return var_to_bool(var, "ConfigGetParamBool");
 }
 
 EXPORT const char * CALL ConfigGetParamString(m64p_handle ConfigSectionHandle, const char *ParamName)
 {
-    static char outstr[64];  /* warning: not thread safe */
     config_section *section;
     config_var *var;
 
@@ -1545,25 +1692,121 @@ EXPORT const char * CALL ConfigGetParamString(m64p_handle ConfigSectionHandle, c
         return "";
     }
 
-    /* translate the actual variable type to a string */
-    switch(var->type)
+    return var_to_string(var, "ConfigGetParamString");
+}
+
+EXPORT m64p_error CALL ConfigGetParamHandle(m64p_handle ConfigSectionHandle, const char *ParamName, m64p_type ParamType, m64p_param_handle *ParamHandle)
+{
+    config_section *section;
+    config_param *param;
+    config_var *var;
+
+    /* check input conditions */
+    if (!l_ConfigInit)
+        return M64ERR_NOT_INIT;
+    if (ConfigSectionHandle == NULL || ParamName == NULL || ParamHandle == NULL || (int) ParamType < 1 || (int) ParamType > 4)
+        return M64ERR_INPUT_ASSERT;
+
+    section = (config_section *) ConfigSectionHandle;
+    if (section->magic != SECTION_MAGIC)
+        return M64ERR_INPUT_INVALID;
+
+    /* if this parameter doesn't already exist, return an error */
+    var = find_section_var(section, ParamName);
+    if (var == NULL)
+        return M64ERR_INPUT_NOT_FOUND;
+
+    /* hand out the same handle again if this parameter was already asked for with this type */
+    for (param = var->params; param != NULL; param = param->next_var)
     {
-        case M64TYPE_INT:
-            snprintf(outstr, 63, "%i", var->val.integer);
-            outstr[63] = 0;
-            return outstr;
-        case M64TYPE_FLOAT:
-            snprintf(outstr, 63, "%f", var->val.number);
-            outstr[63] = 0;
-            return outstr;
-        case M64TYPE_BOOL:
-            return (var->val.integer ? "True" : "False");
-        case M64TYPE_STRING:
-            return var->val.string;
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamString(): invalid internal parameter type for '%s'", ParamName);
-            return "";
+        if (param->type == ParamType)
+        {
+            *ParamHandle = param;
+            return M64ERR_SUCCESS;
+        }
+    }
+
+    param = (config_param *) malloc(sizeof(config_param));
+    if (param == NULL)
+        return M64ERR_NO_MEMORY;
+
+    param->magic = PARAM_MAGIC;
+    param->section = strdup(section->name);
+    param->name = strdup(var->name);
+    if (param->section == NULL || param->name == NULL)
+    {
+        free(param->section);
+        free(param->name);
+        free(param);
+        return M64ERR_NO_MEMORY;
     }
+    param->type = ParamType;
+    param->var = var;
+    param->next_var = var->params;
+    var->params = param;
+    param->next = l_ConfigParams;
+    l_ConfigParams = param;
+
+    *ParamHandle = param;
+    return M64ERR_SUCCESS;
+}
+
+/* Returns the variable behind a handle, looking it up again by name if it
+ * was deleted since the last read, or NULL after reporting an error. */
+static config_var *param_var(m64p_param_handle ParamHandle, m64p_type ParamType, const char *caller)
+{
+    config_param *param = (config_param *) ParamHandle;
+    config_section *section;
+
+    if (!l_ConfigInit || param == NULL || param->magic != PARAM_MAGIC)
+    {
+        DebugMessage(M64MSG_ERROR, "%s(): Input assertion!", caller);
+        return NULL;
+    }
+
+    if (param->type != ParamType)
+    {
+        DebugMessage(M64MSG_ERROR, "%s(): Handle for '%s' has the wrong type!", caller, param->name);
+        return NULL;
+    }
+
+    if (param->var != NULL)
+        return param->var;
+
+    section = find_section(l_ConfigListActive, param->section);
+    if (section == NULL || (param->var = find_section_var(section, param->name)) == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "%s(): Parameter '%s' not found!", caller, param->name);
+        return NULL;
+    }
+
+    param->next_var = param->var->params;
+    param->var->params = param;
+    return param->var;
+}
+
+EXPORT int CALL ConfigReadParamInt(m64p_param_handle ParamHandle)
+{
+    config_var *var = param_var(ParamHandle, M64TYPE_INT, "ConfigReadParamInt");
+    return (var != NULL) ? var_to_int(var, "ConfigReadParamInt") : 0;
+}
+
+EXPORT float CALL ConfigReadParamFloat(m64p_param_handle ParamHandle)
+{
+    config_var *var = param_var(ParamHandle, M64TYPE_FLOAT, "ConfigReadParamFloat");
+    return (var != NULL) ? var_to_float(var, "ConfigReadParamFloat") : 0.0f;
+}
+
+EXPORT int CALL ConfigReadParamBool(m64p_param_handle ParamHandle)
+{
+    config_var *var = param_var(ParamHandle, M64TYPE_BOOL, "ConfigReadParamBool");
+    return (var != NULL) ? var_to_bool(var, "ConfigReadParamBool") : 0;
+}
+
+EXPORT const char * CALL ConfigReadParamString(m64p_param_handle ParamHandle)
+{
+    config_var *var = param_var(ParamHandle, M64TYPE_STRING, "ConfigReadParamString");
+    return (var != NULL) ? var_to_string(var, "ConfigReadParamString") : "";
 }
 
 EXPORT m64p_error CALL ConfigOverrideUserPaths(const char *DataPath, const char *CachePath)
@@ -39,6 +39,8 @@
 #include "m64p_debugger.h"
 #include "m64p_types.h"
 #include "main/main.h"
+#include "main/rdram_dirty.h"
+#include "main/sample_profiler.h"
 
 unsigned int op;
 
@@ -229,6 +231,9 @@ EXPORT void * CALL DebugMemGetPointer(m64p_dbg_memptr_type mem_ptr_type)
     switch (mem_ptr_type)
     {
         case M64P_DBG_PTR_RDRAM:
+            /* writes through this pointer are invisible to the checkpoints,
+             * which hold all of RDRAM until the next power-on or reset */
+            rdram_dirty_disable();
             return g_dev.rdram.dram;
         case M64P_DBG_PTR_PI_REG:
             return g_dev.pi.regs;
@@ -460,3 +465,39 @@ EXPORT uint32_t CALL DebugVirtualToPhysical(uint32_t address)
     return address;
 #endif
 }
+
+EXPORT m64p_error CALL DebugProfileStart(unsigned int period)
+{
+    return sample_profiler_start(period);
+}
+
+EXPORT m64p_error CALL DebugProfileStop(void)
+{
+    return sample_profiler_stop();
+}
+
+EXPORT m64p_error CALL DebugProfileReset(void)
+{
+    return sample_profiler_reset();
+}
+
+EXPORT m64p_error CALL DebugProfileGetHotFunctions(m64p_profile_query *query)
+{
+    if (query == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    return sample_profiler_query(&g_dev.r4300, query);
+}
+
+EXPORT int CALL DebugProfileGetOpcodeCounts(unsigned int *counts, int size)
+{
+    if (counts == NULL && size > 0)
+        return -1;
+
+    return sample_profiler_opcode_counts(&g_dev.r4300, counts, size);
+}
+
+EXPORT const char * CALL DebugProfileGetOpcodeName(int opcode)
+{
+    return sample_profiler_opcode_name(opcode);
+}
@@ -33,6 +33,8 @@
 #define M64P_CORE_PROTOTYPES 1
 #include "callbacks.h"
 #include "config.h"
+#include "device/device.h"
+#include "device/r4300/cached_interp.h"
 #include "m64p_config.h"
 #include "m64p_frontend.h"
 #include "m64p_types.h"
@@ -45,7 +47,11 @@
 #include "main/version.h"
 #include "main/workqueue.h"
 #include "main/screenshot.h"
+#include "main/telemetry.h"
 #include "main/netplay.h"
+#include "main/profile.h"
+#include "main/rdram_heatmap.h"
+#include "main/rewind.h"
 #include "plugin/plugin.h"
 #include "vidext.h"
 
@@ -106,7 +112,7 @@ EXPORT m64p_error CALL CoreStartup(int APIVersion, const char *ConfigPath, const
     /* The ROM database contains MD5 hashes, goodnames, and some game-specific parameters */
     romdatabase_open();
 
-    workqueue_init();
+    workqueue_init(ConfigGetParamInt(g_CoreConfig, "WorkerThreads"));
 
     l_CoreInit = 1;
     return M64ERR_SUCCESS;
@@ -191,6 +197,19 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 cheat_init(&g_cheat_ctx);
             }
             return rval;
+        case M64CMD_ROM_OPEN_FILE:
+            if (g_EmulatorRunning || l_DiskOpen || l_ROMOpen)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            rval = open_rom_file((const char *) ParamPtr);
+            if (rval == M64ERR_SUCCESS)
+            {
+                l_ROMOpen = 1;
+                ScreenshotRomOpen();
+                cheat_init(&g_cheat_ctx);
+            }
+            return rval;
         case M64CMD_ROM_CLOSE:
             if (g_EmulatorRunning || !l_ROMOpen)
                 return M64ERR_INVALID_STATE;
@@ -371,6 +390,29 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 return M64ERR_INCOMPATIBLE;
         case M64CMD_NETPLAY_CLOSE:
             return netplay_stop();
+        case M64CMD_TELEMETRY_DRAIN:
+            if (ParamInt != sizeof(m64p_telemetry_drain) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return telemetry_drain((m64p_telemetry_drain*)ParamPtr);
+        case M64CMD_GET_FRAME_TIMINGS:
+            if (ParamInt != sizeof(m64p_frame_timing_query) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return timed_sections_query((m64p_frame_timing_query*)ParamPtr);
+        case M64CMD_GET_RDRAM_HEATMAP:
+            if (ParamInt != sizeof(m64p_rdram_heatmap) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return rdram_heatmap_query((m64p_rdram_heatmap*)ParamPtr);
+        case M64CMD_REWIND:
+            if (ParamInt != sizeof(m64p_rewind) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            if (((m64p_rewind*)ParamPtr)->frames != 0 && !g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            return rewind_query((m64p_rewind*)ParamPtr);
+        case M64CMD_GET_CODE_CACHE_STATS:
+            if (ParamInt != sizeof(m64p_code_cache_stats) || ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            cached_interp_get_stats(&g_dev.r4300.cached_interp, (m64p_code_cache_stats*)ParamPtr);
+            return M64ERR_SUCCESS;
         default:
             return M64ERR_INPUT_INVALID;
     }
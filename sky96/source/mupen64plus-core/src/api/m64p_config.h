@@ -198,6 +198,40 @@ EXPORT int          CALL ConfigGetParamBool(m64p_handle, const char *);
 EXPORT const char * CALL ConfigGetParamString(m64p_handle, const char *);
 #endif
 
+/* ConfigGetParamHandle()
+ *
+ * This function returns a handle to one of the emulator's parameters in the
+ * given section, to be read with the ConfigReadParam***() function matching
+ * ParamType. Reading through a handle skips the lookup by name, so it is
+ * suited to parameters read every frame. Handles stay valid until the core
+ * is shut down; if the parameter is deleted, for example by reverting its
+ * section, the handle follows the parameter with the same name.
+ */
+typedef m64p_error (*ptr_ConfigGetParamHandle)(m64p_handle, const char *, m64p_type, m64p_param_handle *);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL ConfigGetParamHandle(m64p_handle, const char *, m64p_type, m64p_param_handle *);
+#endif
+
+/* ConfigReadParam***()
+ *
+ * These functions return the value of a parameter through a handle given by
+ * ConfigGetParamHandle(), translated like the ConfigGetParam***() functions.
+ * If an error occurs (such as a handle of another type, or a parameter which
+ * no longer exists), then an error will be sent to the front-end via the
+ * DebugCallback() function, and either a 0 (zero) or an empty string will be
+ * returned.
+ */
+typedef int          (*ptr_ConfigReadParamInt)(m64p_param_handle);
+typedef float        (*ptr_ConfigReadParamFloat)(m64p_param_handle);
+typedef int          (*ptr_ConfigReadParamBool)(m64p_param_handle);
+typedef const char * (*ptr_ConfigReadParamString)(m64p_param_handle);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT int          CALL ConfigReadParamInt(m64p_param_handle);
+EXPORT float        CALL ConfigReadParamFloat(m64p_param_handle);
+EXPORT int          CALL ConfigReadParamBool(m64p_param_handle);
+EXPORT const char * CALL ConfigReadParamString(m64p_param_handle);
+#endif
+
 /* ConfigGetSharedDataFilepath()
  *
  * This function is provided to allow a plugin to retrieve a full pathname to a
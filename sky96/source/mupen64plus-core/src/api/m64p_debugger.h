@@ -214,6 +214,68 @@ typedef uint32_t (*ptr_DebugVirtualToPhysical)(uint32_t);
 EXPORT uint32_t CALL DebugVirtualToPhysical(uint32_t);
 #endif
 
+/* DebugProfileStart()
+ *
+ * This function starts the R4300 sampling profiler, which records the guest
+ * PC and the opcode found there every given number of count cycles (0 selects
+ * the default period). Sampling begins on the next VI. This function does not
+ * require the core to be built with the debugger.
+ */
+typedef m64p_error (*ptr_DebugProfileStart)(unsigned int);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL DebugProfileStart(unsigned int);
+#endif
+
+/* DebugProfileStop()
+ *
+ * This function stops the sampling profiler. Samples taken so far are kept.
+ */
+typedef m64p_error (*ptr_DebugProfileStop)(void);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL DebugProfileStop(void);
+#endif
+
+/* DebugProfileReset()
+ *
+ * This function discards all the samples taken by the profiler so far.
+ */
+typedef m64p_error (*ptr_DebugProfileReset)(void);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL DebugProfileReset(void);
+#endif
+
+/* DebugProfileGetHotFunctions()
+ *
+ * This function aggregates the pending samples and copies the hottest guest
+ * functions, as guessed from their prologue, into a caller-owned array. The
+ * DebugProfile* query functions must all be called from the same thread.
+ */
+typedef m64p_error (*ptr_DebugProfileGetHotFunctions)(m64p_profile_query *);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL DebugProfileGetHotFunctions(m64p_profile_query *);
+#endif
+
+/* DebugProfileGetOpcodeCounts()
+ *
+ * This function aggregates the pending samples and copies the number of
+ * samples taken on each R4300 opcode into a caller-owned array of the given
+ * size. It returns the number of opcodes known to the core.
+ */
+typedef int (*ptr_DebugProfileGetOpcodeCounts)(unsigned int *, int);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT int CALL DebugProfileGetOpcodeCounts(unsigned int *, int);
+#endif
+
+/* DebugProfileGetOpcodeName()
+ *
+ * This function returns the mnemonic of an opcode index used by
+ * DebugProfileGetOpcodeCounts(), or NULL if the index is out of range.
+ */
+typedef const char * (*ptr_DebugProfileGetOpcodeName)(int);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT const char * CALL DebugProfileGetOpcodeName(int);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
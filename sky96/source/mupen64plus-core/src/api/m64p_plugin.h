@@ -222,13 +222,21 @@ typedef struct
    unsigned int width;
    unsigned int height;
 } FrameBufferInfo;
+/* byte range of a frame buffer written by the CPU or a DMA */
+typedef struct
+{
+   unsigned int addr;
+   unsigned int size;
+} FrameBufferWriteRange;
 typedef void (*ptr_FBRead)(unsigned int addr);
 typedef void (*ptr_FBWrite)(unsigned int addr, unsigned int size);
 typedef void (*ptr_FBGetFrameBufferInfo)(void *p);
+typedef void (*ptr_FBWriteList)(const FrameBufferWriteRange *ranges, unsigned int count);
 #if defined(M64P_PLUGIN_PROTOTYPES)
 EXPORT void CALL FBRead(unsigned int addr);
 EXPORT void CALL FBWrite(unsigned int addr, unsigned int size);
 EXPORT void CALL FBGetFrameBufferInfo(void *p);
+EXPORT void CALL FBWriteList(const FrameBufferWriteRange *ranges, unsigned int count);
 #endif
 
 /* audio plugin function pointers */
@@ -288,9 +296,11 @@ EXPORT void CALL SetVRUWordMask(uint8_t length, uint8_t *mask);
 /* RSP plugin function pointers */
 typedef unsigned int (*ptr_DoRspCycles)(unsigned int Cycles);
 typedef void (*ptr_InitiateRSP)(RSP_INFO Rsp_Info, unsigned int *CycleCount);
+typedef int  (*ptr_GetRdramWrites)(unsigned int *Pages, unsigned int Count);
 #if defined(M64P_PLUGIN_PROTOTYPES)
 EXPORT unsigned int CALL DoRspCycles(unsigned int Cycles);
 EXPORT void CALL InitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount);
+EXPORT int  CALL GetRdramWrites(unsigned int *Pages, unsigned int Count);
 #endif
 
 #ifdef __cplusplus
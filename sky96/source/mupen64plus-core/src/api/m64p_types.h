@@ -52,6 +52,9 @@
 
 typedef void * m64p_handle;
 
+/* Handle to a single configuration parameter, given by ConfigGetParamHandle() */
+typedef void * m64p_param_handle;
+
 /* Generic function pointer returned from osal_dynlib_getproc (and the like)
  * Don't use it directly, cast to proper type before using it.
  */
@@ -171,7 +174,13 @@ typedef enum {
   M64CMD_PIF_OPEN,
   M64CMD_ROM_SET_SETTINGS,
   M64CMD_DISK_OPEN,
-  M64CMD_DISK_CLOSE
+  M64CMD_DISK_CLOSE,
+  M64CMD_TELEMETRY_DRAIN,
+  M64CMD_GET_FRAME_TIMINGS,
+  M64CMD_GET_RDRAM_HEATMAP,
+  M64CMD_REWIND,
+  M64CMD_ROM_OPEN_FILE,
+  M64CMD_GET_CODE_CACHE_STATS
 } m64p_command;
 
 typedef struct {
@@ -220,6 +229,77 @@ typedef struct {
   char* (*get_dd_disk)(void* cb_data);
 } m64p_media_loader;
 
+/* ----------------------------------------- */
+/* Structures for real-time telemetry        */
+/* ----------------------------------------- */
+
+typedef enum {
+  M64TELEM_FRAME = 1,     /* arg0: frame index */
+  M64TELEM_VI,            /* arg0: CP0 count register */
+  M64TELEM_INTERRUPT      /* arg0: interrupt event type, arg1: times raised since the previous VI */
+} m64p_telemetry_type;
+
+typedef struct {
+  uint64_t timestamp_ns;  /* monotonic host time at which the event was published */
+  uint32_t type;          /* one of m64p_telemetry_type */
+  uint32_t frame;         /* index of the frame during which the event occurred */
+  uint32_t arg0;
+  uint32_t arg1;
+} m64p_telemetry_event;
+
+typedef struct {
+  m64p_telemetry_event* events; /* caller-owned array receiving the events */
+  unsigned int capacity;        /* number of elements in the events array */
+  unsigned int count;           /* out: number of events written */
+  unsigned int dropped;         /* out: number of events lost because the ring was full since the previous drain */
+} m64p_telemetry_drain;
+
+typedef struct {
+  uint32_t vi;            /* sequence number of the VI which closed this record */
+  uint32_t frame;         /* index of the current frame when the record was closed */
+  uint32_t total_ns;      /* host time elapsed since the previous VI */
+  uint32_t cpu_ns;        /* r4300 emulation, everything not accounted below */
+  uint32_t rsp_gfx_ns;    /* RSP graphics tasks */
+  uint32_t rsp_audio_ns;  /* RSP audio tasks */
+  uint32_t compiler_ns;   /* dynamic recompiler */
+  uint32_t idle_ns;       /* speed limiter sleep */
+  uint32_t input_ns;      /* input polling */
+  int32_t  pacing_error_ns; /* release time minus VI deadline (positive when late), 0 when unpaced */
+  uint32_t instructions;  /* r4300 instructions emulated since the previous VI, estimated from the CP0 count */
+} m64p_frame_timing;
+
+typedef struct {
+  m64p_frame_timing* timings; /* caller-owned array receiving the records */
+  unsigned int capacity;      /* number of elements in the timings array */
+  unsigned int first;         /* in: sequence number of the first record wanted, out: sequence number of the first record returned */
+  unsigned int count;         /* out: number of records written */
+} m64p_frame_timing_query;
+
+/* 8 MB of RDRAM in 4 KB pages */
+#define M64P_RDRAM_HEATMAP_PAGES 2048
+
+typedef struct {
+  uint32_t sample;                                  /* out: number of VIs sampled so far */
+  uint32_t reads[M64P_RDRAM_HEATMAP_PAGES];         /* out: decayed word reads per page */
+  uint32_t writes[M64P_RDRAM_HEATMAP_PAGES];        /* out: decayed word writes per page */
+  uint32_t dma_writes[M64P_RDRAM_HEATMAP_PAGES];    /* out: decayed words written by PI/SI/SP DMA per page */
+} m64p_rdram_heatmap;
+
+typedef struct {
+  uint32_t frames;          /* in: frames to step back, 0 to only query the history */
+  uint32_t frame;           /* out: frame counter of the newest snapshot */
+  uint32_t depth;           /* out: how many frames back the history reaches */
+  uint32_t used_bytes;      /* out: bytes of the history buffer in use */
+  uint32_t capacity_bytes;  /* out: size of the history buffer, 0 when rewind is disabled */
+} m64p_rewind;
+
+typedef struct {
+  uint32_t live_blocks;     /* out: 4 KB code pages currently held by the cached interpreter */
+  uint32_t bytes_used;      /* out: bytes of those blocks */
+  uint32_t bytes_reserved;  /* out: bytes reserved for blocks, including free slots */
+  uint32_t recompiles;      /* out: blocks (re)compiled since emulation started, wraps around */
+} m64p_code_cache_stats;
+
 /* ----------------------------------------- */
 /* Structures to hold ROM image information  */
 /* ----------------------------------------- */
@@ -401,6 +481,19 @@ typedef struct {
   unsigned int flags;
 } m64p_breakpoint;
 
+typedef struct {
+  uint32_t address;       /* guest address of the function entry, or of the sampled PC when no entry was found */
+  uint32_t samples;       /* number of samples attributed to this function */
+} m64p_profile_function;
+
+typedef struct {
+  m64p_profile_function* functions; /* caller-owned array receiving the hottest functions, hottest first */
+  unsigned int capacity;            /* number of elements in the functions array */
+  unsigned int count;               /* out: number of functions written */
+  unsigned int samples;             /* out: total number of samples aggregated since the profiler was reset */
+  unsigned int dropped;             /* out: number of samples lost since the profiler was reset */
+} m64p_profile_query;
+
 /* ------------------------------------------------- */
 /* Structures and Types for Core Video Extension API */
 /* ------------------------------------------------- */
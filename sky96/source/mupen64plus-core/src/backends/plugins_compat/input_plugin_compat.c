@@ -28,6 +28,7 @@
 
 #include "main/main.h"
 #include "main/netplay.h"
+#include "main/profile.h"
 
 #include <stdint.h>
 #include <string.h>
@@ -61,6 +62,7 @@ static m64p_error input_plugin_get_input(void* opaque, uint32_t* input_)
     int pak_change_requested = 0;
 
     /* first poll controller */
+    timed_section_start(TIMED_SECTION_INPUT);
     if (!netplay_is_init())
     {
         if (input.getKeys)
@@ -84,6 +86,7 @@ static m64p_error input_plugin_get_input(void* opaque, uint32_t* input_)
         cin_compat->last_input = keys.Value; //disable pak switching for netplay
         cin_compat->last_pak_type = Controls[cin_compat->control_id].Plugin; //disable pak switching for netplay
     }
+    timed_section_end(TIMED_SECTION_INPUT);
 
     /* return an error if controller is not plugged */
     if (!Controls[cin_compat->control_id].Present) {
@@ -26,6 +26,7 @@
 #include "api/m64p_types.h"
 
 #include "device/memory/memory.h"
+#include "device/memory/swapped_copy.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/pi/pi_controller.h"
 
@@ -93,7 +94,6 @@ unsigned int cart_rom_dma_read(void* opaque, const uint8_t* dram, uint32_t dram_
 
 unsigned int cart_rom_dma_write(void* opaque, uint8_t* dram, uint32_t dram_addr, uint32_t cart_addr, uint32_t length)
 {
-    size_t i;
     struct cart_rom* cart_rom = (struct cart_rom*)opaque;
     const uint8_t* mem = cart_rom->rom;
 
@@ -101,9 +101,7 @@ unsigned int cart_rom_dma_write(void* opaque, uint8_t* dram, uint32_t dram_addr,
 
     if (cart_addr + length < cart_rom->rom_size)
     {
-        for(i = 0; i < length; ++i) {
-            dram[(dram_addr+i)^S8] = mem[(cart_addr+i)^S8];
-        }
+        swapped_copy_bytes(dram, dram_addr, mem, cart_addr, length);
     }
     else
     {
@@ -111,12 +109,8 @@ unsigned int cart_rom_dma_write(void* opaque, uint8_t* dram, uint32_t dram_addr,
             ? 0
             : cart_rom->rom_size - cart_addr;
 
-        for (i = 0; i < diff; ++i) {
-            dram[(dram_addr+i)^S8] = mem[(cart_addr+i)^S8];
-        }
-        for (; i < length; ++i) {
-            dram[(dram_addr+i)^S8] = 0;
-        }
+        swapped_copy_bytes(dram, dram_addr, mem, cart_addr, diff);
+        swapped_zero_bytes(dram, dram_addr + diff, length - diff);
     }
 
     /* invalidate cached code */
@@ -0,0 +1,119 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - swapped_copy.h                                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_MEMORY_SWAPPED_COPY_H
+#define M64P_DEVICE_MEMORY_SWAPPED_COPY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "osal/preproc.h"
+
+#if defined(OSAL_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SWAPPED_COPY_SSE2
+#endif
+
+/* Bulk copies between buffers of 32-bit words in host order, such as RDRAM
+ * and the cart ROM, where byte i lives at [i ^ S8].
+ *
+ * Words hold their big-endian value in either host byte order, so once the
+ * destination is word aligned each word is built from at most two source
+ * words: a plain memcpy when both sides share the alignment, a funnel shift
+ * otherwise. Bytes before and after the aligned part go through the byte
+ * loop. Source words past the last byte copied are never read. */
+
+static osal_inline void swapped_copy_bytes(uint8_t* dst, uint32_t dst_addr,
+                                           const uint8_t* src, uint32_t src_addr,
+                                           uint32_t length)
+{
+    /* head, up to the first aligned destination word */
+    while (length != 0 && (dst_addr & 3)) {
+        dst[dst_addr ^ S8] = src[src_addr ^ S8];
+        ++dst_addr;
+        ++src_addr;
+        --length;
+    }
+
+    size_t words = length / 4;
+    unsigned int shift = (src_addr & 3) * 8;
+
+    if (shift == 0) {
+        memcpy(dst + dst_addr, src + src_addr, words * 4);
+    }
+    else if (words > 1) {
+        /* the last word would need the source word after it, leave it to the tail */
+        uint32_t* d = (uint32_t*)(dst + dst_addr);
+        const uint32_t* s = (const uint32_t*)(src + (src_addr & ~UINT32_C(3)));
+        size_t k = 0;
+        --words;
+
+#ifdef SWAPPED_COPY_SSE2
+        __m128i lsh = _mm_cvtsi32_si128(shift);
+        __m128i rsh = _mm_cvtsi32_si128(32 - shift);
+        for (; k + 4 <= words; k += 4) {
+            __m128i lo = _mm_loadu_si128((const __m128i*)(s + k));
+            __m128i hi = _mm_loadu_si128((const __m128i*)(s + k + 1));
+            _mm_storeu_si128((__m128i*)(d + k),
+                             _mm_or_si128(_mm_sll_epi32(lo, lsh), _mm_srl_epi32(hi, rsh)));
+        }
+#endif
+        for (; k < words; ++k) {
+            d[k] = (s[k] << shift) | (s[k + 1] >> (32 - shift));
+        }
+    }
+    else {
+        words = 0;
+    }
+
+    dst_addr += (uint32_t)words * 4;
+    src_addr += (uint32_t)words * 4;
+    length -= (uint32_t)words * 4;
+
+    /* tail */
+    while (length != 0) {
+        dst[dst_addr ^ S8] = src[src_addr ^ S8];
+        ++dst_addr;
+        ++src_addr;
+        --length;
+    }
+}
+
+static osal_inline void swapped_zero_bytes(uint8_t* dst, uint32_t dst_addr, uint32_t length)
+{
+    while (length != 0 && (dst_addr & 3)) {
+        dst[dst_addr ^ S8] = 0;
+        ++dst_addr;
+        --length;
+    }
+
+    memset(dst + dst_addr, 0, length & ~UINT32_C(3));
+    dst_addr += length & ~UINT32_C(3);
+    length &= 3;
+
+    while (length != 0) {
+        dst[dst_addr ^ S8] = 0;
+        ++dst_addr;
+        --length;
+    }
+}
+
+#endif
@@ -0,0 +1,188 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - block_arena.c                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "block_arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osal/atomics.h"
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(__GNUC__)
+#include <sys/mman.h>
+
+#ifndef  MAP_ANONYMOUS
+#ifdef MAP_ANON
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+#endif
+
+/* huge page size on x86_64 and arm64 */
+#define CHUNK_ALIGN (UINT32_C(2) << 20)
+/* slots per chunk before rounding the chunk up to CHUNK_ALIGN */
+#define CHUNK_MIN_SLOTS 32
+#define SLOT_ALIGN 64
+
+struct block_arena_chunk
+{
+    unsigned char* base;
+    size_t used;
+    struct block_arena_chunk* next;
+};
+
+
+/* Returns zeroed memory, size being a multiple of CHUNK_ALIGN. */
+static void* map_chunk(size_t size)
+{
+#if defined(WIN32)
+    return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#elif defined(__GNUC__)
+    uintptr_t aligned;
+    size_t head;
+
+    /* over-map so that the chunk can start on a huge page boundary */
+    unsigned char* p = mmap(NULL, size + CHUNK_ALIGN, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    aligned = ((uintptr_t)p + CHUNK_ALIGN - 1) & ~(uintptr_t)(CHUNK_ALIGN - 1);
+    head = aligned - (uintptr_t)p;
+    if (head != 0)
+        munmap(p, head);
+    munmap((unsigned char*)aligned + size, CHUNK_ALIGN - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise((void*)aligned, size, MADV_HUGEPAGE);
+#endif
+    return (void*)aligned;
+#else
+    return calloc(1, size);
+#endif
+}
+
+static void unmap_chunk(void* p, size_t size)
+{
+#if defined(WIN32)
+    VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(__GNUC__)
+    munmap(p, size);
+#else
+    free(p);
+#endif
+}
+
+static void publish_stats(struct block_arena* arena)
+{
+    uint64_t used = (uint64_t)arena->live * arena->slot_size;
+    uint64_t reserved = (uint64_t)arena->chunk_count * arena->chunk_size;
+
+    osal_atomic_store_release(&arena->stats[BLOCK_ARENA_LIVE_SLOTS], (uint32_t)arena->live);
+    osal_atomic_store_release(&arena->stats[BLOCK_ARENA_BYTES_USED], (used > UINT32_MAX) ? UINT32_MAX : (uint32_t)used);
+    osal_atomic_store_release(&arena->stats[BLOCK_ARENA_BYTES_RESERVED], (reserved > UINT32_MAX) ? UINT32_MAX : (uint32_t)reserved);
+}
+
+void block_arena_init(struct block_arena* arena, size_t slot_size)
+{
+    memset(arena, 0, sizeof(*arena));
+
+    arena->slot_size = (slot_size + SLOT_ALIGN - 1) & ~(size_t)(SLOT_ALIGN - 1);
+    arena->chunk_size = (arena->slot_size * CHUNK_MIN_SLOTS + CHUNK_ALIGN - 1) & ~(size_t)(CHUNK_ALIGN - 1);
+    arena->slots_per_chunk = arena->chunk_size / arena->slot_size;
+
+    publish_stats(arena);
+}
+
+void* block_arena_alloc(struct block_arena* arena)
+{
+    void* slot;
+
+    if (arena->free_list != NULL)
+    {
+        slot = arena->free_list;
+        arena->free_list = *(void**)slot;
+        memset(slot, 0, arena->slot_size);
+    }
+    else
+    {
+        struct block_arena_chunk* chunk = arena->chunks;
+
+        if (chunk == NULL || chunk->used == arena->slots_per_chunk)
+        {
+            chunk = malloc(sizeof(*chunk));
+            if (chunk == NULL)
+                return NULL;
+
+            chunk->base = map_chunk(arena->chunk_size);
+            if (chunk->base == NULL)
+            {
+                free(chunk);
+                return NULL;
+            }
+            chunk->used = 0;
+            chunk->next = arena->chunks;
+            arena->chunks = chunk;
+            ++arena->chunk_count;
+        }
+
+        /* never handed out before, still zero */
+        slot = chunk->base + chunk->used * arena->slot_size;
+        ++chunk->used;
+    }
+
+    ++arena->live;
+    publish_stats(arena);
+
+    return slot;
+}
+
+void block_arena_free(struct block_arena* arena, void* slot)
+{
+    *(void**)slot = arena->free_list;
+    arena->free_list = slot;
+
+    --arena->live;
+    publish_stats(arena);
+}
+
+void block_arena_release(struct block_arena* arena)
+{
+    while (arena->chunks != NULL)
+    {
+        struct block_arena_chunk* chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        unmap_chunk(chunk->base, arena->chunk_size);
+        free(chunk);
+    }
+
+    arena->free_list = NULL;
+    arena->live = 0;
+    arena->chunk_count = 0;
+    publish_stats(arena);
+}
+
+uint32_t block_arena_stat(const struct block_arena* arena, enum block_arena_stat_id id)
+{
+    return osal_atomic_load_acquire(&arena->stats[id]);
+}
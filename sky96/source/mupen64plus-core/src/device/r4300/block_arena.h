@@ -0,0 +1,72 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - block_arena.h                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_BLOCK_ARENA_H
+#define M64P_DEVICE_R4300_BLOCK_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fixed-size slot allocator for the cached interpreter's precompiled blocks.
+ * Slots are carved out of large chunks (2 MB aligned so that the OS can back
+ * them with huge pages) and recycled through a free list. Chunk memory is
+ * only touched when a slot is first used, by the emulation thread, so on NUMA
+ * hosts it ends up local to that thread.
+ *
+ * The arena is only used by the emulation thread; the statistics may be read
+ * concurrently with block_arena_stat. */
+
+struct block_arena_chunk;
+
+enum block_arena_stat_id
+{
+    BLOCK_ARENA_LIVE_SLOTS,
+    BLOCK_ARENA_BYTES_USED,
+    BLOCK_ARENA_BYTES_RESERVED,
+    BLOCK_ARENA_STATS_COUNT
+};
+
+struct block_arena
+{
+    size_t slot_size;
+    size_t slots_per_chunk;
+    size_t chunk_size;
+
+    struct block_arena_chunk* chunks;   /* most recent first, bump-allocated */
+    size_t chunk_count;
+    void* free_list;
+    size_t live;
+
+    uint32_t stats[BLOCK_ARENA_STATS_COUNT];
+};
+
+void block_arena_init(struct block_arena* arena, size_t slot_size);
+
+/* Returns a zeroed slot, or NULL if out of memory. */
+void* block_arena_alloc(struct block_arena* arena);
+void block_arena_free(struct block_arena* arena, void* slot);
+
+/* Releases all chunks at once; outstanding slots become invalid. */
+void block_arena_release(struct block_arena* arena);
+
+uint32_t block_arena_stat(const struct block_arena* arena, enum block_arena_stat_id id);
+
+#endif /* M64P_DEVICE_R4300_BLOCK_ARENA_H */
@@ -35,6 +35,7 @@
 #include "device/r4300/r4300_core.h"
 #include "device/r4300/idec.h"
 #include "main/main.h"
+#include "osal/atomics.h"
 #include "osal/preproc.h"
 
 #ifdef DBG
@@ -340,6 +341,65 @@ static void (*const ci_table[R4300_OPCODES_COUNT])(void) =
 };
 #undef X
 
+// -----------------------------------------------------------
+// Threaded dispatch (EMUMODE_THREADED_INTERPRETER)
+// -----------------------------------------------------------
+/* Threaded dispatch relies on the GNU labels-as-values extension, and the
+ * debugger / core comparison hooks need to run between every instruction. */
+#if defined(__GNUC__) && !defined(DBG) && !defined(COMPARE_CORE)
+#define CACHED_INTERP_THREADED
+#endif
+
+/* Straight-line instructions which get their own dispatch label.
+ * Anything else (jumps, branches, exceptions, COP0, ...) is run through
+ * its ops handler, after which the stop flag is checked. */
+#define CI_THREADED_OPS \
+    X(ADD) X(ADDI) X(ADDIU) X(ADDU) X(AND) X(ANDI) X(NOR) X(OR) X(ORI) \
+    X(XOR) X(XORI) X(LUI) X(NOP) X(SLT) X(SLTI) X(SLTIU) X(SLTU) X(SUB) \
+    X(SUBU) X(SLL) X(SLLV) X(SRA) X(SRAV) X(SRL) X(SRLV) \
+    X(DADD) X(DADDI) X(DADDIU) X(DADDU) X(DSUB) X(DSUBU) \
+    X(DSLL) X(DSLL32) X(DSLLV) X(DSRA) X(DSRA32) X(DSRAV) X(DSRL) X(DSRL32) X(DSRLV) \
+    X(MULT) X(MULTU) X(DIV) X(DIVU) X(DMULT) X(DMULTU) X(DDIV) X(DDIVU) \
+    X(MFHI) X(MFLO) X(MTHI) X(MTLO) \
+    X(LB) X(LBU) X(LH) X(LHU) X(LW) X(LWU) X(LWL) X(LWR) X(LD) \
+    X(SB) X(SH) X(SW) X(SWL) X(SWR) X(SD) \
+    X(LWC1) X(LDC1) X(SWC1) X(SDC1) X(MFC1) X(DMFC1) X(MTC1) X(DMTC1) \
+    X(CACHE) X(SYNC)
+
+/* Superinstructions: frequent pairs run with a single dispatch.
+ * The first instruction gets the pair label when both were decoded together,
+ * see cached_interp_recompile_block. */
+#define CI_THREADED_PAIRS \
+    X(LUI, ADDIU) \
+    X(LUI, ORI) \
+    X(LW, BEQ) \
+    X(LW, BNE) \
+    X(ADDIU, BNE)
+
+enum
+{
+#define X(a, b) CI_PAIR_##a##_##b,
+    CI_THREADED_PAIRS
+#undef X
+    CI_PAIRS_COUNT
+};
+
+/* Filled by cached_interp_threaded_init; NULL when threaded dispatch isn't used. */
+static const void* ci_labels[R4300_OPCODES_COUNT];
+static const void* ci_pair_labels[CI_PAIRS_COUNT];
+static const void* ci_call_label;
+
+static void fuse_threaded_pair(struct precomp_instr* first, enum r4300_opcode first_opcode, enum r4300_opcode second_opcode)
+{
+#define X(a, b) \
+    if (first_opcode == R4300_OP_##a && second_opcode == R4300_OP_##b) { \
+        first->label = ci_pair_labels[CI_PAIR_##a##_##b]; \
+        return; \
+    }
+    CI_THREADED_PAIRS
+#undef X
+}
+
 /* return 0:normal, 1:idle, 2:out */
 static int infer_jump_sub_type(uint32_t target, uint32_t pc, uint32_t next_iw, const struct precomp_block* block)
 {
@@ -366,6 +426,9 @@ enum r4300_opcode r4300_decode(struct precomp_instr* inst, struct r4300_core* r4
     uint8_t dummy;
     enum r4300_opcode opcode = idec->opcode;
 
+    /* handlers picked directly below (CP1 formats) are run through ops */
+    inst->label = ci_call_label;
+
     switch(idec->opcode)
     {
     case R4300_OP_JALR:
@@ -690,6 +753,7 @@ enum r4300_opcode r4300_decode(struct precomp_instr* inst, struct r4300_core* r4
 
     /* set appropriate handler */
     inst->ops = ci_table[opcode];
+    inst->label = ci_labels[opcode];
 
     /* propagate opcode info to allow further processing */
     return opcode;
@@ -747,16 +811,24 @@ size_t get_block_memsize(const struct precomp_block *block)
     return ((length+1)+(length>>2)) * sizeof(struct precomp_instr);
 }
 
+/* cached interpreter blocks are always one page long, see get_block_memsize */
+#define BLOCK_HEADER_SIZE ((sizeof(struct precomp_block) + 63) & ~(size_t)63)
+#define BLOCK_INSTRUCTIONS_SIZE ((1024+1+(1024>>2)) * sizeof(struct precomp_instr))
+
 void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
 {
     int i, length;
 
     struct precomp_block** block = &r4300->cached_interp.blocks[address >> 12];
 
-    /* allocate block */
+    /* allocate block and its instructions in a single arena slot */
     if (*block == NULL) {
-        *block = malloc(sizeof(struct precomp_block));
-        (*block)->block = NULL;
+        *block = block_arena_alloc(&r4300->cached_interp.arena);
+        if (*block == NULL) {
+            DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
+            return;
+        }
+        (*block)->block = (struct precomp_instr*)((unsigned char*)(*block) + BLOCK_HEADER_SIZE);
         (*block)->start = address & ~UINT32_C(0xfff);
         (*block)->end = (address & ~UINT32_C(0xfff)) + 0x1000;
     }
@@ -769,24 +841,12 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
     DebugMessage(M64MSG_INFO, "init block %" PRIX32 " - %" PRIX32, b->start, b->end);
 #endif
 
-    /* allocate block instructions */
-    if (!b->block)
-    {
-        size_t memsize = get_block_memsize(b);
-        b->block = (struct precomp_instr*)malloc(memsize);
-        if (!b->block) {
-            DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
-            return;
-        }
-
-        memset(b->block, 0, memsize);
-    }
-
     /* reset block instructions (addr + ops) */
     for (i = 0; i < length; ++i)
     {
         b->block[i].addr = b->start + 4*i;
         b->block[i].ops = cached_interp_NOTCOMPILED;
+        b->block[i].label = ci_call_label;
     }
 
     /* here we're marking the block as a valid code even if it's not compiled
@@ -818,19 +878,18 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
     }
 }
 
-void cached_interp_free_block(struct precomp_block* block)
+void cached_interp_free_block(struct cached_interp* cinterp, struct precomp_block* block)
 {
-    if (block->block) {
-        free(block->block);
-        block->block = NULL;
-    }
+    block_arena_free(&cinterp->arena, block);
 }
 
 void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struct precomp_block* block, uint32_t func)
 {
     int i, length, length2, finished;
     struct precomp_instr* inst;
+    struct precomp_instr* prev_inst = NULL;
     enum r4300_opcode opcode;
+    enum r4300_opcode prev_opcode = R4300_OP_RESERVED;
 
     /* ??? not sure why we need these 2 different tests */
     int block_start_in_tlb = ((block->start & UINT32_C(0xc0000000)) != UINT32_C(0x80000000));
@@ -842,6 +901,8 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
     /* reset xxhash */
     block->xxhash = 0;
 
+    cached_interp_count_recompile(&r4300->cached_interp);
+
 
     for (i = (func & 0xFFF) / 4, finished = 0; finished != 2; ++i)
     {
@@ -861,6 +922,12 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
         /* decode instruction */
         opcode = r4300_decode(inst, r4300, r4300_get_idec(iw[i]), iw[i], iw[i+1], block);
 
+        if (prev_inst != NULL) {
+            fuse_threaded_pair(prev_inst, prev_opcode, opcode);
+        }
+        prev_inst = inst;
+        prev_opcode = opcode;
+
         /* decode ending conditions */
         if (i >= length2) { finished = 2; }
         if (i >= (length-1)
@@ -881,12 +948,14 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
         inst = block->block + i;
         inst->addr = block->start + i*4;
         inst->ops = cached_interp_FIN_BLOCK;
+        inst->label = ci_call_label;
         ++i;
         if (i <= length2) // useful when last opcode is a jump
         {
             inst = block->block + i;
             inst->addr = block->start + i*4;
             inst->ops = cached_interp_FIN_BLOCK;
+            inst->label = ci_call_label;
             i++;
         }
     }
@@ -927,6 +996,10 @@ void init_blocks(struct cached_interp* cinterp)
         cinterp->invalid_code[i] = 1;
         cinterp->blocks[i] = NULL;
     }
+
+    /* every block covers one 4KB page */
+    block_arena_init(&cinterp->arena, BLOCK_HEADER_SIZE + BLOCK_INSTRUCTIONS_SIZE);
+    osal_atomic_store_release(&cinterp->recompiles, 0);
 }
 
 void free_blocks(struct cached_interp* cinterp)
@@ -936,11 +1009,25 @@ void free_blocks(struct cached_interp* cinterp)
     {
         if (cinterp->blocks[i])
         {
-            cinterp->free_block(cinterp->blocks[i]);
-            free(cinterp->blocks[i]);
+            cinterp->free_block(cinterp, cinterp->blocks[i]);
             cinterp->blocks[i] = NULL;
         }
     }
+
+    block_arena_release(&cinterp->arena);
+}
+
+void cached_interp_count_recompile(struct cached_interp* cinterp)
+{
+    osal_atomic_store_release(&cinterp->recompiles, cinterp->recompiles + 1);
+}
+
+void cached_interp_get_stats(const struct cached_interp* cinterp, m64p_code_cache_stats* stats)
+{
+    stats->live_blocks = block_arena_stat(&cinterp->arena, BLOCK_ARENA_LIVE_SLOTS);
+    stats->bytes_used = block_arena_stat(&cinterp->arena, BLOCK_ARENA_BYTES_USED);
+    stats->bytes_reserved = block_arena_stat(&cinterp->arena, BLOCK_ARENA_BYTES_RESERVED);
+    stats->recompiles = osal_atomic_load_acquire(&cinterp->recompiles);
 }
 
 void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address, size_t size)
@@ -984,8 +1071,101 @@ void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address
     }
 }
 
+#ifdef CACHED_INTERP_THREADED
+/* Runs the cached interpreter with one indirect jump per instruction instead
+ * of a call/return through ops. Labels are stored in each precomp_instr by
+ * r4300_decode; with r4300 == NULL only the label addresses are published. */
+static void run_threaded_dispatch(struct r4300_core* r4300)
+{
+    static const struct { enum r4300_opcode opcode; const void* label; } op_labels[] =
+    {
+#define X(op) { R4300_OP_##op, &&dispatch_##op },
+        CI_THREADED_OPS
+#undef X
+    };
+    static const void* const pair_labels[CI_PAIRS_COUNT] =
+    {
+#define X(a, b) &&dispatch_##a##_##b,
+        CI_THREADED_PAIRS
+#undef X
+    };
+    struct precomp_instr** pc;
+    const int* stop;
+    struct precomp_instr* first;
+    size_t i;
+
+    if (r4300 == NULL)
+    {
+        for (i = 0; i < R4300_OPCODES_COUNT; ++i) {
+            ci_labels[i] = &&dispatch_call;
+        }
+        for (i = 0; i < sizeof(op_labels) / sizeof(op_labels[0]); ++i) {
+            ci_labels[op_labels[i].opcode] = op_labels[i].label;
+        }
+        for (i = 0; i < CI_PAIRS_COUNT; ++i) {
+            ci_pair_labels[i] = pair_labels[i];
+        }
+        /* RESERVED never gets a label of its own */
+        ci_call_label = ci_labels[R4300_OP_RESERVED];
+        return;
+    }
+
+    pc = r4300_pc_struct(r4300);
+    stop = r4300_stop(r4300);
+
+    /* like the dynarec, stop requests are only honored after instructions
+     * which may leave the straight-line path (jumps, interrupts, exceptions) */
+dispatch_next:
+    if (*stop) {
+        return;
+    }
+    goto *(*pc)->label;
+
+dispatch_call:
+    (*pc)->ops();
+    goto dispatch_next;
+
+#define X(op) \
+dispatch_##op: \
+    cached_interp_##op(); \
+    goto *(*pc)->label;
+    CI_THREADED_OPS
+#undef X
+
+    /* the second instruction is skipped if the first one raised an exception */
+#define X(a, b) \
+dispatch_##a##_##b: \
+    first = *pc; \
+    cached_interp_##a(); \
+    if (*pc == first + 1) { \
+        cached_interp_##b(); \
+    } \
+    goto dispatch_next;
+    CI_THREADED_PAIRS
+#undef X
+}
+#endif
+
+int cached_interp_threaded_init(void)
+{
+#ifdef CACHED_INTERP_THREADED
+    run_threaded_dispatch(NULL);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
 void run_cached_interpreter(struct r4300_core* r4300)
 {
+#ifdef CACHED_INTERP_THREADED
+    if (r4300->emumode == EMUMODE_THREADED_INTERPRETER)
+    {
+        run_threaded_dispatch(r4300);
+        return;
+    }
+#endif
+
     while (!*r4300_stop(r4300))
     {
 #ifdef COMPARE_CORE
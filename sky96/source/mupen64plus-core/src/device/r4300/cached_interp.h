@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "api/m64p_types.h"
 #include "idec.h"
 
 struct r4300_core;
@@ -39,17 +40,25 @@ int get_block_length(const struct precomp_block *block);
 size_t get_block_memsize(const struct precomp_block *block);
 
 void cached_interp_init_block(struct r4300_core* r4300, uint32_t address);
-void cached_interp_free_block(struct precomp_block* block);
+void cached_interp_free_block(struct cached_interp* cinterp, struct precomp_block* block);
 
 void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struct precomp_block* block, uint32_t func);
 
 void init_blocks(struct cached_interp* cinterp);
 void free_blocks(struct cached_interp* cinterp);
 
+void cached_interp_count_recompile(struct cached_interp* cinterp);
+/* May be called from any thread. */
+void cached_interp_get_stats(const struct cached_interp* cinterp, m64p_code_cache_stats* stats);
+
 void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address, size_t size);
 
 void run_cached_interpreter(struct r4300_core* r4300);
 
+/* Sets up threaded dispatch for EMUMODE_THREADED_INTERPRETER.
+ * Returns 0 if this build doesn't support it. */
+int cached_interp_threaded_init(void);
+
 /* Jumps to the given address. This is for the cached interpreter. */
 void cached_interpreter_jump_to(struct r4300_core* r4300, uint32_t address);
 
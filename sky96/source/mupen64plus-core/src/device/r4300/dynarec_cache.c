@@ -0,0 +1,260 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - dynarec_cache.c                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "dynarec_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "osal/files.h"
+
+/* File layout, in host byte order: header, then the pages. The checksum
+ * covers the pages. Bump the version whenever the block boundaries chosen by
+ * the dynarec change, as recorded entry points would then be meaningless. */
+#define DYNAREC_CACHE_MAGIC "M64+DYNC"
+enum { DYNAREC_CACHE_VERSION = 1 };
+
+/* Enough for every page of an 8 MB RDRAM to have two variants. */
+enum { DYNAREC_CACHE_MAX_PAGES = 4096 };
+
+struct dynarec_cache_page
+{
+    uint32_t start;
+    uint32_t padding;
+    uint64_t hash;
+    uint32_t entries[32];
+};
+
+struct dynarec_cache_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t count;
+    uint32_t padding;
+    uint64_t checksum;
+};
+
+static uint32_t dynarec_cache_hash(uint32_t start, uint64_t hash)
+{
+    uint32_t h = (uint32_t)hash ^ (uint32_t)(hash >> 32) ^ (start * 0x9e3779b1u);
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+}
+
+static uint32_t* dynarec_cache_find_slot(const struct dynarec_cache* cache, uint32_t start, uint64_t hash)
+{
+    uint32_t i = dynarec_cache_hash(start, hash) & cache->slot_mask;
+
+    for (;; i = (i + 1) & cache->slot_mask)
+    {
+        const struct dynarec_cache_page* page;
+
+        if (cache->slots[i] == 0)
+            return &cache->slots[i];
+
+        page = &cache->pages[cache->slots[i] - 1];
+        if (page->start == start && page->hash == hash)
+            return &cache->slots[i];
+    }
+}
+
+/* Grows the page array and rebuilds the slots. Returns 0 if out of memory. */
+static int dynarec_cache_grow(struct dynarec_cache* cache, uint32_t capacity)
+{
+    struct dynarec_cache_page* pages;
+    uint32_t* slots;
+    uint32_t slot_count = 16;
+    uint32_t i;
+
+    /* Keep the table at most half full. */
+    while (slot_count < 2 * capacity)
+        slot_count <<= 1;
+
+    pages = realloc(cache->pages, capacity * sizeof(*pages));
+    if (pages == NULL)
+        return 0;
+    cache->pages = pages;
+
+    slots = calloc(slot_count, sizeof(*slots));
+    if (slots == NULL)
+        return 0;
+
+    free(cache->slots);
+    cache->slots = slots;
+    cache->slot_mask = slot_count - 1;
+    cache->capacity = capacity;
+
+    for (i = 0; i < cache->count; ++i)
+        *dynarec_cache_find_slot(cache, cache->pages[i].start, cache->pages[i].hash) = i + 1;
+
+    return 1;
+}
+
+void dynarec_cache_init(struct dynarec_cache* cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+void dynarec_cache_release(struct dynarec_cache* cache)
+{
+    free(cache->pages);
+    free(cache->slots);
+    dynarec_cache_init(cache);
+}
+
+uint32_t dynarec_cache_load(struct dynarec_cache* cache, const char* path)
+{
+    struct dynarec_cache_header header;
+    struct dynarec_cache_page* pages;
+    FILE* f;
+
+    dynarec_cache_release(cache);
+
+    if ((f = osal_file_open(path, "rb")) == NULL)
+        return 0;
+
+    if (fread(&header, sizeof(header), 1, f) != 1
+     || memcmp(header.magic, DYNAREC_CACHE_MAGIC, sizeof(header.magic)) != 0
+     || header.version != DYNAREC_CACHE_VERSION
+     || header.page_size != sizeof(struct dynarec_cache_page)
+     || header.count == 0 || header.count > DYNAREC_CACHE_MAX_PAGES
+     || (pages = malloc(header.count * sizeof(*pages))) == NULL)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    if (fread(pages, sizeof(*pages), header.count, f) != header.count
+     || XXH3_64bits(pages, header.count * sizeof(*pages)) != header.checksum)
+    {
+        DebugMessage(M64MSG_VERBOSE, "Dynarec cache: ignoring corrupt file '%s'", path);
+        free(pages);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    cache->pages = pages;
+    cache->count = header.count;
+    if (!dynarec_cache_grow(cache, header.count))
+    {
+        dynarec_cache_release(cache);
+        return 0;
+    }
+
+    DebugMessage(M64MSG_VERBOSE, "Dynarec cache: loaded %u pages from '%s'", cache->count, path);
+    return cache->count;
+}
+
+void dynarec_cache_save(struct dynarec_cache* cache, const char* path)
+{
+    struct dynarec_cache_header header;
+    FILE* f;
+    int ok;
+
+    if (!cache->dirty)
+        return;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DYNAREC_CACHE_MAGIC, sizeof(header.magic));
+    header.version = DYNAREC_CACHE_VERSION;
+    header.page_size = sizeof(struct dynarec_cache_page);
+    header.count = cache->count;
+    header.checksum = XXH3_64bits(cache->pages, cache->count * sizeof(*cache->pages));
+
+    if ((f = osal_file_open(path, "wb")) == NULL)
+    {
+        DebugMessage(M64MSG_VERBOSE, "Dynarec cache: unable to write '%s'", path);
+        return;
+    }
+
+    ok = (fwrite(&header, sizeof(header), 1, f) == 1
+       && fwrite(cache->pages, sizeof(*cache->pages), cache->count, f) == cache->count);
+    if (fclose(f) != 0 || !ok)
+    {
+        DebugMessage(M64MSG_VERBOSE, "Dynarec cache: unable to write '%s'", path);
+        remove(path);
+        return;
+    }
+
+    cache->dirty = 0;
+}
+
+void dynarec_cache_record(struct dynarec_cache* cache, uint32_t start, uint64_t hash, uint32_t func)
+{
+    struct dynarec_cache_page* page;
+    uint32_t index = (func & 0xfff) / 4;
+    uint32_t bit = UINT32_C(1) << (index % 32);
+    uint32_t* slot;
+
+    if (cache->count != 0)
+    {
+        slot = dynarec_cache_find_slot(cache, start, hash);
+        if (*slot != 0)
+        {
+            page = &cache->pages[*slot - 1];
+            if (!(page->entries[index / 32] & bit))
+            {
+                page->entries[index / 32] |= bit;
+                cache->dirty = 1;
+            }
+            return;
+        }
+    }
+
+    if (cache->count == DYNAREC_CACHE_MAX_PAGES)
+        return;
+
+    if (cache->count == cache->capacity
+     && !dynarec_cache_grow(cache, cache->capacity ? 2 * cache->capacity : 256))
+        return;
+
+    page = &cache->pages[cache->count];
+    memset(page, 0, sizeof(*page));
+    page->start = start;
+    page->hash = hash;
+    page->entries[index / 32] = bit;
+
+    *dynarec_cache_find_slot(cache, start, hash) = ++cache->count;
+    cache->dirty = 1;
+}
+
+const uint32_t* dynarec_cache_lookup(const struct dynarec_cache* cache, uint32_t start, uint64_t hash)
+{
+    uint32_t slot;
+
+    if (cache->count == 0)
+        return NULL;
+
+    slot = *dynarec_cache_find_slot(cache, start, hash);
+    return (slot != 0) ? cache->pages[slot - 1].entries : NULL;
+}
@@ -0,0 +1,67 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - dynarec_cache.h                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_DYNAREC_CACHE_H
+#define M64P_DEVICE_R4300_DYNAREC_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Per-ROM record of the code the dynarec compiled, kept across runs.
+ *
+ * The generated code itself embeds host addresses (helpers, r4300 state,
+ * precomp_instr slots) and can't be reused by another process, so the cache
+ * remembers where compilation happened instead: for each page and source
+ * contents, the entry points that were compiled. When a page whose contents
+ * match a record is initialized again, all of its known entry points are
+ * compiled together instead of one stall at a time as execution reaches them.
+ *
+ * Pages are keyed by their KSEG0/KSEG1 start address and the XXH3 hash of the
+ * 4 KB source, so overlays loaded at the same address get separate records. */
+
+struct dynarec_cache_page;
+
+struct dynarec_cache
+{
+    struct dynarec_cache_page* pages;
+    uint32_t* slots;            /* page index plus one, zero for an empty slot */
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t slot_mask;
+    int dirty;
+};
+
+void dynarec_cache_init(struct dynarec_cache* cache);
+void dynarec_cache_release(struct dynarec_cache* cache);
+
+/* Replaces the cache contents with the file's. A missing, stale or corrupt
+ * file leaves the cache empty. Returns the number of pages loaded. */
+uint32_t dynarec_cache_load(struct dynarec_cache* cache, const char* path);
+/* Writes the cache if it changed since it was loaded. */
+void dynarec_cache_save(struct dynarec_cache* cache, const char* path);
+
+void dynarec_cache_record(struct dynarec_cache* cache, uint32_t start, uint64_t hash, uint32_t func);
+
+/* Returns a bitmap of the compiled instruction indices of the page,
+ * 32 words long, or NULL if the page wasn't compiled with these contents. */
+const uint32_t* dynarec_cache_lookup(const struct dynarec_cache* cache, uint32_t start, uint64_t hash);
+
+#endif /* M64P_DEVICE_R4300_DYNAREC_CACHE_H */
@@ -0,0 +1,165 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - event_queue.h                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_EVENT_QUEUE_H
+#define M64P_DEVICE_R4300_EVENT_QUEUE_H
+
+#include <stdint.h>
+
+#include "osal/preproc.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Interrupt event scheduler.
+ *
+ * There is at most one pending event of each type and types are single
+ * bits, so every event lives in the slot of its type (type == 1 << slot)
+ * and looking up a pending event is a direct slot access. The firing order
+ * is packed as 4-bit slot numbers in a single 64-bit word, next to fire in
+ * the low nibble: firing the head is a shift, and scheduling an event scans
+ * the pending counts, which sit next to each other in memory, instead of
+ * chasing list nodes.
+ *
+ * Events are compared exactly like the former sorted linked list did, so
+ * the firing order (and the savestate layout derived from it) is unchanged. */
+
+enum { INTERRUPT_EVENT_SLOTS = 16 };
+
+struct interrupt_queue
+{
+    uint32_t count[INTERRUPT_EVENT_SLOTS];
+    uint64_t order;     /* nibble i is the slot firing in position i */
+    uint32_t pending;   /* bitmask of occupied slots */
+    unsigned int size;
+};
+
+static osal_inline int event_queue_ctz(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/* slot of an event type, -1 if type is not a valid event type */
+static osal_inline int event_queue_slot(int type)
+{
+    if (type <= 0 || type >= (1 << INTERRUPT_EVENT_SLOTS) || (type & (type - 1)) != 0)
+        return -1;
+
+    return event_queue_ctz((uint32_t)type);
+}
+
+static osal_inline void event_queue_clear(struct interrupt_queue* q)
+{
+    q->order = 0;
+    q->pending = 0;
+    q->size = 0;
+}
+
+/* slot firing in position i */
+static osal_inline int event_queue_at(const struct interrupt_queue* q, unsigned int i)
+{
+    return (int)((q->order >> (4 * i)) & 0xf);
+}
+
+/* slot of the next event to fire, -1 when empty */
+static osal_inline int event_queue_first(const struct interrupt_queue* q)
+{
+    return (q->size != 0) ? event_queue_at(q, 0) : -1;
+}
+
+/* bits of the positions before i */
+static osal_inline uint64_t event_queue_low_mask(unsigned int i)
+{
+    return (i < INTERRUPT_EVENT_SLOTS) ? ((UINT64_C(1) << (4 * i)) - 1) : UINT64_MAX;
+}
+
+static osal_inline void event_queue_remove(struct interrupt_queue* q, int slot)
+{
+    unsigned int i;
+    uint64_t low;
+
+    if ((q->pending & (UINT32_C(1) << slot)) == 0)
+        return;
+
+    q->pending &= ~(UINT32_C(1) << slot);
+    --q->size;
+
+    /* firing the head */
+    if (event_queue_at(q, 0) == slot)
+    {
+        q->order >>= 4;
+        return;
+    }
+
+    for (i = 1; event_queue_at(q, i) != slot; ++i);
+
+    low = event_queue_low_mask(i);
+    q->order = (q->order & low) | ((q->order >> 4) & ~low);
+}
+
+static osal_inline void event_queue_insert_at(struct interrupt_queue* q, unsigned int i, int slot, uint32_t count)
+{
+    uint64_t low = event_queue_low_mask(i);
+
+    q->order = (q->order & low) | ((uint64_t)slot << (4 * i)) | ((q->order & ~low) << 4);
+    ++q->size;
+
+    q->count[slot] = count;
+    q->pending |= UINT32_C(1) << slot;
+}
+
+/* Schedule an event after all the pending events which do not fire
+ * strictly after it, counts being taken relative to ref.
+ * A pending event of the same type is replaced. */
+static osal_inline void event_queue_insert(struct interrupt_queue* q, int slot, uint32_t count, uint32_t ref)
+{
+    unsigned int i;
+
+    event_queue_remove(q, slot);
+
+    for (i = 0; i < q->size && (q->count[event_queue_at(q, i)] - ref) <= (count - ref); ++i);
+
+    event_queue_insert_at(q, i, slot, count);
+}
+
+/* Schedule an event ahead of all others, whatever its count. */
+static osal_inline void event_queue_push_front(struct interrupt_queue* q, int slot, uint32_t count)
+{
+    event_queue_remove(q, slot);
+    event_queue_insert_at(q, 0, slot, count);
+}
+
+static osal_inline void event_queue_translate(struct interrupt_queue* q, uint32_t delta)
+{
+    unsigned int i;
+
+    for (i = 0; i < q->size; ++i)
+        q->count[event_queue_at(q, i)] += delta;
+}
+
+#endif /* M64P_DEVICE_R4300_EVENT_QUEUE_H */
@@ -44,61 +44,18 @@
 #include "device/rcp/ai/ai_controller.h"
 #include "device/rcp/vi/vi_controller.h"
 #include "main/main.h"
+#include "main/rewind.h"
+#include "main/sample_profiler.h"
 #include "main/savestates.h"
+#include "main/telemetry.h"
 
 
-/***************************************************************************
- * Pool of Single Linked List Nodes
- **************************************************************************/
-
-static struct node* alloc_node(struct pool* p);
-static void free_node(struct pool* p, struct node* node);
-static void clear_pool(struct pool* p);
-
-
-/* node allocation/deallocation on a given pool */
-static struct node* alloc_node(struct pool* p)
-{
-    /* return NULL if pool is too small */
-    if (p->index >= INTERRUPT_NODES_POOL_CAPACITY) {
-        return NULL;
-    }
-
-    return p->stack[p->index++];
-}
-
-static void free_node(struct pool* p, struct node* node)
-{
-    if (p->index == 0 || node == NULL) {
-        return;
-    }
-
-    p->stack[--p->index] = node;
-}
-
-/* release all nodes */
-static void clear_pool(struct pool* p)
-{
-    size_t i;
-
-    for (i = 0; i < INTERRUPT_NODES_POOL_CAPACITY; ++i) {
-        p->stack[i] = &p->nodes[i];
-    }
-
-    p->index = 0;
-}
-
 /***************************************************************************
  * Interrupt Queue
  **************************************************************************/
 
-static void clear_queue(struct interrupt_queue* q)
-{
-    q->first = NULL;
-    clear_pool(&q->pool);
-}
-
-static int before_event(const struct cp0* cp0, unsigned int evt1, unsigned int evt2, int type2)
+/* count which event counts are compared against when inserting */
+static uint32_t queue_reference(const struct cp0* cp0)
 {
     const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)cp0); /* OK to cast away const qualifier */
     uint32_t count = cp0_regs[CP0_COUNT_REG];
@@ -108,8 +65,23 @@ static int before_event(const struct cp0* cp0, unsigned int evt1, unsigned int e
     if (*cp0_cycle_count > 0)
         count -= *cp0_cycle_count;
 
-    if ((evt1 - count) < (evt2 - count)) return 1;
-    else return 0;
+    return count;
+}
+
+static void update_next_interrupt(struct cp0* cp0)
+{
+    const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
+    unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
+    int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
+    int first = event_queue_first(&cp0->q);
+
+    *cp0_next_interrupt = (first >= 0)
+        ? cp0->q.count[first]
+        : 0;
+
+    *cp0_cycle_count = (first >= 0)
+        ? (cp0_regs[CP0_COUNT_REG] - cp0->q.count[first])
+        : 0;
 }
 
 unsigned int add_random_interrupt_time(struct r4300_core* r4300)
@@ -134,146 +106,71 @@ void add_interrupt_event(struct cp0* cp0, int type, unsigned int delay)
 
 void add_interrupt_event_count(struct cp0* cp0, int type, unsigned int count)
 {
-    struct node* event;
-    struct node* e;
-    const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
-    unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
-    int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
+    int slot = event_queue_slot(type);
 
-    if (get_event(&cp0->q, type)) {
-        DebugMessage(M64MSG_WARNING, "two events of type 0x%x in interrupt queue", type);
-    }
-
-    event = alloc_node(&cp0->q.pool);
-    if (event == NULL)
+    if (slot < 0)
     {
-        DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
+        DebugMessage(M64MSG_ERROR, "Unknown interrupt event type 0x%x", type);
         return;
     }
 
-    event->data.count = count;
-    event->data.type = type;
-
-    if (cp0->q.first == NULL)
-    {
-        cp0->q.first = event;
-        event->next = NULL;
-    }
-    else if (before_event(cp0, count, cp0->q.first->data.count, cp0->q.first->data.type))
-    {
-        event->next = cp0->q.first;
-        cp0->q.first = event;
+    /* the new event replaces the pending one */
+    if (cp0->q.pending & (UINT32_C(1) << slot)) {
+        DebugMessage(M64MSG_WARNING, "two events of type 0x%x in interrupt queue", type);
     }
-    else
-    {
-        for (e = cp0->q.first;
-            e->next != NULL &&
-            (!before_event(cp0, count, e->next->data.count, e->next->data.type));
-            e = e->next);
-
-        if (e->next == NULL)
-        {
-            e->next = event;
-            event->next = NULL;
-        }
-        else
-        {
-            for(; e->next != NULL && e->next->data.count == count; e = e->next);
 
-            event->next = e->next;
-            e->next = event;
-        }
-    }
-    *cp0_next_interrupt = cp0->q.first->data.count;
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+    event_queue_insert(&cp0->q, slot, count, queue_reference(cp0));
+    update_next_interrupt(cp0);
 }
 
 void remove_interrupt_event(struct cp0* cp0)
 {
-    struct node* e;
-    const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
-    unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
-    int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
-
-    e = cp0->q.first;
-    cp0->q.first = e->next;
-    free_node(&cp0->q.pool, e);
+    int first = event_queue_first(&cp0->q);
 
-    *cp0_next_interrupt = (cp0->q.first != NULL)
-        ? cp0->q.first->data.count
-        : 0;
-
-    *cp0_cycle_count = (cp0->q.first != NULL)
-        ? (cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count)
-        : 0;
+    if (first >= 0) {
+        event_queue_remove(&cp0->q, first);
+    }
+    update_next_interrupt(cp0);
 }
 
 unsigned int* get_event(const struct interrupt_queue* q, int type)
 {
-    struct node* e = q->first;
+    int slot = event_queue_slot(type);
 
-    if (e == NULL) {
+    if (slot < 0 || (q->pending & (UINT32_C(1) << slot)) == 0) {
         return NULL;
     }
 
-    if (e->data.type == type) {
-        return &e->data.count;
-    }
-
-    for (; e->next != NULL && e->next->data.type != type; e = e->next);
-
-    return (e->next != NULL)
-        ? &e->next->data.count
-        : NULL;
+    return (unsigned int*)&q->count[slot];
 }
 
 int get_next_event_type(const struct interrupt_queue* q)
 {
-    return (q->first == NULL)
+    int first = event_queue_first(q);
+
+    return (first < 0)
         ? 0
-        : q->first->data.type;
+        : (1 << first);
 }
 
 void remove_event(struct interrupt_queue* q, int type)
 {
-    struct node* to_del;
-    struct node* e = q->first;
+    int slot = event_queue_slot(type);
 
-    if (e == NULL) {
-        return;
-    }
-
-    if (e->data.type == type)
-    {
-        q->first = e->next;
-        free_node(&q->pool, e);
-    }
-    else
-    {
-        for (; e->next != NULL && e->next->data.type != type; e = e->next);
-
-        if (e->next != NULL)
-        {
-            to_del = e->next;
-            e->next = to_del->next;
-            free_node(&q->pool, to_del);
-        }
+    if (slot >= 0) {
+        event_queue_remove(q, slot);
     }
 }
 
 void translate_event_queue(struct cp0* cp0, unsigned int base)
 {
-    struct node* e;
     uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
 
     remove_event(&cp0->q, COMPARE_INT);
     remove_event(&cp0->q, SPECIAL_INT);
 
-    for (e = cp0->q.first; e != NULL; e = e->next)
-    {
-        e->data.count = (e->data.count - cp0_regs[CP0_COUNT_REG]) + base;
-    }
+    event_queue_translate(&cp0->q, base - cp0_regs[CP0_COUNT_REG]);
 
     cp0_regs[CP0_COUNT_REG] = base;
     add_interrupt_event_count(cp0, SPECIAL_INT, ((cp0_regs[CP0_COUNT_REG] & UINT32_C(0x80000000)) ^ UINT32_C(0x80000000)));
@@ -285,20 +182,27 @@ void translate_event_queue(struct cp0* cp0, unsigned int base)
     cp0_regs[CP0_COUNT_REG] -= cp0->count_per_op;
 
     /* Update next interrupt in case first event is COMPARE_INT */
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.count[event_queue_first(&cp0->q)];
 }
 
 int save_eventqueue_infos(const struct cp0* cp0, char *buf)
 {
     int len;
-    struct node* e;
+    unsigned int i;
 
     len = 0;
 
-    for (e = cp0->q.first; e != NULL; e = e->next)
+    for (i = 0; i < cp0->q.size; ++i)
     {
-        memcpy(buf + len    , &e->data.type , 4);
-        memcpy(buf + len + 4, &e->data.count, 4);
+        int slot = event_queue_at(&cp0->q, i);
+        uint32_t type = UINT32_C(1) << slot;
+
+        /* the profiler is not part of the emulated machine */
+        if (type == PROFILE_EVT)
+            continue;
+
+        memcpy(buf + len    , &type              , 4);
+        memcpy(buf + len + 4, &cp0->q.count[slot], 4);
         len += 8;
     }
 
@@ -311,7 +215,7 @@ void load_eventqueue_infos(struct cp0* cp0, const char *buf)
     int len = 0;
     uint32_t* cp0_regs = r4300_cp0_regs(cp0);
 
-    clear_queue(&cp0->q);
+    event_queue_clear(&cp0->q);
 
     while (*((const unsigned int*)&buf[len]) != 0xFFFFFFFF)
     {
@@ -327,14 +231,13 @@ void load_eventqueue_infos(struct cp0* cp0, const char *buf)
 
 void init_interrupt(struct cp0* cp0)
 {
-    clear_queue(&cp0->q);
+    event_queue_clear(&cp0->q);
     add_interrupt_event_count(cp0, SPECIAL_INT, 0x80000000);
     add_interrupt_event_count(cp0, COMPARE_INT, 0);
 }
 
 void r4300_check_interrupt(struct r4300_core* r4300, uint32_t cause_ip, int set_cause)
 {
-    struct node* event;
     uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(&r4300->cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0);
@@ -351,29 +254,10 @@ void r4300_check_interrupt(struct r4300_core* r4300, uint32_t cause_ip, int set_
     }
     if (cp0_regs[CP0_STATUS_REG] & cp0_regs[CP0_CAUSE_REG] & UINT32_C(0xFF00))
     {
-        event = alloc_node(&r4300->cp0.q.pool);
+        event_queue_push_front(&r4300->cp0.q, event_queue_slot(CHECK_INT), cp0_regs[CP0_COUNT_REG]);
 
-        if (event == NULL)
-        {
-            DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
-            return;
-        }
-
-        event->data.count = *cp0_next_interrupt = cp0_regs[CP0_COUNT_REG];
-        event->data.type = CHECK_INT;
+        *cp0_next_interrupt = cp0_regs[CP0_COUNT_REG];
         *cp0_cycle_count = 0;
-
-        if (r4300->cp0.q.first == NULL)
-        {
-            r4300->cp0.q.first = event;
-            event->next = NULL;
-        }
-        else
-        {
-            event->next = r4300->cp0.q.first;
-            r4300->cp0.q.first = event;
-
-        }
     }
 }
 
@@ -406,7 +290,7 @@ void compare_int_handler(void* opaque)
     cp0_regs[CP0_COUNT_REG] -= r4300->cp0.count_per_op;
 
     /* Update next interrupt in case first event is COMPARE_INT */
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.first->data.count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.count[event_queue_first(&r4300->cp0.q)];
 
     raise_maskable_interrupt(r4300, CP0_CAUSE_IP7);
 }
@@ -500,7 +384,7 @@ void reset_hard_handler(void* opaque)
     init_interrupt(&r4300->cp0);
     invalidate_r4300_cached_code(r4300, 0, 0);
     *r4300_pc_struct(r4300) = &r4300->interp_PC;
-    if (r4300->emumode >= 2)
+    if (r4300->emumode == EMUMODE_DYNAREC)
     {
 #ifdef NEW_DYNAREC
         new_dynarec_cleanup();
@@ -534,10 +418,6 @@ static void call_interrupt_handler(const struct cp0* cp0, size_t index)
 
 void gen_interrupt(struct r4300_core* r4300)
 {
-    uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0);
-    unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(&r4300->cp0);
-    int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0);
-
     if (*r4300_stop(r4300) == 1)
     {
         g_gs_vi_counter = 0; // debug
@@ -556,6 +436,12 @@ void gen_interrupt(struct r4300_core* r4300)
             return;
         }
 
+        if (rewind_pending())
+        {
+            rewind_run_job();
+            return;
+        }
+
         if (r4300->reset_hard_job)
         {
             call_interrupt_handler(&r4300->cp0, 11);
@@ -568,20 +454,16 @@ void gen_interrupt(struct r4300_core* r4300)
         uint32_t dest = r4300->skip_jump;
         r4300->skip_jump = 0;
 
-        *cp0_next_interrupt = (r4300->cp0.q.first != NULL)
-            ? r4300->cp0.q.first->data.count
-            : 0;
-
-        *cp0_cycle_count = (r4300->cp0.q.first != NULL)
-            ? (cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.first->data.count)
-            : 0;
+        update_next_interrupt(&r4300->cp0);
 
         r4300->cp0.last_addr = dest;
         generic_jump_to(r4300, dest);
         return;
     }
 
-    switch (r4300->cp0.q.first->data.type)
+    telemetry_count_interrupt(get_next_event_type(&r4300->cp0.q));
+
+    switch (get_next_event_type(&r4300->cp0.q))
     {
         case VI_INT:
             call_interrupt_handler(&r4300->cp0, 0);
@@ -656,8 +538,13 @@ void gen_interrupt(struct r4300_core* r4300)
             call_interrupt_handler(&r4300->cp0, 15);
             break;
 
+        case PROFILE_EVT:
+            remove_interrupt_event(&r4300->cp0);
+            sample_profiler_event(r4300);
+            break;
+
         default:
-            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", r4300->cp0.q.first->data.type);
+            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", get_next_event_type(&r4300->cp0.q));
             remove_interrupt_event(&r4300->cp0);
             exception_general(r4300);
             break;
@@ -670,6 +557,8 @@ void gen_interrupt(struct r4300_core* r4300)
             savestates_save();
             return;
         }
+
+        rewind_checkpoint();
     }
 }
 
@@ -33,6 +33,7 @@
 #include "api/m64p_types.h"
 #include "api/callbacks.h"
 #include "main/main.h"
+#include "main/profile.h"
 #include "main/rom.h"
 #include "device/memory/memory.h"
 #include "device/r4300/cached_interp.h"
@@ -8758,7 +8759,18 @@ void new_dynarec_cleanup(void)
 #endif
 }
 
+static int recompile_block(int addr);
+
 int new_recompile_block(int addr)
+{
+  int r;
+  timed_section_start(TIMED_SECTION_COMPILER);
+  r=recompile_block(addr);
+  timed_section_end(TIMED_SECTION_COMPILER);
+  return r;
+}
+
+static int recompile_block(int addr)
 {
 #if defined(RECOMPILER_DEBUG) && !defined(RECOMP_DBG)
   recomp_dbg_block(addr);
@@ -147,7 +147,7 @@ void run_r4300(struct r4300_core* r4300)
         run_pure_interpreter(r4300);
     }
 #if defined(DYNAREC)
-    else if (r4300->emumode >= 2)
+    else if (r4300->emumode >= 2 && r4300->emumode != EMUMODE_THREADED_INTERPRETER)
     {
         DebugMessage(M64MSG_INFO, "Starting R4300 emulator: Dynamic Recompiler");
         r4300->emumode = EMUMODE_DYNAREC;
@@ -174,10 +174,19 @@ void run_r4300(struct r4300_core* r4300)
         free_blocks(&r4300->cached_interp);
     }
 #endif
-    else /* if (r4300->emumode == EMUMODE_INTERPRETER) */
+    else /* if (r4300->emumode == EMUMODE_INTERPRETER || r4300->emumode == EMUMODE_THREADED_INTERPRETER) */
     {
-        DebugMessage(M64MSG_INFO, "Starting R4300 emulator: Cached Interpreter");
-        r4300->emumode = EMUMODE_INTERPRETER;
+        if (r4300->emumode == EMUMODE_THREADED_INTERPRETER && cached_interp_threaded_init())
+        {
+            DebugMessage(M64MSG_INFO, "Starting R4300 emulator: Threaded Cached Interpreter");
+        }
+        else
+        {
+            if (r4300->emumode == EMUMODE_THREADED_INTERPRETER)
+                DebugMessage(M64MSG_WARNING, "Threaded Cached Interpreter not supported by this build, using Cached Interpreter.");
+            DebugMessage(M64MSG_INFO, "Starting R4300 emulator: Cached Interpreter");
+            r4300->emumode = EMUMODE_INTERPRETER;
+        }
         r4300->cached_interp.fin_block = cached_interp_FIN_BLOCK;
         r4300->cached_interp.not_compiled = cached_interp_NOTCOMPILED;
         r4300->cached_interp.not_compiled2 = cached_interp_NOTCOMPILED2;
@@ -431,6 +440,7 @@ void generic_jump_to(struct r4300_core* r4300, uint32_t address)
         break;
 
     case EMUMODE_INTERPRETER:
+    case EMUMODE_THREADED_INTERPRETER:
         cached_interpreter_jump_to(r4300, address);
         break;
 
@@ -29,9 +29,11 @@
 #include <stdio.h>
 #endif
 
+#include "block_arena.h"
 #include "cp0.h"
 #include "cp1.h"
 #include "cp2.h"
+#include "dynarec_cache.h"
 
 #include "recomp_types.h" /* for precomp_instr, regcache_state */
 
@@ -55,16 +57,23 @@ struct cached_interp
     void (*not_compiled2)(void);
 
     void (*init_block)(struct r4300_core* r4300, uint32_t address);
-    void (*free_block)(struct precomp_block* block);
+    /* releases the block and its instructions */
+    void (*free_block)(struct cached_interp* cinterp, struct precomp_block* block);
 
     void (*recompile_block)(struct r4300_core* r4300,
         const uint32_t* source, struct precomp_block* block, uint32_t func);
+
+    /* cached interpreter blocks, see cached_interp_init_block */
+    struct block_arena arena;
+    /* blocks (re)compiled since start, read by other threads */
+    uint32_t recompiles;
 };
 
 enum {
-    EMUMODE_PURE_INTERPRETER = 0,
-    EMUMODE_INTERPRETER      = 1,
-    EMUMODE_DYNAREC          = 2,
+    EMUMODE_PURE_INTERPRETER     = 0,
+    EMUMODE_INTERPRETER          = 1,
+    EMUMODE_DYNAREC              = 2,
+    EMUMODE_THREADED_INTERPRETER = 3,
 };
 
 
@@ -98,6 +107,9 @@ struct r4300_core
      * XXX: more work is needed to correctly encapsulate these */
     struct cached_interp cached_interp;
 
+    /* entry points compiled by the dynarec in earlier runs of this ROM */
+    struct dynarec_cache dynarec_cache;
+
 #ifndef NEW_DYNAREC
     /* from recomp.c.
      * XXX: more work is needed to correctly encapsulate these */
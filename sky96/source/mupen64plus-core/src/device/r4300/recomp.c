@@ -35,17 +35,19 @@
 #endif
 #endif
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
 #include "device/r4300/cached_interp.h"
 #include "device/r4300/cp0.h"
+#include "device/r4300/dynarec_cache.h"
 #include "device/r4300/idec.h"
 #include "device/r4300/recomp_types.h"
 #include "device/r4300/tlb.h"
 #include "main/main.h"
-#if defined(PROFILE)
 #include "main/profile.h"
-#endif
 
 #if defined(__x86_64__)
   #include "x86_64/regcache.h"
@@ -449,15 +451,43 @@ static void (*const recomp_funcs[R4300_OPCODES_COUNT])(struct r4300_core* r4300)
 };
 #undef X
 
+/* Compiles the entry points recorded for the current contents of the page
+ * in earlier runs, see dynarec_cache.h. Mapped pages aren't recorded. */
+static void dynarec_prewarm_block(struct r4300_core* r4300, struct precomp_block* block)
+{
+    const uint32_t* recorded;
+    const uint32_t* iw;
+    uint32_t entries[32];
+    uint32_t i;
+
+    if ((block->start & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)
+     || (iw = fast_mem_access(r4300, block->start)) == NULL)
+        return;
+
+    recorded = dynarec_cache_lookup(&r4300->dynarec_cache, block->start, XXH3_64bits(iw, 0x1000));
+    if (recorded == NULL)
+        return;
+
+    /* recompiling records into the cache, which may move the page */
+    memcpy(entries, recorded, sizeof(entries));
+
+    for (i = 0; i < 1024; ++i)
+    {
+        if ((entries[i / 32] & (UINT32_C(1) << (i % 32)))
+         && block->block[i].ops == r4300->cached_interp.not_compiled)
+        {
+            dynarec_recompile_block(r4300, iw, block, block->start + i*4);
+        }
+    }
+}
+
 /**********************************************************************
  ******************** initialize an empty block ***********************
  **********************************************************************/
 void dynarec_init_block(struct r4300_core* r4300, uint32_t address)
 {
     int i, length, already_exist = 1;
-#if defined(PROFILE)
     timed_section_start(TIMED_SECTION_COMPILER);
-#endif
 
     struct precomp_block** block = &r4300->cached_interp.blocks[address >> 12];
 
@@ -600,12 +630,12 @@ void dynarec_init_block(struct r4300_core* r4300, uint32_t address)
             dynarec_init_block(r4300, alt_addr);
         }
     }
-#if defined(PROFILE)
+
+    dynarec_prewarm_block(r4300, b);
     timed_section_end(TIMED_SECTION_COMPILER);
-#endif
 }
 
-void dynarec_free_block(struct precomp_block* block)
+void dynarec_free_block(struct cached_interp* cinterp, struct precomp_block* block)
 {
     size_t memsize = get_block_memsize(block);
 
@@ -613,6 +643,7 @@ void dynarec_free_block(struct precomp_block* block)
     if (block->code) { free_exec(block->code, block->max_code_length); block->code = NULL; }
     if (block->jumps_table) { free(block->jumps_table); block->jumps_table = NULL; }
     if (block->riprel_table) { free(block->riprel_table); block->riprel_table = NULL; }
+    free(block);
 }
 
 /**********************************************************************
@@ -627,9 +658,7 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
     int block_start_in_tlb = ((block->start & UINT32_C(0xc0000000)) != UINT32_C(0x80000000));
     int block_not_in_tlb = (block->start >= UINT32_C(0xc0000000) || block->end < UINT32_C(0x80000000));
 
-#if defined(PROFILE)
     timed_section_start(TIMED_SECTION_COMPILER);
-#endif
 
     length = get_block_length(block);
     length2 = length - 2 + (length >> 2);
@@ -637,6 +666,8 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
     /* reset xxhash */
     block->xxhash = 0;
 
+    cached_interp_count_recompile(&r4300->cached_interp);
+
     r4300->recomp.dst_block = block;
     r4300->recomp.code_length = block->code_length;
     r4300->recomp.max_code_length = block->max_code_length;
@@ -749,6 +780,10 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
     block->max_code_length = r4300->recomp.max_code_length;
     free_assembler(r4300, &block->jumps_table, &block->jumps_number, &block->riprel_table, &block->riprel_number);
 
+    if (!block_start_in_tlb) {
+        dynarec_cache_record(&r4300->dynarec_cache, block->start, XXH3_64bits(iw, 0x1000), func);
+    }
+
 #ifdef DBG
     DebugMessage(M64MSG_INFO, "block recompiled (%" PRIX32 "-%" PRIX32 ")", func, block->start+i*4);
 #endif
@@ -757,9 +792,7 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
     r4300->recomp.pfProfile = NULL;
 #endif
 
-#if defined(PROFILE)
     timed_section_end(TIMED_SECTION_COMPILER);
-#endif
 }
 
 /**********************************************************************
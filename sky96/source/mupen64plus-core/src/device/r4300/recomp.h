@@ -26,10 +26,11 @@
 #include <stdint.h>
 
 struct r4300_core;
+struct cached_interp;
 struct precomp_block;
 
 void dynarec_init_block(struct r4300_core* r4300, uint32_t address);
-void dynarec_free_block(struct precomp_block* block);
+void dynarec_free_block(struct cached_interp* cinterp, struct precomp_block* block);
 void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* source, struct precomp_block* block, uint32_t func);
 void recompile_opcode(struct r4300_core* r4300);
 void dyna_jump(void);
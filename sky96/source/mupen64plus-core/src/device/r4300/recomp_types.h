@@ -72,6 +72,9 @@ struct precomp_instr
     /* these fields are recomp specific */
     unsigned int local_addr; /* byte offset to start of corresponding x86_64 instructions, from start of code block */
     struct reg_cache reg_cache_infos;
+
+    /* threaded cached interpreter: address of the dispatch label for this instruction */
+    const void* label;
 };
 
 struct precomp_block
@@ -34,6 +34,8 @@
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rdp/rdp_core.h"
 #include "device/rcp/ri/ri_controller.h"
+#include "main/rdram_dirty.h"
+#include "main/rdram_heatmap.h"
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -114,6 +116,8 @@ static void dma_pi_write(struct pi_controller* pi)
     unsigned int cycles = handler->dma_write(opaque, dram, dram_addr, cart_addr, length);
 
     post_framebuffer_write(&pi->dp->fb, dram_addr, length);
+    rdram_heatmap_dma_write(dram_addr, length);
+    rdram_dirty_mark_range(dram_addr, length);
 
     /* Mark DMA as busy */
     pi->regs[PI_STATUS_REG] |= PI_STATUS_DMA_BUSY;
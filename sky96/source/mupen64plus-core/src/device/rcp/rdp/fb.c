@@ -26,6 +26,7 @@
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rdram/rdram.h"
+#include "main/rdram_dirty.h"
 #include "osal/preproc.h"
 #include "plugin/plugin.h"
 
@@ -65,10 +66,12 @@ void pre_framebuffer_read(struct fb* fb, uint32_t address)
 
 void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length)
 {
-    if (!fb->infos[0].addr) {
+    if (!fb->infos[0].addr || length == 0) {
         return;
     }
 
+    FrameBufferWriteRange ranges[FB_INFOS_COUNT];
+    unsigned int count = 0;
     size_t i, j;
     unsigned char size;
     if (length % 4 == 0)
@@ -78,6 +81,8 @@ void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length)
     else
         size = 1;
 
+    uint32_t last = address + length - 1;
+
     for (i = 0; i < FB_INFOS_COUNT; ++i) {
 
         /* skip empty fb info */
@@ -85,14 +90,48 @@ void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length)
             continue;
         }
 
-        /* if address in within a fb notify GFX plugin */
+        /* clip the write to the fb */
         uint32_t begin = fb->infos[i].addr;
         uint32_t end   = fb->infos[i].addr + fb_buffer_size(&fb->infos[i]) - 1;
 
-        for (j = 0; j < length; j += size) {
-            if ((address + j >= begin) && (address + j <= end)) {
-                gfx.fBWrite(address + j, size);
-            }
+        if (last < begin || address > end) {
+            continue;
+        }
+
+        /* keep element alignment relative to the write */
+        uint32_t first = address;
+        if (first < begin) {
+            first += (begin - address + size - 1) / size * size;
+        }
+        if (first > end) {
+            continue;
+        }
+        uint32_t stop = (last < end) ? last : end;
+
+        /* RDRAM now holds the latest data of fully overwritten pages,
+         * so reads must not pull the stale fb back over it */
+        for (j = (first + 0xfff) >> 12; j < ((stop + 1) >> 12); ++j) {
+            fb->dirty_page[j] = 0;
+        }
+
+        ranges[count].addr = first;
+        ranges[count].size = stop - first + 1;
+        ++count;
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    /* notify GFX plugin, one call per element when it lacks FBWriteList */
+    if (gfx.fBWriteList != NULL) {
+        gfx.fBWriteList(ranges, count);
+        return;
+    }
+
+    for (i = 0; i < count; ++i) {
+        for (j = 0; j < ranges[i].size; j += size) {
+            gfx.fBWrite(ranges[i].addr + j, size);
         }
     }
 }
@@ -113,6 +152,7 @@ void poweron_fb(struct fb* fb)
     memset(fb->dirty_page, 0, FB_DIRTY_PAGES_COUNT*sizeof(fb->dirty_page[0]));
     memset(fb->infos, 0, FB_INFOS_COUNT*sizeof(fb->infos[0]));
     fb->once = 1;
+    memset(&fb->images, 0, sizeof(fb->images));
 }
 
 void read_rdram_fb(void* opaque, uint32_t address, uint32_t* value)
@@ -261,3 +301,29 @@ void unprotect_framebuffers(struct fb* fb)
         apply_mem_mapping(fb->mem, &ram_mapping);
     }
 }
+
+/* The gfx plugin draws the display lists it gets from the RSP plugin to
+ * RDRAM behind our back: have the next checkpoint compare the frame buffers
+ * it reports, or all pages if it reports none. Other writes of the plugin,
+ * such as depth buffer copies, are not seen. */
+void check_framebuffers(void)
+{
+    FrameBufferInfo infos[FB_INFOS_COUNT];
+    size_t i;
+
+    memset(infos, 0, sizeof(infos));
+    if (gfx.fBGetFrameBufferInfo != NULL) {
+        gfx.fBGetFrameBufferInfo(infos);
+    }
+
+    if (infos[0].addr == 0) {
+        rdram_dirty_untracked();
+        return;
+    }
+
+    for (i = 0; i < FB_INFOS_COUNT; ++i) {
+        if (infos[i].addr != 0) {
+            rdram_dirty_check_range(infos[i].addr, (uint32_t)fb_buffer_size(&infos[i]));
+        }
+    }
+}
@@ -25,6 +25,7 @@
 #include <stdint.h>
 
 #include "api/m64p_plugin.h"
+#include "rdp_images.h"
 
 struct memory;
 struct rdram;
@@ -42,6 +43,8 @@ struct fb
     unsigned char dirty_page[FB_DIRTY_PAGES_COUNT];
     FrameBufferInfo infos[FB_INFOS_COUNT];
     unsigned int once;
+
+    struct rdp_images images;
 };
 
 void init_fb(struct fb* fb,
@@ -60,4 +63,6 @@ void unprotect_framebuffers(struct fb* fb);
 void pre_framebuffer_read(struct fb* fb, uint32_t address);
 void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length);
 
+void check_framebuffers(void);
+
 #endif
@@ -26,6 +26,7 @@
 #include "device/memory/memory.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rsp/rsp_core.h"
+#include "device/rdram/rdram.h"
 #include "plugin/plugin.h"
 
 static void update_dpc_status(struct rdp_core* dp, uint32_t w)
@@ -81,6 +82,22 @@ void poweron_rdp(struct rdp_core* dp)
 }
 
 
+/* The gfx plugin draws to RDRAM behind our back, so the commands from
+ * DPC_CURRENT to DPC_END first go through check_rdp_images. The RSP plugin
+ * also sends its command lists here. */
+void process_rdp_list(struct rdp_core* dp)
+{
+    if (dp->dpc_regs[DPC_STATUS_REG] & DPC_STATUS_XBUS_DMEM_DMA)
+        check_rdp_images(&dp->fb.images, dp->sp->mem, 0xfff,
+                         dp->dpc_regs[DPC_CURRENT_REG], dp->dpc_regs[DPC_END_REG]);
+    else
+        check_rdp_images(&dp->fb.images, dp->fb.rdram->dram, (uint32_t)dp->fb.rdram->dram_size - 1,
+                         dp->dpc_regs[DPC_CURRENT_REG], dp->dpc_regs[DPC_END_REG]);
+
+    gfx.processRDPList();
+}
+
+
 void read_dpc_regs(void* opaque, uint32_t address, uint32_t* value)
 {
     struct rdp_core* dp = (struct rdp_core*)opaque;
@@ -115,7 +132,7 @@ void write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
         break;
     case DPC_END_REG:
         unprotect_framebuffers(&dp->fb);
-        gfx.processRDPList();
+        process_rdp_list(dp);
         protect_framebuffers(&dp->fb);
         signal_rcp_interrupt(dp->mi, MI_INTR_DP);
         break;
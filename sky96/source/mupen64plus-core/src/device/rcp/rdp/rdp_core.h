@@ -112,6 +112,8 @@ void init_rdp(struct rdp_core* dp,
 
 void poweron_rdp(struct rdp_core* dp);
 
+void process_rdp_list(struct rdp_core* dp);
+
 void read_dpc_regs(void* opaque, uint32_t address, uint32_t* value);
 void write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
 
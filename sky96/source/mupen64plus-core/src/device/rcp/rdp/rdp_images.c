@@ -0,0 +1,144 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdp_images.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "rdp_images.h"
+
+#include "main/rdram_dirty.h"
+
+enum
+{
+    RDP_COLOR_IMAGE_KNOWN = 0x1,
+    RDP_Z_IMAGE_KNOWN     = 0x2,
+    RDP_SCISSOR_KNOWN     = 0x4,
+    RDP_Z_UPDATE_KNOWN    = 0x8
+};
+
+static uint32_t rdp_command_length(uint32_t cmd)
+{
+    /* triangles, with optional shade, texture and Z coefficients */
+    if (cmd >= 0x08 && cmd <= 0x0f) {
+        return 32 + ((cmd & 4) ? 64 : 0) + ((cmd & 2) ? 64 : 0) + ((cmd & 1) ? 16 : 0);
+    }
+
+    /* texture rectangles */
+    if (cmd == 0x24 || cmd == 0x25) {
+        return 16;
+    }
+
+    return 8;
+}
+
+static int rdp_draw_command(uint32_t cmd)
+{
+    return (cmd >= 0x08 && cmd <= 0x0f) || cmd == 0x24 || cmd == 0x25 || cmd == 0x36;
+}
+
+/* Check the images as set up for the next draw. Returns 0 if the stream
+ * hasn't told yet where they are. */
+static int check_rdp_draw(const struct rdp_images* images)
+{
+    const unsigned int needed = RDP_COLOR_IMAGE_KNOWN | RDP_SCISSOR_KNOWN;
+    int z_update = !(images->known & RDP_Z_UPDATE_KNOWN) || images->z_update;
+
+    if ((images->known & needed) != needed
+     || (z_update && !(images->known & RDP_Z_IMAGE_KNOWN))) {
+        return 0;
+    }
+
+    rdram_dirty_check_range(images->color_address, images->color_row * images->rows);
+    if (z_update) {
+        rdram_dirty_check_range(images->z_address, images->z_row * images->rows);
+    }
+
+    return 1;
+}
+
+/* Follow the commands from current to end through the image, scissor and Z
+ * update set up, and check the RDRAM they can draw to: each image, from its
+ * start down to the lower edge of the scissor box. Where that isn't known
+ * yet, as after a state load, the next checkpoint compares all pages. */
+void check_rdp_images(struct rdp_images* images, const uint32_t* mem, uint32_t mask, uint32_t current, uint32_t end)
+{
+    int changed = 1;
+
+    if (end < current || end - current > mask + 1) {
+        images->skip = 0;
+        rdram_dirty_untracked();
+        return;
+    }
+
+    /* skip the rest of a command cut at the previous DPC_END, if the
+     * commands carry on from there */
+    if (current != images->end) {
+        images->skip = 0;
+    }
+    images->end = end;
+
+    if (images->skip >= end - current) {
+        images->skip -= end - current;
+        return;
+    }
+    current += images->skip;
+
+    while (current < end) {
+        uint32_t w0 = mem[(current & mask) >> 2];
+        uint32_t w1 = mem[((current + 4) & mask) >> 2];
+        uint32_t cmd = (w0 >> 24) & 0x3f;
+
+        switch (cmd)
+        {
+        case 0x3f: /* set color image */
+            images->color_address = w1 & 0xffffff;
+            images->color_row = (((w0 & 0x3ff) + 1) << ((w0 >> 19) & 3)) >> 1;
+            images->z_row = ((w0 & 0x3ff) + 1) * 2;
+            images->known |= RDP_COLOR_IMAGE_KNOWN;
+            changed = 1;
+            break;
+        case 0x3e: /* set Z image */
+            images->z_address = w1 & 0xffffff;
+            images->known |= RDP_Z_IMAGE_KNOWN;
+            changed = 1;
+            break;
+        case 0x2d: /* set scissor, with a row of slack for spans past the right edge */
+            images->rows = ((w1 & 0xfff) >> 2) + 2;
+            images->known |= RDP_SCISSOR_KNOWN;
+            changed = 1;
+            break;
+        case 0x2f: /* set other modes */
+            images->z_update = (w1 >> 5) & 1;
+            images->known |= RDP_Z_UPDATE_KNOWN;
+            changed = 1;
+            break;
+        default:
+            if (changed && rdp_draw_command(cmd)) {
+                if (!check_rdp_draw(images)) {
+                    rdram_dirty_untracked();
+                }
+                changed = 0;
+            }
+            break;
+        }
+
+        current += rdp_command_length(cmd);
+    }
+
+    images->skip = current - end;
+}
@@ -0,0 +1,47 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdp_images.h                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_RCP_RDP_RDP_IMAGES_H
+#define M64P_DEVICE_RCP_RDP_RDP_IMAGES_H
+
+#include <stdint.h>
+
+/* What the RDP command stream has set up so far, to tell the savestate
+ * checkpoints which pages the RDP draws to. */
+struct rdp_images
+{
+    uint32_t color_address;
+    uint32_t color_row;
+    uint32_t z_address;
+    uint32_t z_row;
+    uint32_t rows;
+    uint32_t z_update;
+    uint32_t end;
+    uint32_t skip;
+    unsigned int known;
+};
+
+/* Follow the RDP commands from current to end, mem being RDRAM or DMEM as
+ * masked by mask, and mark the pages they can draw to for the savestate
+ * checkpoints. */
+void check_rdp_images(struct rdp_images* images, const uint32_t* mem, uint32_t mask, uint32_t current, uint32_t end);
+
+#endif
@@ -30,9 +30,9 @@
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rdram/rdram.h"
 #include "main/main.h"
-#if defined(PROFILE)
 #include "main/profile.h"
-#endif
+#include "main/rdram_dirty.h"
+#include "main/rdram_heatmap.h"
 #include "plugin/plugin.h"
 #include "api/callbacks.h"
 
@@ -62,6 +62,8 @@ static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
             }
             if (dramaddr <= 0x800000)
                 post_framebuffer_write(&sp->dp->fb, dramaddr - length, length);
+            rdram_heatmap_dma_write(dramaddr - length, length);
+            rdram_dirty_mark_range(dramaddr - length, length);
             dramaddr+=skip;
         }
 
@@ -334,13 +336,9 @@ void do_SP_Task(struct rsp_core* sp)
 
         //gfx.processDList();
         sp->regs2[SP_PC_REG] &= 0xfff;
-#if defined(PROFILE)
         timed_section_start(TIMED_SECTION_GFX);
-#endif
         rsp.doRspCycles(0xffffffff);
-#if defined(PROFILE)
         timed_section_end(TIMED_SECTION_GFX);
-#endif
         sp->regs2[SP_PC_REG] |= save_pc;
         new_frame();
 
@@ -362,13 +360,9 @@ void do_SP_Task(struct rsp_core* sp)
     {
         //audio.processAList();
         sp->regs2[SP_PC_REG] &= 0xfff;
-#if defined(PROFILE)
         timed_section_start(TIMED_SECTION_AUDIO);
-#endif
         rsp.doRspCycles(0xffffffff);
-#if defined(PROFILE)
         timed_section_end(TIMED_SECTION_AUDIO);
-#endif
         sp->regs2[SP_PC_REG] |= save_pc;
 
         sp_delay_time = 4000;
@@ -382,6 +376,11 @@ void do_SP_Task(struct rsp_core* sp)
         sp_delay_time = 0;
     }
 
+    /* the RSP plugin writes RDRAM behind our back, and only some plugins
+     * can tell which pages */
+    if (rsp.getRdramWrites == NULL || !rsp.getRdramWrites(g_rdram_dirty_check, RDRAM_DIRTY_WORDS))
+        rdram_dirty_untracked();
+
     sp->rsp_task_locked = 0;
     sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
     if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
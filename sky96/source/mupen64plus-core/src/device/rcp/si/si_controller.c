@@ -31,6 +31,8 @@
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rdram/rdram.h"
+#include "main/rdram_dirty.h"
+#include "main/rdram_heatmap.h"
 #include "osal/preproc.h"
 
 static int validate_dma(struct si_controller* si, uint32_t reg)
@@ -68,6 +70,8 @@ static void copy_pif_rdram(struct si_controller* si)
         for(i = 0; i < (PIF_RAM_SIZE / 4); ++i) {
             dram[i] = tohl(pif_ram[i]);
         }
+        rdram_heatmap_dma_write(dram_addr, PIF_RAM_SIZE);
+        rdram_dirty_mark_range(dram_addr, PIF_RAM_SIZE);
     }
 }
 
@@ -27,6 +27,8 @@
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/ri/ri_controller.h"
+#include "main/rdram_dirty.h"
+#include "main/rdram_heatmap.h"
 
 #include <string.h>
 
@@ -87,6 +89,8 @@ static void read_rdram_dram_corrupted(void* opaque, uint32_t address, uint32_t*
     uint32_t addr = rdram_dram_address(address);
     size_t module;
 
+    rdram_heatmap_access(RDRAM_HEATMAP_READ, address);
+
     *value = rdram->dram[addr];
 
     module = get_module(rdram, address);
@@ -139,6 +143,7 @@ void poweron_rdram(struct rdram* rdram)
     size_t modules = get_modules_count(rdram);
     memset(rdram->regs, 0, RDRAM_MAX_MODULES_COUNT*RDRAM_REGS_COUNT*sizeof(uint32_t));
     memset(rdram->dram, 0, rdram->dram_size);
+    rdram_dirty_poweron();
 
     DebugMessage(M64MSG_INFO, "Initializing %u RDRAM modules for a total of %u MB",
         (uint32_t) modules, (uint32_t) rdram->dram_size / (1024*1024));
@@ -233,6 +238,7 @@ void read_rdram_dram(void* opaque, uint32_t address, uint32_t* value)
 
     if (address < rdram->dram_size)
     {
+        rdram_heatmap_access(RDRAM_HEATMAP_READ, address);
         *value = rdram->dram[addr];
     }
     else
@@ -248,6 +254,8 @@ void write_rdram_dram(void* opaque, uint32_t address, uint32_t value, uint32_t m
 
     if (address < rdram->dram_size)
     {
+        rdram_heatmap_access(RDRAM_HEATMAP_WRITE, address);
+        rdram_dirty_mark(address);
         masked_write(&rdram->dram[addr], value, mask);
     }
 }
@@ -41,6 +41,7 @@
 #include "api/m64p_types.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rdram/rdram.h"
+#include "main/rdram_dirty.h"
 #include "osal/preproc.h"
 
 /* local definitions */
@@ -75,6 +76,7 @@ static uint8_t read_address_8bit(struct r4300_core* r4300, uint32_t address)
 static void update_address_16bit(struct r4300_core* r4300, uint32_t address, uint16_t new_value)
 {
     *(uint16_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S16))) = new_value;
+    rdram_dirty_mark(address);
     /* mask out bit 24 which is used by GS codes to specify 8/16 bits */
     address &= 0xfeffffff;
     invalidate_r4300_cached_code(r4300, address, 2);
@@ -83,6 +85,7 @@ static void update_address_16bit(struct r4300_core* r4300, uint32_t address, uin
 static void update_address_8bit(struct r4300_core* r4300, uint32_t address, uint8_t new_value)
 {
     *(uint8_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S8))) = new_value;
+    rdram_dirty_mark(address);
     invalidate_r4300_cached_code(r4300, address, 1);
 }
 
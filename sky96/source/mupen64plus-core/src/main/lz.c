@@ -0,0 +1,195 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - lz.c                                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "lz.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define HASH_BITS 12
+#define MAX_OFFSET 0xffff
+
+static osal_inline uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static osal_inline uint32_t hash32(uint32_t v)
+{
+    return (v * UINT32_C(2654435761)) >> (32 - HASH_BITS);
+}
+
+static uint8_t* put_length(uint8_t* op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static uint8_t* put_sequence(uint8_t* op, const uint8_t* literals, size_t literal_length,
+                             size_t offset, size_t match_length)
+{
+    uint8_t* token = op++;
+    size_t ml = match_length - LZ_MIN_MATCH;
+
+    *token = (uint8_t)(((literal_length < 15) ? literal_length : 15) << 4);
+    if (literal_length >= 15)
+        op = put_length(op, literal_length - 15);
+
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+
+    if (match_length == 0)
+        return op;
+
+    *token |= (uint8_t)((ml < 15) ? ml : 15);
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    if (ml >= 15)
+        op = put_length(op, ml - 15);
+
+    return op;
+}
+
+size_t lz_compress(const void* src, size_t n, void* dst, size_t capacity)
+{
+    uint32_t table[1 << HASH_BITS];
+    const uint8_t* const base = (const uint8_t*)src;
+    const uint8_t* const end = base + n;
+    /* stop looking for matches where a 4 bytes read would overrun */
+    const uint8_t* const match_limit = (n >= LZ_MIN_MATCH) ? end - LZ_MIN_MATCH : base;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    uint8_t* op = (uint8_t*)dst;
+
+    if (capacity < lz_compress_bound(n))
+        return 0;
+
+    memset(table, 0, sizeof(table));
+
+    while (ip < match_limit)
+    {
+        uint32_t seq = read32(ip);
+        uint32_t h = hash32(seq);
+        const uint8_t* ref = base + table[h];
+        const uint8_t* mp;
+
+        table[h] = (uint32_t)(ip - base);
+
+        if (ref >= ip || (size_t)(ip - ref) > MAX_OFFSET || read32(ref) != seq)
+        {
+            /* runs of one byte don't hash to an earlier position, catch
+             * them directly as they are the bulk of delta data */
+            if (ip > base && ip[-1] == ip[0] && read32(ip) == (uint32_t)ip[0] * UINT32_C(0x01010101))
+                ref = ip - 1;
+            else
+            {
+                ++ip;
+                continue;
+            }
+        }
+
+        for (mp = ip + LZ_MIN_MATCH; mp < end && *mp == ref[mp - ip]; ++mp)
+            ;
+
+        op = put_sequence(op, anchor, (size_t)(ip - anchor), (size_t)(ip - ref), (size_t)(mp - ip));
+        ip = anchor = mp;
+    }
+
+    op = put_sequence(op, anchor, (size_t)(end - anchor), 0, 0);
+
+    return (size_t)(op - (uint8_t*)dst);
+}
+
+static int get_length(const uint8_t** ip, const uint8_t* end, size_t* length)
+{
+    uint8_t b;
+
+    do
+    {
+        if (*ip >= end)
+            return 0;
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+
+    return 1;
+}
+
+size_t lz_decompress(const void* src, size_t n, void* dst, size_t capacity)
+{
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* const end = ip + n;
+    uint8_t* const out = (uint8_t*)dst;
+    uint8_t* op = out;
+    uint8_t* const out_end = out + capacity;
+
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+        size_t length = token >> 4;
+        size_t offset;
+        const uint8_t* ref;
+
+        if (length == 15 && !get_length(&ip, end, &length))
+            return 0;
+        if (length > (size_t)(end - ip) || length > (size_t)(out_end - op))
+            return 0;
+
+        memcpy(op, ip, length);
+        ip += length;
+        op += length;
+
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return 0;
+        offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+
+        length = token & 15;
+        if (length == 15 && !get_length(&ip, end, &length))
+            return 0;
+        length += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > (size_t)(op - out) || length > (size_t)(out_end - op))
+            return 0;
+
+        /* the match may overlap what it produces, copy forward bytewise */
+        ref = op - offset;
+        if (offset >= length)
+        {
+            memcpy(op, ref, length);
+            op += length;
+        }
+        else
+        {
+            while (length-- != 0)
+                *op++ = *ref++;
+        }
+    }
+
+    return (size_t)(op - out);
+}
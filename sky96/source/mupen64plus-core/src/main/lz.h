@@ -0,0 +1,55 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - lz.h                                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_LZ_H
+#define M64P_MAIN_LZ_H
+
+#include <stddef.h>
+
+#include "osal/preproc.h"
+
+/* Byte oriented LZ77 codec in the spirit of LZ4: no entropy coding, a
+ * greedy single-probe matcher, and a decoder that is little more than
+ * memcpy. It is meant for data that is mostly runs and repeats, such as
+ * XOR deltas between savestate checkpoints, where it runs at memory speed.
+ *
+ * A block is a sequence of tokens. Each token byte holds a literal count in
+ * its high nibble and a match length minus LZ_MIN_MATCH in the low one, a
+ * nibble of 15 continuing in 255-summed extra bytes. The literals follow,
+ * then unless the block ends there, a 16-bit little-endian match offset. */
+
+enum { LZ_MIN_MATCH = 4 };
+
+/* Worst case compressed size of n bytes. */
+static osal_inline size_t lz_compress_bound(size_t n)
+{
+    return n + n / 255 + 16;
+}
+
+/* Compress src into dst, which should hold lz_compress_bound(n) bytes.
+ * Returns the compressed size, or 0 if dst is too small. */
+size_t lz_compress(const void* src, size_t n, void* dst, size_t capacity);
+
+/* Returns the decompressed size, or 0 if src is malformed or the output
+ * doesn't fit in capacity bytes. */
+size_t lz_decompress(const void* src, size_t n, void* dst, size_t capacity);
+
+#endif
@@ -66,17 +66,21 @@
 #include "device/pif/bootrom_hle.h"
 #include "eventloop.h"
 #include "main.h"
+#include "osal/clock.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "plugin/plugin.h"
-#if defined(PROFILE)
 #include "profile.h"
-#endif
+#include "rdram_heatmap.h"
+#include "rewind.h"
 #include "rom.h"
+#include "sample_profiler.h"
 #include "savestates.h"
 #include "screenshot.h"
+#include "telemetry.h"
 #include "util.h"
+#include "workqueue.h"
 #include "netplay.h"
 
 #ifdef DBG
@@ -123,6 +127,11 @@ static int   l_TakeScreenshot = 0;       // Tell OSD Rendering callback to take
 static int   l_SpeedFactor = 100;        // percentage of nominal game speed at which emulator is running
 static int   l_FrameAdvance = 0;         // variable to check if we pause on next frame
 static int   l_MainSpeedLimit = 1;       // insert delay during vi_interrupt to keep speed at real-time
+static int   l_PrecisePacing = 1;        // pace VIs on the nanosecond clock instead of SDL_GetTicks()
+static uint64_t l_PacingDeadline = 0;    // host time at which the current VI should be released, 0 to restart
+static uint64_t l_PacingSpinNs = 0;      // tail of each wait spent spinning instead of sleeping
+static uint32_t l_ViCount = 0;           // CP0 count at the previous VI
+static m64p_param_handle l_OnScreenDisplay = NULL; // read on every frame and message
 
 static osd_message_t *l_msgVol = NULL;
 static osd_message_t *l_msgFF = NULL;
@@ -184,6 +193,18 @@ static char *get_save_filename(void)
     return filename;
 }
 
+static char *get_dynarec_cache_path(void)
+{
+    char filename[64];
+    const char* cachedir = ConfigGetUserCachePath();
+
+    if (cachedir == NULL)
+        return NULL;
+
+    snprintf(filename, sizeof(filename), "%.32s.dyncache", ROM_SETTINGS.MD5);
+    return combinepath(cachedir, filename);
+}
+
 static char *get_mempaks_path(void)
 {
     char *path;
@@ -372,7 +393,7 @@ void main_message(m64p_msg_level level, unsigned int corner, const char *format,
     va_end(ap);
 
     /* send message to on-screen-display if enabled */
-    if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
+    if (ConfigReadParamBool(l_OnScreenDisplay))
         osd_new_message((enum osd_corner) corner, "%s", buffer);
     /* send message to front-end */
     DebugMessage(level, "%s", buffer);
@@ -380,10 +401,12 @@ void main_message(m64p_msg_level level, unsigned int corner, const char *format,
 
 static void main_check_inputs(void)
 {
+    timed_section_start(TIMED_SECTION_INPUT);
 #ifdef WITH_LIRC
     lircCheckInput();
 #endif
     SDL_PumpEvents();
+    timed_section_end(TIMED_SECTION_INPUT);
 }
 
 /*********************************************************************************************************
@@ -419,15 +442,16 @@ int main_set_core_defaults(void)
     ConfigSetDefaultFloat(g_CoreConfig, "Version", (float) CONFIG_PARAM_VERSION,  "Mupen64Plus Core config parameter set version number.  Please don't change this version number.");
     ConfigSetDefaultBool(g_CoreConfig, "OnScreenDisplay", 1, "Draw on-screen display if True, otherwise don't draw OSD");
 #if defined(DYNAREC)
-    ConfigSetDefaultInt(g_CoreConfig, "R4300Emulator", 2, "Use Pure Interpreter if 0, Cached Interpreter if 1, or Dynamic Recompiler if 2 or more");
+    ConfigSetDefaultInt(g_CoreConfig, "R4300Emulator", 2, "Use Pure Interpreter if 0, Cached Interpreter if 1, Dynamic Recompiler if 2, or Threaded Cached Interpreter if 3");
 #else
-    ConfigSetDefaultInt(g_CoreConfig, "R4300Emulator", 1, "Use Pure Interpreter if 0, Cached Interpreter if 1, or Dynamic Recompiler if 2 or more");
+    ConfigSetDefaultInt(g_CoreConfig, "R4300Emulator", 1, "Use Pure Interpreter if 0, Cached Interpreter if 1, Dynamic Recompiler if 2, or Threaded Cached Interpreter if 3");
 #endif
     ConfigSetDefaultBool(g_CoreConfig, "NoCompiledJump", 0, "Disable compiled jump commands in dynamic recompiler (should be set to False) ");
     ConfigSetDefaultBool(g_CoreConfig, "DisableExtraMem", 0, "Disable 4MB expansion RAM pack. May be necessary for some games");
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOp", 0, "Force number of cycles per emulated instruction");
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOpDenomPot", 0, "Reduce number of cycles per update by power of two when set greater than 0 (overclock)");
     ConfigSetDefaultBool(g_CoreConfig, "AutoStateSlotIncrement", 0, "Increment the save state slot after each save operation");
+    ConfigSetDefaultBool(g_CoreConfig, "SaveStateChunked", 0, "Write save states as chunked containers compressed in parallel, instead of a single gzip stream. Cores without this option can't load them");
     ConfigSetDefaultInt(g_CoreConfig, "CurrentStateSlot", 0, "Save state slot (0-9) to use when saving/loading the emulator state");
     ConfigSetDefaultBool(g_CoreConfig, "EnableDebugger", 0, "Activate the R4300 debugger when ROM execution begins, if core was built with Debugger support");
     ConfigSetDefaultString(g_CoreConfig, "ScreenshotPath", "", "Path to directory where screenshots are saved. If this is blank, the default value of ${UserDataPath}/screenshot will be used");
@@ -438,6 +462,9 @@ int main_set_core_defaults(void)
     ConfigSetDefaultInt(g_CoreConfig, "SiDmaDuration", -1, "Duration of SI DMA (-1: use per game settings)");
     ConfigSetDefaultString(g_CoreConfig, "GbCameraVideoCaptureBackend1", DEFAULT_VIDEO_CAPTURE_BACKEND, "Gameboy Camera Video Capture backend");
     ConfigSetDefaultInt(g_CoreConfig, "SaveDiskFormat", 1, "Disk Save Format (0: Full Disk Copy (*.ndr/*.d6r), 1: RAM Area Only (*.ram))");
+    ConfigSetDefaultBool(g_CoreConfig, "PrecisePacing", 1, "Pace emulation on a nanosecond clock, sleeping then spinning up to each VI deadline, instead of the millisecond timer");
+    ConfigSetDefaultInt(g_CoreConfig, "WorkerThreads", 0, "Number of background threads for savestate compression and screenshot encoding (0: automatic)");
+    ConfigSetDefaultInt(g_CoreConfig, "RewindBufferSize", 0, "Memory in MB for the in-memory rewind history (0: disabled)");
     ConfigSetDefaultInt(g_CoreConfig, "SaveFilenameFormat", 1, "Save (SRAM/State) Filename Format (0: ROM Header Name, 1: Automatic (including partial MD5 hash))");
 
     /* handle upgrades */
@@ -451,6 +478,8 @@ int main_set_core_defaults(void)
         }
     }
 
+    ConfigGetParamHandle(g_CoreConfig, "OnScreenDisplay", M64TYPE_BOOL, &l_OnScreenDisplay);
+
     /* set config parameters for keyboard and joystick commands */
     return event_set_core_defaults();
 }
@@ -914,7 +943,7 @@ m64p_error main_reset(int do_hard_reset)
 static void video_plugin_render_callback(int bScreenRedrawn)
 {
 #ifdef M64P_OSD
-    int bOSD = ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay");
+    int bOSD = ConfigReadParamBool(l_OnScreenDisplay);
 #endif /* M64P_OSD */
 
     // if the flag is set to take a screenshot, then grab it now
@@ -946,14 +975,23 @@ static void video_plugin_render_callback(int bScreenRedrawn)
     }
 }
 
+void main_set_current_frame(unsigned int frame)
+{
+    l_CurrentFrame = (int)frame;
+}
+
 void new_frame(void)
 {
+    telemetry_publish(M64TELEM_FRAME, l_CurrentFrame, 0);
+
     if (g_FrameCallback != NULL)
         (*g_FrameCallback)(l_CurrentFrame);
 
     /* advance the current frame */
     l_CurrentFrame++;
 
+    rewind_frame(l_CurrentFrame);
+
     if (l_FrameAdvance) {
         g_rom_pause = 1;
         l_FrameAdvance = 0;
@@ -961,7 +999,69 @@ void new_frame(void)
     }
 }
 
-static void apply_speed_limiter(void)
+/* Keep the deadline at most this many VIs behind before slipping it, and
+ * never wait more than this many VIs ahead of the host clock. */
+#define PACING_MAX_LAG_VIS  4
+#define PACING_MAX_LEAD_VIS 2
+
+/* bounds of the adaptive spin window, in nanoseconds */
+#define PACING_SPIN_MIN_NS  100000
+#define PACING_SPIN_MAX_NS  4000000
+
+static void apply_precise_pacing(void)
+{
+    uint64_t now = osal_clock_ns();
+    uint64_t period = (uint64_t)(1e9 / g_dev.vi.expected_refresh_rate * 100.0 / l_SpeedFactor);
+
+    if (l_PacingSpinNs == 0)
+        l_PacingSpinNs = PACING_SPIN_MAX_NS / 2;
+
+    if (!l_MainSpeedLimit || l_PacingDeadline == 0)
+    {
+        l_PacingDeadline = now;
+        return;
+    }
+
+    /* Deadlines are accumulated rather than measured from the previous
+     * wake-up, so sleep overshoot never turns into drift. A late VI is
+     * caught up on by the following ones; only the part of a backlog beyond
+     * a few VIs (eg. a stall) is slipped, so nothing ever resets the timeline. */
+    l_PacingDeadline += period;
+    if (now > l_PacingDeadline + PACING_MAX_LAG_VIS * period)
+        l_PacingDeadline = now - PACING_MAX_LAG_VIS * period;
+    else if (l_PacingDeadline > now + PACING_MAX_LEAD_VIS * period)
+        l_PacingDeadline = now + period;
+
+    if (now < l_PacingDeadline)
+    {
+        uint64_t remaining = l_PacingDeadline - now;
+
+        if (remaining > l_PacingSpinNs)
+        {
+            uint64_t wake = l_PacingDeadline - l_PacingSpinNs;
+            uint64_t overshoot, spin;
+
+            osal_sleep_ns(wake - now);
+            now = osal_clock_ns();
+
+            /* size the spin window from how late the scheduler wakes us */
+            overshoot = (now > wake) ? now - wake : 0;
+            spin = l_PacingSpinNs - l_PacingSpinNs / 8 + (2 * overshoot + PACING_SPIN_MIN_NS) / 8;
+            if (spin < PACING_SPIN_MIN_NS)
+                spin = PACING_SPIN_MIN_NS;
+            else if (spin > PACING_SPIN_MAX_NS)
+                spin = PACING_SPIN_MAX_NS;
+            l_PacingSpinNs = spin;
+        }
+
+        while (now < l_PacingDeadline)
+            now = osal_clock_ns();
+    }
+
+    timed_sections_set_pacing_error((int64_t)(now - l_PacingDeadline));
+}
+
+static void apply_legacy_pacing(void)
 {
     static unsigned long totalVIs = 0;
     static int resetOnce = 0;
@@ -989,14 +1089,6 @@ static void apply_speed_limiter(void)
 
     lastSpeedFactor = l_SpeedFactor;
 
-#if defined(PROFILE)
-    timed_section_start(TIMED_SECTION_IDLE);
-#endif
-
-#ifdef DBG
-    if(g_DebuggerActive) DebuggerCallback(DEBUG_UI_VI, 0);
-#endif
-
     double totalElapsedGameTime = AdjustedLimit*totalVIs;
     double elapsedRealTime = CurrentFPSTime - StartFPSTime;
     double sleepTime = totalElapsedGameTime - elapsedRealTime;
@@ -1023,11 +1115,22 @@ static void apply_speed_limiter(void)
             sleepTime = totalElapsedGameTime - elapsedRealTime;
         }
     }
+}
 
+static void apply_speed_limiter(void)
+{
+    timed_section_start(TIMED_SECTION_IDLE);
 
-#if defined(PROFILE)
-    timed_section_end(TIMED_SECTION_IDLE);
+#ifdef DBG
+    if(g_DebuggerActive) DebuggerCallback(DEBUG_UI_VI, 0);
 #endif
+
+    if (l_PrecisePacing)
+        apply_precise_pacing();
+    else
+        apply_legacy_pacing();
+
+    timed_section_end(TIMED_SECTION_IDLE);
 }
 
 /* TODO: make a GameShark module and move that there */
@@ -1053,21 +1156,47 @@ static void pause_loop(void)
     {
         osd_render();  // draw Paused message in case gfx.updateScreen didn't do it
         VidExt_GL_SwapBuffers();
-        while(g_rom_pause)
+        /* a rewind has to run up to the next interrupt, it pauses again at the next VI */
+        while(g_rom_pause && !rewind_pending())
         {
             SDL_Delay(10);
             main_check_inputs();
         }
+
+        /* don't let the pause show up as a frame spike, nor as a backlog to catch up on */
+        timed_sections_discard();
+        l_PacingDeadline = 0;
     }
 }
 
+/* r4300 instructions emulated since the previous VI. Every emulator mode
+ * advances the count register by count_per_op / 2^count_per_op_denom_pot
+ * per instruction, so this is exact as long as the game leaves it alone. */
+static uint32_t vi_instructions(void)
+{
+    struct cp0* cp0 = &g_dev.r4300.cp0;
+    uint32_t count = r4300_cp0_regs(cp0)[CP0_COUNT_REG];
+    uint64_t cycles = (uint32_t)(count - l_ViCount);
+
+    l_ViCount = count;
+
+    if (cp0->count_per_op == 0)
+        return (uint32_t)cycles;
+
+    cycles = (cycles << cp0->count_per_op_denom_pot) / cp0->count_per_op;
+    return (cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)cycles;
+}
+
 /* called on vertical interrupt.
  * Allow the core to perform various things */
 void new_vi(void)
 {
-#if defined(PROFILE)
-    timed_sections_refresh();
-#endif
+    telemetry_flush_interrupts();
+    telemetry_publish(M64TELEM_VI, r4300_cp0_regs(&g_dev.r4300.cp0)[CP0_COUNT_REG], 0);
+
+    timed_sections_refresh(l_CurrentFrame, vi_instructions());
+    rdram_heatmap_sample();
+    sample_profiler_vi(&g_dev.r4300);
 
     gs_apply_cheats(&g_cheat_ctx);
 
@@ -1593,6 +1722,7 @@ m64p_error main_run(void)
     size_t dd_rom_size;
     struct dd_disk dd_disk;
     m64p_error failure_rval;
+    char* dynarec_cache_path = NULL;
 
     int control_ids[GAME_CONTROLLERS_COUNT];
     struct controller_input_compat cin_compats[GAME_CONTROLLERS_COUNT];
@@ -1627,6 +1757,8 @@ m64p_error main_run(void)
     savestates_set_autoinc_slot(ConfigGetParamBool(g_CoreConfig, "AutoStateSlotIncrement"));
     savestates_select_slot(ConfigGetParamInt(g_CoreConfig, "CurrentStateSlot"));
     no_compiled_jump = ConfigGetParamBool(g_CoreConfig, "NoCompiledJump");
+    l_PrecisePacing = ConfigGetParamBool(g_CoreConfig, "PrecisePacing");
+    l_PacingDeadline = 0;
     //We disable any randomness for netplay
     randomize_interrupt = !netplay_is_init() ? ConfigGetParamBool(g_CoreConfig, "RandomizeInterrupt") : 0;
     count_per_op = ConfigGetParamInt(g_CoreConfig, "CountPerOp");
@@ -1941,6 +2073,9 @@ m64p_error main_run(void)
     /* initialize frame counter */
     l_CurrentFrame = 0;
 
+    /* no rewinding under netplay, it would desync the other players */
+    rewind_init(!netplay_is_init() ? ConfigGetParamInt(g_CoreConfig, "RewindBufferSize") : 0);
+
     /* initialize the on-screen display */
     if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
     {
@@ -1969,11 +2104,26 @@ m64p_error main_run(void)
     g_rom_pause = 1;
     StateChanged(M64CORE_EMU_STATE, M64EMU_PAUSED);
 
+    if (emumode == EMUMODE_DYNAREC)
+        dynarec_cache_path = get_dynarec_cache_path();
+    if (dynarec_cache_path != NULL)
+        dynarec_cache_load(&g_dev.r4300.dynarec_cache, dynarec_cache_path);
+
     poweron_device(&g_dev);
     pif_bootrom_hle_execute(&g_dev.r4300);
     run_device(&g_dev);
 
+    if (dynarec_cache_path != NULL)
+        dynarec_cache_save(&g_dev.r4300.dynarec_cache, dynarec_cache_path);
+    dynarec_cache_release(&g_dev.r4300.dynarec_cache);
+    free(dynarec_cache_path);
+
     /* now begin to shut down */
+    rewind_deinit();
+
+    /* let pending states and screenshots reach the disk before the ROM goes away */
+    flush_workqueue();
+
 #ifdef WITH_LIRC
     lircStop();
 #endif // WITH_LIRC
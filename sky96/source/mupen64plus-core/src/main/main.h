@@ -60,6 +60,7 @@ const char* get_savesrampath(void);
 const char* get_savestatefilename(void);
 
 void new_frame(void);
+void main_set_current_frame(unsigned int frame);
 void new_vi(void);
 
 void main_switch_next_pak(int control_id);
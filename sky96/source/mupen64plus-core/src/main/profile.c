@@ -23,77 +23,153 @@
 
 #include "profile.h"
 
-#include "api/callbacks.h"
+#include <stdint.h>
+#include <string.h>
+
 #include "api/m64p_types.h"
+#include "osal/atomics.h"
+#include "osal/clock.h"
+
+/* number of VI records kept, must be a power of two */
+#define FRAME_TIMING_HISTORY 8192
+#define FRAME_TIMING_MASK (FRAME_TIMING_HISTORY - 1)
+
+static uint64_t time_in_section[NUM_TIMED_SECTIONS];
+static uint64_t last_start[NUM_TIMED_SECTIONS];
+static unsigned int section_depth[NUM_TIMED_SECTIONS];
 
-static long long int time_in_section[NUM_TIMED_SECTIONS];
-static long long int last_start[NUM_TIMED_SECTIONS];
-
-#if defined(WIN32) && !defined(__MINGW32__)
-  // timing
-  #include <windows.h>
-
-  static long long int get_time(void)
-  {
-      LARGE_INTEGER counter;
-      QueryPerformanceCounter(&counter);
-      return counter.QuadPart;
-  }
-  static long long int time_to_nsec(long long int time)
-  {
-      static LARGE_INTEGER freq = { 0 };
-      if (freq.QuadPart == 0)
-          QueryPerformanceFrequency(&freq);
-      return time * 1000000000 / freq.QuadPart;
-  }
-
-#else  /* Not WIN32 */
-  // timing
-  #include <time.h>
-
-  static long long int get_time(void)
-  {
-     struct timespec ts;
-     clock_gettime(CLOCK_MONOTONIC, &ts);
-     return (long long int)ts.tv_sec * 1000000000 + ts.tv_nsec;
-  }
-  static long long int time_to_nsec(long long int time)
-  {
-      return time;
-  }
-#endif
+/* Records are written by the emulation thread only. Readers copy them
+ * optimistically and discard those which may have been overwritten
+ * meanwhile, so neither side ever waits for the other. */
+static m64p_frame_timing l_history[FRAME_TIMING_HISTORY];
+static uint32_t l_published;
+static int32_t l_pacing_error;
+
+static uint32_t clamp_ns(uint64_t ns)
+{
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
 
 void timed_section_start(enum timed_section section)
 {
-   last_start[section] = get_time();
+   if (section_depth[section]++ == 0)
+      last_start[section] = osal_clock_ns();
 }
 
 void timed_section_end(enum timed_section section)
 {
-   long long int end = get_time();
-   time_in_section[section] += end - last_start[section];
+   if (section_depth[section] == 0)
+      return;
+
+   if (--section_depth[section] == 0)
+      time_in_section[section] += osal_clock_ns() - last_start[section];
+}
+
+void timed_sections_set_pacing_error(int64_t error_ns)
+{
+   if (error_ns > INT32_MAX)
+      error_ns = INT32_MAX;
+   else if (error_ns < INT32_MIN)
+      error_ns = INT32_MIN;
+
+   l_pacing_error = (int32_t)error_ns;
 }
 
-void timed_sections_refresh()
+void timed_sections_refresh(unsigned int frame, uint32_t instructions)
 {
-   long long int curr_time = get_time();
-   if(time_to_nsec(curr_time - last_start[TIMED_SECTION_ALL]) >= 2000000000)
+   uint64_t curr_time = osal_clock_ns();
+   uint64_t accounted = 0;
+   int i;
+
+   /* split sections which are still running across the two records */
+   for (i = TIMED_SECTION_ALL + 1; i < NUM_TIMED_SECTIONS; ++i)
+   {
+      if (section_depth[i] != 0)
+      {
+         time_in_section[i] += curr_time - last_start[i];
+         last_start[i] = curr_time;
+      }
+      accounted += time_in_section[i];
+   }
+
+   if (last_start[TIMED_SECTION_ALL] != 0)
    {
-      time_in_section[TIMED_SECTION_ALL] = curr_time - last_start[TIMED_SECTION_ALL];
-      DebugMessage(M64MSG_INFO, "gfx=%f%% - audio=%f%% - compiler=%f%%, idle=%f%%",
-         100.0 * (double)time_in_section[TIMED_SECTION_GFX] / time_in_section[TIMED_SECTION_ALL],
-         100.0 * (double)time_in_section[TIMED_SECTION_AUDIO] / time_in_section[TIMED_SECTION_ALL],
-         100.0 * (double)time_in_section[TIMED_SECTION_COMPILER] / time_in_section[TIMED_SECTION_ALL],
-         100.0 * (double)time_in_section[TIMED_SECTION_IDLE] / time_in_section[TIMED_SECTION_ALL]);
-      DebugMessage(M64MSG_INFO, "gfx=%llins - audio=%llins - compiler %llins - idle=%llins",
-         time_to_nsec(time_in_section[TIMED_SECTION_GFX]),
-         time_to_nsec(time_in_section[TIMED_SECTION_AUDIO]),
-         time_to_nsec(time_in_section[TIMED_SECTION_COMPILER]),
-         time_to_nsec(time_in_section[TIMED_SECTION_IDLE]));
-      time_in_section[TIMED_SECTION_GFX] = 0;
-      time_in_section[TIMED_SECTION_AUDIO] = 0;
-      time_in_section[TIMED_SECTION_COMPILER] = 0;
-      time_in_section[TIMED_SECTION_IDLE] = 0;
-      last_start[TIMED_SECTION_ALL] = curr_time;
+      uint64_t total = curr_time - last_start[TIMED_SECTION_ALL];
+      m64p_frame_timing* t = &l_history[l_published & FRAME_TIMING_MASK];
+
+      t->vi = l_published;
+      t->frame = frame;
+      t->total_ns = clamp_ns(total);
+      t->cpu_ns = clamp_ns((total > accounted) ? total - accounted : 0);
+      t->rsp_gfx_ns = clamp_ns(time_in_section[TIMED_SECTION_GFX]);
+      t->rsp_audio_ns = clamp_ns(time_in_section[TIMED_SECTION_AUDIO]);
+      t->compiler_ns = clamp_ns(time_in_section[TIMED_SECTION_COMPILER]);
+      t->idle_ns = clamp_ns(time_in_section[TIMED_SECTION_IDLE]);
+      t->input_ns = clamp_ns(time_in_section[TIMED_SECTION_INPUT]);
+      t->pacing_error_ns = l_pacing_error;
+      t->instructions = instructions;
+
+      osal_atomic_store_release(&l_published, l_published + 1);
    }
+
+   memset(time_in_section, 0, sizeof(time_in_section));
+   l_pacing_error = 0;
+   last_start[TIMED_SECTION_ALL] = curr_time;
+}
+
+void timed_sections_discard(void)
+{
+   int i;
+   uint64_t curr_time = osal_clock_ns();
+
+   for (i = TIMED_SECTION_ALL + 1; i < NUM_TIMED_SECTIONS; ++i)
+   {
+      if (section_depth[i] != 0)
+         last_start[i] = curr_time;
+   }
+
+   memset(time_in_section, 0, sizeof(time_in_section));
+   l_pacing_error = 0;
+   last_start[TIMED_SECTION_ALL] = curr_time;
+}
+
+m64p_error timed_sections_query(m64p_frame_timing_query* query)
+{
+   uint32_t published, first, n, i, skip;
+
+   if (query->timings == NULL && query->capacity != 0)
+      return M64ERR_INPUT_ASSERT;
+
+   published = osal_atomic_load_acquire(&l_published);
+
+   /* clamp to the oldest record still in history */
+   first = query->first;
+   if (published - first > FRAME_TIMING_HISTORY)
+      first = published - FRAME_TIMING_HISTORY;
+
+   n = published - first;
+   if (n > query->capacity)
+      n = query->capacity;
+
+   for (i = 0; i < n; ++i)
+      query->timings[i] = l_history[(first + i) & FRAME_TIMING_MASK];
+
+   /* drop the records the emulation thread may have overwritten while we were copying */
+   osal_atomic_fence_acquire();
+   published = osal_atomic_load_acquire(&l_published);
+
+   skip = 0;
+   if (published - first >= FRAME_TIMING_HISTORY)
+   {
+      skip = published - first - FRAME_TIMING_HISTORY + 1;
+      if (skip > n)
+         skip = n;
+      else if (skip != 0)
+         memmove(query->timings, query->timings + skip, (n - skip) * sizeof(m64p_frame_timing));
+   }
+
+   query->first = first + skip;
+   query->count = n - skip;
+
+   return M64ERR_SUCCESS;
 }
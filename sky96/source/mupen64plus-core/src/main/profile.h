@@ -24,6 +24,10 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
 enum timed_section
 {
     TIMED_SECTION_ALL,
@@ -31,11 +35,22 @@ enum timed_section
     TIMED_SECTION_AUDIO,
     TIMED_SECTION_COMPILER,
     TIMED_SECTION_IDLE,
+    TIMED_SECTION_INPUT,
     NUM_TIMED_SECTIONS
 };
 
+/* Sections may be nested, only the outermost start/end pair is accounted. */
 void timed_section_start(enum timed_section section);
 void timed_section_end(enum timed_section section);
-void timed_sections_refresh(void);
+
+/* Attach the speed limiter's pacing error to the current VI record. */
+void timed_sections_set_pacing_error(int64_t error_ns);
+
+/* Close the timing record of the current VI and append it to the history. */
+void timed_sections_refresh(unsigned int frame, uint32_t instructions);
+/* Restart the current VI record without publishing it (eg. after a pause). */
+void timed_sections_discard(void);
+
+m64p_error timed_sections_query(m64p_frame_timing_query* query);
 
 #endif
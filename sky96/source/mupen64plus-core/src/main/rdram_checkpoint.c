@@ -0,0 +1,188 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdram_checkpoint.c                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "rdram_checkpoint.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+enum { PAGE_WORDS = RDRAM_CHECKPOINT_PAGE_SIZE / 4 };
+
+static uint32_t* l_shadow = NULL;
+static uint32_t l_page[PAGE_WORDS];
+
+static void put_word(unsigned char* curr, uint32_t value)
+{
+    value = little32(value);
+    memcpy(curr, &value, 4);
+}
+
+static uint32_t get_word(const unsigned char* curr)
+{
+    uint32_t value;
+
+    memcpy(&value, curr, 4);
+    return little32(value);
+}
+
+/* Read the page index of a record and its data in host order. */
+static const uint32_t* read_record(const unsigned char* curr, uint32_t* page)
+{
+    size_t i;
+
+    *page = get_word(curr) & (RDRAM_DIRTY_PAGES - 1);
+    for (i = 0; i < PAGE_WORDS; ++i)
+        l_page[i] = get_word(curr + 4 + 4 * i);
+
+    return l_page;
+}
+
+int rdram_checkpoint_reset(void)
+{
+    if (l_shadow == NULL)
+    {
+        l_shadow = malloc((size_t)RDRAM_DIRTY_PAGES * RDRAM_CHECKPOINT_PAGE_SIZE);
+        if (l_shadow == NULL)
+            return 0;
+    }
+
+    memset(l_shadow, 0, (size_t)RDRAM_DIRTY_PAGES * RDRAM_CHECKPOINT_PAGE_SIZE);
+    rdram_dirty_mark_all();
+
+    return 1;
+}
+
+int rdram_checkpoint_ready(void)
+{
+    return l_shadow != NULL;
+}
+
+void rdram_checkpoint_free(void)
+{
+    free(l_shadow);
+    l_shadow = NULL;
+}
+
+uint32_t rdram_checkpoint_collect(const uint32_t* dram, int untracked)
+{
+    uint32_t page;
+    uint32_t pages = 0;
+
+    if (g_rdram_dirty_disabled)
+        rdram_dirty_mark_all();
+
+    untracked |= g_rdram_dirty_untracked;
+
+    for (page = 0; page < RDRAM_DIRTY_PAGES; ++page)
+    {
+        if (!rdram_dirty_test(page) && (untracked || rdram_dirty_test_check(page)))
+        {
+            size_t offset = (size_t)page * PAGE_WORDS;
+
+            if (memcmp(&dram[offset], &l_shadow[offset], RDRAM_CHECKPOINT_PAGE_SIZE) == 0)
+                continue;
+
+            rdram_dirty_mark(page << RDRAM_DIRTY_PAGE_SHIFT);
+        }
+
+        pages += rdram_dirty_test(page);
+    }
+
+    return pages;
+}
+
+void rdram_checkpoint_write(unsigned char* curr, const uint32_t* dram, int xor_previous)
+{
+    uint32_t page;
+    size_t i;
+
+    for (page = 0; page < RDRAM_DIRTY_PAGES; ++page)
+    {
+        size_t offset = (size_t)page * PAGE_WORDS;
+        uint32_t* shadow = &l_shadow[offset];
+
+        if (!rdram_dirty_test(page))
+            continue;
+
+        put_word(curr, page);
+        for (i = 0; i < PAGE_WORDS; ++i)
+            put_word(curr + 4 + 4 * i, xor_previous ? (dram[offset + i] ^ shadow[i]) : dram[offset + i]);
+        memcpy(shadow, &dram[offset], RDRAM_CHECKPOINT_PAGE_SIZE);
+        curr += RDRAM_CHECKPOINT_RECORD_SIZE;
+    }
+
+    rdram_dirty_clear();
+}
+
+void rdram_checkpoint_load(uint32_t* dram, const unsigned char* curr, uint32_t pages)
+{
+    uint32_t i, page;
+
+    for (i = 0; i < pages; ++i)
+    {
+        const uint32_t* src = read_record(curr, &page);
+
+        memcpy(&dram[(size_t)page * PAGE_WORDS], src, RDRAM_CHECKPOINT_PAGE_SIZE);
+        curr += RDRAM_CHECKPOINT_RECORD_SIZE;
+    }
+
+    if (l_shadow != NULL)
+        memcpy(l_shadow, dram, (size_t)RDRAM_DIRTY_PAGES * RDRAM_CHECKPOINT_PAGE_SIZE);
+    rdram_dirty_clear();
+}
+
+void rdram_checkpoint_undo(const unsigned char* curr, uint32_t pages)
+{
+    uint32_t i, page;
+    size_t k;
+
+    for (i = 0; i < pages; ++i)
+    {
+        const uint32_t* delta = read_record(curr, &page);
+        uint32_t* shadow = &l_shadow[(size_t)page * PAGE_WORDS];
+
+        for (k = 0; k < PAGE_WORDS; ++k)
+            shadow[k] ^= delta[k];
+
+        /* make sure revert copies it back */
+        rdram_dirty_mark(page << RDRAM_DIRTY_PAGE_SHIFT);
+        curr += RDRAM_CHECKPOINT_RECORD_SIZE;
+    }
+}
+
+void rdram_checkpoint_revert(uint32_t* dram, int untracked)
+{
+    uint32_t page;
+
+    rdram_checkpoint_collect(dram, untracked);
+
+    for (page = 0; page < RDRAM_DIRTY_PAGES; ++page)
+    {
+        size_t offset = (size_t)page * PAGE_WORDS;
+
+        if (rdram_dirty_test(page))
+            memcpy(&dram[offset], &l_shadow[offset], RDRAM_CHECKPOINT_PAGE_SIZE);
+    }
+
+    rdram_dirty_clear();
+}
@@ -0,0 +1,63 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdram_checkpoint.h                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_RDRAM_CHECKPOINT_H
+#define M64P_MAIN_RDRAM_CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "rdram_dirty.h"
+
+/* RDRAM side of the savestate checkpoints. It keeps a copy of RDRAM as of
+ * the last checkpoint, which also finds the pages written by the writers
+ * the dirty bitmap can't see, and reads and writes the page records of a
+ * checkpoint: the page index followed by the page, both in little endian
+ * 32-bit words. Delta records hold the page XORed with the copy. */
+
+enum { RDRAM_CHECKPOINT_PAGE_SIZE = 1 << RDRAM_DIRTY_PAGE_SHIFT };
+enum { RDRAM_CHECKPOINT_RECORD_SIZE = 4 + RDRAM_CHECKPOINT_PAGE_SIZE };
+
+/* Allocate and zero the copy, so that the next checkpoint holds all of
+ * RDRAM. Returns 0 if it can't be allocated. */
+int rdram_checkpoint_reset(void);
+
+int rdram_checkpoint_ready(void);
+
+void rdram_checkpoint_free(void);
+
+/* Mark the pages that differ from the copy, among those of the check bitmap
+ * or, if untracked, among all of them. Returns the number of marked pages. */
+uint32_t rdram_checkpoint_collect(const uint32_t* dram, int untracked);
+
+/* Write a record of each marked page, bring the copy up to date and clear
+ * the bitmaps. */
+void rdram_checkpoint_write(unsigned char* curr, const uint32_t* dram, int xor_previous);
+
+/* Copy the pages of full records to dram, which becomes the copy. */
+void rdram_checkpoint_load(uint32_t* dram, const unsigned char* curr, uint32_t pages);
+
+/* Apply delta records to the copy, marking their pages. */
+void rdram_checkpoint_undo(const unsigned char* curr, uint32_t pages);
+
+/* Put back the pages of dram that differ from the copy. */
+void rdram_checkpoint_revert(uint32_t* dram, int untracked);
+
+#endif
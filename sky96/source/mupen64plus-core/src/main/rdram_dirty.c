@@ -0,0 +1,80 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdram_dirty.c                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "rdram_dirty.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define PAGE_SIZE (UINT32_C(1) << RDRAM_DIRTY_PAGE_SHIFT)
+#define RDRAM_DIRTY_SIZE (RDRAM_DIRTY_PAGES * PAGE_SIZE)
+
+uint32_t g_rdram_dirty[RDRAM_DIRTY_WORDS];
+uint32_t g_rdram_dirty_check[RDRAM_DIRTY_WORDS];
+int g_rdram_dirty_untracked;
+int g_rdram_dirty_disabled;
+
+
+static void rdram_dirty_set_range(uint32_t* bitmap, uint32_t address, uint32_t length)
+{
+    uint32_t first, last;
+
+    if (length == 0)
+        return;
+
+    address &= RDRAM_DIRTY_SIZE - 1;
+    if (length > RDRAM_DIRTY_SIZE - address)
+        length = RDRAM_DIRTY_SIZE - address;
+
+    first = address >> RDRAM_DIRTY_PAGE_SHIFT;
+    last = (address + length - 1) >> RDRAM_DIRTY_PAGE_SHIFT;
+
+    for (; first <= last; ++first)
+        bitmap[first >> 5] |= UINT32_C(1) << (first & 31);
+}
+
+void rdram_dirty_mark_range(uint32_t address, uint32_t length)
+{
+    rdram_dirty_set_range(g_rdram_dirty, address, length);
+}
+
+void rdram_dirty_check_range(uint32_t address, uint32_t length)
+{
+    rdram_dirty_set_range(g_rdram_dirty_check, address, length);
+}
+
+void rdram_dirty_mark_all(void)
+{
+    memset(g_rdram_dirty, 0xff, sizeof(g_rdram_dirty));
+}
+
+void rdram_dirty_poweron(void)
+{
+    rdram_dirty_mark_all();
+    g_rdram_dirty_disabled = 0;
+}
+
+void rdram_dirty_clear(void)
+{
+    memset(g_rdram_dirty, 0, sizeof(g_rdram_dirty));
+    memset(g_rdram_dirty_check, 0, sizeof(g_rdram_dirty_check));
+    g_rdram_dirty_untracked = 0;
+}
@@ -0,0 +1,94 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdram_dirty.h                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_RDRAM_DIRTY_H
+#define M64P_MAIN_RDRAM_DIRTY_H
+
+#include <stdint.h>
+
+#include "osal/preproc.h"
+
+/* Bitmap of the 4KB RDRAM pages written since the last savestate
+ * checkpoint, fed by the RDRAM write handler and the PI/SI/SP DMA paths.
+ *
+ * Some writers bypass both: the RSP and RDP plugins write RDRAM through
+ * their own pointer and the dynarecs store to it inline. Where the core
+ * knows which pages such a writer may have touched, it puts them in
+ * g_rdram_dirty_check and the checkpoint code compares only those with its
+ * copy of RDRAM. Otherwise it raises g_rdram_dirty_untracked and the next
+ * checkpoint compares all pages.
+ *
+ * A debugger front-end holding the raw RDRAM pointer can write at any time,
+ * so once it has been handed out g_rdram_dirty_disabled is set and every
+ * checkpoint holds the whole RDRAM, until the next power-on or reset. */
+
+enum { RDRAM_DIRTY_PAGE_SHIFT = 12 };
+enum { RDRAM_DIRTY_PAGES = 0x800000 >> RDRAM_DIRTY_PAGE_SHIFT };
+enum { RDRAM_DIRTY_WORDS = RDRAM_DIRTY_PAGES / 32 };
+
+extern uint32_t g_rdram_dirty[RDRAM_DIRTY_WORDS];
+extern uint32_t g_rdram_dirty_check[RDRAM_DIRTY_WORDS];
+extern int g_rdram_dirty_untracked;
+extern int g_rdram_dirty_disabled;
+
+static osal_inline void rdram_dirty_mark(uint32_t address)
+{
+    uint32_t page = (address >> RDRAM_DIRTY_PAGE_SHIFT) & (RDRAM_DIRTY_PAGES - 1);
+
+    g_rdram_dirty[page >> 5] |= UINT32_C(1) << (page & 31);
+}
+
+static osal_inline int rdram_dirty_test(uint32_t page)
+{
+    return (g_rdram_dirty[page >> 5] >> (page & 31)) & 1;
+}
+
+static osal_inline int rdram_dirty_test_check(uint32_t page)
+{
+    return (g_rdram_dirty_check[page >> 5] >> (page & 31)) & 1;
+}
+
+static osal_inline void rdram_dirty_untracked(void)
+{
+    g_rdram_dirty_untracked = 1;
+}
+
+static osal_inline void rdram_dirty_disable(void)
+{
+    g_rdram_dirty_disabled = 1;
+}
+
+/* Mark every page overlapped by a DMA of length bytes. */
+void rdram_dirty_mark_range(uint32_t address, uint32_t length);
+
+/* Have the next checkpoint compare the pages overlapped by length bytes
+ * with its copy of RDRAM: they may have been written behind our back. */
+void rdram_dirty_check_range(uint32_t address, uint32_t length);
+
+/* Mark all pages, so that the next checkpoint holds the whole RDRAM. */
+void rdram_dirty_mark_all(void);
+
+/* Power-on and reset: mark all pages and track writes again. */
+void rdram_dirty_poweron(void);
+
+void rdram_dirty_clear(void);
+
+#endif
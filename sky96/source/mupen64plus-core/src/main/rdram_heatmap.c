@@ -0,0 +1,125 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdram_heatmap.c                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "rdram_heatmap.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "api/m64p_types.h"
+#include "osal/atomics.h"
+
+/* each snapshot keeps 3/4 of the previous one, so a page's heat is about
+ * four VIs worth of accesses at a steady rate */
+#define HEAT_DECAY_SHIFT 2
+
+#define PAGE_SIZE (UINT32_C(1) << RDRAM_HEATMAP_PAGE_SHIFT)
+#define RDRAM_HEATMAP_SIZE (M64P_RDRAM_HEATMAP_PAGES * PAGE_SIZE)
+
+uint32_t g_rdram_heat_counts[RDRAM_HEATMAP_KINDS][M64P_RDRAM_HEATMAP_PAGES];
+
+/* Double-buffered snapshot: the emulation thread writes snapshot
+ * (l_sequence + 1) & 1 then publishes it by bumping l_sequence. Readers copy
+ * snapshot l_sequence & 1, which can only be overwritten by the sample after
+ * the next one, and retry if l_sequence moved during the copy. */
+static uint32_t l_heat[2][RDRAM_HEATMAP_KINDS][M64P_RDRAM_HEATMAP_PAGES];
+static uint32_t l_sequence;
+static uint32_t l_enabled;
+
+
+void rdram_heatmap_dma_write(uint32_t address, uint32_t length)
+{
+    uint32_t* counts = g_rdram_heat_counts[RDRAM_HEATMAP_DMA_WRITE];
+
+    address &= RDRAM_HEATMAP_SIZE - 1;
+    if (length > RDRAM_HEATMAP_SIZE - address)
+        length = RDRAM_HEATMAP_SIZE - address;
+
+    while (length != 0)
+    {
+        uint32_t in_page = PAGE_SIZE - (address & (PAGE_SIZE - 1));
+        if (in_page > length)
+            in_page = length;
+
+        counts[address >> RDRAM_HEATMAP_PAGE_SHIFT] += (in_page + 3) >> 2;
+        address += in_page;
+        length -= in_page;
+    }
+}
+
+void rdram_heatmap_sample(void)
+{
+    uint32_t sequence = l_sequence;
+    const uint32_t (*prev)[M64P_RDRAM_HEATMAP_PAGES] = l_heat[sequence & 1];
+    uint32_t (*next)[M64P_RDRAM_HEATMAP_PAGES] = l_heat[(sequence + 1) & 1];
+    size_t k, p;
+
+    /* nobody is looking, don't bother decaying */
+    if (!osal_atomic_load_acquire(&l_enabled))
+    {
+        memset(g_rdram_heat_counts, 0, sizeof(g_rdram_heat_counts));
+        return;
+    }
+
+    for (k = 0; k < RDRAM_HEATMAP_KINDS; ++k)
+    {
+        for (p = 0; p < M64P_RDRAM_HEATMAP_PAGES; ++p)
+        {
+            uint32_t heat = prev[k][p] - (prev[k][p] >> HEAT_DECAY_SHIFT);
+            uint32_t count = g_rdram_heat_counts[k][p];
+
+            next[k][p] = (count > UINT32_MAX - heat) ? UINT32_MAX : heat + count;
+        }
+    }
+
+    memset(g_rdram_heat_counts, 0, sizeof(g_rdram_heat_counts));
+    osal_atomic_store_release(&l_sequence, sequence + 1);
+}
+
+m64p_error rdram_heatmap_query(m64p_rdram_heatmap* heatmap)
+{
+    uint32_t before, after;
+    int retries = 4;
+
+    osal_atomic_store_release(&l_enabled, 1);
+
+    do
+    {
+        const uint32_t (*heat)[M64P_RDRAM_HEATMAP_PAGES];
+
+        before = osal_atomic_load_acquire(&l_sequence);
+        heat = l_heat[before & 1];
+
+        memcpy(heatmap->reads, heat[RDRAM_HEATMAP_READ], sizeof(heatmap->reads));
+        memcpy(heatmap->writes, heat[RDRAM_HEATMAP_WRITE], sizeof(heatmap->writes));
+        memcpy(heatmap->dma_writes, heat[RDRAM_HEATMAP_DMA_WRITE], sizeof(heatmap->dma_writes));
+
+        osal_atomic_fence_acquire();
+        after = osal_atomic_load_acquire(&l_sequence);
+    } while (after != before && --retries != 0);
+
+    if (after != before)
+        return M64ERR_SYSTEM_FAIL;
+
+    heatmap->sample = before;
+
+    return M64ERR_SUCCESS;
+}
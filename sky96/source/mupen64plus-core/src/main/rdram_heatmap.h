@@ -0,0 +1,60 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rdram_heatmap.h                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_RDRAM_HEATMAP_H
+#define M64P_MAIN_RDRAM_HEATMAP_H
+
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+#include "osal/preproc.h"
+
+/* Per-page RDRAM access counters.
+ * Counters are only ever touched by the emulation thread: accesses bump
+ * them with a plain increment and rdram_heatmap_sample, called once per
+ * VI, folds them into a decayed snapshot. Only that snapshot is shared
+ * with the front-end (M64CMD_GET_RDRAM_HEATMAP). */
+
+enum { RDRAM_HEATMAP_PAGE_SHIFT = 12 };
+
+enum rdram_heatmap_kind
+{
+    RDRAM_HEATMAP_READ,
+    RDRAM_HEATMAP_WRITE,
+    RDRAM_HEATMAP_DMA_WRITE,
+    RDRAM_HEATMAP_KINDS
+};
+
+extern uint32_t g_rdram_heat_counts[RDRAM_HEATMAP_KINDS][M64P_RDRAM_HEATMAP_PAGES];
+
+static osal_inline void rdram_heatmap_access(enum rdram_heatmap_kind kind, uint32_t address)
+{
+    ++g_rdram_heat_counts[kind][(address >> RDRAM_HEATMAP_PAGE_SHIFT) & (M64P_RDRAM_HEATMAP_PAGES - 1)];
+}
+
+/* Account a DMA of length bytes to RDRAM, in words per page. */
+void rdram_heatmap_dma_write(uint32_t address, uint32_t length);
+
+void rdram_heatmap_sample(void);
+
+m64p_error rdram_heatmap_query(m64p_rdram_heatmap* heatmap);
+
+#endif
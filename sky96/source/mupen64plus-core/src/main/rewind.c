@@ -0,0 +1,284 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rewind.c                                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "rewind.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "device/device.h"
+#include "main/lz.h"
+#include "main/main.h"
+#include "main/savestates.h"
+#include "osal/atomics.h"
+#include "osd/osd.h"
+
+/* about four and a half minutes at 60 frames per second */
+enum { REWIND_MAX_ENTRIES = 16384 };
+/* entry offsets are 32 bits */
+enum { REWIND_MAX_MEGABYTES = 2048 };
+
+struct rewind_entry
+{
+    uint32_t offset;    /* of the compressed delta in the arena */
+    uint32_t size;
+    uint32_t frame;     /* frame counter of the state undoing it leads to */
+};
+
+static unsigned char* l_arena = NULL;
+static size_t l_arena_size;
+/* raw and compressed delta scratch, sized for the worst case */
+static unsigned char* l_delta = NULL;
+static size_t l_delta_size;
+static unsigned char* l_packed = NULL;
+static size_t l_packed_size;
+
+/* FIFO of deltas, oldest first, laid out in the arena in the same order */
+static struct rewind_entry l_entries[REWIND_MAX_ENTRIES];
+static uint32_t l_first;
+static uint32_t l_count;
+static size_t l_write;
+
+static int l_have_head;
+static uint32_t l_head_frame;
+static int l_snapshot_pending;
+static uint32_t l_snapshot_frame;
+
+/* shared with the front-end */
+static uint32_t l_request;
+static uint32_t l_public_frame;
+static uint32_t l_public_depth;
+static uint32_t l_public_used;
+static uint32_t l_public_capacity;
+
+
+static void publish(void)
+{
+    uint32_t used = 0;
+
+    if (l_count != 0)
+    {
+        const struct rewind_entry* first = &l_entries[l_first];
+        const struct rewind_entry* last = &l_entries[(l_first + l_count - 1) % REWIND_MAX_ENTRIES];
+        size_t end = last->offset + last->size;
+
+        used = (uint32_t)((end > first->offset) ? end - first->offset : l_arena_size - first->offset + end);
+    }
+
+    osal_atomic_store_release(&l_public_frame, l_head_frame);
+    osal_atomic_store_release(&l_public_depth, l_count);
+    osal_atomic_store_release(&l_public_used, used);
+}
+
+static void drop_oldest(void)
+{
+    l_first = (l_first + 1) % REWIND_MAX_ENTRIES;
+    --l_count;
+}
+
+static void push(size_t size, uint32_t frame)
+{
+    struct rewind_entry* entry;
+
+    if (size > l_arena_size)
+    {
+        /* can't rewind across this one */
+        l_count = 0;
+        l_write = 0;
+        return;
+    }
+
+    if (l_write + size > l_arena_size)
+    {
+        /* the tail of the arena goes unused, and holds the oldest deltas */
+        while (l_count != 0 && l_entries[l_first].offset >= l_write)
+            drop_oldest();
+        l_write = 0;
+    }
+
+    while (l_count != 0
+        && l_entries[l_first].offset >= l_write
+        && l_entries[l_first].offset < l_write + size)
+    {
+        drop_oldest();
+    }
+
+    if (l_count == REWIND_MAX_ENTRIES)
+        drop_oldest();
+
+    entry = &l_entries[(l_first + l_count) % REWIND_MAX_ENTRIES];
+    entry->offset = (uint32_t)l_write;
+    entry->size = (uint32_t)size;
+    entry->frame = frame;
+    memcpy(l_arena + l_write, l_packed, size);
+
+    l_write += size;
+    ++l_count;
+}
+
+int rewind_init(int megabytes)
+{
+    rewind_deinit();
+
+    if (megabytes <= 0)
+        return 1;
+
+    if (megabytes > REWIND_MAX_MEGABYTES)
+        megabytes = REWIND_MAX_MEGABYTES;
+
+    l_arena_size = (size_t)megabytes << 20;
+    l_delta_size = savestates_checkpoint_max_size();
+    l_packed_size = lz_compress_bound(l_delta_size);
+
+    l_arena = malloc(l_arena_size);
+    l_delta = malloc(l_delta_size);
+    l_packed = malloc(l_packed_size);
+
+    if (l_arena == NULL || l_delta == NULL || l_packed == NULL || !savestates_checkpoint_reset())
+    {
+        DebugMessage(M64MSG_ERROR, "Could not allocate %i MB rewind buffer", megabytes);
+        rewind_deinit();
+        return 0;
+    }
+
+    osal_atomic_store_release(&l_public_capacity, (uint32_t)l_arena_size);
+    DebugMessage(M64MSG_INFO, "Rewind buffer of %i MB", megabytes);
+
+    return 1;
+}
+
+void rewind_deinit(void)
+{
+    free(l_arena);
+    free(l_delta);
+    free(l_packed);
+    l_arena = l_delta = l_packed = NULL;
+
+    l_first = l_count = 0;
+    l_write = 0;
+    l_have_head = 0;
+    l_head_frame = 0;
+    l_snapshot_pending = 0;
+
+    osal_atomic_store_release(&l_request, 0);
+    osal_atomic_store_release(&l_public_capacity, 0);
+    publish();
+}
+
+void rewind_frame(unsigned int frame)
+{
+    if (l_arena == NULL)
+        return;
+
+    l_snapshot_pending = 1;
+    l_snapshot_frame = frame;
+}
+
+void rewind_checkpoint(void)
+{
+    size_t size;
+
+    if (!l_snapshot_pending)
+        return;
+
+    l_snapshot_pending = 0;
+
+    size = savestates_checkpoint_save(&g_dev, l_delta, l_delta_size, 1);
+    if (size == 0)
+        return;
+
+    /* the first one only sets the starting point */
+    if (l_have_head)
+    {
+        size = lz_compress(l_delta, size, l_packed, l_packed_size);
+        push(size, l_head_frame);
+    }
+
+    l_have_head = 1;
+    l_head_frame = l_snapshot_frame;
+    publish();
+}
+
+int rewind_pending(void)
+{
+    return osal_atomic_load_acquire(&l_request) != 0;
+}
+
+void rewind_run_job(void)
+{
+    /* a request posted after this point is kept for the next job */
+    uint32_t frames = osal_atomic_exchange(&l_request, 0);
+    uint32_t undone = 0;
+
+    if (frames == 0 || !l_have_head)
+        return;
+
+    for (; undone < frames && l_count != 0; ++undone)
+    {
+        const struct rewind_entry* entry = &l_entries[(l_first + l_count - 1) % REWIND_MAX_ENTRIES];
+        size_t size = lz_decompress(l_arena + entry->offset, entry->size, l_delta, l_delta_size);
+
+        if (size == 0 || !savestates_checkpoint_undo(l_delta, size))
+        {
+            DebugMessage(M64MSG_ERROR, "Corrupted rewind history at frame %u", entry->frame);
+            l_count = 0;
+            break;
+        }
+
+        l_head_frame = entry->frame;
+        l_write = entry->offset;
+        --l_count;
+    }
+
+    /* whatever ran since the last snapshot is discarded too */
+    l_snapshot_pending = 0;
+    savestates_checkpoint_revert(&g_dev);
+    main_set_current_frame(l_head_frame);
+    publish();
+
+    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Rewound to frame %u", l_head_frame);
+}
+
+m64p_error rewind_query(m64p_rewind* rewind)
+{
+    uint32_t depth = osal_atomic_load_acquire(&l_public_depth);
+
+    rewind->frame = osal_atomic_load_acquire(&l_public_frame);
+    rewind->depth = depth;
+    rewind->used_bytes = osal_atomic_load_acquire(&l_public_used);
+    rewind->capacity_bytes = osal_atomic_load_acquire(&l_public_capacity);
+
+    if (rewind->frames == 0)
+        return M64ERR_SUCCESS;
+
+    if (rewind->capacity_bytes == 0)
+        return M64ERR_INVALID_STATE;
+    if (rewind->frames > depth)
+        return M64ERR_INPUT_INVALID;
+
+    osal_atomic_store_release(&l_request, rewind->frames);
+
+    return M64ERR_SUCCESS;
+}
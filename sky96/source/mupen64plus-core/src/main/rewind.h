@@ -0,0 +1,52 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rewind.h                                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_REWIND_H
+#define M64P_MAIN_REWIND_H
+
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
+/* In-memory rewind history.
+ * new_frame() asks for a snapshot, which is taken at the next point where
+ * savestates can be, as an XOR delta checkpoint against the previous one
+ * (see savestates_checkpoint_save). The deltas are LZ compressed into an
+ * arena allocated once by rewind_init: when it is full, the oldest are
+ * dropped. Stepping back undoes the newest deltas then reverts the device
+ * to the state they lead to.
+ *
+ * Everything but rewind_query and rewind_pending runs on the emulation
+ * thread. */
+
+/* Allocate a history of megabytes, 0 or less disables rewind. */
+int rewind_init(int megabytes);
+void rewind_deinit(void);
+
+void rewind_frame(unsigned int frame);
+void rewind_checkpoint(void);
+
+int rewind_pending(void);
+void rewind_run_job(void);
+
+m64p_error rewind_query(m64p_rewind* rewind);
+
+#endif
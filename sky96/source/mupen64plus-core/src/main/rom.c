@@ -30,6 +30,9 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 #define M64P_CORE_PROTOTYPES 1
 #include "api/callbacks.h"
 #include "api/config.h"
@@ -72,6 +75,10 @@ static m64p_system_type rom_country_code_to_system_type(uint16_t country_code);
 
 static unsigned char rom_homebrew_savetype_to_savetype(uint8_t save_type);
 
+static void rom_setup(const md5_byte_t* digest, unsigned char imagetype);
+
+enum { ROM_LOAD_CHUNK_SIZE = 0x10000 };
+
 static const uint8_t Z64_SIGNATURE[4] = { 0x80, 0x37, 0x12, 0x40 };
 static const uint8_t V64_SIGNATURE[4] = { 0x37, 0x80, 0x40, 0x12 };
 static const uint8_t N64_SIGNATURE[4] = { 0x40, 0x12, 0x37, 0x80 };
@@ -87,63 +94,72 @@ static int is_valid_rom(const unsigned char *buffer, unsigned int size)
         return 0;
 }
 
-/* Copies the source block of memory to the destination block of memory while
- * switching the endianness of .v64 and .n64 images to the .z64 format, which
- * is native to the Nintendo 64. The data extraction routines and MD5 hashing
- * function may only act on the .z64 big-endian format.
- *
- * IN: src: The source block of memory. This must be a valid Nintendo 64 ROM
- *          image of 'len' bytes.
- *     len: The length of the source and destination, in bytes.
- * OUT: dst: The destination block of memory. This must be a valid buffer for
- *           at least 'len' bytes.
- *      imagetype: A pointer to a byte that gets updated with the value of
- *                 V64IMAGE, N64IMAGE or Z64IMAGE according to the format of
- *                 the source block. The value is undefined if 'src' does not
- *                 represent a valid Nintendo 64 ROM image.
- */
-static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char* imagetype)
+/* Same as swap_copy_rom() for any part of an image whose type is already
+ * known. dst may be src to convert in place. */
+static void swap_copy_rom_chunk(void* dst, const void* src, size_t len, unsigned char imagetype)
 {
-    if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
+    size_t i;
+
+    if (imagetype == V64IMAGE)
     {
-        size_t i;
         const uint16_t* src16 = (const uint16_t*) src;
         uint16_t* dst16 = (uint16_t*) dst;
 
-        *imagetype = V64IMAGE;
         /* .v64 images have byte-swapped half-words (16-bit). */
         for (i = 0; i < len; i += 2)
         {
             *dst16++ = m64p_swap16(*src16++);
         }
     }
-    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+    else if (imagetype == N64IMAGE)
     {
-        size_t i;
         const uint32_t* src32 = (const uint32_t*) src;
         uint32_t* dst32 = (uint32_t*) dst;
 
-        *imagetype = N64IMAGE;
         /* .n64 images have byte-swapped words (32-bit). */
         for (i = 0; i < len; i += 4)
         {
             *dst32++ = m64p_swap32(*src32++);
         }
     }
-    else {
-        *imagetype = Z64IMAGE;
+    else if (dst != src)
+    {
         memcpy(dst, src, len);
     }
 }
 
+/* Copies the source block of memory to the destination block of memory while
+ * switching the endianness of .v64 and .n64 images to the .z64 format, which
+ * is native to the Nintendo 64. The data extraction routines and MD5 hashing
+ * function may only act on the .z64 big-endian format.
+ *
+ * IN: src: The source block of memory. This must be a valid Nintendo 64 ROM
+ *          image of 'len' bytes.
+ *     len: The length of the source and destination, in bytes.
+ * OUT: dst: The destination block of memory. This must be a valid buffer for
+ *           at least 'len' bytes.
+ *      imagetype: A pointer to a byte that gets updated with the value of
+ *                 V64IMAGE, N64IMAGE or Z64IMAGE according to the format of
+ *                 the source block. The value is undefined if 'src' does not
+ *                 represent a valid Nintendo 64 ROM image.
+ */
+static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char* imagetype)
+{
+    if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
+        *imagetype = V64IMAGE;
+    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+        *imagetype = N64IMAGE;
+    else
+        *imagetype = Z64IMAGE;
+
+    swap_copy_rom_chunk(dst, src, len, *imagetype);
+}
+
 m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 {
     md5_state_t state;
     md5_byte_t digest[16];
-    romdatabase_entry* entry;
-    char buffer[256];
     unsigned char imagetype;
-    int i;
 
     /* check input requirements */
     if (romimage == NULL || !is_valid_rom(romimage, size))
@@ -165,6 +181,104 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     md5_init(&state);
     md5_append(&state, (const md5_byte_t*)((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM)), g_rom_size);
     md5_finish(&state, digest);
+
+    rom_setup(digest, imagetype);
+
+    return M64ERR_SUCCESS;
+}
+
+/* Loads the ROM image straight from the file into the cart ROM memory in
+ * ROM_LOAD_CHUNK_SIZE chunks, each one converted to .z64 order, hashed and
+ * then swapped to host word order while still in cache. This spares the
+ * front-end buffer and the whole-image passes of open_rom() and main_run(). */
+m64p_error open_rom_file(const char* filepath)
+{
+    md5_state_t state;
+    md5_byte_t digest[16];
+    unsigned char imagetype = Z64IMAGE;
+    uint8_t* rom = (uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM);
+    size_t size = 0;
+    size_t offset, len;
+    FILE* f;
+
+    if (get_file_size(filepath, &size) != file_ok)
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom_file(): couldn't get the size of '%s'", filepath);
+        return M64ERR_FILES;
+    }
+
+    if (size < 4096 || size > CART_ROM_MAX_SIZE)
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom_file(): can't use '%s' as a ROM image", filepath);
+        return M64ERR_INPUT_INVALID;
+    }
+
+    f = osal_file_open(filepath, "rb");
+    if (f == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom_file(): couldn't open '%s'", filepath);
+        return M64ERR_FILES;
+    }
+
+    /* the buffer is about to be overwritten, whatever happens next */
+    g_RomWordsLittleEndian = 0;
+    g_rom_size = 0;
+    md5_init(&state);
+
+    for (offset = 0; offset < size; offset += len)
+    {
+        len = (size - offset < ROM_LOAD_CHUNK_SIZE) ? size - offset : ROM_LOAD_CHUNK_SIZE;
+
+        if (fread(rom + offset, 1, len, f) != len)
+        {
+            DebugMessage(M64MSG_ERROR, "open_rom_file(): couldn't read %u bytes from '%s'", (unsigned int) size, filepath);
+            fclose(f);
+            return M64ERR_FILES;
+        }
+
+        if (offset == 0)
+        {
+            if (!is_valid_rom(rom, (unsigned int) size))
+            {
+                DebugMessage(M64MSG_ERROR, "open_rom_file(): not a valid ROM image");
+                fclose(f);
+                return M64ERR_INPUT_INVALID;
+            }
+
+            swap_copy_rom(rom, rom, len, &imagetype);
+            memcpy(&ROM_HEADER, rom, sizeof(m64p_rom_header));
+        }
+        else
+        {
+            swap_copy_rom_chunk(rom + offset, rom + offset, len, imagetype);
+        }
+
+        md5_append(&state, (const md5_byte_t*)(rom + offset), len);
+
+#if !defined(M64P_BIG_ENDIAN)
+        swap_buffer(rom + offset, 4, len / 4);
+#endif
+    }
+    fclose(f);
+    md5_finish(&state, digest);
+
+    g_rom_size = (int) size;
+#if !defined(M64P_BIG_ENDIAN)
+    g_RomWordsLittleEndian = 1;
+#endif
+
+    rom_setup(digest, imagetype);
+
+    return M64ERR_SUCCESS;
+}
+
+/* Fills ROM_SETTINGS and ROM_PARAMS in from ROM_HEADER and the MD5 of the image */
+static void rom_setup(const md5_byte_t* digest, unsigned char imagetype)
+{
+    romdatabase_entry* entry;
+    char buffer[256];
+    int i;
+
     for ( i = 0; i < 16; ++i )
         sprintf(buffer+i*2, "%02X", digest[i]);
     buffer[32] = '\0';
@@ -179,7 +293,7 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     trim(ROM_PARAMS.headername); /* Remove trailing whitespace from ROM name. */
 
     /* Look up this ROM in the .ini file and fill in goodname, etc */
-    if ((entry=ini_search_by_md5(digest)) != NULL ||
+    if ((entry=ini_search_by_md5((md5_byte_t*)digest)) != NULL ||
         (entry=ini_search_by_crc(tohl(ROM_HEADER.CRC1),tohl(ROM_HEADER.CRC2))) != NULL)
     {
         strncpy(ROM_SETTINGS.goodname, entry->goodname, 255);
@@ -245,8 +359,6 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     DebugMessage(M64MSG_INFO, "Country: %s", buffer);
     DebugMessage(M64MSG_VERBOSE, "PC = %" PRIX32, tohl(ROM_HEADER.PC));
     DebugMessage(M64MSG_VERBOSE, "Save type: %d", ROM_SETTINGS.savetype);
-
-    return M64ERR_SUCCESS;
 }
 
 m64p_error close_rom(void)
@@ -443,18 +555,31 @@ static unsigned char rom_homebrew_savetype_to_savetype(uint8_t save_type)
     return m64p_save_type;
 }
 
-static size_t romdatabase_resolve_round(void)
+static romdatabase_entry* romdatabase_ini_search_by_md5(romdatabase_ini* ini, const md5_byte_t* md5)
+{
+    romdatabase_search* search = ini->md5_lists[md5[0]];
+
+    while (search != NULL && memcmp(search->entry.md5, md5, 16) != 0)
+        search = search->next_md5;
+
+    if(search==NULL)
+        return NULL;
+
+    return &(search->entry);
+}
+
+static size_t romdatabase_resolve_round(romdatabase_ini* ini)
 {
     romdatabase_search *entry;
     romdatabase_entry *ref;
     size_t skipped = 0;
 
     /* Resolve RefMD5 references */
-    for (entry = g_romdatabase.list; entry; entry = entry->next_entry) {
+    for (entry = ini->list; entry; entry = entry->next_entry) {
         if (!entry->entry.refmd5)
             continue;
 
-        ref = ini_search_by_md5(entry->entry.refmd5);
+        ref = romdatabase_ini_search_by_md5(ini, entry->entry.refmd5);
         if (!ref) {
             DebugMessage(M64MSG_WARNING, "ROM Database: Error solving RefMD5s");
             continue;
@@ -560,13 +685,13 @@ static size_t romdatabase_resolve_round(void)
     return skipped;
 }
 
-static void romdatabase_resolve(void)
+static void romdatabase_resolve(romdatabase_ini* ini)
 {
     size_t last_skipped = (size_t)~0ULL;
     size_t skipped;
 
     do {
-        skipped = romdatabase_resolve_round();
+        skipped = romdatabase_resolve_round(ini);
         if (skipped == last_skipped) {
             DebugMessage(M64MSG_ERROR, "Unable to resolve rom database entries (loop)");
             break;
@@ -578,7 +703,9 @@ static void romdatabase_resolve(void)
 /********************************************************************************************/
 /* INI Rom database functions */
 
-void romdatabase_open(void)
+/* Parses the ini into a list of entries indexed by MD5 and CRC, the way
+ * RefMD5 resolution needs them. Returns 0 if the file can't be opened. */
+static int romdatabase_parse_ini(const char* pathname, romdatabase_ini* ini)
 {
     FILE *fPtr;
     char buffer[256];
@@ -587,28 +714,18 @@ void romdatabase_open(void)
 
     int counter, value, lineno;
     unsigned char index;
-    const char *pathname = ConfigGetSharedDataFilepath("mupen64plus.ini");
 
-    if(g_romdatabase.have_database)
-        return;
-
-    /* Open romdatabase. */
-    if (pathname == NULL || (fPtr = osal_file_open(pathname, "rb")) == NULL)
-    {
-        DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
-        return;
-    }
-
-    g_romdatabase.have_database = 1;
+    if ((fPtr = osal_file_open(pathname, "rb")) == NULL)
+        return 0;
 
     /* Clear premade indices. */
-    for(counter = 0; counter < 255; ++counter)
-        g_romdatabase.crc_lists[counter] = NULL;
-    for(counter = 0; counter < 255; ++counter)
-        g_romdatabase.md5_lists[counter] = NULL;
-    g_romdatabase.list = NULL;
+    for(counter = 0; counter < 256; ++counter)
+        ini->crc_lists[counter] = NULL;
+    for(counter = 0; counter < 256; ++counter)
+        ini->md5_lists[counter] = NULL;
+    ini->list = NULL;
 
-    next_search = &g_romdatabase.list;
+    next_search = &ini->list;
 
     /* Parse ROM database file */
     for (lineno = 1; fgets(buffer, 255, fPtr) != NULL; lineno++)
@@ -656,8 +773,8 @@ void romdatabase_open(void)
             search->next_crc = NULL;
             /* Index MD5s by first 8 bits. */
             index = search->entry.md5[0];
-            search->next_md5 = g_romdatabase.md5_lists[index];
-            g_romdatabase.md5_lists[index] = search;
+            search->next_md5 = ini->md5_lists[index];
+            ini->md5_lists[index] = search;
 
             break;
         }
@@ -682,8 +799,8 @@ void romdatabase_open(void)
                 {
                     /* Index CRCs by first 8 bits. */
                     index = search->entry.crc1 >> 24;
-                    search->next_crc = g_romdatabase.crc_lists[index];
-                    g_romdatabase.crc_lists[index] = search;
+                    search->next_crc = ini->crc_lists[index];
+                    ini->crc_lists[index] = search;
                     search->entry.set_flags |= ROMDATABASE_ENTRY_CRC;
                 }
                 else
@@ -866,72 +983,498 @@ void romdatabase_open(void)
     }
 
     fclose(fPtr);
-    romdatabase_resolve();
+    return 1;
 }
 
-void romdatabase_close(void)
+static void romdatabase_free_ini(romdatabase_ini* ini)
 {
-    if (!g_romdatabase.have_database)
-        return;
+    while (ini->list != NULL)
+    {
+        romdatabase_search* search = ini->list->next_entry;
+        free(ini->list->entry.goodname);
+        free(ini->list->entry.refmd5);
+        free(ini->list->entry.cheats);
+        free(ini->list);
+        ini->list = search;
+    }
+}
 
-    while (g_romdatabase.list != NULL)
+/* The parsed database is kept as a binary cache in the user cache directory,
+ * so later launches skip the ini parsing and RefMD5 resolution. The cache is
+ * trusted while the ini size and modification time match its stamp, and
+ * rebuilt once the ini contents hash differs; bump the version whenever the
+ * parsing or the entry defaults above change.
+ *
+ * Layout, in host byte order: header, entries, MD5 slots, CRC slots, strings.
+ * Slots hold an entry index plus one, zero for an empty slot. The header
+ * checksum covers everything after the header. */
+#define ROMDATABASE_CACHE_NAME "mupen64plus.ini.cache"
+#define ROMDATABASE_CACHE_MAGIC "M64+RDBC"
+enum { ROMDATABASE_CACHE_VERSION = 1 };
+
+struct romdatabase_cache_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    int64_t ini_size;
+    int64_t ini_mtime;
+    uint64_t ini_hash;
+    uint64_t checksum;
+    uint32_t count;
+    uint32_t md5_slots;
+    uint32_t crc_slots;
+    uint32_t strings_size;
+};
+
+struct romdatabase_cache_entry
+{
+    md5_byte_t md5[16];
+    uint32_t crc1;
+    uint32_t crc2;
+    uint32_t goodname; /* string offset plus one, zero for none */
+    uint32_t cheats;
+    uint32_t sidmaduration;
+    uint32_t aidmamodifier;
+    uint32_t set_flags;
+    uint8_t status;
+    uint8_t savetype;
+    uint8_t players;
+    uint8_t rumble;
+    uint8_t countperop;
+    uint8_t disableextramem;
+    uint8_t transferpak;
+    uint8_t mempak;
+    uint8_t biopak;
+    uint8_t padding[3];
+};
+
+static uint32_t romdatabase_md5_hash(const md5_byte_t* md5)
+{
+    /* MD5s are already well distributed. */
+    return (uint32_t)md5[0] | ((uint32_t)md5[1] << 8) | ((uint32_t)md5[2] << 16) | ((uint32_t)md5[3] << 24);
+}
+
+static uint32_t romdatabase_crc_hash(uint32_t crc1, uint32_t crc2)
+{
+    uint32_t h = crc1 ^ (crc2 * 0x9e3779b1u);
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+}
+
+static uint32_t romdatabase_slot_count(uint32_t count)
+{
+    uint32_t slots = 16;
+
+    /* Keep the tables at most half full. */
+    while (slots < 2 * count)
+        slots <<= 1;
+    return slots;
+}
+
+/* Hashes the whole file. Returns 0 if the file can't be read. */
+static int romdatabase_hash_file(const char* pathname, uint64_t* hash)
+{
+    unsigned char buffer[16384];
+    XXH3_state_t state;
+    size_t len;
+    FILE* f;
+
+    if ((f = osal_file_open(pathname, "rb")) == NULL)
+        return 0;
+
+    XXH3_64bits_reset(&state);
+    while ((len = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        XXH3_64bits_update(&state, buffer, len);
+
+    fclose(f);
+    *hash = XXH3_64bits_digest(&state);
+    return 1;
+}
+
+static uint32_t romdatabase_add_string(unsigned char* strings, uint32_t* size, const char* str)
+{
+    uint32_t offset = *size;
+
+    if (str == NULL)
+        return 0;
+
+    if (strings != NULL)
+        strcpy((char*)strings + offset, str);
+    *size += (uint32_t)strlen(str) + 1;
+    return offset + 1;
+}
+
+/* Packs the resolved entries into a cache image. Returns NULL on failure. */
+static unsigned char* romdatabase_pack(romdatabase_ini* ini, size_t* size)
+{
+    struct romdatabase_cache_header* header;
+    struct romdatabase_cache_entry* entries;
+    uint32_t *md5_slots, *crc_slots;
+    unsigned char *cache, *strings;
+    romdatabase_search* search;
+    uint32_t count = 0, strings_size = 0, md5_slot_count, crc_slot_count, i;
+
+    for (search = ini->list; search != NULL; search = search->next_entry)
+    {
+        search->index = count++;
+        romdatabase_add_string(NULL, &strings_size, search->entry.goodname);
+        romdatabase_add_string(NULL, &strings_size, search->entry.cheats);
+    }
+
+    md5_slot_count = romdatabase_slot_count(count);
+    crc_slot_count = romdatabase_slot_count(count);
+    *size = sizeof(*header) + count * sizeof(*entries)
+          + (md5_slot_count + crc_slot_count) * sizeof(uint32_t) + strings_size;
+
+    cache = calloc(1, *size);
+    if (cache == NULL)
+        return NULL;
+
+    header = (struct romdatabase_cache_header*)cache;
+    entries = (struct romdatabase_cache_entry*)(header + 1);
+    md5_slots = (uint32_t*)(entries + count);
+    crc_slots = md5_slots + md5_slot_count;
+    strings = (unsigned char*)(crc_slots + crc_slot_count);
+
+    memcpy(header->magic, ROMDATABASE_CACHE_MAGIC, 8);
+    header->version = ROMDATABASE_CACHE_VERSION;
+    header->entry_size = sizeof(*entries);
+    header->count = count;
+    header->md5_slots = md5_slot_count;
+    header->crc_slots = crc_slot_count;
+    header->strings_size = strings_size;
+
+    strings_size = 0;
+    for (search = ini->list; search != NULL; search = search->next_entry)
+    {
+        const romdatabase_entry* e = &search->entry;
+        struct romdatabase_cache_entry* c = &entries[search->index];
+
+        memcpy(c->md5, e->md5, 16);
+        c->crc1 = e->crc1;
+        c->crc2 = e->crc2;
+        c->goodname = romdatabase_add_string(strings, &strings_size, e->goodname);
+        c->cheats = romdatabase_add_string(strings, &strings_size, e->cheats);
+        c->sidmaduration = e->sidmaduration;
+        c->aidmamodifier = e->aidmamodifier;
+        c->set_flags = e->set_flags;
+        c->status = e->status;
+        c->savetype = e->savetype;
+        c->players = e->players;
+        c->rumble = e->rumble;
+        c->countperop = e->countperop;
+        c->disableextramem = e->disableextramem;
+        c->transferpak = e->transferpak;
+        c->mempak = e->mempak;
+        c->biopak = e->biopak;
+
+        /* A later section with the same MD5 overrides an earlier one. */
+        i = romdatabase_md5_hash(e->md5) & (md5_slot_count - 1);
+        while (md5_slots[i] != 0 && memcmp(entries[md5_slots[i] - 1].md5, e->md5, 16) != 0)
+            i = (i + 1) & (md5_slot_count - 1);
+        md5_slots[i] = search->index + 1;
+    }
+
+    /* Only entries with their own CRC line are looked up by CRC. */
+    for (i = 0; i < 256; ++i)
+    {
+        for (search = ini->crc_lists[i]; search != NULL; search = search->next_crc)
         {
-        romdatabase_search* search = g_romdatabase.list->next_entry;
-        if(g_romdatabase.list->entry.goodname)
-            free(g_romdatabase.list->entry.goodname);
-        if(g_romdatabase.list->entry.refmd5)
-            free(g_romdatabase.list->entry.refmd5);
-        free(g_romdatabase.list->entry.cheats);
-        free(g_romdatabase.list);
-        g_romdatabase.list = search;
+            uint32_t slot = romdatabase_crc_hash(search->entry.crc1, search->entry.crc2) & (crc_slot_count - 1);
+            while (crc_slots[slot] != 0)
+                slot = (slot + 1) & (crc_slot_count - 1);
+            crc_slots[slot] = search->index + 1;
         }
+    }
 
-    g_romdatabase.have_database = 0;
+    header->checksum = XXH3_64bits(header + 1, *size - sizeof(*header));
+    return cache;
 }
 
-static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5)
+/* Checks a cache image and makes it the loaded database, which then owns it.
+ * Returns 0 if the image is malformed. */
+static int romdatabase_attach(unsigned char* cache, size_t size)
 {
-    romdatabase_search* search;
+    const struct romdatabase_cache_header* header = (const struct romdatabase_cache_header*)cache;
+    const struct romdatabase_cache_entry* entries;
+    const uint32_t *md5_slots, *crc_slots;
+    const char* strings;
+    romdatabase_entry* unpacked;
+    uint64_t expected;
+    uint32_t i;
+
+    if (size < sizeof(*header)
+     || memcmp(header->magic, ROMDATABASE_CACHE_MAGIC, 8) != 0
+     || header->version != ROMDATABASE_CACHE_VERSION
+     || header->entry_size != sizeof(*entries)
+     || header->md5_slots < 16 || (header->md5_slots & (header->md5_slots - 1)) != 0
+     || header->crc_slots < 16 || (header->crc_slots & (header->crc_slots - 1)) != 0
+     || header->md5_slots < 2 * (uint64_t)header->count
+     || header->crc_slots < 2 * (uint64_t)header->count)
+        return 0;
 
-    if(!g_romdatabase.have_database)
+    expected = sizeof(*header) + (uint64_t)header->count * sizeof(*entries)
+             + ((uint64_t)header->md5_slots + header->crc_slots) * sizeof(uint32_t) + header->strings_size;
+    if (expected != size || XXH3_64bits(header + 1, size - sizeof(*header)) != header->checksum)
+        return 0;
+
+    entries = (const struct romdatabase_cache_entry*)(header + 1);
+    md5_slots = (const uint32_t*)(entries + header->count);
+    crc_slots = md5_slots + header->md5_slots;
+    strings = (const char*)(crc_slots + header->crc_slots);
+
+    if (header->strings_size > 0 && strings[header->strings_size - 1] != '\0')
+        return 0;
+    for (i = 0; i < header->md5_slots; ++i)
+        if (md5_slots[i] > header->count)
+            return 0;
+    for (i = 0; i < header->crc_slots; ++i)
+        if (crc_slots[i] > header->count)
+            return 0;
+
+    unpacked = malloc((header->count > 0 ? header->count : 1) * sizeof(*unpacked));
+    if (unpacked == NULL)
+        return 0;
+
+    for (i = 0; i < header->count; ++i)
+    {
+        const struct romdatabase_cache_entry* c = &entries[i];
+        romdatabase_entry* e = &unpacked[i];
+
+        if (c->goodname > header->strings_size || c->cheats > header->strings_size)
+        {
+            free(unpacked);
+            return 0;
+        }
+
+        e->goodname = c->goodname ? (char*)strings + c->goodname - 1 : NULL;
+        memcpy(e->md5, c->md5, 16);
+        e->refmd5 = NULL;
+        e->cheats = c->cheats ? (char*)strings + c->cheats - 1 : NULL;
+        e->crc1 = c->crc1;
+        e->crc2 = c->crc2;
+        e->status = c->status;
+        e->savetype = c->savetype;
+        e->players = c->players;
+        e->rumble = c->rumble;
+        e->countperop = c->countperop;
+        e->disableextramem = c->disableextramem;
+        e->transferpak = c->transferpak;
+        e->mempak = c->mempak;
+        e->biopak = c->biopak;
+        e->sidmaduration = c->sidmaduration;
+        e->aidmamodifier = c->aidmamodifier;
+        e->set_flags = c->set_flags;
+    }
+
+    g_romdatabase.cache = cache;
+    g_romdatabase.entries = unpacked;
+    g_romdatabase.count = header->count;
+    g_romdatabase.md5_slots = md5_slots;
+    g_romdatabase.crc_slots = crc_slots;
+    g_romdatabase.md5_mask = header->md5_slots - 1;
+    g_romdatabase.crc_mask = header->crc_slots - 1;
+    g_romdatabase.have_database = 1;
+    return 1;
+}
+
+static unsigned char* romdatabase_read_cache(const char* cachepath, size_t* size)
+{
+    unsigned char* cache;
+    long len;
+    FILE* f;
+
+    if ((f = osal_file_open(cachepath, "rb")) == NULL)
         return NULL;
 
-    search = g_romdatabase.md5_lists[md5[0]];
+    if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < (long)sizeof(struct romdatabase_cache_header)
+     || fseek(f, 0, SEEK_SET) != 0 || (cache = malloc(len)) == NULL)
+    {
+        fclose(f);
+        return NULL;
+    }
 
-    while (search != NULL && memcmp(search->entry.md5, md5, 16) != 0)
-        search = search->next_md5;
+    if (fread(cache, 1, len, f) != (size_t)len)
+    {
+        free(cache);
+        fclose(f);
+        return NULL;
+    }
 
-    if(search==NULL)
+    fclose(f);
+    *size = (size_t)len;
+    return cache;
+}
+
+static void romdatabase_write_cache(const char* cachepath, const unsigned char* cache, size_t size)
+{
+    FILE* f;
+    int ok;
+
+    if ((f = osal_file_open(cachepath, "wb")) == NULL)
+    {
+        DebugMessage(M64MSG_VERBOSE, "ROM Database: Unable to write cache '%s'", cachepath);
+        return;
+    }
+
+    ok = (fwrite(cache, 1, size, f) == size);
+    if (fclose(f) != 0 || !ok)
+    {
+        DebugMessage(M64MSG_VERBOSE, "ROM Database: Unable to write cache '%s'", cachepath);
+        remove(cachepath);
+    }
+}
+
+void romdatabase_open(void)
+{
+    romdatabase_ini ini;
+    struct romdatabase_cache_header* header;
+    unsigned char* cache;
+    char* cachepath = NULL;
+    const char* cachedir;
+    int64_t ini_size, ini_mtime;
+    uint64_t ini_hash;
+    size_t size;
+    const char *pathname = ConfigGetSharedDataFilepath("mupen64plus.ini");
+
+    if(g_romdatabase.have_database)
+        return;
+
+    if (pathname == NULL || osal_file_info(pathname, &ini_size, &ini_mtime) != 0)
+    {
+        DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
+        return;
+    }
+
+    cachedir = ConfigGetUserCachePath();
+    if (cachedir != NULL)
+        cachepath = combinepath(cachedir, ROMDATABASE_CACHE_NAME);
+
+    /* Use the cache if it was built from this ini. An ini that was only
+     * touched is recognized by its hash and refreshes the cache stamp. */
+    if (cachepath != NULL && (cache = romdatabase_read_cache(cachepath, &size)) != NULL)
+    {
+        int current;
+
+        header = (struct romdatabase_cache_header*)cache;
+        current = (header->ini_size == ini_size && header->ini_mtime == ini_mtime);
+        if (!current && header->ini_size == ini_size
+         && romdatabase_hash_file(pathname, &ini_hash) && header->ini_hash == ini_hash)
+        {
+            header->ini_mtime = ini_mtime;
+            current = romdatabase_attach(cache, size);
+            if (current)
+                romdatabase_write_cache(cachepath, cache, size);
+        }
+        else if (current)
+            current = romdatabase_attach(cache, size);
+
+        if (current)
+        {
+            DebugMessage(M64MSG_VERBOSE, "ROM Database: Loaded %u entries from cache '%s'", g_romdatabase.count, cachepath);
+            free(cachepath);
+            return;
+        }
+        free(cache);
+    }
+
+    /* Parse romdatabase. */
+    if (!romdatabase_parse_ini(pathname, &ini))
+    {
+        DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
+        free(cachepath);
+        return;
+    }
+
+    romdatabase_resolve(&ini);
+    cache = romdatabase_pack(&ini, &size);
+    romdatabase_free_ini(&ini);
+
+    if (cache == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "ROM Database: Insufficient memory to load '%s'.", pathname);
+        free(cachepath);
+        return;
+    }
+
+    header = (struct romdatabase_cache_header*)cache;
+    header->ini_size = ini_size;
+    header->ini_mtime = ini_mtime;
+    if (!romdatabase_hash_file(pathname, &header->ini_hash))
+    {
+        /* Leave the cache unwritten rather than stamp it with a bad hash. */
+        free(cachepath);
+        cachepath = NULL;
+    }
+
+    if (!romdatabase_attach(cache, size))
+    {
+        free(cache);
+        free(cachepath);
+        return;
+    }
+
+    if (cachepath != NULL)
+        romdatabase_write_cache(cachepath, cache, size);
+    free(cachepath);
+}
+
+void romdatabase_close(void)
+{
+    if (!g_romdatabase.have_database)
+        return;
+
+    free(g_romdatabase.entries);
+    free(g_romdatabase.cache);
+    memset(&g_romdatabase, 0, sizeof(g_romdatabase));
+}
+
+static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5)
+{
+    uint32_t slot, index;
+
+    if(!g_romdatabase.have_database)
         return NULL;
 
-    return &(search->entry);
+    slot = romdatabase_md5_hash(md5) & g_romdatabase.md5_mask;
+    while ((index = g_romdatabase.md5_slots[slot]) != 0)
+    {
+        if (memcmp(g_romdatabase.entries[index - 1].md5, md5, 16) == 0)
+            return &g_romdatabase.entries[index - 1];
+        slot = (slot + 1) & g_romdatabase.md5_mask;
+    }
+
+    return NULL;
 }
 
 romdatabase_entry* ini_search_by_crc(unsigned int crc1, unsigned int crc2)
 {
-    romdatabase_search* search;
     romdatabase_entry* found_entry = NULL;
+    uint32_t slot, index;
 
     if(!g_romdatabase.have_database) 
         return NULL;
 
-    search = g_romdatabase.crc_lists[((crc1 >> 24) & 0xff)];
+    slot = romdatabase_crc_hash(crc1, crc2) & g_romdatabase.crc_mask;
 
     // because CRCs can be ambiguous (there can be multiple database entries with the same CRC),
     // we will prefer MD5 hashes instead. If the given CRC matches more than one entry in the
     // database, we will return no match.
-    while (search != NULL)
+    while ((index = g_romdatabase.crc_slots[slot]) != 0)
     {
-        if (search->entry.crc1 == crc1 && search->entry.crc2 == crc2)
+        romdatabase_entry* entry = &g_romdatabase.entries[index - 1];
+        if (entry->crc1 == crc1 && entry->crc2 == crc2)
         {
             if (found_entry != NULL)
                 return NULL;
-            found_entry = &search->entry;
+            found_entry = entry;
         }
-        search = search->next_crc;
+        slot = (slot + 1) & g_romdatabase.crc_mask;
     }
 
     return found_entry;
 }
-
-
@@ -39,6 +39,7 @@
 /* ROM Loading and Saving functions */
 
 m64p_error open_rom(const unsigned char* romimage, unsigned int size);
+m64p_error open_rom_file(const char* filepath);
 m64p_error close_rom(void);
 
 m64p_error open_disk(void);
@@ -136,9 +137,11 @@ typedef struct
 #define ROMDATABASE_ENTRY_SIDMADURATION BIT(12)
 #define ROMDATABASE_ENTRY_AIDMAMODIFIER BIT(13)
 
+/* Entries as parsed from the ini, before they are packed into the cache. */
 typedef struct _romdatabase_search
 {
     romdatabase_entry entry;
+    unsigned int index;
     struct _romdatabase_search* next_entry;
     struct _romdatabase_search* next_crc;
     struct _romdatabase_search* next_md5;
@@ -146,10 +149,24 @@ typedef struct _romdatabase_search
 
 typedef struct
 {
-    int have_database;
     romdatabase_search* crc_lists[256];
     romdatabase_search* md5_lists[256];
     romdatabase_search* list;
+} romdatabase_ini;
+
+/* The loaded database: a binary cache image holding the packed entries, the
+ * MD5 and CRC open-addressing tables and the strings, plus the entries
+ * unpacked for lookups. */
+typedef struct
+{
+    int have_database;
+    unsigned char* cache;
+    romdatabase_entry* entries;
+    uint32_t count;
+    const uint32_t* md5_slots;
+    const uint32_t* crc_slots;
+    uint32_t md5_mask;
+    uint32_t crc_mask;
 } _romdatabase;
 
 void romdatabase_open(void);
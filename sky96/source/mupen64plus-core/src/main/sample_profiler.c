@@ -0,0 +1,331 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - sample_profiler.c                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "sample_profiler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/m64p_types.h"
+#include "device/memory/memory.h"
+#include "device/r4300/idec.h"
+#include "device/r4300/interrupt.h"
+#include "device/r4300/r4300_core.h"
+#include "device/rdram/rdram.h"
+#include "osal/atomics.h"
+#include "osal/preproc.h"
+
+/* must be a power of two */
+#define SAMPLE_RING_SIZE 4096
+#define SAMPLE_RING_MASK (SAMPLE_RING_SIZE - 1)
+
+/* must be a power of two, kept at most 3/4 full */
+#define FUNCTION_TABLE_SIZE 4096
+#define FUNCTION_TABLE_MAX_FILL (FUNCTION_TABLE_SIZE / 4 * 3)
+
+/* how far back from a sampled PC to look for the start of its function */
+#define FUNCTION_SCAN_WORDS 1024
+
+#define SAMPLE_PROFILER_MIN_PERIOD 100
+
+#define CACHE_LINE_SIZE 64
+
+/* recognized function boundaries */
+#define IW_ADDIU_SP_SP_NEG_MASK UINT32_C(0xffff8000)
+#define IW_ADDIU_SP_SP_NEG      UINT32_C(0x27bd8000)   /* addiu $sp, $sp, -imm */
+#define IW_JR_RA                UINT32_C(0x03e00008)   /* jr $ra */
+
+struct profile_sample
+{
+    uint32_t pc;
+    uint32_t opcode;    /* enum r4300_opcode, R4300_OPCODES_COUNT if the PC couldn't be read */
+};
+
+struct sample_ring
+{
+    /* written by producer only */
+    ALIGN(CACHE_LINE_SIZE, uint32_t head);
+    uint32_t tail_cache;    /* producer's last observed value of tail */
+    uint32_t dropped;
+
+    /* written by consumer only */
+    ALIGN(CACHE_LINE_SIZE, uint32_t tail);
+    uint32_t period;        /* sampling period in count cycles, 0 when stopped */
+
+    ALIGN(CACHE_LINE_SIZE, struct profile_sample samples[SAMPLE_RING_SIZE]);
+};
+
+struct profile_function
+{
+    uint32_t address;
+    uint32_t samples;       /* 0 for an empty slot */
+};
+
+static struct sample_ring l_ring;
+
+/* aggregated samples, consumer only */
+static struct profile_function l_functions[FUNCTION_TABLE_SIZE];
+static struct profile_function l_sorted[FUNCTION_TABLE_SIZE];
+static unsigned int l_function_count;
+static uint32_t l_opcode_samples[R4300_OPCODES_COUNT];
+static uint32_t l_samples;
+static uint32_t l_dropped_base;
+
+
+/* Emulation thread */
+
+static uint32_t sample_opcode(struct r4300_core* r4300, uint32_t pc)
+{
+    const uint32_t* iw;
+
+    /* never raise a TLB exception on behalf of the profiler */
+    if ((pc & UINT32_C(0xc0000000)) != UINT32_C(0x80000000))
+    {
+        uint32_t lut = r4300->cp0.tlb.LUT_r[pc >> 12];
+        if (lut == 0)
+            return R4300_OPCODES_COUNT;
+        pc = (lut & UINT32_C(0xfffff000)) | (pc & UINT32_C(0xfff));
+    }
+
+    iw = mem_base_u32(r4300->mem->base, pc & UINT32_C(0x1ffffffc));
+
+    return (iw == NULL)
+        ? R4300_OPCODES_COUNT
+        : (uint32_t)r4300_get_idec(*iw)->opcode;
+}
+
+void sample_profiler_vi(struct r4300_core* r4300)
+{
+    uint32_t period = osal_atomic_load_acquire(&l_ring.period);
+
+    /* the event reschedules itself, only (re)start it when it isn't pending,
+     * eg. after the profiler was started or a savestate was loaded */
+    if (period != 0 && get_event(&r4300->cp0.q, PROFILE_EVT) == NULL)
+        add_interrupt_event(&r4300->cp0, PROFILE_EVT, period);
+}
+
+void sample_profiler_event(struct r4300_core* r4300)
+{
+    struct profile_sample* s;
+    uint32_t period = osal_atomic_load_acquire(&l_ring.period);
+    uint32_t head;
+
+    if (period == 0)
+        return;
+
+    add_interrupt_event(&r4300->cp0, PROFILE_EVT, period);
+
+    head = l_ring.head;
+
+    if (head - l_ring.tail_cache >= SAMPLE_RING_SIZE)
+    {
+        /* only reload the consumer index when our cached copy says we are full */
+        l_ring.tail_cache = osal_atomic_load_acquire(&l_ring.tail);
+
+        if (head - l_ring.tail_cache >= SAMPLE_RING_SIZE)
+        {
+            osal_atomic_store_release(&l_ring.dropped, l_ring.dropped + 1);
+            return;
+        }
+    }
+
+    s = &l_ring.samples[head & SAMPLE_RING_MASK];
+    s->pc = *r4300_pc(r4300);
+    s->opcode = sample_opcode(r4300, s->pc);
+
+    osal_atomic_store_release(&l_ring.head, head + 1);
+}
+
+
+/* Consumer */
+
+/* Guess the entry point of the function containing pc by scanning back for
+ * its stack frame allocation, or for the return of the function laid out
+ * before it. Only RDRAM is scanned; guest code may be changed meanwhile by
+ * the emulation thread, which at worst misattributes a sample. */
+static uint32_t function_entry(const struct r4300_core* r4300, uint32_t pc)
+{
+    const uint32_t* dram = r4300->rdram->dram;
+    uint32_t addr = pc;
+    uint32_t i, n;
+
+    if ((addr & UINT32_C(0xc0000000)) != UINT32_C(0x80000000))
+    {
+        uint32_t lut = r4300->cp0.tlb.LUT_r[addr >> 12];
+        if (lut == 0)
+            return pc;
+        addr = (lut & UINT32_C(0xfffff000)) | (addr & UINT32_C(0xfff));
+    }
+
+    addr = (addr & UINT32_C(0x1ffffffc)) >> 2;
+    if (addr >= r4300->rdram->dram_size / 4)
+        return pc;
+
+    n = (addr < FUNCTION_SCAN_WORDS) ? addr : FUNCTION_SCAN_WORDS;
+    for (i = 0; i <= n; ++i)
+    {
+        uint32_t iw = dram[addr - i];
+
+        if ((iw & IW_ADDIU_SP_SP_NEG_MASK) == IW_ADDIU_SP_SP_NEG)
+            return pc - 4 * i;
+
+        /* a return and its delay slot right before pc still belong to pc's function */
+        if (iw == IW_JR_RA && i >= 2)
+            return pc - 4 * i + 8;
+    }
+
+    return pc;
+}
+
+static void account_function(uint32_t address)
+{
+    uint32_t slot = (address >> 2) * UINT32_C(2654435761) & (FUNCTION_TABLE_SIZE - 1);
+
+    while (l_functions[slot].samples != 0 && l_functions[slot].address != address)
+        slot = (slot + 1) & (FUNCTION_TABLE_SIZE - 1);
+
+    if (l_functions[slot].samples == 0)
+    {
+        /* table is full, the sample only shows up in the total */
+        if (l_function_count >= FUNCTION_TABLE_MAX_FILL)
+            return;
+
+        l_functions[slot].address = address;
+        ++l_function_count;
+    }
+
+    ++l_functions[slot].samples;
+}
+
+static void drain_samples(const struct r4300_core* r4300)
+{
+    uint32_t tail = l_ring.tail;
+    uint32_t head = osal_atomic_load_acquire(&l_ring.head);
+
+    for (; tail != head; ++tail)
+    {
+        const struct profile_sample* s = &l_ring.samples[tail & SAMPLE_RING_MASK];
+
+        if (s->opcode < R4300_OPCODES_COUNT)
+            ++l_opcode_samples[s->opcode];
+
+        account_function(function_entry(r4300, s->pc));
+        ++l_samples;
+    }
+
+    osal_atomic_store_release(&l_ring.tail, tail);
+}
+
+static int compare_functions(const void* a, const void* b)
+{
+    const struct profile_function* fa = (const struct profile_function*)a;
+    const struct profile_function* fb = (const struct profile_function*)b;
+
+    if (fa->samples != fb->samples)
+        return (fa->samples > fb->samples) ? -1 : 1;
+
+    return (fa->address < fb->address) ? -1 : (fa->address > fb->address);
+}
+
+m64p_error sample_profiler_start(unsigned int period)
+{
+    if (period == 0)
+        period = SAMPLE_PROFILER_DEFAULT_PERIOD;
+    else if (period < SAMPLE_PROFILER_MIN_PERIOD)
+        return M64ERR_INPUT_INVALID;
+
+    osal_atomic_store_release(&l_ring.period, period);
+    return M64ERR_SUCCESS;
+}
+
+m64p_error sample_profiler_stop(void)
+{
+    osal_atomic_store_release(&l_ring.period, 0);
+    return M64ERR_SUCCESS;
+}
+
+m64p_error sample_profiler_reset(void)
+{
+    /* discard the samples still in the ring */
+    osal_atomic_store_release(&l_ring.tail, osal_atomic_load_acquire(&l_ring.head));
+    l_dropped_base = osal_atomic_load_acquire(&l_ring.dropped);
+
+    memset(l_functions, 0, sizeof(l_functions));
+    memset(l_opcode_samples, 0, sizeof(l_opcode_samples));
+    l_function_count = 0;
+    l_samples = 0;
+
+    return M64ERR_SUCCESS;
+}
+
+m64p_error sample_profiler_query(const struct r4300_core* r4300, m64p_profile_query* query)
+{
+    unsigned int i, n;
+
+    if (query->functions == NULL && query->capacity != 0)
+        return M64ERR_INPUT_ASSERT;
+
+    drain_samples(r4300);
+
+    n = 0;
+    for (i = 0; i < FUNCTION_TABLE_SIZE; ++i)
+    {
+        if (l_functions[i].samples != 0)
+            l_sorted[n++] = l_functions[i];
+    }
+    qsort(l_sorted, n, sizeof(l_sorted[0]), compare_functions);
+
+    if (n > query->capacity)
+        n = query->capacity;
+
+    for (i = 0; i < n; ++i)
+    {
+        query->functions[i].address = l_sorted[i].address;
+        query->functions[i].samples = l_sorted[i].samples;
+    }
+
+    query->count = n;
+    query->samples = l_samples;
+    query->dropped = osal_atomic_load_acquire(&l_ring.dropped) - l_dropped_base;
+
+    return M64ERR_SUCCESS;
+}
+
+int sample_profiler_opcode_counts(const struct r4300_core* r4300, unsigned int* counts, int size)
+{
+    int i;
+
+    drain_samples(r4300);
+
+    for (i = 0; i < size && i < R4300_OPCODES_COUNT; ++i)
+        counts[i] = l_opcode_samples[i];
+
+    return R4300_OPCODES_COUNT;
+}
+
+const char* sample_profiler_opcode_name(int opcode)
+{
+    return (opcode >= 0 && opcode < R4300_OPCODES_COUNT)
+        ? g_r4300_opcodes[opcode]
+        : NULL;
+}
@@ -0,0 +1,55 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - sample_profiler.h                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_SAMPLE_PROFILER_H
+#define M64P_MAIN_SAMPLE_PROFILER_H
+
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
+struct r4300_core;
+
+/* Statistical profiler of the emulated R4300.
+ * While running, a PROFILE_EVT interrupt event fires every period count
+ * cycles and records the guest PC with the opcode found there. Events are
+ * only checked on block exits by the cached interpreter and the recompilers,
+ * so that is where samples land in those modes.
+ * Samples go through a single-producer / single-consumer ring: the emulation
+ * thread only stores them, the thread calling the DebugProfile* functions
+ * (the only consumer) drains and aggregates them into per-function counts. */
+
+enum { SAMPLE_PROFILER_DEFAULT_PERIOD = 5000 };
+
+/* Emulation thread: arm the sampling event if needed, called once per VI. */
+void sample_profiler_vi(struct r4300_core* r4300);
+/* Emulation thread: PROFILE_EVT handler, the event has already been removed. */
+void sample_profiler_event(struct r4300_core* r4300);
+
+m64p_error sample_profiler_start(unsigned int period);
+m64p_error sample_profiler_stop(void);
+m64p_error sample_profiler_reset(void);
+
+m64p_error sample_profiler_query(const struct r4300_core* r4300, m64p_profile_query* query);
+int sample_profiler_opcode_counts(const struct r4300_core* r4300, unsigned int* counts, int size);
+const char* sample_profiler_opcode_name(int opcode);
+
+#endif
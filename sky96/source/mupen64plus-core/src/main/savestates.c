@@ -43,12 +43,15 @@
 #include "device/device.h"
 #include "main/list.h"
 #include "main/main.h"
+#include "main/rdram_checkpoint.h"
+#include "main/rdram_dirty.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "plugin/plugin.h"
 #include "rom.h"
 #include "savestates.h"
+#include "st64.h"
 #include "util.h"
 #include "workqueue.h"
 
@@ -60,6 +63,15 @@ enum { DD_DISK_ID_OFFSET = 0x43670 };
 static const char* savestate_magic = "M64+SAVE";
 static const int savestate_latest_version = 0x00010900;  /* 1.9 */
 static const unsigned char pj64_magic[4] = { 0xC8, 0xA6, 0xD8, 0x23 };
+static const char* checkpoint_magic = "M64+CKPT";
+
+/* A checkpoint holds the m64p state data without RDRAM and the TLB lookup
+ * tables, followed by the RDRAM pages written since the previous one. With
+ * CHECKPOINT_XOR, both are XORed with their value at the previous one. */
+enum { CHECKPOINT_HEADER_SIZE = 8 + 4 + 32 + 4 + 4 };
+enum { CHECKPOINT_MAIN_SIZE = 16788244 - RDRAM_MAX_SIZE - 2 * 0x100000 * 4 };
+enum { CHECKPOINT_STATE_SIZE = CHECKPOINT_MAIN_SIZE + 1024 + 4 + 4096 };
+enum { CHECKPOINT_XOR = 1 };
 
 static savestates_job job = savestates_job_nothing;
 static savestates_type type = savestates_type_unknown;
@@ -69,11 +81,20 @@ static unsigned int slot = 0;
 static int autoinc_save_slot = 0;
 
 static SDL_mutex *savestates_lock;
+static SDL_cond *savestates_turn_cond;
+
+/* Saves are compressed on the workqueue; tickets keep them writing in
+ * submission order when several workers pick them up at once. */
+static struct work_future savestates_pending;
+static unsigned int savestates_next_ticket;
+static unsigned int savestates_turn;
 
 struct savestate_work {
     char *filepath;
     char *data;
     size_t size;
+    unsigned int ticket;
+    int chunked;
     struct work_struct work;
 };
 
@@ -185,125 +206,17 @@ static void savestates_clear_job(void)
 #define PUTDATA(buff, type, value) \
     do { type x = value; PUTARRAY(&x, buff, type, 1); } while(0)
 
-static int savestates_load_m64p(struct device* dev, char *filepath)
+/* Apply the state data following the 44 bytes header. Without full, RDRAM
+ * and the TLB lookup tables are absent from curr and RDRAM is left alone. */
+static void savestates_read_m64p(struct device* dev, unsigned char* curr,
+                                 char* queue, unsigned char* using_tlb_data,
+                                 unsigned char* data_0001_0200,
+                                 unsigned int version, int full)
 {
-    unsigned char header[44];
-    gzFile f;
-    unsigned int version;
     int i;
     uint32_t FCR31;
-
-    size_t savestateSize;
-    unsigned char *savestateData, *curr;
-    char queue[1024];
-    unsigned char using_tlb_data[4];
-    unsigned char data_0001_0200[4096]; // 4k for extra state from v1.2
-
     uint32_t* cp0_regs = r4300_cp0_regs(&dev->r4300.cp0);
 
-    SDL_LockMutex(savestates_lock);
-
-    f = osal_gzopen(filepath, "rb");
-    if(f==NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-
-    /* Read and check Mupen64Plus magic number. */
-    if (gzread(f, header, 44) != 44)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr = header;
-
-    if(strncmp((char *)curr, savestate_magic, 8)!=0)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr += 8;
-
-    version = *curr++;
-    version = (version << 8) | *curr++;
-    version = (version << 8) | *curr++;
-    version = (version << 8) | *curr++;
-    if((version >> 16) != (savestate_latest_version >> 16))
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", version);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-
-    if(memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    curr += 32;
-
-    /* Read the rest of the savestate */
-    savestateSize = 16788244;
-    savestateData = curr = (unsigned char *)malloc(savestateSize);
-    if (savestateData == NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
-    }
-    if (version == 0x00010000) /* original savestate version */
-    {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            (gzread(f, queue, sizeof(queue)) % 4) != 0)
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.0 data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
-    }
-    else if (version == 0x00010100) // saves entire eventqueue plus 4-byte using_tlb flags
-    {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
-            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data))
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.1 data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
-    }
-    else // version >= 0x00010200  saves entire eventqueue, 4-byte using_tlb flags and extra state
-    {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
-            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data) ||
-            gzread(f, data_0001_0200, sizeof(data_0001_0200)) != sizeof(data_0001_0200))
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.2+ data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
-    }
-
-    gzclose(f);
-    SDL_UnlockMutex(savestates_lock);
-
     // Parse savestate
     dev->rdram.regs[0][RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
     dev->rdram.regs[0][RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
@@ -419,7 +332,9 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG] = GETDATA(curr, uint32_t);
     dev->dp.dps_regs[DPS_BUFTEST_DATA_REG] = GETDATA(curr, uint32_t);
 
-    COPYARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    if (full) {
+        COPYARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    }
     COPYARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
     COPYARRAY(dev->pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
@@ -428,8 +343,10 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     /* by default, reset flashram state here and load it later if available */
     poweron_flashram(&dev->cart.flashram);
 
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    if (full) {
+        COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
+        COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    }
 
     *r4300_llbit(&dev->r4300) = GETDATA(curr, uint32_t);
     COPYARRAY(r4300_regs(&dev->r4300), curr, int64_t, 32);
@@ -471,6 +388,14 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
         dev->r4300.cp0.tlb.entries[i].phys_odd = GETDATA(curr, uint32_t);
     }
 
+    /* checkpoints leave out the TLB lookup tables, rebuild them */
+    if (!full) {
+        memset(dev->r4300.cp0.tlb.LUT_r, 0, sizeof(dev->r4300.cp0.tlb.LUT_r));
+        memset(dev->r4300.cp0.tlb.LUT_w, 0, sizeof(dev->r4300.cp0.tlb.LUT_w));
+        for (i = 0; i < 32; i++)
+            tlb_map(&dev->r4300.cp0.tlb, i);
+    }
+
     savestates_load_set_pc(&dev->r4300, GETDATA(curr, uint32_t));
 
     *r4300_cp0_next_interrupt(&dev->r4300.cp0) = GETDATA(curr, uint32_t);
@@ -953,6 +878,192 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     dev->r4300.cp0.interrupt_unsafe_state = 0;
 
     *r4300_cp0_last_addr(&dev->r4300.cp0) = *r4300_pc(&dev->r4300);
+}
+
+/* Size of the m64p image following the 44 bytes header, up to the event queue */
+#define M64P_STATE_DATA_SIZE 16788244
+#define M64P_STATE_SIZE (44 + M64P_STATE_DATA_SIZE + 1024 + 4 + 4096)
+
+/* Checks the 44 bytes m64p header and returns its version, or 0 if the
+ * state can't be loaded. */
+static unsigned int savestates_check_m64p_header(const unsigned char* header)
+{
+    const unsigned char* curr = header;
+    unsigned int version;
+
+    if(strncmp((const char *)curr, savestate_magic, 8)!=0)
+    {
+        return 0;
+    }
+    curr += 8;
+
+    version = *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    if((version >> 16) != (savestate_latest_version >> 16))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", version);
+        return 0;
+    }
+
+    if(memcmp((const char *)curr, ROM_SETTINGS.MD5, 32))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
+        return 0;
+    }
+
+    return version;
+}
+
+/* Loads a state written as a chunked st64 container; its image always has
+ * the latest layout, with the event queue and extra state. */
+static int savestates_load_st64(struct device* dev, char *filepath)
+{
+    unsigned char *image;
+    unsigned int version;
+
+    image = (unsigned char *)malloc(M64P_STATE_SIZE);
+    if (image == NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+        return 0;
+    }
+
+    SDL_LockMutex(savestates_lock);
+    if (!st64_read(filepath, 0, M64P_STATE_SIZE, image))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate data from %s", filepath);
+        SDL_UnlockMutex(savestates_lock);
+        free(image);
+        return 0;
+    }
+    SDL_UnlockMutex(savestates_lock);
+
+    version = savestates_check_m64p_header(image);
+    if (version < 0x00010200)
+    {
+        if (version == 0)
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
+        free(image);
+        return 0;
+    }
+
+    savestates_read_m64p(dev, image + 44,
+                         (char *)image + 44 + M64P_STATE_DATA_SIZE,
+                         image + 44 + M64P_STATE_DATA_SIZE + 1024,
+                         image + 44 + M64P_STATE_DATA_SIZE + 1024 + 4,
+                         version, 1);
+
+    free(image);
+    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
+    return 1;
+}
+
+static int savestates_load_m64p(struct device* dev, char *filepath)
+{
+    unsigned char header[44];
+    FILE *fp;
+    gzFile f;
+    unsigned int version;
+
+    size_t savestateSize;
+    unsigned char *savestateData, *curr;
+    char queue[1024];
+    unsigned char using_tlb_data[4];
+    unsigned char data_0001_0200[4096]; // 4k for extra state from v1.2
+
+    /* Chunked states are told apart from gzip streams by their magic. */
+    if ((fp = osal_file_open(filepath, "rb")) != NULL)
+    {
+        size_t got = fread(header, 1, 8, fp);
+        fclose(fp);
+        if (got == 8 && st64_is_container(header))
+            return savestates_load_st64(dev, filepath);
+    }
+
+    SDL_LockMutex(savestates_lock);
+
+    f = osal_gzopen(filepath, "rb");
+    if(f==NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    /* Read and check Mupen64Plus magic number. */
+    if (gzread(f, header, 44) != 44)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    version = savestates_check_m64p_header(header);
+    if (version == 0)
+    {
+        if (strncmp((char *)header, savestate_magic, 8)!=0)
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    /* Read the rest of the savestate */
+    savestateSize = M64P_STATE_DATA_SIZE;
+    savestateData = curr = (unsigned char *)malloc(savestateSize);
+    if (savestateData == NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    if (version == 0x00010000) /* original savestate version */
+    {
+        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
+            (gzread(f, queue, sizeof(queue)) % 4) != 0)
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.0 data from %s", filepath);
+            free(savestateData);
+            gzclose(f);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+    else if (version == 0x00010100) // saves entire eventqueue plus 4-byte using_tlb flags
+    {
+        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
+            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
+            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data))
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.1 data from %s", filepath);
+            free(savestateData);
+            gzclose(f);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+    else // version >= 0x00010200  saves entire eventqueue, 4-byte using_tlb flags and extra state
+    {
+        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
+            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
+            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data) ||
+            gzread(f, data_0001_0200, sizeof(data_0001_0200)) != sizeof(data_0001_0200))
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.2+ data from %s", filepath);
+            free(savestateData);
+            gzclose(f);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+
+    gzclose(f);
+    SDL_UnlockMutex(savestates_lock);
+
+    savestates_read_m64p(dev, savestateData, queue, using_tlb_data, data_0001_0200, version, 1);
 
     free(savestateData);
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
@@ -1404,6 +1515,9 @@ int savestates_load(void)
     char *filepath = NULL;
     int ret = 0;
 
+    /* the state may still be on its way to disk */
+    work_future_wait(&savestates_pending);
+
     if (fname == NULL) // For slots, autodetect the savestate type
     {
         // try M64P type first
@@ -1468,6 +1582,10 @@ int savestates_load(void)
         }
         free(filepath);
         filepath = NULL;
+
+        /* the next checkpoint has to find out which pages changed */
+        if (ret)
+            rdram_dirty_untracked();
     }
 
     // deliver callback to indicate completion of state loading operation
@@ -1478,13 +1596,73 @@ int savestates_load(void)
     return ret;
 }
 
+/* Splits a full m64p image into st64 chunks: registers, RDRAM and the TLB
+ * lookup tables by megabyte, SP memory and PIF RAM, then the remaining CPU
+ * state. Returns the number of chunks. */
+static unsigned int savestates_m64p_chunks(struct st64_chunk* chunks)
+{
+    static const struct { uint32_t kind, size; } regions[] = {
+        { ST64_CHUNK_REGS,   44 + 400 },
+        { ST64_CHUNK_RDRAM,  0x800000 },
+        { ST64_CHUNK_SP_MEM, 0x2000 + 0x40 + 4 + 20 },
+        { ST64_CHUNK_TLB,    0x800000 },
+        { ST64_CHUNK_CPU,    0 }
+    };
+    const uint32_t max_chunk = 0x100000;
+    uint32_t offset = 0;
+    unsigned int count = 0;
+    size_t i;
+
+    for (i = 0; i < sizeof(regions) / sizeof(regions[0]); ++i)
+    {
+        uint32_t end = (regions[i].size != 0) ? offset + regions[i].size : M64P_STATE_SIZE;
+
+        while (offset < end)
+        {
+            uint32_t size = (end - offset > max_chunk) ? max_chunk : end - offset;
+
+            chunks[count].kind = regions[i].kind;
+            chunks[count].offset = offset;
+            chunks[count].size = size;
+            ++count;
+            offset += size;
+        }
+    }
+
+    return count;
+}
+
+static int savestates_save_m64p_st64(const struct savestate_work *save)
+{
+    struct st64_chunk chunks[ST64_MAX_CHUNKS];
+    unsigned int count = savestates_m64p_chunks(chunks);
+
+    if (!st64_write(save->filepath, (const unsigned char *)save->data, save->size, chunks, count))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
+        return 0;
+    }
+
+    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
+    return 1;
+}
+
 static void savestates_save_m64p_work(struct work_struct *work)
 {
     gzFile f;
     int gzres;
+    int ok = 0;
     struct savestate_work *save = container_of(work, struct savestate_work, work);
 
     SDL_LockMutex(savestates_lock);
+    while (savestates_turn != save->ticket)
+        SDL_CondWait(savestates_turn_cond, savestates_lock);
+
+    if (save->chunked)
+    {
+        ok = savestates_save_m64p_st64(save);
+        goto done;
+    }
 
     // Write the state to a GZIP file
     f = osal_gzopen(save->filepath, "wb");
@@ -1492,83 +1670,43 @@ static void savestates_save_m64p_work(struct work_struct *work)
     if (f==NULL)
     {
         main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", save->filepath);
-        free(save->data);
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return;
     }
-
-    gzres = gzwrite(f, save->data, save->size);
-    if ((gzres < 0) || ((size_t)gzres != save->size))
+    else
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
+        gzres = gzwrite(f, save->data, save->size);
+        if ((gzres < 0) || ((size_t)gzres != save->size))
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
+        else
+            ok = 1;
+
         gzclose(f);
-        free(save->data);
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return;
+        if (ok)
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
     }
 
-    gzclose(f);
-    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
+done:
     free(save->data);
     free(save->filepath);
     free(save);
 
+    savestates_turn++;
+    SDL_CondBroadcast(savestates_turn_cond);
     SDL_UnlockMutex(savestates_lock);
-    StateChanged(M64CORE_STATE_SAVECOMPLETE, 1);
+    StateChanged(M64CORE_STATE_SAVECOMPLETE, ok);
 }
 
-static int savestates_save_m64p(const struct device* dev, char *filepath)
+/* Serialize the state data following the 44 bytes header into curr, which
+ * must be zeroed. Without full, RDRAM and the TLB lookup tables are left out. */
+static void savestates_write_m64p(const struct device* dev, char* curr, int full)
 {
-    unsigned char outbuf[4];
     int i;
-
     char queue[1024];
 
-    struct savestate_work *save;
-    char *curr;
-
     /* OK to cast away const qualifier */
     const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
 
-    save = malloc(sizeof(*save));
-    if (!save) {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return 0;
-    }
-
-    save->filepath = strdup(filepath);
-
-    if(autoinc_save_slot)
-        savestates_inc_slot();
-
     save_eventqueue_infos(&dev->r4300.cp0, queue);
 
-    // Allocate memory for the save state data
-    save->size = 16788288 + sizeof(queue) + 4 + 4096;
-    save->data = curr = malloc(save->size);
-    if (save->data == NULL)
-    {
-        free(save->filepath);
-        free(save);
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return 0;
-    }
-
-    memset(save->data, 0, save->size);
-
-    // Write the save state data to memory
-    PUTARRAY(savestate_magic, curr, unsigned char, 8);
-
-    outbuf[0] = (savestate_latest_version >> 24) & 0xff;
-    outbuf[1] = (savestate_latest_version >> 16) & 0xff;
-    outbuf[2] = (savestate_latest_version >>  8) & 0xff;
-    outbuf[3] = (savestate_latest_version >>  0) & 0xff;
-    PUTARRAY(outbuf, curr, unsigned char, 4);
-
-    PUTARRAY(ROM_SETTINGS.MD5, curr, char, 32);
-
     PUTDATA(curr, uint32_t, dev->rdram.regs[0][RDRAM_CONFIG_REG]);
     PUTDATA(curr, uint32_t, dev->rdram.regs[0][RDRAM_DEVICE_ID_REG]);
     PUTDATA(curr, uint32_t, dev->rdram.regs[0][RDRAM_DELAY_REG]);
@@ -1709,15 +1847,19 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_BUFTEST_ADDR_REG]);
     PUTDATA(curr, uint32_t, dev->dp.dps_regs[DPS_BUFTEST_DATA_REG]);
 
-    PUTARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    if (full) {
+        PUTARRAY(dev->rdram.dram, curr, uint32_t, RDRAM_MAX_SIZE/4);
+    }
     PUTARRAY(dev->sp.mem, curr, uint32_t, SP_MEM_SIZE/4);
     PUTARRAY(dev->pif.ram, curr, uint8_t, PIF_RAM_SIZE);
 
     PUTDATA(curr, int32_t, dev->cart.use_flashram);
     curr += 4+8+4+4; // Here used to be flashram state
 
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    if (full) {
+        PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
+        PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    }
 
     /* OK to cast away const qualifier */
     PUTDATA(curr, uint32_t, *r4300_llbit((struct r4300_core*)&dev->r4300));
@@ -1915,8 +2057,61 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     PUTDATA(curr, uint64_t, *r4300_cp0_latch((struct cp0*)&dev->r4300.cp0));
     PUTDATA(curr, uint64_t, *r4300_cp2_latch((struct cp2*)&dev->r4300.cp2));
 
+}
+
+static int savestates_save_m64p(const struct device* dev, char *filepath)
+{
+    unsigned char outbuf[4];
+
+    struct savestate_work *save;
+    char *curr;
+
+    save = malloc(sizeof(*save));
+    if (!save) {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
+        return 0;
+    }
+
+    save->filepath = strdup(filepath);
+
+    if(autoinc_save_slot)
+        savestates_inc_slot();
+
+    // Allocate memory for the save state data
+    save->size = M64P_STATE_SIZE;
+    save->chunked = ConfigGetParamBool(g_CoreConfig, "SaveStateChunked");
+    save->data = curr = malloc(save->size);
+    if (save->data == NULL)
+    {
+        free(save->filepath);
+        free(save);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
+        return 0;
+    }
+
+    memset(save->data, 0, save->size);
+
+    // Write the save state data to memory
+    PUTARRAY(savestate_magic, curr, unsigned char, 8);
+
+    outbuf[0] = (savestate_latest_version >> 24) & 0xff;
+    outbuf[1] = (savestate_latest_version >> 16) & 0xff;
+    outbuf[2] = (savestate_latest_version >>  8) & 0xff;
+    outbuf[3] = (savestate_latest_version >>  0) & 0xff;
+    PUTARRAY(outbuf, curr, unsigned char, 4);
+
+    PUTARRAY(ROM_SETTINGS.MD5, curr, char, 32);
+
+    savestates_write_m64p(dev, curr, 1);
+
+    SDL_LockMutex(savestates_lock);
+    save->ticket = savestates_next_ticket++;
+    SDL_UnlockMutex(savestates_lock);
+
     init_work(&save->work, savestates_save_m64p_work);
-    queue_work(&save->work);
+    queue_work_future(&save->work, WORK_PRIORITY_HIGH, &savestates_pending);
 
     return 1;
 }
@@ -2199,17 +2394,218 @@ int savestates_save(void)
     return ret;
 }
 
+/* State data as of the last checkpoint, RDRAM is kept by rdram_checkpoint */
+static unsigned char l_checkpoint_prev[CHECKPOINT_STATE_SIZE];
+static unsigned char l_checkpoint_state[CHECKPOINT_STATE_SIZE];
+
+static void savestates_checkpoint_write_header(unsigned char* curr, uint32_t pages, uint32_t flags)
+{
+    unsigned char outbuf[4];
+
+    PUTARRAY(checkpoint_magic, curr, unsigned char, 8);
+
+    outbuf[0] = (savestate_latest_version >> 24) & 0xff;
+    outbuf[1] = (savestate_latest_version >> 16) & 0xff;
+    outbuf[2] = (savestate_latest_version >>  8) & 0xff;
+    outbuf[3] = (savestate_latest_version >>  0) & 0xff;
+    PUTARRAY(outbuf, curr, unsigned char, 4);
+
+    PUTARRAY(ROM_SETTINGS.MD5, curr, char, 32);
+    PUTDATA(curr, uint32_t, flags);
+    PUTDATA(curr, uint32_t, pages);
+}
+
+/* Check the header and return the number of page records, or -1. */
+static int savestates_checkpoint_read_header(const unsigned char* curr, size_t size, uint32_t* flags)
+{
+    uint32_t pages;
+
+    if (size < CHECKPOINT_HEADER_SIZE + CHECKPOINT_STATE_SIZE
+     || memcmp(curr, checkpoint_magic, 8) != 0
+     || memcmp(curr + 8 + 4, ROM_SETTINGS.MD5, 32) != 0)
+    {
+        DebugMessage(M64MSG_WARNING, "Invalid savestate checkpoint");
+        return -1;
+    }
+
+    if ((uint32_t)((curr[8] << 24) | (curr[9] << 16) | (curr[10] << 8) | curr[11]) != (uint32_t)savestate_latest_version)
+    {
+        DebugMessage(M64MSG_WARNING, "Savestate checkpoint version doesn't match");
+        return -1;
+    }
+    curr += 8 + 4 + 32;
+
+    memcpy(flags, curr, 4);
+    to_little_endian_buffer(flags, 4, 1);
+    memcpy(&pages, curr + 4, 4);
+    to_little_endian_buffer(&pages, 4, 1);
+
+    if (pages > RDRAM_DIRTY_PAGES
+     || size < CHECKPOINT_HEADER_SIZE + CHECKPOINT_STATE_SIZE + (size_t)pages * RDRAM_CHECKPOINT_RECORD_SIZE)
+    {
+        DebugMessage(M64MSG_WARNING, "Truncated savestate checkpoint");
+        return -1;
+    }
+
+    return (int)pages;
+}
+
+/* The dynarecs store to RDRAM without going through the dirty bitmap. */
+static int savestates_checkpoint_untracked(const struct device* dev)
+{
+    return dev->r4300.emumode == EMUMODE_DYNAREC;
+}
+
+size_t savestates_checkpoint_max_size(void)
+{
+    return CHECKPOINT_HEADER_SIZE + CHECKPOINT_STATE_SIZE
+         + (size_t)RDRAM_DIRTY_PAGES * RDRAM_CHECKPOINT_RECORD_SIZE;
+}
+
+int savestates_checkpoint_reset(void)
+{
+    /* the first checkpoint after a reset holds all of RDRAM */
+    if (!rdram_checkpoint_reset())
+    {
+        DebugMessage(M64MSG_ERROR, "Could not allocate checkpoint RDRAM shadow");
+        return 0;
+    }
+
+    memset(l_checkpoint_prev, 0, CHECKPOINT_STATE_SIZE);
+
+    return 1;
+}
+
+size_t savestates_checkpoint_save(const struct device* dev, unsigned char* data, size_t size, int xor_previous)
+{
+    unsigned char* curr = data;
+    uint32_t pages;
+    size_t i, total;
+
+    if (!rdram_checkpoint_ready() && !savestates_checkpoint_reset())
+        return 0;
+
+    pages = rdram_checkpoint_collect(dev->rdram.dram, savestates_checkpoint_untracked(dev));
+
+    /* pages stay marked, the next attempt picks them up */
+    total = CHECKPOINT_HEADER_SIZE + CHECKPOINT_STATE_SIZE + (size_t)pages * RDRAM_CHECKPOINT_RECORD_SIZE;
+    if (total > size)
+        return 0;
+
+    savestates_checkpoint_write_header(curr, pages, xor_previous ? CHECKPOINT_XOR : 0);
+    curr += CHECKPOINT_HEADER_SIZE;
+
+    memset(l_checkpoint_state, 0, CHECKPOINT_STATE_SIZE);
+    savestates_write_m64p(dev, (char*)l_checkpoint_state, 0);
+    for (i = 0; i < CHECKPOINT_STATE_SIZE; ++i)
+    {
+        curr[i] = xor_previous
+            ? (unsigned char)(l_checkpoint_state[i] ^ l_checkpoint_prev[i])
+            : l_checkpoint_state[i];
+    }
+    memcpy(l_checkpoint_prev, l_checkpoint_state, CHECKPOINT_STATE_SIZE);
+    curr += CHECKPOINT_STATE_SIZE;
+
+    rdram_checkpoint_write(curr, dev->rdram.dram, xor_previous);
+
+    return total;
+}
+
+int savestates_checkpoint_load(struct device* dev, const unsigned char* data, size_t size)
+{
+    const unsigned char* curr = data;
+    uint32_t flags;
+    int pages;
+
+    pages = savestates_checkpoint_read_header(curr, size, &flags);
+    if (pages < 0)
+        return 0;
+
+    if (flags & CHECKPOINT_XOR)
+    {
+        DebugMessage(M64MSG_WARNING, "Delta checkpoints can only be undone");
+        return 0;
+    }
+    curr += CHECKPOINT_HEADER_SIZE;
+
+    /* GETARRAY byte swaps in place, work on a copy */
+    memcpy(l_checkpoint_state, curr, CHECKPOINT_STATE_SIZE);
+    curr += CHECKPOINT_STATE_SIZE;
+
+    rdram_checkpoint_load(dev->rdram.dram, curr, (uint32_t)pages);
+
+    /* deltas from now on are against the loaded state */
+    memcpy(l_checkpoint_prev, l_checkpoint_state, CHECKPOINT_STATE_SIZE);
+
+    savestates_read_m64p(dev, l_checkpoint_state,
+                         (char*)l_checkpoint_state + CHECKPOINT_MAIN_SIZE,
+                         l_checkpoint_state + CHECKPOINT_MAIN_SIZE + 1024,
+                         l_checkpoint_state + CHECKPOINT_MAIN_SIZE + 1024 + 4,
+                         savestate_latest_version, 0);
+
+    return 1;
+}
+
+int savestates_checkpoint_undo(const unsigned char* data, size_t size)
+{
+    const unsigned char* curr = data;
+    uint32_t flags;
+    size_t k;
+    int pages;
+
+    pages = savestates_checkpoint_read_header(curr, size, &flags);
+    if (pages < 0 || !rdram_checkpoint_ready())
+        return 0;
+
+    if (!(flags & CHECKPOINT_XOR))
+    {
+        DebugMessage(M64MSG_WARNING, "Only delta checkpoints can be undone");
+        return 0;
+    }
+    curr += CHECKPOINT_HEADER_SIZE;
+
+    for (k = 0; k < CHECKPOINT_STATE_SIZE; ++k)
+        l_checkpoint_prev[k] ^= curr[k];
+    curr += CHECKPOINT_STATE_SIZE;
+
+    rdram_checkpoint_undo(curr, (uint32_t)pages);
+
+    return 1;
+}
+
+void savestates_checkpoint_revert(struct device* dev)
+{
+    if (!rdram_checkpoint_ready())
+        return;
+
+    rdram_checkpoint_revert(dev->rdram.dram, savestates_checkpoint_untracked(dev));
+
+    memcpy(l_checkpoint_state, l_checkpoint_prev, CHECKPOINT_STATE_SIZE);
+    savestates_read_m64p(dev, l_checkpoint_state,
+                         (char*)l_checkpoint_state + CHECKPOINT_MAIN_SIZE,
+                         l_checkpoint_state + CHECKPOINT_MAIN_SIZE + 1024,
+                         l_checkpoint_state + CHECKPOINT_MAIN_SIZE + 1024 + 4,
+                         savestate_latest_version, 0);
+}
+
 void savestates_init(void)
 {
     savestates_lock = SDL_CreateMutex();
-    if (!savestates_lock) {
+    savestates_turn_cond = SDL_CreateCond();
+    if (!savestates_lock || !savestates_turn_cond) {
         DebugMessage(M64MSG_ERROR, "Could not create savestates list lock");
         return;
     }
+
+    init_work_future(&savestates_pending);
+    savestates_next_ticket = savestates_turn = 0;
 }
 
 void savestates_deinit(void)
 {
+    SDL_DestroyCond(savestates_turn_cond);
     SDL_DestroyMutex(savestates_lock);
     savestates_clear_job();
+
+    rdram_checkpoint_free();
 }
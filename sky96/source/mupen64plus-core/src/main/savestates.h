@@ -25,6 +25,10 @@
 #ifndef __SAVESTAVES_H__
 #define __SAVESTAVES_H__
 
+#include <stddef.h>
+
+struct device;
+
 typedef enum _savestates_job
 {
     savestates_job_nothing,
@@ -53,5 +57,20 @@ unsigned int savestates_get_slot(void);
 void savestates_set_autoinc_slot(int b);
 void savestates_inc_slot(void);
 
+/* Incremental checkpoints: the device state plus the RDRAM pages written
+ * since the previous checkpoint. checkpoint_reset makes the next one
+ * self-contained.
+ *
+ * With xor_previous, the checkpoint holds the difference with the previous
+ * one instead, so undoing delta checkpoints from the latest backwards walks
+ * the tracked state back in time; checkpoint_revert then puts the device in
+ * that state. */
+int savestates_checkpoint_reset(void);
+size_t savestates_checkpoint_max_size(void);
+size_t savestates_checkpoint_save(const struct device* dev, unsigned char* data, size_t size, int xor_previous);
+int savestates_checkpoint_load(struct device* dev, const unsigned char* data, size_t size);
+int savestates_checkpoint_undo(const unsigned char* data, size_t size);
+void savestates_checkpoint_revert(struct device* dev);
+
 #endif /* __SAVESTAVES_H__ */
 
@@ -35,6 +35,7 @@
 #include "main/main.h"
 #include "main/rom.h"
 #include "main/util.h"
+#include "main/workqueue.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
@@ -130,6 +131,38 @@ static int SaveRGBBufferToFile(const char *filename, const unsigned char *buf, i
 
 static int CurrentShotIndex;
 
+struct screenshot_work {
+    char *filename;
+    unsigned char *frame;
+    int width;
+    int height;
+    int frame_number;
+    struct work_struct work;
+};
+
+static void screenshot_encode_work(struct work_struct *work)
+{
+    struct screenshot_work *shot = container_of(work, struct screenshot_work, work);
+
+    // write the image to a PNG
+    int rval = SaveRGBBufferToFile(shot->filename, shot->frame, shot->width, shot->height, shot->width * 3);
+    // print message -- this allows developers to capture frames and use them in the regression test
+    if (rval != 0)
+    {
+        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 0);
+    }
+    else
+    {
+        main_message(M64MSG_INFO, OSD_BOTTOM_LEFT, "Captured screenshot for frame %i.", shot->frame_number);
+        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 1);
+    }
+
+    // free the memory
+    free(shot->frame);
+    free(shot->filename);
+    free(shot);
+}
+
 static char *GetNextScreenshotPath(void)
 {
     char *ScreenshotPath;
@@ -233,10 +266,13 @@ void TakeScreenshot(int iFrameNumber)
     gfx.readScreen(NULL, &width, &height, 0);
 
     // allocate memory for the image
+    struct screenshot_work *shot = (struct screenshot_work *) malloc(sizeof(*shot));
     unsigned char *pucFrame = (unsigned char *) malloc(width * height * 3);
-    if (pucFrame == NULL)
+    if (shot == NULL || pucFrame == NULL)
     {
         StateChanged(M64CORE_SCREENSHOT_CAPTURED, 0);
+        free(pucFrame);
+        free(shot);
         free(filename);
         return;
     }
@@ -244,20 +280,13 @@ void TakeScreenshot(int iFrameNumber)
     // grab the back image from OpenGL by calling the video plugin
     gfx.readScreen(pucFrame, &width, &height, 0);
 
-    // write the image to a PNG
-    int rval = SaveRGBBufferToFile(filename, pucFrame, width, height, width * 3);
-    // free the memory
-    free(pucFrame);
-    free(filename);
-    // print message -- this allows developers to capture frames and use them in the regression test
-    if (rval != 0)
-    {
-        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 0);
-    }
-    else
-    {
-        main_message(M64MSG_INFO, OSD_BOTTOM_LEFT, "Captured screenshot for frame %i.", iFrameNumber);
-        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 1);
-    }
+    // the PNG encoding runs on the workqueue so the frame isn't held up by zlib
+    shot->filename = filename;
+    shot->frame = pucFrame;
+    shot->width = width;
+    shot->height = height;
+    shot->frame_number = iFrameNumber;
+    init_work(&shot->work, screenshot_encode_work);
+    queue_work(&shot->work);
 }
 
@@ -0,0 +1,305 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - st64.c                                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "st64.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz.h"
+#include "osal/files.h"
+#include "workqueue.h"
+
+static const unsigned char st64_magic[8] = { 'M', '6', '4', '+', 'S', 'T', '6', '4' };
+
+enum { ST64_VERSION = 1 };
+enum { ST64_HEADER_SIZE = 8 + 4 + 4 + 4 };
+enum { ST64_INDEX_ENTRY_SIZE = 5 * 4 };
+
+struct st64_index_entry
+{
+    struct st64_chunk chunk;
+    uint32_t file_offset;
+    uint32_t stored_size;
+};
+
+struct st64_job
+{
+    struct work_struct work;
+    const unsigned char* src;
+    size_t src_size;
+    unsigned char* dst;
+    size_t dst_size;
+    int ok;
+};
+
+static void st64_put32(unsigned char* p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t st64_get32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* dst_size is the capacity on entry; chunks that don't shrink are stored */
+static void st64_pack_work(struct work_struct* work)
+{
+    struct st64_job* job = container_of(work, struct st64_job, work);
+    size_t packed = lz_compress(job->src, job->src_size, job->dst, job->dst_size);
+
+    if (packed == 0 || packed >= job->src_size) {
+        memcpy(job->dst, job->src, job->src_size);
+        packed = job->src_size;
+    }
+
+    job->dst_size = packed;
+    job->ok = 1;
+}
+
+static void st64_unpack_work(struct work_struct* work)
+{
+    struct st64_job* job = container_of(work, struct st64_job, work);
+
+    if (job->src_size == job->dst_size) {
+        memcpy(job->dst, job->src, job->dst_size);
+        job->ok = 1;
+    }
+    else {
+        job->ok = (lz_decompress(job->src, job->src_size, job->dst, job->dst_size) == job->dst_size);
+    }
+}
+
+int st64_is_container(const unsigned char* magic)
+{
+    return memcmp(magic, st64_magic, sizeof(st64_magic)) == 0;
+}
+
+int st64_write(const char* filepath, const unsigned char* image, size_t size,
+               const struct st64_chunk* chunks, unsigned int count)
+{
+    struct work_future future;
+    struct st64_job* jobs;
+    unsigned char* index;
+    unsigned int i;
+    uint32_t file_offset;
+    size_t expected = 0;
+    int ok = 0;
+    FILE* f;
+
+    if (count == 0 || count > ST64_MAX_CHUNKS)
+        return 0;
+
+    for (i = 0; i < count; ++i) {
+        if (chunks[i].offset != expected || chunks[i].size == 0)
+            return 0;
+        expected += chunks[i].size;
+    }
+    if (expected != size)
+        return 0;
+
+    jobs = calloc(count, sizeof(*jobs));
+    index = malloc(ST64_HEADER_SIZE + count * ST64_INDEX_ENTRY_SIZE);
+    if (jobs == NULL || index == NULL)
+        goto free_jobs;
+
+    /* compress all chunks at once, this thread taking its share */
+    init_work_future(&future);
+    for (i = 0; i < count; ++i) {
+        jobs[i].src = image + chunks[i].offset;
+        jobs[i].src_size = chunks[i].size;
+        jobs[i].dst_size = lz_compress_bound(chunks[i].size);
+        jobs[i].dst = malloc(jobs[i].dst_size);
+        if (jobs[i].dst == NULL)
+            break;
+
+        init_work(&jobs[i].work, st64_pack_work);
+        queue_work_future(&jobs[i].work, WORK_PRIORITY_HIGH, &future);
+    }
+    work_future_wait(&future);
+    if (i != count)
+        goto free_jobs;
+
+    memcpy(index, st64_magic, sizeof(st64_magic));
+    st64_put32(index + 8, ST64_VERSION);
+    st64_put32(index + 12, (uint32_t)size);
+    st64_put32(index + 16, count);
+
+    file_offset = ST64_HEADER_SIZE + count * ST64_INDEX_ENTRY_SIZE;
+    for (i = 0; i < count; ++i) {
+        unsigned char* entry = index + ST64_HEADER_SIZE + i * ST64_INDEX_ENTRY_SIZE;
+        st64_put32(entry + 0, chunks[i].kind);
+        st64_put32(entry + 4, chunks[i].offset);
+        st64_put32(entry + 8, chunks[i].size);
+        st64_put32(entry + 12, file_offset);
+        st64_put32(entry + 16, (uint32_t)jobs[i].dst_size);
+        file_offset += (uint32_t)jobs[i].dst_size;
+    }
+
+    f = osal_file_open(filepath, "wb");
+    if (f == NULL)
+        goto free_jobs;
+
+    ok = (fwrite(index, 1, ST64_HEADER_SIZE + count * ST64_INDEX_ENTRY_SIZE, f) == ST64_HEADER_SIZE + count * ST64_INDEX_ENTRY_SIZE);
+    for (i = 0; ok && i < count; ++i)
+        ok = (fwrite(jobs[i].dst, 1, jobs[i].dst_size, f) == jobs[i].dst_size);
+
+    if (fclose(f) != 0)
+        ok = 0;
+
+free_jobs:
+    if (jobs != NULL) {
+        for (i = 0; i < count; ++i)
+            free(jobs[i].dst);
+    }
+    free(jobs);
+    free(index);
+    return ok;
+}
+
+static int st64_read_index(FILE* f, struct st64_index_entry* entries, unsigned int* count, size_t* image_size)
+{
+    unsigned char header[ST64_HEADER_SIZE];
+    unsigned char entry[ST64_INDEX_ENTRY_SIZE];
+    unsigned int i;
+
+    if (fread(header, 1, sizeof(header), f) != sizeof(header)
+     || !st64_is_container(header)
+     || st64_get32(header + 8) != ST64_VERSION)
+        return 0;
+
+    *image_size = st64_get32(header + 12);
+    *count = st64_get32(header + 16);
+    if (*count == 0 || *count > ST64_MAX_CHUNKS)
+        return 0;
+
+    for (i = 0; i < *count; ++i) {
+        if (fread(entry, 1, sizeof(entry), f) != sizeof(entry))
+            return 0;
+
+        entries[i].chunk.kind = st64_get32(entry + 0);
+        entries[i].chunk.offset = st64_get32(entry + 4);
+        entries[i].chunk.size = st64_get32(entry + 8);
+        entries[i].file_offset = st64_get32(entry + 12);
+        entries[i].stored_size = st64_get32(entry + 16);
+
+        if ((size_t)entries[i].chunk.offset + entries[i].chunk.size > *image_size
+         || entries[i].stored_size > lz_compress_bound(entries[i].chunk.size))
+            return 0;
+    }
+
+    return 1;
+}
+
+int st64_read(const char* filepath, size_t offset, size_t size, unsigned char* dst)
+{
+    struct st64_index_entry entries[ST64_MAX_CHUNKS];
+    struct work_future future;
+    struct st64_job* jobs = NULL;
+    unsigned char** whole = NULL;
+    unsigned int count, i;
+    size_t image_size, covered = 0;
+    int ok = 0;
+    FILE* f;
+
+    f = osal_file_open(filepath, "rb");
+    if (f == NULL)
+        return 0;
+
+    if (!st64_read_index(f, entries, &count, &image_size) || offset + size > image_size)
+        goto close_file;
+
+    jobs = calloc(count, sizeof(*jobs));
+    whole = calloc(count, sizeof(*whole));
+    if (jobs == NULL || whole == NULL)
+        goto close_file;
+
+    /* reading is serial, but each chunk is inflated as soon as it is in */
+    init_work_future(&future);
+    for (i = 0; i < count; ++i) {
+        size_t begin = entries[i].chunk.offset;
+        size_t end = begin + entries[i].chunk.size;
+        unsigned char* stored;
+
+        if (end <= offset || begin >= offset + size)
+            continue;
+
+        stored = malloc(entries[i].stored_size);
+        if (stored == NULL
+         || fseek(f, entries[i].file_offset, SEEK_SET) != 0
+         || fread(stored, 1, entries[i].stored_size, f) != entries[i].stored_size) {
+            free(stored);
+            break;
+        }
+
+        /* chunks only partly in range go through a buffer of their own */
+        jobs[i].dst = (begin >= offset && end <= offset + size)
+            ? dst + (begin - offset)
+            : (whole[i] = malloc(entries[i].chunk.size));
+        if (jobs[i].dst == NULL) {
+            free(stored);
+            break;
+        }
+
+        jobs[i].src = stored;
+        jobs[i].src_size = entries[i].stored_size;
+        jobs[i].dst_size = entries[i].chunk.size;
+        init_work(&jobs[i].work, st64_unpack_work);
+        queue_work_future(&jobs[i].work, WORK_PRIORITY_HIGH, &future);
+    }
+    work_future_wait(&future);
+
+    ok = (i == count);
+    for (i = 0; i < count; ++i) {
+        size_t begin = entries[i].chunk.offset;
+        size_t end = begin + entries[i].chunk.size;
+
+        if (jobs[i].src == NULL)
+            continue;
+
+        if (!jobs[i].ok)
+            ok = 0;
+        else if (whole[i] != NULL) {
+            size_t from = (begin > offset) ? begin : offset;
+            size_t to = (end < offset + size) ? end : offset + size;
+            memcpy(dst + (from - offset), whole[i] + (from - begin), to - from);
+        }
+
+        covered += ((end < offset + size) ? end : offset + size) - ((begin > offset) ? begin : offset);
+        free((void*)jobs[i].src);
+        free(whole[i]);
+    }
+
+    /* the index may not cover the whole range */
+    if (covered != size)
+        ok = 0;
+
+close_file:
+    free(jobs);
+    free(whole);
+    fclose(f);
+    return ok;
+}
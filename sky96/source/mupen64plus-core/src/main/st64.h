@@ -0,0 +1,72 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - st64.h                                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_ST64_H
+#define M64P_MAIN_ST64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Chunked savestate container.
+ *
+ * An image (such as the uncompressed m64p savestate) is cut into chunks
+ * that are compressed independently with the lz codec, on the workqueue.
+ * An index at the start of the file gives, for each chunk, its kind, where
+ * it sits in the image and where its data sits in the file, so any range
+ * of the image can be read back by inflating only the chunks it overlaps,
+ * again in parallel.
+ *
+ * File layout, all fields little-endian 32-bit words:
+ *   "M64+ST64", version, image size, chunk count
+ *   chunk count x { kind, image offset, size, file offset, stored size }
+ *   chunk data; a chunk whose stored size equals its size is not compressed */
+
+enum st64_chunk_kind
+{
+    ST64_CHUNK_REGS = 0,
+    ST64_CHUNK_RDRAM,
+    ST64_CHUNK_SP_MEM,
+    ST64_CHUNK_TLB,
+    ST64_CHUNK_CPU
+};
+
+enum { ST64_MAX_CHUNKS = 256 };
+
+struct st64_chunk
+{
+    uint32_t kind;
+    uint32_t offset;
+    uint32_t size;
+};
+
+/* Returns non-zero if the first 8 bytes of a file are the container magic. */
+int st64_is_container(const unsigned char* magic);
+
+/* Writes size bytes of image as the given chunks, which must follow each
+ * other from offset 0 to size. Returns 1 on success, 0 on failure. */
+int st64_write(const char* filepath, const unsigned char* image, size_t size,
+               const struct st64_chunk* chunks, unsigned int count);
+
+/* Reads size bytes at offset of the image stored in filepath into dst.
+ * Returns 1 on success, 0 on failure. */
+int st64_read(const char* filepath, size_t offset, size_t size, unsigned char* dst);
+
+#endif
@@ -0,0 +1,165 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - telemetry.c                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "telemetry.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "api/m64p_types.h"
+#include "osal/atomics.h"
+#include "osal/clock.h"
+#include "osal/preproc.h"
+
+/* must be a power of two */
+#define TELEMETRY_RING_SIZE 4096
+#define TELEMETRY_RING_MASK (TELEMETRY_RING_SIZE - 1)
+
+#define CACHE_LINE_SIZE 64
+
+/* Producer and consumer indices live on separate cache lines so that
+ * publishing an event never contends with the consumer updating its tail.
+ * Indices are free-running and wrap naturally at 2^32. */
+struct telemetry_ring
+{
+    /* written by producer only */
+    ALIGN(CACHE_LINE_SIZE, uint32_t head);
+    uint32_t tail_cache;    /* producer's last observed value of tail */
+    uint32_t dropped;
+    uint32_t frame;
+    uint32_t enabled;
+    uint32_t interrupts[16];    /* raised since the last flush, by event type bit */
+
+    /* written by consumer only */
+    ALIGN(CACHE_LINE_SIZE, uint32_t tail);
+    uint32_t dropped_seen;
+
+    ALIGN(CACHE_LINE_SIZE, m64p_telemetry_event events[TELEMETRY_RING_SIZE]);
+};
+
+static struct telemetry_ring l_ring;
+
+
+void telemetry_publish(m64p_telemetry_type type, uint32_t arg0, uint32_t arg1)
+{
+    m64p_telemetry_event* e;
+    uint32_t head;
+
+    /* don't fill the ring until somebody started draining it */
+    if (!osal_atomic_load_acquire(&l_ring.enabled)) {
+        return;
+    }
+
+    if (type == M64TELEM_FRAME) {
+        l_ring.frame = arg0;
+    }
+
+    head = l_ring.head;
+
+    if (head - l_ring.tail_cache >= TELEMETRY_RING_SIZE)
+    {
+        /* only reload the consumer index when our cached copy says we are full */
+        l_ring.tail_cache = osal_atomic_load_acquire(&l_ring.tail);
+
+        if (head - l_ring.tail_cache >= TELEMETRY_RING_SIZE) {
+            osal_atomic_store_release(&l_ring.dropped, l_ring.dropped + 1);
+            return;
+        }
+    }
+
+    e = &l_ring.events[head & TELEMETRY_RING_MASK];
+    e->timestamp_ns = osal_clock_ns();
+    e->type = type;
+    e->frame = l_ring.frame;
+    e->arg0 = arg0;
+    e->arg1 = arg1;
+
+    osal_atomic_store_release(&l_ring.head, head + 1);
+}
+
+void telemetry_count_interrupt(uint32_t type)
+{
+    unsigned int bit = 0;
+
+    if (!osal_atomic_load_acquire(&l_ring.enabled)) {
+        return;
+    }
+
+    while (bit < 15 && !(type & (UINT32_C(1) << bit))) {
+        ++bit;
+    }
+
+    ++l_ring.interrupts[bit];
+}
+
+void telemetry_flush_interrupts(void)
+{
+    unsigned int bit;
+
+    for (bit = 0; bit < 16; ++bit)
+    {
+        if (l_ring.interrupts[bit] != 0)
+        {
+            telemetry_publish(M64TELEM_INTERRUPT, UINT32_C(1) << bit, l_ring.interrupts[bit]);
+            l_ring.interrupts[bit] = 0;
+        }
+    }
+}
+
+m64p_error telemetry_drain(m64p_telemetry_drain* drain)
+{
+    uint32_t head, tail, dropped, n, first;
+
+    if (drain->events == NULL && drain->capacity != 0) {
+        return M64ERR_INPUT_ASSERT;
+    }
+
+    osal_atomic_store_release(&l_ring.enabled, 1);
+
+    tail = l_ring.tail;
+    head = osal_atomic_load_acquire(&l_ring.head);
+
+    n = head - tail;
+    if (n > drain->capacity) {
+        n = drain->capacity;
+    }
+
+    if (n != 0)
+    {
+        /* copy out in at most two contiguous chunks */
+        first = TELEMETRY_RING_SIZE - (tail & TELEMETRY_RING_MASK);
+        if (first > n) {
+            first = n;
+        }
+        memcpy(drain->events, &l_ring.events[tail & TELEMETRY_RING_MASK], first * sizeof(m64p_telemetry_event));
+        memcpy(drain->events + first, &l_ring.events[0], (n - first) * sizeof(m64p_telemetry_event));
+
+        osal_atomic_store_release(&l_ring.tail, tail + n);
+    }
+
+    dropped = osal_atomic_load_acquire(&l_ring.dropped);
+    drain->count = n;
+    drain->dropped = dropped - l_ring.dropped_seen;
+    l_ring.dropped_seen = dropped;
+
+    return M64ERR_SUCCESS;
+}
@@ -0,0 +1,45 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - telemetry.h                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_TELEMETRY_H
+#define M64P_MAIN_TELEMETRY_H
+
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
+/* Single-producer / single-consumer event ring.
+ * The emulation thread is the only producer (telemetry_publish),
+ * the front-end thread draining M64CMD_TELEMETRY_DRAIN is the only consumer.
+ * Neither side ever takes a lock: when the ring is full new events are dropped
+ * and accounted for, so the emulation thread is never stalled. */
+
+void telemetry_publish(m64p_telemetry_type type, uint32_t arg0, uint32_t arg1);
+
+/* Interrupts are too frequent to be published one by one: they are counted
+ * per event type, and telemetry_flush_interrupts publishes one
+ * M64TELEM_INTERRUPT event per type raised since the previous flush. */
+void telemetry_count_interrupt(uint32_t type);
+void telemetry_flush_interrupts(void);
+
+m64p_error telemetry_drain(m64p_telemetry_drain* drain);
+
+#endif
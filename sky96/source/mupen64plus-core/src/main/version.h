@@ -27,9 +27,9 @@
 #define MUPEN_CORE_NAME "Mupen64Plus Core"
 #define MUPEN_CORE_VERSION 0x020600
 
-#define FRONTEND_API_VERSION 0x020106
-#define CONFIG_API_VERSION   0x020302
-#define DEBUG_API_VERSION    0x020001
+#define FRONTEND_API_VERSION 0x020107
+#define CONFIG_API_VERSION   0x020303
+#define DEBUG_API_VERSION    0x020002
 #define VIDEXT_API_VERSION   0x030300
 #define NETPLAY_API_VERSION  0x010001
 
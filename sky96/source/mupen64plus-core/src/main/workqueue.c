@@ -1,5 +1,5 @@
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- *   Mupen64plus - util.h                                                  *
+ *   Mupen64plus - workqueue.c                                             *
  *   Mupen64Plus homepage: https://mupen64plus.org/                        *
  *   Copyright (C) 2012 Mupen64plus development team                       *
  *                                                                         *
@@ -24,168 +24,273 @@
 #include <SDL.h>
 #include <SDL_thread.h>
 #include <stddef.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
 #include "main/list.h"
 
-#define WORKQUEUE_THREADS 1
+#define WORKQUEUE_MAX_THREADS 8
 
 struct workqueue_mgmt_globals {
-    struct list_head work_queue;
-    struct list_head thread_queue;
-    struct list_head thread_list;
+    struct list_head work_queue[WORK_PRIORITY_COUNT];
+    SDL_Thread *threads[WORKQUEUE_MAX_THREADS];
+    int thread_count;
+    int busy;
+    int quit;
     SDL_mutex *lock;
-};
-
-struct workqueue_thread {
-    SDL_Thread *thread;
     SDL_cond *work_avail;
-    struct list_head list;
-    struct list_head list_mgmt;
+    SDL_cond *work_done;
 };
 
 static struct workqueue_mgmt_globals workqueue_mgmt;
 
-static void workqueue_dismiss(struct work_struct *work)
+static int workqueue_empty(void)
 {
+    size_t i;
+
+    for (i = 0; i < WORK_PRIORITY_COUNT; i++) {
+        if (!list_empty(&workqueue_mgmt.work_queue[i]))
+            return 0;
+    }
+
+    return 1;
 }
 
-static struct work_struct *workqueue_get_work(struct workqueue_thread *thread)
+/* Must be called with the lock held; returns NULL once the queue is drained
+ * and a shutdown was requested. */
+static struct work_struct *workqueue_get_work(void)
 {
-    int found = 0;
+    size_t i;
     struct work_struct *work;
 
     for (;;) {
-        SDL_LockMutex(workqueue_mgmt.lock);
-        list_del_init(&thread->list);
-        if (!list_empty(&workqueue_mgmt.work_queue)) {
-            found = 1;
-            work = list_first_entry(&workqueue_mgmt.work_queue, struct work_struct, list);
-            list_del_init(&work->list);
-        } else {
-            list_add(&thread->list, &workqueue_mgmt.thread_queue);
-	        SDL_CondWait(thread->work_avail, workqueue_mgmt.lock);
+        for (i = 0; i < WORK_PRIORITY_COUNT; i++) {
+            if (!list_empty(&workqueue_mgmt.work_queue[i])) {
+                work = list_first_entry(&workqueue_mgmt.work_queue[i], struct work_struct, list);
+                list_del_init(&work->list);
+                return work;
+            }
         }
-        SDL_UnlockMutex(workqueue_mgmt.lock);
 
-        if (found)
-            break;
+        if (workqueue_mgmt.quit)
+            return NULL;
+
+        SDL_CondWait(workqueue_mgmt.work_avail, workqueue_mgmt.lock);
     }
+}
+
+/* The work may free itself from func, so only the future pointer read
+ * beforehand is touched afterwards. */
+static void workqueue_run(struct work_struct *work)
+{
+    struct work_future *future = work->future;
 
-    return work;
+    work->func(work);
+
+    if (future != NULL) {
+        SDL_LockMutex(workqueue_mgmt.lock);
+        future->pending--;
+        SDL_CondBroadcast(workqueue_mgmt.work_done);
+        SDL_UnlockMutex(workqueue_mgmt.lock);
+    }
 }
 
 static int workqueue_thread_handler(void *data)
 {
-    struct workqueue_thread *thread = data;
     struct work_struct *work;
 
+    SDL_LockMutex(workqueue_mgmt.lock);
     for (;;) {
-        work = workqueue_get_work(thread);
-        if (work->func == workqueue_dismiss) {
-            free(work);
+        work = workqueue_get_work();
+        if (work == NULL)
             break;
-        }
 
-        work->func(work);
+        workqueue_mgmt.busy++;
+        SDL_UnlockMutex(workqueue_mgmt.lock);
+
+        workqueue_run(work);
+
+        SDL_LockMutex(workqueue_mgmt.lock);
+        workqueue_mgmt.busy--;
+        if (workqueue_mgmt.busy == 0 && workqueue_empty())
+            SDL_CondBroadcast(workqueue_mgmt.work_done);
     }
+    SDL_UnlockMutex(workqueue_mgmt.lock);
 
     return 0;
 }
 
-int workqueue_init(void)
+int workqueue_init(int threads)
 {
     size_t i;
-    struct workqueue_thread *thread;
+    SDL_Thread *thread;
 
     memset(&workqueue_mgmt, 0, sizeof(workqueue_mgmt));
-    INIT_LIST_HEAD(&workqueue_mgmt.work_queue);
-    INIT_LIST_HEAD(&workqueue_mgmt.thread_queue);
-    INIT_LIST_HEAD(&workqueue_mgmt.thread_list);
+    for (i = 0; i < WORK_PRIORITY_COUNT; i++)
+        INIT_LIST_HEAD(&workqueue_mgmt.work_queue[i]);
+
+    /* leave a core to the emulation thread */
+    if (threads <= 0)
+        threads = SDL_GetCPUCount() - 1;
+    if (threads < 1)
+        threads = 1;
+    if (threads > WORKQUEUE_MAX_THREADS)
+        threads = WORKQUEUE_MAX_THREADS;
 
     workqueue_mgmt.lock = SDL_CreateMutex();
-    if (!workqueue_mgmt.lock) {
+    workqueue_mgmt.work_avail = SDL_CreateCond();
+    workqueue_mgmt.work_done = SDL_CreateCond();
+    if (!workqueue_mgmt.lock || !workqueue_mgmt.work_avail || !workqueue_mgmt.work_done) {
         DebugMessage(M64MSG_ERROR, "Could not create workqueue management");
         return -1;
     }
 
     SDL_LockMutex(workqueue_mgmt.lock);
-    for (i = 0; i < WORKQUEUE_THREADS; i++) {
-        thread = malloc(sizeof(*thread));
-        if (!thread) {
-            DebugMessage(M64MSG_ERROR, "Could not create workqueue thread management data");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
-        }
-
-        memset(thread, 0, sizeof(*thread));
-        list_add(&thread->list_mgmt, &workqueue_mgmt.thread_list);
-        INIT_LIST_HEAD(&thread->list);
-        thread->work_avail = SDL_CreateCond();
-        if (!thread->work_avail) {
-            DebugMessage(M64MSG_ERROR, "Could not create workqueue thread work_avail condition");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
-        }
-
+    for (i = 0; i < (size_t)threads; i++) {
 #if SDL_VERSION_ATLEAST(2,0,0)
-        thread->thread = SDL_CreateThread(workqueue_thread_handler, "m64pwq", thread);
+        thread = SDL_CreateThread(workqueue_thread_handler, "m64pwq", NULL);
 #else
-        thread->thread = SDL_CreateThread(workqueue_thread_handler, thread);
+        thread = SDL_CreateThread(workqueue_thread_handler, NULL);
 #endif
-        if (!thread->thread) {
+        if (!thread) {
             DebugMessage(M64MSG_ERROR, "Could not create workqueue thread handler");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
+            break;
         }
+
+        workqueue_mgmt.threads[workqueue_mgmt.thread_count++] = thread;
     }
     SDL_UnlockMutex(workqueue_mgmt.lock);
 
+    /* without any worker queue_work falls back to running work inline */
+    if (workqueue_mgmt.thread_count == 0)
+        return -1;
+
+    DebugMessage(M64MSG_VERBOSE, "Started workqueue with %i threads", workqueue_mgmt.thread_count);
     return 0;
 }
 
 void workqueue_shutdown(void)
 {
-    size_t i;
+    int i;
     int status;
-    struct work_struct *work;
-    struct workqueue_thread *thread, *safe;
 
-    for (i = 0; i < WORKQUEUE_THREADS; i++) {
-        work = malloc(sizeof(*work));
-        init_work(work, workqueue_dismiss);
-        queue_work(work);
-    }
+    if (!workqueue_mgmt.lock)
+        return;
 
-    list_for_each_entry_safe_t(thread, safe, &workqueue_mgmt.thread_list, struct workqueue_thread, list_mgmt) {
-        list_del(&thread->list_mgmt);
-        SDL_WaitThread(thread->thread, &status);
-        SDL_DestroyCond(thread->work_avail);
-        free(thread);
-    }
+    /* workers drain all pending work before they exit */
+    SDL_LockMutex(workqueue_mgmt.lock);
+    workqueue_mgmt.quit = 1;
+    SDL_CondBroadcast(workqueue_mgmt.work_avail);
+    SDL_UnlockMutex(workqueue_mgmt.lock);
 
-    if (!list_empty(&workqueue_mgmt.work_queue))
-        DebugMessage(M64MSG_WARNING, "Stopped workqueue with work still pending");
+    for (i = 0; i < workqueue_mgmt.thread_count; i++)
+        SDL_WaitThread(workqueue_mgmt.threads[i], &status);
 
+    SDL_DestroyCond(workqueue_mgmt.work_done);
+    SDL_DestroyCond(workqueue_mgmt.work_avail);
     SDL_DestroyMutex(workqueue_mgmt.lock);
+    memset(&workqueue_mgmt, 0, sizeof(workqueue_mgmt));
 }
 
 int queue_work(struct work_struct *work)
 {
-    struct workqueue_thread *thread;
+    return queue_work_future(work, work->priority, work->future);
+}
+
+int queue_work_future(struct work_struct *work, enum work_priority priority, struct work_future *future)
+{
+    if ((int)priority < 0 || priority >= WORK_PRIORITY_COUNT)
+        priority = WORK_PRIORITY_NORMAL;
+
+    work->priority = priority;
+    work->future = future;
+
+    if (!workqueue_mgmt.lock) {
+        work->func(work);
+        return 0;
+    }
 
     SDL_LockMutex(workqueue_mgmt.lock);
-    list_add_tail(&work->list, &workqueue_mgmt.work_queue);
-    if (!list_empty(&workqueue_mgmt.thread_queue)) {
-        thread = list_first_entry(&workqueue_mgmt.thread_queue, struct workqueue_thread, list);
-        list_del_init(&thread->list);
+    if (future != NULL)
+        future->pending++;
 
-        SDL_CondSignal(thread->work_avail);
+    if (workqueue_mgmt.thread_count == 0 || workqueue_mgmt.quit) {
+        SDL_UnlockMutex(workqueue_mgmt.lock);
+        workqueue_run(work);
+        return 0;
     }
+
+    list_add_tail(&work->list, &workqueue_mgmt.work_queue[priority]);
+    SDL_CondSignal(workqueue_mgmt.work_avail);
     SDL_UnlockMutex(workqueue_mgmt.lock);
 
     return 0;
 }
+
+int work_future_done(struct work_future *future)
+{
+    int done;
+
+    if (!workqueue_mgmt.lock)
+        return 1;
+
+    SDL_LockMutex(workqueue_mgmt.lock);
+    done = (future->pending == 0);
+    SDL_UnlockMutex(workqueue_mgmt.lock);
+
+    return done;
+}
+
+/* Must be called with the lock held */
+static struct work_struct *workqueue_take_future_work(struct work_future *future)
+{
+    size_t i;
+    struct work_struct *work;
+
+    for (i = 0; i < WORK_PRIORITY_COUNT; i++) {
+        list_for_each_entry_t(work, &workqueue_mgmt.work_queue[i], struct work_struct, list) {
+            if (work->future == future) {
+                list_del_init(&work->list);
+                return work;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+void work_future_wait(struct work_future *future)
+{
+    struct work_struct *work;
+
+    if (!workqueue_mgmt.lock)
+        return;
+
+    SDL_LockMutex(workqueue_mgmt.lock);
+    while (future->pending != 0) {
+        /* run our own queued work rather than sleep on it, so waiting from
+         * a worker can't starve the pool */
+        work = workqueue_take_future_work(future);
+        if (work != NULL) {
+            SDL_UnlockMutex(workqueue_mgmt.lock);
+            workqueue_run(work);
+            SDL_LockMutex(workqueue_mgmt.lock);
+            continue;
+        }
+
+        SDL_CondWait(workqueue_mgmt.work_done, workqueue_mgmt.lock);
+    }
+    SDL_UnlockMutex(workqueue_mgmt.lock);
+}
+
+void flush_workqueue(void)
+{
+    if (!workqueue_mgmt.lock)
+        return;
+
+    SDL_LockMutex(workqueue_mgmt.lock);
+    while (workqueue_mgmt.thread_count != 0 && (workqueue_mgmt.busy != 0 || !workqueue_empty()))
+        SDL_CondWait(workqueue_mgmt.work_done, workqueue_mgmt.lock);
+    SDL_UnlockMutex(workqueue_mgmt.lock);
+}
@@ -1,5 +1,5 @@
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- *   Mupen64plus - util.h                                                  *
+ *   Mupen64plus - workqueue.h                                             *
  *   Mupen64Plus homepage: https://mupen64plus.org/                        *
  *   Copyright (C) 2012 Mupen64plus development team                       *
  *                                                                         *
@@ -25,43 +25,61 @@
 #include "list.h"
 #include "osal/preproc.h"
 
+/* Work items of a higher priority are always dequeued before lower ones,
+ * items of the same priority run in submission order. */
+enum work_priority
+{
+    WORK_PRIORITY_HIGH = 0,
+    WORK_PRIORITY_NORMAL,
+    WORK_PRIORITY_LOW,
+    WORK_PRIORITY_COUNT
+};
+
+/* Completion tracker for one or more work items. It is owned by the
+ * submitter and stays valid after the work itself freed its container;
+ * it completes once every item attached to it has returned. */
+struct work_future {
+    unsigned int pending;
+};
+
 struct work_struct;
 
 typedef void (*work_func_t)(struct work_struct *work);
 struct work_struct {
     work_func_t func;
     struct list_head list;
+    enum work_priority priority;
+    struct work_future *future;
 };
 
 static osal_inline void init_work(struct work_struct *work, work_func_t func)
 {
     INIT_LIST_HEAD(&work->list);
     work->func = func;
+    work->priority = WORK_PRIORITY_NORMAL;
+    work->future = NULL;
 }
 
-#ifdef M64P_PARALLEL
-
-int workqueue_init(void);
-void workqueue_shutdown(void);
-int queue_work(struct work_struct *work);
-
-#else
-
-static osal_inline int workqueue_init(void)
+static osal_inline void init_work_future(struct work_future *future)
 {
-    return 0;
+    future->pending = 0;
 }
 
-static osal_inline void workqueue_shutdown(void)
-{
-}
+/* threads <= 0 picks one worker per spare CPU core */
+int workqueue_init(int threads);
+void workqueue_shutdown(void);
 
-static osal_inline int queue_work(struct work_struct *work)
-{
-    work->func(work);
-    return 0;
-}
+/* Queue work with the given priority; when future is non-NULL it is
+ * completed after work->func returns. */
+int queue_work(struct work_struct *work);
+int queue_work_future(struct work_struct *work, enum work_priority priority, struct work_future *future);
 
-#endif
+/* Returns non-zero once all work attached to future has finished. */
+int work_future_done(struct work_future *future);
+/* Blocks until all work attached to future has finished, running the
+ * part of it still queued on the calling thread. Safe to call from work. */
+void work_future_wait(struct work_future *future);
+/* Blocks until the queue is empty and all workers are idle. */
+void flush_workqueue(void);
 
 #endif
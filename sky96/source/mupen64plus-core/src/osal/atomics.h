@@ -0,0 +1,93 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/atomics.h                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the compiler-dependent atomic primitives used to share
+ * data between the emulation thread and other threads without locking.
+ * Only naturally aligned 32-bit values are supported.
+ */
+
+#if !defined (OSAL_ATOMICS_H)
+#define OSAL_ATOMICS_H
+
+#include <stdint.h>
+
+#include "preproc.h"
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+
+  #if defined(_M_ARM) || defined(_M_ARM64)
+    #define OSAL_ATOMIC_FENCE() __dmb(0xB) /* _ARM_BARRIER_ISH */
+  #else
+    /* x86 loads have acquire and stores have release semantics,
+     * we only need to prevent compiler reordering */
+    #define OSAL_ATOMIC_FENCE() _ReadWriteBarrier()
+  #endif
+
+static osal_inline uint32_t osal_atomic_load_acquire(const volatile uint32_t* p)
+{
+    uint32_t v = *p;
+    OSAL_ATOMIC_FENCE();
+    return v;
+}
+
+static osal_inline void osal_atomic_store_release(volatile uint32_t* p, uint32_t v)
+{
+    OSAL_ATOMIC_FENCE();
+    *p = v;
+}
+
+static osal_inline void osal_atomic_fence_acquire(void)
+{
+    OSAL_ATOMIC_FENCE();
+}
+
+/* _InterlockedExchange is a full barrier on every target */
+static osal_inline uint32_t osal_atomic_exchange(volatile uint32_t* p, uint32_t v)
+{
+    return (uint32_t)_InterlockedExchange((volatile long*)p, (long)v);
+}
+
+#else  /* GCC / Clang */
+
+static osal_inline uint32_t osal_atomic_load_acquire(const volatile uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static osal_inline void osal_atomic_store_release(volatile uint32_t* p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static osal_inline void osal_atomic_fence_acquire(void)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static osal_inline uint32_t osal_atomic_exchange(volatile uint32_t* p, uint32_t v)
+{
+    return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+
+#endif
+
+#endif /* OSAL_ATOMICS_H */
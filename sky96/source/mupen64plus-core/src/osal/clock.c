@@ -0,0 +1,93 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/clock.c                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the definitions for the OS-dependent high resolution
+ * monotonic clock.
+ */
+
+#include "clock.h"
+
+#if defined(WIN32)
+  #include <windows.h>
+
+uint64_t osal_clock_ns(void)
+{
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER counter;
+
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+
+    QueryPerformanceCounter(&counter);
+
+    /* split the conversion to avoid overflowing 64 bits on long uptimes */
+    return (uint64_t)(counter.QuadPart / freq.QuadPart) * UINT64_C(1000000000)
+         + (uint64_t)(counter.QuadPart % freq.QuadPart) * UINT64_C(1000000000) / freq.QuadPart;
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+void osal_sleep_ns(uint64_t ns)
+{
+    static HANDLE timer = NULL;
+    LARGE_INTEGER due;
+
+    /* high resolution timers need Windows 10 1803, fall back to the legacy one */
+    if (timer == NULL)
+        timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (timer == NULL)
+        timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    if (timer == NULL)
+    {
+        Sleep((DWORD)(ns / 1000000));
+        return;
+    }
+
+    /* negative due time is relative, in 100 ns units */
+    due.QuadPart = -(LONGLONG)(ns / 100);
+    if (SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE))
+        WaitForSingleObject(timer, INFINITE);
+}
+
+#else  /* Not WIN32 */
+  #include <errno.h>
+  #include <time.h>
+
+uint64_t osal_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+void osal_sleep_ns(uint64_t ns)
+{
+    struct timespec req, rem;
+
+    req.tv_sec = (time_t)(ns / UINT64_C(1000000000));
+    req.tv_nsec = (long)(ns % UINT64_C(1000000000));
+    while (nanosleep(&req, &rem) != 0 && errno == EINTR)
+        req = rem;
+}
+
+#endif
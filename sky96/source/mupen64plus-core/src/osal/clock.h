@@ -0,0 +1,40 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/clock.h                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the declarations for the OS-dependent high resolution
+ * monotonic clock used for timing measurements and frame pacing.
+ */
+
+#if !defined (OSAL_CLOCK_H)
+#define OSAL_CLOCK_H
+
+#include <stdint.h>
+
+/* Returns a monotonic timestamp in nanoseconds.
+ * Only the difference between two timestamps is meaningful. */
+uint64_t osal_clock_ns(void);
+
+/* Sleeps for roughly the given number of nanoseconds. The scheduler may
+ * wake the thread late; callers needing precision spin on osal_clock_ns()
+ * for the tail of the wait. */
+void osal_sleep_ns(uint64_t ns);
+
+#endif /* OSAL_CLOCK_H */
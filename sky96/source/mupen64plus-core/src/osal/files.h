@@ -26,6 +26,7 @@
 #if !defined (OSAL_FILES_H)
 #define OSAL_FILES_H
 
+#include <stdint.h>
 #include <zlib.h>
 
 /* some file-related preprocessor definitions */
@@ -67,5 +68,10 @@ extern const char * osal_get_user_cachepath(void);
 extern FILE * osal_file_open (const char *filename, const char *mode);
 extern gzFile osal_gzopen(const char *filename, const char *mode);
 
+/* Gets the size and last modification time of a file.
+ * Returns zero on success, nonzero if the file can't be examined.
+ */
+extern int osal_file_info(const char *filename, int64_t *size, int64_t *mtime);
+
 #endif /* OSAL_FILES_H */
 
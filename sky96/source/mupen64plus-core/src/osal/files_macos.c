@@ -232,3 +232,15 @@ gzFile osal_gzopen(const char *filename, const char *mode)
 {
     return gzopen(filename, mode);
 }
+
+int osal_file_info(const char *filename, int64_t *size, int64_t *mtime)
+{
+    struct stat fileinfo;
+
+    if (stat(filename, &fileinfo) != 0)
+        return 1;
+
+    *size = (int64_t)fileinfo.st_size;
+    *mtime = (int64_t)fileinfo.st_mtime;
+    return 0;
+}
@@ -220,3 +220,17 @@ gzFile osal_gzopen(const char *filename, const char *mode)
     MultiByteToWideChar(CP_UTF8, 0, filename, -1, wstr_filename, PATH_MAX);
     return gzopen_w(wstr_filename, mode);
 }
+
+int osal_file_info(const char *filename, int64_t *size, int64_t *mtime)
+{
+    wchar_t wstr_filename[PATH_MAX];
+    struct _stat64 fileinfo;
+
+    MultiByteToWideChar(CP_UTF8, 0, filename, -1, wstr_filename, PATH_MAX);
+    if (_wstat64(wstr_filename, &fileinfo) != 0)
+        return 1;
+
+    *size = (int64_t)fileinfo.st_size;
+    *mtime = (int64_t)fileinfo.st_mtime;
+    return 0;
+}
@@ -39,6 +39,7 @@
 #include "dummy_rsp.h"
 #include "dummy_video.h"
 #include "main/main.h"
+#include "main/rdram_dirty.h"
 #include "main/rom.h"
 #include "main/version.h"
 #include "osal/dynamiclib.h"
@@ -71,7 +72,8 @@ static const gfx_plugin_functions dummy_gfx = {
     dummyvideo_ResizeVideoOutput,
     dummyvideo_FBRead,
     dummyvideo_FBWrite,
-    dummyvideo_FBGetFrameBufferInfo
+    dummyvideo_FBGetFrameBufferInfo,
+    NULL
 };
 
 static const audio_plugin_functions dummy_audio = {
@@ -108,7 +110,8 @@ static const rsp_plugin_functions dummy_rsp = {
     dummyrsp_PluginGetVersion,
     dummyrsp_DoRspCycles,
     dummyrsp_InitiateRSP,
-    dummyrsp_RomClosed
+    dummyrsp_RomClosed,
+    NULL
 };
 
 static GFX_INFO gfx_info;
@@ -193,6 +196,7 @@ static m64p_error plugin_connect_gfx(m64p_dynlib_handle plugin_handle)
 
         /* set function pointers for optional functions */
         gfx.resizeVideoOutput = (ptr_ResizeVideoOutput)osal_dynlib_getproc(plugin_handle, "ResizeVideoOutput");
+        gfx.fBWriteList = (ptr_FBWriteList)osal_dynlib_getproc(plugin_handle, "FBWriteList");
 
         /* check the version info */
         (*gfx.getVersion)(&PluginType, &PluginVersion, &APIVersion, NULL, NULL);
@@ -472,6 +476,9 @@ static m64p_error plugin_connect_rsp(m64p_dynlib_handle plugin_handle)
             return M64ERR_INPUT_INVALID;
         }
 
+        /* set function pointers for optional functions */
+        rsp.getRdramWrites = (ptr_GetRdramWrites)osal_dynlib_getproc(plugin_handle, "GetRdramWrites");
+
         /* check the version info */
         (*rsp.getVersion)(&PluginType, &PluginVersion, &APIVersion, NULL, NULL);
         if (PluginType != M64PLUGIN_RSP || (APIVersion & 0xffff0000) != (RSP_API_VERSION & 0xffff0000))
@@ -489,6 +496,25 @@ static m64p_error plugin_connect_rsp(m64p_dynlib_handle plugin_handle)
     return M64ERR_SUCCESS;
 }
 
+/* what the RSP plugin hands over to the other plugins writes RDRAM behind
+ * our back as well */
+static void rsp_process_dlist_list(void)
+{
+    gfx.processDList();
+    check_framebuffers();
+}
+
+static void rsp_process_alist_list(void)
+{
+    audio.processAList();
+    rdram_dirty_untracked();
+}
+
+static void rsp_process_rdp_list(void)
+{
+    process_rdp_list(&g_dev.dp);
+}
+
 static m64p_error plugin_start_rsp(void)
 {
     /* fill in the RSP_INFO data structure */
@@ -514,9 +540,9 @@ static m64p_error plugin_start_rsp(void)
     rsp_info.DPC_PIPEBUSY_REG = &g_dev.dp.dpc_regs[DPC_PIPEBUSY_REG];
     rsp_info.DPC_TMEM_REG = &g_dev.dp.dpc_regs[DPC_TMEM_REG];
     rsp_info.CheckInterrupts = EmptyFunc;
-    rsp_info.ProcessDlistList = gfx.processDList;
-    rsp_info.ProcessAlistList = audio.processAList;
-    rsp_info.ProcessRdpList = gfx.processRDPList;
+    rsp_info.ProcessDlistList = rsp_process_dlist_list;
+    rsp_info.ProcessAlistList = rsp_process_alist_list;
+    rsp_info.ProcessRdpList = rsp_process_rdp_list;
     rsp_info.ShowCFB = gfx.showCFB;
 
     /* call the RSP plugin  */
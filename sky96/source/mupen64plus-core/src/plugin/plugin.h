@@ -63,6 +63,7 @@ typedef struct _gfx_plugin_functions
 	ptr_FBRead          fBRead;
 	ptr_FBWrite         fBWrite;
 	ptr_FBGetFrameBufferInfo fBGetFrameBufferInfo;
+	ptr_FBWriteList     fBWriteList;
 } gfx_plugin_functions;
 
 extern gfx_plugin_functions gfx;
@@ -117,6 +118,7 @@ typedef struct _rsp_plugin_functions
 	ptr_DoRspCycles         doRspCycles;
 	ptr_InitiateRSP         initiateRSP;
 	ptr_RomClosed           romClosed;
+	ptr_GetRdramWrites      getRdramWrites;
 } rsp_plugin_functions;
 
 extern rsp_plugin_functions rsp;
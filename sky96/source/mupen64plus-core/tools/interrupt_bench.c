@@ -0,0 +1,349 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - interrupt_bench.c                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Micro-benchmark of the r4300 interrupt event scheduler.
+ *
+ * Replays the same pseudo-random event traffic (VI, AI, SI, PI, SP, DP,
+ * RSP DMA, COMPARE and SPECIAL events being fired and rescheduled, with
+ * pending event lookups and cancellations in between) through the slot
+ * based queue used by the core and through the sorted linked list it
+ * replaced, checks both fire events in the same order and reports the
+ * best time per operation over a few runs.
+ *
+ * Build with "gcc -O2 -I../src -o interrupt_bench interrupt_bench.c"
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "device/r4300/event_queue.h"
+
+#define VI_INT      0x0001
+#define COMPARE_INT 0x0002
+#define SI_INT      0x0008
+#define PI_INT      0x0010
+#define SPECIAL_INT 0x0020
+#define AI_INT      0x0040
+#define SP_INT      0x0080
+#define DP_INT      0x0100
+#define RSP_DMA_EVT 0x0800
+
+#define ITERATIONS 20000000
+#define RUNS 5
+
+/***************************************************************************
+ * Former linked list scheduler
+ **************************************************************************/
+
+enum { POOL_CAPACITY = 16 };
+
+struct node
+{
+    int type;
+    uint32_t count;
+    struct node* next;
+};
+
+struct list_queue
+{
+    struct node nodes[POOL_CAPACITY];
+    struct node* stack[POOL_CAPACITY];
+    size_t index;
+    struct node* first;
+};
+
+static void list_clear(struct list_queue* q)
+{
+    size_t i;
+
+    for (i = 0; i < POOL_CAPACITY; ++i)
+        q->stack[i] = &q->nodes[i];
+
+    q->index = 0;
+    q->first = NULL;
+}
+
+static int list_before(uint32_t ref, uint32_t evt1, uint32_t evt2)
+{
+    return (evt1 - ref) < (evt2 - ref);
+}
+
+static uint32_t* list_get(struct list_queue* q, int type)
+{
+    struct node* e;
+
+    for (e = q->first; e != NULL && e->type != type; e = e->next);
+
+    return (e != NULL) ? &e->count : NULL;
+}
+
+static void list_insert(struct list_queue* q, int type, uint32_t count, uint32_t ref)
+{
+    struct node* event;
+    struct node* e;
+
+    /* add_interrupt_event_count() looked for a duplicate before inserting */
+    if (list_get(q, type) != NULL)
+        fprintf(stderr, "two events of type 0x%x in interrupt queue\n", type);
+
+    if (q->index >= POOL_CAPACITY)
+        return;
+
+    event = q->stack[q->index++];
+    event->count = count;
+    event->type = type;
+
+    if (q->first == NULL)
+    {
+        q->first = event;
+        event->next = NULL;
+    }
+    else if (list_before(ref, count, q->first->count))
+    {
+        event->next = q->first;
+        q->first = event;
+    }
+    else
+    {
+        for (e = q->first; e->next != NULL && !list_before(ref, count, e->next->count); e = e->next);
+
+        event->next = e->next;
+        e->next = event;
+    }
+}
+
+static void list_remove(struct list_queue* q, int type)
+{
+    struct node** link;
+
+    for (link = &q->first; *link != NULL && (*link)->type != type; link = &(*link)->next);
+
+    if (*link != NULL)
+    {
+        q->stack[--q->index] = *link;
+        *link = (*link)->next;
+    }
+}
+
+static void list_pop(struct list_queue* q, int* type, uint32_t* count)
+{
+    struct node* e = q->first;
+
+    *type = e->type;
+    *count = e->count;
+    q->first = e->next;
+    q->stack[--q->index] = e;
+}
+
+/***************************************************************************
+ * Slot scheduler, as used by the core
+ **************************************************************************/
+
+static void slot_insert(struct interrupt_queue* q, int type, uint32_t count, uint32_t ref)
+{
+    event_queue_insert(q, event_queue_slot(type), count, ref);
+}
+
+static uint32_t* slot_get(struct interrupt_queue* q, int type)
+{
+    int slot = event_queue_slot(type);
+
+    return (q->pending & (UINT32_C(1) << slot)) ? &q->count[slot] : NULL;
+}
+
+static void slot_remove(struct interrupt_queue* q, int type)
+{
+    event_queue_remove(q, event_queue_slot(type));
+}
+
+static void slot_pop(struct interrupt_queue* q, int* type, uint32_t* count)
+{
+    int slot = event_queue_first(q);
+
+    *type = 1 << slot;
+    *count = q->count[slot];
+    event_queue_remove(q, slot);
+}
+
+/***************************************************************************
+ * Workload
+ **************************************************************************/
+
+static const int l_types[] = { VI_INT, AI_INT, SI_INT, PI_INT, SP_INT, DP_INT, RSP_DMA_EVT };
+
+static uint32_t l_rng;
+
+static uint32_t next_random(void)
+{
+    /* xorshift32 */
+    l_rng ^= l_rng << 13;
+    l_rng ^= l_rng >> 17;
+    l_rng ^= l_rng << 5;
+    return l_rng;
+}
+
+static uint32_t event_delay(int type)
+{
+    switch (type)
+    {
+    case VI_INT:      return 1562500 / 2;
+    case AI_INT:      return 20000 + next_random() % 20000;
+    case SI_INT:      return 0x900 + next_random() % 0x40;
+    case PI_INT:      return 100 + next_random() % 20000;
+    case SP_INT:      return 1000 + next_random() % 4000;
+    case DP_INT:      return 4000;
+    case RSP_DMA_EVT: return 8 + next_random() % 512;
+    default:          return 0;
+    }
+}
+
+/* Each run returns a checksum of the events fired and looked up, which
+ * must be identical for both schedulers. */
+#define DEFINE_RUNS(prefix, queue_type, clear, insert, get, remove, pop) \
+static void prefix##_setup(queue_type* q) \
+{ \
+    size_t i; \
+ \
+    l_rng = 0x12345678; \
+    clear(q); \
+    insert(q, SPECIAL_INT, 0x80000000, 0); \
+    insert(q, COMPARE_INT, 0x40000000, 0); \
+    for (i = 0; i < sizeof(l_types) / sizeof(l_types[0]); ++i) \
+        insert(q, l_types[i], event_delay(l_types[i]), 0); \
+} \
+ \
+/* fire the next event and schedule the following one of the same type */ \
+static uint64_t prefix##_fire(queue_type* q) \
+{ \
+    uint64_t checksum = 0; \
+    uint32_t now = 0; \
+    size_t i; \
+ \
+    prefix##_setup(q); \
+    for (i = 0; i < ITERATIONS; ++i) \
+    { \
+        int type; \
+ \
+        pop(q, &type, &now); \
+        checksum = checksum * 31 + ((uint64_t)type << 32 | now); \
+ \
+        if (type == SPECIAL_INT) \
+            insert(q, SPECIAL_INT, (now & 0x80000000) ^ 0x80000000, now); \
+        else if (type == COMPARE_INT) \
+            insert(q, COMPARE_INT, now + 0x40000000, now); \
+        else \
+            insert(q, type, now + event_delay(type), now); \
+    } \
+ \
+    return checksum; \
+} \
+ \
+/* VI_CURRENT_REG and AI_LEN_REG style lookups of a pending event */ \
+static uint64_t prefix##_lookup(queue_type* q) \
+{ \
+    uint64_t checksum = 0; \
+    size_t i; \
+ \
+    prefix##_setup(q); \
+    for (i = 0; i < ITERATIONS; ++i) \
+    { \
+        uint32_t* pending = get(q, (i & 1) ? VI_INT : AI_INT); \
+        checksum += (pending != NULL) ? *pending : 0; \
+    } \
+ \
+    return checksum; \
+} \
+ \
+/* cancel a pending event and schedule it again, like SP tasks or DD events */ \
+static uint64_t prefix##_cancel(queue_type* q) \
+{ \
+    uint64_t checksum = 0; \
+    size_t i; \
+ \
+    prefix##_setup(q); \
+    for (i = 0; i < ITERATIONS; ++i) \
+    { \
+        int type = l_types[i % (sizeof(l_types) / sizeof(l_types[0]))]; \
+        uint32_t first; \
+ \
+        remove(q, type); \
+        insert(q, type, (uint32_t)i + event_delay(type), (uint32_t)i); \
+        pop(q, &type, &first); \
+        insert(q, type, first, (uint32_t)i); \
+        checksum = checksum * 31 + ((uint64_t)type << 32 | first); \
+    } \
+ \
+    return checksum; \
+}
+
+DEFINE_RUNS(list, struct list_queue, list_clear, list_insert, list_get, list_remove, list_pop)
+DEFINE_RUNS(slots, struct interrupt_queue, event_queue_clear, slot_insert, slot_get, slot_remove, slot_pop)
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static double min_time(double a, double b)
+{
+    return (a < b) ? a : b;
+}
+
+#define COMPARE(name, what) \
+    do { \
+        clock_t start; \
+        double t_list, t_slots; \
+        int run; \
+        uint64_t sum_list, sum_slots; \
+ \
+        t_list = t_slots = 1e9; \
+        for (run = 0; run < RUNS; ++run) \
+        { \
+            start = clock(); \
+            sum_list = list_##name(&list); \
+            t_list = min_time(t_list, seconds_since(start)); \
+ \
+            start = clock(); \
+            sum_slots = slots_##name(&slots); \
+            t_slots = min_time(t_slots, seconds_since(start)); \
+        } \
+ \
+        printf("%-22s list %6.2f ns   slots %6.2f ns\n", what, t_list * 1e9 / ITERATIONS, t_slots * 1e9 / ITERATIONS); \
+        if (sum_list != sum_slots) { \
+            printf("MISMATCH: schedulers disagree on %s\n", what); \
+            failed = 1; \
+        } \
+    } while (0)
+
+int main(void)
+{
+    static struct list_queue list;
+    static struct interrupt_queue slots;
+    int failed = 0;
+
+    COMPARE(fire, "fire and reschedule");
+    COMPARE(lookup, "pending event lookup");
+    COMPARE(cancel, "cancel and reschedule");
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -29,6 +29,7 @@
 #include "alist.h"
 #include "arithmetics.h"
 #include "audio.h"
+#include "audio_simd.h"
 #include "hle_external.h"
 #include "hle_internal.h"
 #include "memory.h"
@@ -64,6 +65,38 @@ static int16_t* alist_s16(struct hle_t* hle, uint16_t dmem)
 }
 
 
+#ifdef HLE_SIMD
+/* The vector kernels read and write 8 samples at once, which only matches
+ * the sample by sample loops when no two buffers partially overlap. */
+static bool apart(const int16_t* a, const int16_t* b)
+{
+    ptrdiff_t d = a - b;
+    return d <= -8 || d >= 8;
+}
+#endif
+
+static bool envmix_use_simd(size_t n, int16_t* const* dst, const int16_t* in)
+{
+#ifdef HLE_SIMD
+    size_t i, j;
+
+    for (i = 0; i < n; ++i) {
+        if (!apart(dst[i], in))
+            return false;
+
+        for (j = i + 1; j < n; ++j) {
+            if (dst[i] != dst[j] && !apart(dst[i], dst[j]))
+                return false;
+        }
+    }
+
+    return true;
+#else
+    (void)n; (void)dst; (void)in;
+    return false;
+#endif
+}
+
 static void sample_mix(int16_t* dst, int16_t src, int16_t gain)
 {
     *dst = clamp_s16(*dst + ((src * gain) >> 15));
@@ -77,6 +110,31 @@ static void alist_envmix_mix(size_t n, int16_t** dst, const int16_t* gains, int1
         sample_mix(dst[i], src, gains[i]);
 }
 
+/* Mixes 8 samples of in into the n buffers, with one gain per sample. */
+static void alist_envmix_mix8(size_t n, int16_t** dst, int16_t gains[][8], const int16_t* in, bool simd)
+{
+    size_t i, j;
+
+#ifdef HLE_SIMD
+    if (simd) {
+        v16x8 src = v_load(in);
+
+        for (j = 0; j < n; ++j)
+            v_store(dst[j], v_mix(v_load(dst[j]), src, v_load(gains[j])));
+        return;
+    }
+#else
+    (void)simd;
+#endif
+
+    for (i = 0; i < 8; ++i) {
+        int16_t src = in[i^S];
+
+        for (j = 0; j < n; ++j)
+            sample_mix(dst[j] + (i^S), src, gains[j][i^S]);
+    }
+}
+
 static int16_t ramp_step(struct ramp_t* ramp)
 {
     bool target_reached;
@@ -96,6 +154,55 @@ static int16_t ramp_step(struct ramp_t* ramp)
     return (int16_t)(ramp->value >> 16);
 }
 
+static void envmix_gains(int16_t* gains, struct ramp_t* ramps, int16_t dry, int16_t wet)
+{
+    int16_t l_vol = ramp_step(&ramps[0]);
+    int16_t r_vol = ramp_step(&ramps[1]);
+
+    gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
+    gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
+    gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
+    gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
+}
+
+/* Ramped envelope mix shared by the envmix variants, one chunk of 8
+ * samples at a time, with the per sample loop for any remainder. */
+static void envmix_ramped(size_t n, int16_t** dst, const int16_t* in, size_t count,
+                          struct ramp_t* ramps, int16_t dry, int16_t wet)
+{
+    bool simd = envmix_use_simd(n, dst, in);
+    size_t i, j, k;
+
+    for (k = 0; k + 8 <= count; k += 8) {
+        int16_t gains[4][8];
+        int16_t* buffers[4];
+
+        for (i = 0; i < 8; ++i) {
+            int16_t g[4];
+
+            envmix_gains(g, ramps, dry, wet);
+            for (j = 0; j < 4; ++j)
+                gains[j][i^S] = g[j];
+        }
+
+        for (j = 0; j < n; ++j)
+            buffers[j] = dst[j] + k;
+
+        alist_envmix_mix8(n, buffers, gains, in + k, simd);
+    }
+
+    for (; k < count; ++k) {
+        int16_t  gains[4];
+        int16_t* buffers[4];
+
+        for (j = 0; j < n; ++j)
+            buffers[j] = dst[j] + (k^S);
+
+        envmix_gains(gains, ramps, dry, wet);
+        alist_envmix_mix(n, buffers, gains, in[k^S]);
+    }
+}
+
 /* global functions */
 void alist_process(struct hle_t* hle, const acmd_callback_t abi[], unsigned int abi_size)
 {
@@ -168,6 +275,7 @@ void alist_save(struct hle_t* hle, uint16_t dmem, uint32_t address, uint16_t cou
     address &= ~7;
     count = align(count, 8);
     memcpy(hle->dram + address, hle->alist_buffer + dmem, count);
+    mark_dram_written(hle, address, count);
 }
 
 void alist_move(struct hle_t* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count)
@@ -278,8 +386,9 @@ void alist_envmix_exp(
     int32_t exp_seq[2];
     int32_t exp_rates[2];
 
+    int16_t* buffers[4];
     uint32_t ptr = 0;
-    int x, y;
+    int y;
     short save_buffer[40];
 
     memcpy((uint8_t *)save_buffer, (hle->dram + address), sizeof(save_buffer));
@@ -323,25 +432,13 @@ void alist_envmix_exp(
             ramps[1].step = (exp_seq[1] - ramps[1].value) >> 3;
         }
 
-        for (x = 0; x < 8; ++x) {
-            int16_t  gains[4];
-            int16_t* buffers[4];
-            int16_t l_vol = ramp_step(&ramps[0]);
-            int16_t r_vol = ramp_step(&ramps[1]);
-
-            buffers[0] = dl + (ptr^S);
-            buffers[1] = dr + (ptr^S);
-            buffers[2] = wl + (ptr^S);
-            buffers[3] = wr + (ptr^S);
+        buffers[0] = dl + ptr;
+        buffers[1] = dr + ptr;
+        buffers[2] = wl + ptr;
+        buffers[3] = wr + ptr;
 
-            gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
-            gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
-            gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
-            gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
-
-            alist_envmix_mix(n, buffers, gains, in[ptr^S]);
-            ++ptr;
-        }
+        envmix_ramped(n, buffers, in + ptr, 8, ramps, dry, wet);
+        ptr += 8;
     }
 
     *(int16_t *)(save_buffer +  0) = wet;               /* 0-1 */
@@ -355,6 +452,7 @@ void alist_envmix_exp(
     *(int32_t *)(save_buffer + 16) = (int32_t)ramps[0].value;    /* 12-13 */
     *(int32_t *)(save_buffer + 18) = (int32_t)ramps[1].value;    /* 14-15 */
     memcpy(hle->dram + address, (uint8_t *)save_buffer, sizeof(save_buffer));
+    mark_dram_written(hle, address, sizeof(save_buffer));
 }
 
 void alist_envmix_ge(
@@ -370,7 +468,6 @@ void alist_envmix_ge(
         const int32_t *rate,
         uint32_t address)
 {
-    unsigned k;
     size_t n = (aux) ? 4 : 2;
 
     const int16_t* const in = (int16_t*)(hle->alist_buffer + dmemi);
@@ -379,6 +476,7 @@ void alist_envmix_ge(
     int16_t* const wl = (int16_t*)(hle->alist_buffer + dmem_wl);
     int16_t* const wr = (int16_t*)(hle->alist_buffer + dmem_wr);
 
+    int16_t* buffers[4] = { dl, dr, wl, wr };
     struct ramp_t ramps[2];
     short save_buffer[40];
 
@@ -403,25 +501,7 @@ void alist_envmix_ge(
         ramps[1].value  = *(int32_t *)(save_buffer + 18);   /* 14-15 */
     }
 
-    count >>= 1;
-    for (k = 0; k < count; ++k) {
-        int16_t  gains[4];
-        int16_t* buffers[4];
-        int16_t l_vol = ramp_step(&ramps[0]);
-        int16_t r_vol = ramp_step(&ramps[1]);
-
-        buffers[0] = dl + (k^S);
-        buffers[1] = dr + (k^S);
-        buffers[2] = wl + (k^S);
-        buffers[3] = wr + (k^S);
-
-        gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
-        gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
-        gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
-        gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
-
-        alist_envmix_mix(n, buffers, gains, in[k^S]);
-    }
+    envmix_ramped(n, buffers, in, count >> 1, ramps, dry, wet);
 
     *(int16_t *)(save_buffer +  0) = wet;               /* 0-1 */
     *(int16_t *)(save_buffer +  2) = dry;               /* 2-3 */
@@ -434,6 +514,7 @@ void alist_envmix_ge(
     *(int32_t *)(save_buffer + 16) = (int32_t)ramps[0].value;    /* 12-13 */
     *(int32_t *)(save_buffer + 18) = (int32_t)ramps[1].value;    /* 14-15 */
     memcpy(hle->dram + address, (uint8_t *)save_buffer, 80);
+    mark_dram_written(hle, address, 80);
 }
 
 void alist_envmix_lin(
@@ -448,7 +529,6 @@ void alist_envmix_lin(
         const int32_t *rate,
         uint32_t address)
 {
-    size_t k;
     struct ramp_t ramps[2];
     int16_t save_buffer[40];
 
@@ -457,6 +537,7 @@ void alist_envmix_lin(
     int16_t* const dr = (int16_t*)(hle->alist_buffer + dmem_dr);
     int16_t* const wl = (int16_t*)(hle->alist_buffer + dmem_wl);
     int16_t* const wr = (int16_t*)(hle->alist_buffer + dmem_wr);
+    int16_t* buffers[4] = { dl, dr, wl, wr };
 
     memcpy((uint8_t *)save_buffer, hle->dram + address, 80);
     if (init) {
@@ -478,25 +559,7 @@ void alist_envmix_lin(
         ramps[1].value  = *(int32_t *)(save_buffer + 18); /* 16-17 */
     }
 
-    count >>= 1;
-    for(k = 0; k < count; ++k) {
-        int16_t  gains[4];
-        int16_t* buffers[4];
-        int16_t l_vol = ramp_step(&ramps[0]);
-        int16_t r_vol = ramp_step(&ramps[1]);
-
-        buffers[0] = dl + (k^S);
-        buffers[1] = dr + (k^S);
-        buffers[2] = wl + (k^S);
-        buffers[3] = wr + (k^S);
-
-        gains[0] = clamp_s16((l_vol * dry + 0x4000) >> 15);
-        gains[1] = clamp_s16((r_vol * dry + 0x4000) >> 15);
-        gains[2] = clamp_s16((l_vol * wet + 0x4000) >> 15);
-        gains[3] = clamp_s16((r_vol * wet + 0x4000) >> 15);
-
-        alist_envmix_mix(4, buffers, gains, in[k^S]);
-    }
+    envmix_ramped(4, buffers, in, count >> 1, ramps, dry, wet);
 
     *(int16_t *)(save_buffer +  0) = wet;            /* 0-1 */
     *(int16_t *)(save_buffer +  2) = dry;            /* 2-3 */
@@ -507,6 +570,7 @@ void alist_envmix_lin(
     *(int32_t *)(save_buffer + 16) = (int32_t)ramps[0].value; /* 16-17 */
     *(int32_t *)(save_buffer + 18) = (int32_t)ramps[1].value; /* 18-19 */
     memcpy(hle->dram + address, (uint8_t *)save_buffer, 80);
+    mark_dram_written(hle, address, 80);
 }
 
 void alist_envmix_nead(
@@ -527,6 +591,10 @@ void alist_envmix_nead(
     int16_t *dr = (int16_t*)(hle->alist_buffer + dmem_dr);
     int16_t *wl = (int16_t*)(hle->alist_buffer + dmem_wl);
     int16_t *wr = (int16_t*)(hle->alist_buffer + dmem_wr);
+#ifdef HLE_SIMD
+    int16_t *buffers[4];
+    bool simd;
+#endif
 
     /* make sure count is a multiple of 8 */
     count = align(count, 8);
@@ -534,8 +602,32 @@ void alist_envmix_nead(
     if (swap_wet_LR)
         swap(&wl, &wr);
 
+#ifdef HLE_SIMD
+    buffers[0] = dl;
+    buffers[1] = dr;
+    buffers[2] = wl;
+    buffers[3] = wr;
+    simd = envmix_use_simd(4, buffers, in);
+#endif
+
     while (count != 0) {
         size_t i;
+
+#ifdef HLE_SIMD
+        if (simd) {
+            v16x8 x  = v_load(in);
+            v16x8 l  = v_xor(v_mulhi_su(x, v_set1(env_values[0])), v_set1(xors[0]));
+            v16x8 r  = v_xor(v_mulhi_su(x, v_set1(env_values[1])), v_set1(xors[1]));
+            v16x8 l2 = v_xor(v_mulhi_su(l, v_set1(env_values[2])), v_set1(xors[2]));
+            v16x8 r2 = v_xor(v_mulhi_su(r, v_set1(env_values[2])), v_set1(xors[3]));
+
+            v_store(dl, v_adds(v_load(dl), l));
+            v_store(dr, v_adds(v_load(dr), r));
+            v_store(wl, v_adds(v_load(wl), l2));
+            v_store(wr, v_adds(v_load(wr), r2));
+        }
+        else
+#endif
         for(i = 0; i < 8; ++i) {
             int16_t l  = (((int32_t)in[i^S] * (uint32_t)env_values[0]) >> 16) ^ xors[0];
             int16_t r  = (((int32_t)in[i^S] * (uint32_t)env_values[1]) >> 16) ^ xors[1];
@@ -569,6 +661,15 @@ void alist_mix(struct hle_t* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count
 
     count >>= 1;
 
+#ifdef HLE_SIMD
+    if (dst == src || apart(dst, src)) {
+        const v16x8 g = v_set1(gain);
+
+        for (; count >= 8; count -= 8, dst += 8, src += 8)
+            v_store(dst, v_mix(v_load(dst), v_load(src), g));
+    }
+#endif
+
     while(count != 0) {
         sample_mix(dst, *src, gain);
 
@@ -584,6 +685,15 @@ void alist_multQ44(struct hle_t* hle, uint16_t dmem, uint16_t count, int8_t gain
 
     count >>= 1;
 
+#ifdef HLE_SIMD
+    {
+        const v16x8 g = v_set1(gain);
+
+        for (; count >= 8; count -= 8, dst += 8)
+            v_store(dst, v_mulq44(v_load(dst), g));
+    }
+#endif
+
     while(count != 0) {
         *dst = clamp_s16(*dst * gain >> 4);
 
@@ -599,6 +709,13 @@ void alist_add(struct hle_t* hle, uint16_t dmemo, uint16_t dmemi, uint16_t count
 
     count >>= 1;
 
+#ifdef HLE_SIMD
+    if (dst == src || apart(dst, src)) {
+        for (; count >= 8; count -= 8, dst += 8, src += 8)
+            v_store(dst, v_adds(v_load(dst), v_load(src)));
+    }
+#endif
+
     while(count != 0) {
         *dst = clamp_s16(*dst + *src);
 
@@ -636,6 +753,7 @@ static void alist_resample_save(struct hle_t* hle, uint32_t address, uint16_t po
     *dram_u16(hle, address + 6) = *sample(hle, pos + 3);
 
     *dram_u16(hle, address + 8) = pitch_accu;
+    mark_dram_written(hle, address, 10);
 }
 
 void alist_resample(
@@ -813,6 +931,8 @@ void alist_filter(
         int32_t v = (lutt5[x] + lutt6[x]) >> 1;
         lutt5[x] = lutt6[x] = v;
     }
+    mark_dram_written(hle, lut_address[0], 16);
+    mark_dram_written(hle, lut_address[1], 16);
 
     for (x = 0; x < count; x += 16) {
         int32_t v[8];
@@ -903,6 +1023,7 @@ void alist_filter(
     }
 
     memcpy(hle->dram + address, in2 - 8, 16);
+    mark_dram_written(hle, address, 16);
     memcpy(hle->alist_buffer + dmem, outbuff, count);
 }
 
@@ -0,0 +1,190 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - audio_simd.h                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef AUDIO_SIMD_H
+#define AUDIO_SIMD_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+/* 8 x 16-bit sample kernels shared by the audio ucodes, matching the scalar
+ * code bit for bit: products are formed on 32 bits and narrowed with signed
+ * saturation, which is what clamp_s16 does. SSE2 and NEON are part of the
+ * x86_64 and AArch64 baselines, so the choice is made at build time. Define
+ * HLE_NO_SIMD to keep the scalar loops only. */
+#if !defined(HLE_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HLE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HLE_NEON
+#endif
+#endif
+
+#if defined(HLE_SSE2) || defined(HLE_NEON)
+#define HLE_SIMD
+#endif
+
+#if defined(HLE_SSE2)
+typedef __m128i v16x8;
+
+static inline v16x8 v_load(const int16_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void v_store(int16_t* p, v16x8 v) { _mm_storeu_si128((__m128i*)p, v); }
+static inline v16x8 v_set1(int16_t x) { return _mm_set1_epi16(x); }
+static inline v16x8 v_adds(v16x8 a, v16x8 b) { return _mm_adds_epi16(a, b); }
+static inline v16x8 v_xor(v16x8 a, v16x8 b) { return _mm_xor_si128(a, b); }
+
+/* full 32-bit products of the low and high 4 lanes */
+static inline void v_mul32(v16x8 a, v16x8 b, __m128i* lo, __m128i* hi)
+{
+    __m128i l = _mm_mullo_epi16(a, b);
+    __m128i h = _mm_mulhi_epi16(a, b);
+
+    *lo = _mm_unpacklo_epi16(l, h);
+    *hi = _mm_unpackhi_epi16(l, h);
+}
+
+/* clamp_s16(y + p), for 32-bit p */
+static inline v16x8 v_add32_sat(v16x8 y, __m128i p0, __m128i p1)
+{
+    __m128i y0 = _mm_srai_epi32(_mm_unpacklo_epi16(y, y), 16);
+    __m128i y1 = _mm_srai_epi32(_mm_unpackhi_epi16(y, y), 16);
+
+    return _mm_packs_epi32(_mm_add_epi32(y0, p0), _mm_add_epi32(y1, p1));
+}
+
+/* clamp_s16(y + ((x * gain) >> 15)) */
+static inline v16x8 v_mix(v16x8 y, v16x8 x, v16x8 gain)
+{
+    __m128i p0, p1;
+
+    v_mul32(x, gain, &p0, &p1);
+    return v_add32_sat(y, _mm_srai_epi32(p0, 15), _mm_srai_epi32(p1, 15));
+}
+
+/* clamp_s16(y + ((x * gain + 0x4000) >> 15)) */
+static inline v16x8 v_mix_round(v16x8 y, v16x8 x, v16x8 gain)
+{
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i p0, p1;
+
+    v_mul32(x, gain, &p0, &p1);
+    return v_add32_sat(y, _mm_srai_epi32(_mm_add_epi32(p0, round), 15),
+                          _mm_srai_epi32(_mm_add_epi32(p1, round), 15));
+}
+
+/* clamp_s16((x * gain) >> 4) */
+static inline v16x8 v_mulq44(v16x8 x, v16x8 gain)
+{
+    __m128i p0, p1;
+
+    v_mul32(x, gain, &p0, &p1);
+    return _mm_packs_epi32(_mm_srai_epi32(p0, 4), _mm_srai_epi32(p1, 4));
+}
+
+/* (int16_t)(((int32_t)x * (uint32_t)u) >> 16), u being unsigned */
+static inline v16x8 v_mulhi_su(v16x8 x, v16x8 u)
+{
+    return _mm_add_epi16(_mm_mulhi_epi16(x, u), _mm_and_si128(x, _mm_srai_epi16(u, 15)));
+}
+
+/* clamp_s16(y[i] + ((h[0]*x[i] + h[1]*x[i+1] + h[2]*x[i+2] + h[3]*x[i+3]) >> 15)),
+ * the sum wrapping on 32 bits */
+static inline v16x8 v_fir4(v16x8 y, const int16_t* x, const v16x8* h)
+{
+    __m128i s0 = _mm_setzero_si128();
+    __m128i s1 = _mm_setzero_si128();
+    unsigned k;
+
+    for (k = 0; k < 4; ++k) {
+        __m128i p0, p1;
+
+        v_mul32(v_load(x + k), h[k], &p0, &p1);
+        s0 = _mm_add_epi32(s0, p0);
+        s1 = _mm_add_epi32(s1, p1);
+    }
+
+    return v_add32_sat(y, _mm_srai_epi32(s0, 15), _mm_srai_epi32(s1, 15));
+}
+#elif defined(HLE_NEON)
+typedef int16x8_t v16x8;
+
+static inline v16x8 v_load(const int16_t* p) { return vld1q_s16(p); }
+static inline void v_store(int16_t* p, v16x8 v) { vst1q_s16(p, v); }
+static inline v16x8 v_set1(int16_t x) { return vdupq_n_s16(x); }
+static inline v16x8 v_adds(v16x8 a, v16x8 b) { return vqaddq_s16(a, b); }
+static inline v16x8 v_xor(v16x8 a, v16x8 b) { return veorq_s16(a, b); }
+
+static inline v16x8 v_add32_sat(v16x8 y, int32x4_t p0, int32x4_t p1)
+{
+    return vcombine_s16(vqmovn_s32(vaddw_s16(p0, vget_low_s16(y))),
+                        vqmovn_s32(vaddw_s16(p1, vget_high_s16(y))));
+}
+
+static inline v16x8 v_mix(v16x8 y, v16x8 x, v16x8 gain)
+{
+    return v_add32_sat(y, vshrq_n_s32(vmull_s16(vget_low_s16(x), vget_low_s16(gain)), 15),
+                          vshrq_n_s32(vmull_s16(vget_high_s16(x), vget_high_s16(gain)), 15));
+}
+
+static inline v16x8 v_mix_round(v16x8 y, v16x8 x, v16x8 gain)
+{
+    const int32x4_t round = vdupq_n_s32(0x4000);
+
+    return v_add32_sat(y, vshrq_n_s32(vmlal_s16(round, vget_low_s16(x), vget_low_s16(gain)), 15),
+                          vshrq_n_s32(vmlal_s16(round, vget_high_s16(x), vget_high_s16(gain)), 15));
+}
+
+static inline v16x8 v_mulq44(v16x8 x, v16x8 gain)
+{
+    return vcombine_s16(vqmovn_s32(vshrq_n_s32(vmull_s16(vget_low_s16(x), vget_low_s16(gain)), 4)),
+                        vqmovn_s32(vshrq_n_s32(vmull_s16(vget_high_s16(x), vget_high_s16(gain)), 4)));
+}
+
+static inline v16x8 v_mulhi_su(v16x8 x, v16x8 u)
+{
+    uint16x8_t w = vreinterpretq_u16_s16(u);
+    int32x4_t p0 = vmulq_s32(vmovl_s16(vget_low_s16(x)), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(w))));
+    int32x4_t p1 = vmulq_s32(vmovl_s16(vget_high_s16(x)), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(w))));
+
+    return vcombine_s16(vshrn_n_s32(p0, 16), vshrn_n_s32(p1, 16));
+}
+
+static inline v16x8 v_fir4(v16x8 y, const int16_t* x, const v16x8* h)
+{
+    int32x4_t s0 = vdupq_n_s32(0);
+    int32x4_t s1 = vdupq_n_s32(0);
+    unsigned k;
+
+    for (k = 0; k < 4; ++k) {
+        v16x8 xk = v_load(x + k);
+
+        s0 = vmlal_s16(s0, vget_low_s16(xk), vget_low_s16(h[k]));
+        s1 = vmlal_s16(s1, vget_high_s16(xk), vget_high_s16(h[k]));
+    }
+
+    return v_add32_sat(y, vshrq_n_s32(s0, 15), vshrq_n_s32(s1, 15));
+}
+#endif
+
+#endif
@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include "hle_internal.h"
+#include "memory.h"
 
 /**
  * During IPL3 stage of CIC x105 games, the RSP performs some checks and transactions
@@ -50,6 +51,7 @@ void cicx105_ucode(struct hle_t* hle)
         src += 0x8;
 
     }
+    mark_dram_written(hle, 0x2fb1f0, 23 * 0xff0 + 8);
 
     rsp_break(hle, 0);
 }
@@ -26,6 +26,10 @@
 
 #include "ucodes.h"
 
+/* 4KB pages of the 8MB RDRAM */
+#define HLE_DRAM_PAGE_SHIFT 12
+#define HLE_DRAM_PAGES      (0x800000 >> HLE_DRAM_PAGE_SHIFT)
+
 /* rsp hle internal state - internal usage only */
 struct hle_t
 {
@@ -76,6 +80,10 @@ struct hle_t
     uint8_t  mp3_buffer[0x1000];
 
     struct cached_ucodes_t cached_ucodes;
+
+    /* pages written since the core last asked, see GetRdramWrites */
+    uint32_t dram_written[HLE_DRAM_PAGES / 32];
+    int dram_written_unknown;
 };
 
 /* some mips interface interrupt flags */
@@ -26,12 +26,19 @@
 #include <stdlib.h>
 
 #include "arithmetics.h"
+#include "audio_simd.h"
 #include "hle_external.h"
 #include "hle_internal.h"
 #include "memory.h"
 
 #define SUBBLOCK_SIZE 64
 
+/* RGBA conversion needs 2 x double vectors, which 32-bit ARM NEON does not
+ * have */
+#if defined(HLE_SSE2) || (defined(HLE_NEON) && (defined(__aarch64__) || defined(_M_ARM64)))
+#define HLE_JPEG_RGBA_SIMD
+#endif
+
 typedef void (*tile_line_emitter_t)(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
 typedef void (*subblock_transform_t)(int16_t *dst, const int16_t *src);
 
@@ -43,13 +50,21 @@ static void jpeg_decode_std(struct hle_t* hle,
                             const tile_line_emitter_t emit_line);
 
 /* helper functions */
+#ifndef HLE_SIMD
 static uint8_t clamp_u8(int16_t x);
+#endif
 static int16_t clamp_s12(int16_t x);
+#ifndef HLE_JPEG_RGBA_SIMD
 static uint16_t clamp_RGBA_component(int16_t x);
+#endif
 
 /* pixel conversion & formatting */
+#ifndef HLE_SIMD
 static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v);
+#endif
+#ifndef HLE_JPEG_RGBA_SIMD
 static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v);
+#endif
 
 /* tile line emitters */
 static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
@@ -72,7 +87,9 @@ static void ReorderSubBlock(int16_t *dst, const int16_t *src, const unsigned int
 static void MultSubBlocks(int16_t *dst, const int16_t *src1, const int16_t *src2, unsigned int shift);
 static void ScaleSubBlock(int16_t *dst, const int16_t *src, int16_t scale);
 static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift);
+#ifndef HLE_SIMD
 static void InverseDCT1D(const float *const x, float *dst, unsigned int stride);
+#endif
 static void InverseDCTSubBlock(int16_t *dst, const int16_t *src);
 static void RescaleYSubBlock(int16_t *dst, const int16_t *src);
 static void RescaleUVSubBlock(int16_t *dst, const int16_t *src);
@@ -101,6 +118,7 @@ static const unsigned int ZIGZAG_TABLE[SUBBLOCK_SIZE] = {
     35, 36, 48, 49, 57, 58, 62, 63
 };
 
+#ifndef HLE_SIMD
 /* transposition indices */
 static const unsigned int TRANSPOSE_TABLE[SUBBLOCK_SIZE] = {
     0,  8, 16, 24, 32, 40, 48, 56,
@@ -112,6 +130,7 @@ static const unsigned int TRANSPOSE_TABLE[SUBBLOCK_SIZE] = {
     6, 14, 22, 30, 38, 46, 54, 62,
     7, 15, 23, 31, 39, 47, 55, 63
 };
+#endif
 
 
 
@@ -132,6 +151,336 @@ static const float IDCT_K[10] = {
     -2.562915448f    /* -C1-C3         */
 };
 
+#ifdef HLE_SIMD
+/* Vector versions of the subblock and tile line helpers. They follow the
+ * scalar code operation for operation, including the float IDCT (same
+ * additions in the same order, 4 rows or columns per vector) and the double
+ * precision colour conversion, so the output is identical. */
+#if defined(HLE_SSE2)
+typedef __m128 f32x4;
+
+static inline f32x4 vf_set1(float x) { return _mm_set1_ps(x); }
+static inline f32x4 vf_add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+static inline f32x4 vf_sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+static inline f32x4 vf_mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+
+/* (float)x, lanes 0..3 in f[0] and 4..7 in f[1] */
+static inline void vf_from_s16(v16x8 x, f32x4* f)
+{
+    f[0] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+    f[1] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+}
+
+/* (int16_t)x >> 3 for the 8 lanes of lo and hi */
+static inline v16x8 vf_to_s16_shr3(f32x4 lo, f32x4 hi)
+{
+    __m128i l = _mm_srai_epi32(_mm_slli_epi32(_mm_cvttps_epi32(lo), 16), 19);
+    __m128i h = _mm_srai_epi32(_mm_slli_epi32(_mm_cvttps_epi32(hi), 16), 19);
+
+    return _mm_packs_epi32(l, h);
+}
+
+static inline void vf_transpose4(f32x4* r)
+{
+    _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+}
+
+static inline void v_transpose8(v16x8* r)
+{
+    __m128i b0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i b1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i b2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i b3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i b4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i b5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i b6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i b7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+    __m128i c0 = _mm_unpacklo_epi32(b0, b2);
+    __m128i c1 = _mm_unpackhi_epi32(b0, b2);
+    __m128i c2 = _mm_unpacklo_epi32(b1, b3);
+    __m128i c3 = _mm_unpackhi_epi32(b1, b3);
+    __m128i c4 = _mm_unpacklo_epi32(b4, b6);
+    __m128i c5 = _mm_unpackhi_epi32(b4, b6);
+    __m128i c6 = _mm_unpacklo_epi32(b5, b7);
+    __m128i c7 = _mm_unpackhi_epi32(b5, b7);
+
+    r[0] = _mm_unpacklo_epi64(c0, c4);
+    r[1] = _mm_unpackhi_epi64(c0, c4);
+    r[2] = _mm_unpacklo_epi64(c1, c5);
+    r[3] = _mm_unpackhi_epi64(c1, c5);
+    r[4] = _mm_unpacklo_epi64(c2, c6);
+    r[5] = _mm_unpackhi_epi64(c2, c6);
+    r[6] = _mm_unpacklo_epi64(c3, c7);
+    r[7] = _mm_unpackhi_epi64(c3, c7);
+}
+
+/* clamp_s16(a * b) << shift, the shift wrapping on 16 bits */
+static inline v16x8 v_mul_shl(v16x8 a, v16x8 b, unsigned int shift)
+{
+    __m128i p0, p1;
+
+    v_mul32(a, b, &p0, &p1);
+    return _mm_sll_epi16(_mm_packs_epi32(p0, p1), _mm_cvtsi32_si128(shift));
+}
+
+static inline v16x8 v_sar(v16x8 x, unsigned int shift)
+{
+    return _mm_sra_epi16(x, _mm_cvtsi32_si128(shift));
+}
+
+static inline v16x8 v_rescale_y(v16x8 x)
+{
+    x = _mm_min_epi16(_mm_max_epi16(x, _mm_set1_epi16(-0x800)), _mm_set1_epi16(0x7f0));
+    x = _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(0x800)), _mm_set1_epi16(0xdb0));
+    return _mm_add_epi16(x, _mm_set1_epi16(0x10));
+}
+
+static inline v16x8 v_rescale_uv(v16x8 x)
+{
+    x = _mm_min_epi16(_mm_max_epi16(x, _mm_set1_epi16(-0x800)), _mm_set1_epi16(0x7f0));
+    x = _mm_mulhi_epi16(x, _mm_set1_epi16(0xe00));
+    return _mm_add_epi16(x, _mm_set1_epi16(0x80));
+}
+
+/* clamp_u8, which maps -0x8000 to 1 */
+static inline v16x8 v_clamp_u8(v16x8 x)
+{
+    __m128i c = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(0xff));
+    __m128i m = _mm_cmpeq_epi16(x, _mm_set1_epi16(INT16_MIN));
+
+    return _mm_or_si128(c, _mm_and_si128(m, _mm_set1_epi16(1)));
+}
+
+/* GetUYVY for 8 pixel pairs, y1 and y2 being the 16 luma samples */
+static inline void v_uyvy8(uint32_t* dst, v16x8 y1, v16x8 y2, v16x8 u, v16x8 v)
+{
+    __m128i y = _mm_packus_epi16(v_clamp_u8(y1), v_clamp_u8(y2));
+    __m128i even = _mm_and_si128(y, _mm_set1_epi16(0xff));
+    __m128i odd = _mm_srli_epi16(y, 8);
+    __m128i lo = _mm_or_si128(odd, _mm_slli_epi16(v_clamp_u8(v), 8));
+    __m128i hi = _mm_or_si128(even, _mm_slli_epi16(v_clamp_u8(u), 8));
+
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi16(lo, hi));
+}
+
+/* chroma samples 0..3 or 4..7, each repeated twice */
+static inline v16x8 v_dup_lo(v16x8 x) { return _mm_unpacklo_epi16(x, x); }
+static inline v16x8 v_dup_hi(v16x8 x) { return _mm_unpackhi_epi16(x, x); }
+
+/* the 4 lanes of x as 2 x 2 doubles */
+static inline void v_to_f64(__m128i x, __m128d* d)
+{
+    d[0] = _mm_cvtepi32_pd(x);
+    d[1] = _mm_cvtepi32_pd(_mm_srli_si128(x, 8));
+}
+
+/* clamp_RGBA_component((int16_t)c) for 8 doubles */
+static inline v16x8 v_rgba_component(const __m128d* c)
+{
+    __m128i lo = _mm_unpacklo_epi64(_mm_cvttpd_epi32(c[0]), _mm_cvttpd_epi32(c[1]));
+    __m128i hi = _mm_unpacklo_epi64(_mm_cvttpd_epi32(c[2]), _mm_cvttpd_epi32(c[3]));
+    __m128i x;
+
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    x = _mm_packs_epi32(lo, hi);
+    x = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(0xff0));
+    return _mm_and_si128(x, _mm_set1_epi16(0xf80));
+}
+
+/* GetRGBA for 8 pixels */
+static inline void v_rgba8(uint16_t* dst, v16x8 y, v16x8 u, v16x8 v)
+{
+    const __m128d cr  = _mm_set1_pd(1.4025);
+    const __m128d cgu = _mm_set1_pd(0.3443);
+    const __m128d cgv = _mm_set1_pd(0.7144);
+    const __m128d cb  = _mm_set1_pd(1.7729);
+    __m128d fy[4], fu[4], fv[4], r[4], g[4], b[4];
+    __m128i x;
+    unsigned int i;
+
+    v_to_f64(_mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(y, y), 16), _mm_set1_epi32(2048)), fy);
+    v_to_f64(_mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(y, y), 16), _mm_set1_epi32(2048)), fy + 2);
+    v_to_f64(_mm_srai_epi32(_mm_unpacklo_epi16(u, u), 16), fu);
+    v_to_f64(_mm_srai_epi32(_mm_unpackhi_epi16(u, u), 16), fu + 2);
+    v_to_f64(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), fv);
+    v_to_f64(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), fv + 2);
+
+    for (i = 0; i < 4; ++i) {
+        r[i] = _mm_add_pd(fy[i], _mm_mul_pd(cr, fv[i]));
+        g[i] = _mm_sub_pd(_mm_sub_pd(fy[i], _mm_mul_pd(cgu, fu[i])), _mm_mul_pd(cgv, fv[i]));
+        b[i] = _mm_add_pd(fy[i], _mm_mul_pd(cb, fu[i]));
+    }
+
+    x = _mm_slli_epi16(v_rgba_component(r), 4);
+    x = _mm_or_si128(x, _mm_srli_epi16(v_rgba_component(g), 1));
+    x = _mm_or_si128(x, _mm_srli_epi16(v_rgba_component(b), 6));
+    x = _mm_or_si128(x, _mm_set1_epi16(1));
+    _mm_storeu_si128((__m128i*)dst, x);
+}
+#elif defined(HLE_NEON)
+typedef float32x4_t f32x4;
+
+static inline f32x4 vf_set1(float x) { return vdupq_n_f32(x); }
+static inline f32x4 vf_add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+static inline f32x4 vf_sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+static inline f32x4 vf_mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+
+static inline void vf_from_s16(v16x8 x, f32x4* f)
+{
+    f[0] = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+    f[1] = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+}
+
+static inline v16x8 vf_to_s16_shr3(f32x4 lo, f32x4 hi)
+{
+    return vshrq_n_s16(vcombine_s16(vmovn_s32(vcvtq_s32_f32(lo)), vmovn_s32(vcvtq_s32_f32(hi))), 3);
+}
+
+static inline void vf_transpose4(f32x4* r)
+{
+    float32x4x2_t t0 = vtrnq_f32(r[0], r[1]);
+    float32x4x2_t t1 = vtrnq_f32(r[2], r[3]);
+
+    r[0] = vcombine_f32(vget_low_f32(t0.val[0]), vget_low_f32(t1.val[0]));
+    r[1] = vcombine_f32(vget_low_f32(t0.val[1]), vget_low_f32(t1.val[1]));
+    r[2] = vcombine_f32(vget_high_f32(t0.val[0]), vget_high_f32(t1.val[0]));
+    r[3] = vcombine_f32(vget_high_f32(t0.val[1]), vget_high_f32(t1.val[1]));
+}
+
+static inline void v_transpose8(v16x8* r)
+{
+    int16x8x2_t t0 = vtrnq_s16(r[0], r[1]);
+    int16x8x2_t t1 = vtrnq_s16(r[2], r[3]);
+    int16x8x2_t t2 = vtrnq_s16(r[4], r[5]);
+    int16x8x2_t t3 = vtrnq_s16(r[6], r[7]);
+
+    int32x4x2_t u0 = vtrnq_s32(vreinterpretq_s32_s16(t0.val[0]), vreinterpretq_s32_s16(t1.val[0]));
+    int32x4x2_t u1 = vtrnq_s32(vreinterpretq_s32_s16(t0.val[1]), vreinterpretq_s32_s16(t1.val[1]));
+    int32x4x2_t u2 = vtrnq_s32(vreinterpretq_s32_s16(t2.val[0]), vreinterpretq_s32_s16(t3.val[0]));
+    int32x4x2_t u3 = vtrnq_s32(vreinterpretq_s32_s16(t2.val[1]), vreinterpretq_s32_s16(t3.val[1]));
+
+    r[0] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u0.val[0]), vget_low_s32(u2.val[0])));
+    r[1] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u1.val[0]), vget_low_s32(u3.val[0])));
+    r[2] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u0.val[1]), vget_low_s32(u2.val[1])));
+    r[3] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u1.val[1]), vget_low_s32(u3.val[1])));
+    r[4] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u0.val[0]), vget_high_s32(u2.val[0])));
+    r[5] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u1.val[0]), vget_high_s32(u3.val[0])));
+    r[6] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u0.val[1]), vget_high_s32(u2.val[1])));
+    r[7] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u1.val[1]), vget_high_s32(u3.val[1])));
+}
+
+static inline v16x8 v_mul_shl(v16x8 a, v16x8 b, unsigned int shift)
+{
+    v16x8 p = vcombine_s16(vqmovn_s32(vmull_s16(vget_low_s16(a), vget_low_s16(b))),
+                           vqmovn_s32(vmull_s16(vget_high_s16(a), vget_high_s16(b))));
+
+    return vshlq_s16(p, vdupq_n_s16((int16_t)shift));
+}
+
+static inline v16x8 v_sar(v16x8 x, unsigned int shift)
+{
+    return vshlq_s16(x, vdupq_n_s16(-(int16_t)shift));
+}
+
+static inline v16x8 v_rescale_y(v16x8 x)
+{
+    const uint16x4_t k = vdup_n_u16(0xdb0);
+    uint16x8_t w;
+
+    x = vminq_s16(vmaxq_s16(x, vdupq_n_s16(-0x800)), vdupq_n_s16(0x7f0));
+    w = vreinterpretq_u16_s16(vaddq_s16(x, vdupq_n_s16(0x800)));
+    w = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(w), k), 16),
+                     vshrn_n_u32(vmull_u16(vget_high_u16(w), k), 16));
+    return vaddq_s16(vreinterpretq_s16_u16(w), vdupq_n_s16(0x10));
+}
+
+static inline v16x8 v_rescale_uv(v16x8 x)
+{
+    const int16x4_t k = vdup_n_s16(0xe00);
+
+    x = vminq_s16(vmaxq_s16(x, vdupq_n_s16(-0x800)), vdupq_n_s16(0x7f0));
+    x = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(x), k), 16),
+                     vshrn_n_s32(vmull_s16(vget_high_s16(x), k), 16));
+    return vaddq_s16(x, vdupq_n_s16(0x80));
+}
+
+static inline uint16x8_t v_clamp_u8(v16x8 x)
+{
+    int16x8_t c = vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(0xff));
+    uint16x8_t m = vceqq_s16(x, vdupq_n_s16(INT16_MIN));
+
+    return vorrq_u16(vreinterpretq_u16_s16(c), vandq_u16(m, vdupq_n_u16(1)));
+}
+
+static inline void v_uyvy8(uint32_t* dst, v16x8 y1, v16x8 y2, v16x8 u, v16x8 v)
+{
+    uint16x8_t y = vreinterpretq_u16_u8(vcombine_u8(vmovn_u16(v_clamp_u8(y1)), vmovn_u16(v_clamp_u8(y2))));
+    uint16x8_t even = vandq_u16(y, vdupq_n_u16(0xff));
+    uint16x8_t odd = vshrq_n_u16(y, 8);
+    uint16x8x2_t w = vzipq_u16(vorrq_u16(odd, vshlq_n_u16(v_clamp_u8(v), 8)),
+                               vorrq_u16(even, vshlq_n_u16(v_clamp_u8(u), 8)));
+
+    vst1q_u32(dst, vreinterpretq_u32_u16(w.val[0]));
+    vst1q_u32(dst + 4, vreinterpretq_u32_u16(w.val[1]));
+}
+
+static inline v16x8 v_dup_lo(v16x8 x) { return vzipq_s16(x, x).val[0]; }
+static inline v16x8 v_dup_hi(v16x8 x) { return vzipq_s16(x, x).val[1]; }
+
+#ifdef HLE_JPEG_RGBA_SIMD
+static inline void v_to_f64(int32x4_t x, float64x2_t* d)
+{
+    d[0] = vcvtq_f64_s64(vmovl_s32(vget_low_s32(x)));
+    d[1] = vcvtq_f64_s64(vmovl_s32(vget_high_s32(x)));
+}
+
+static inline uint16x8_t v_rgba_component(const float64x2_t* c)
+{
+    int32x4_t lo = vcombine_s32(vmovn_s64(vcvtq_s64_f64(c[0])), vmovn_s64(vcvtq_s64_f64(c[1])));
+    int32x4_t hi = vcombine_s32(vmovn_s64(vcvtq_s64_f64(c[2])), vmovn_s64(vcvtq_s64_f64(c[3])));
+    int16x8_t x = vcombine_s16(vmovn_s32(lo), vmovn_s32(hi));
+
+    x = vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(0xff0));
+    return vandq_u16(vreinterpretq_u16_s16(x), vdupq_n_u16(0xf80));
+}
+
+static inline void v_rgba8(uint16_t* dst, v16x8 y, v16x8 u, v16x8 v)
+{
+    const float64x2_t cr  = vdupq_n_f64(1.4025);
+    const float64x2_t cgu = vdupq_n_f64(0.3443);
+    const float64x2_t cgv = vdupq_n_f64(0.7144);
+    const float64x2_t cb  = vdupq_n_f64(1.7729);
+    const int32x4_t bias = vdupq_n_s32(2048);
+    float64x2_t fy[4], fu[4], fv[4], r[4], g[4], b[4];
+    uint16x8_t x;
+    unsigned int i;
+
+    v_to_f64(vaddq_s32(vmovl_s16(vget_low_s16(y)), bias), fy);
+    v_to_f64(vaddq_s32(vmovl_s16(vget_high_s16(y)), bias), fy + 2);
+    v_to_f64(vmovl_s16(vget_low_s16(u)), fu);
+    v_to_f64(vmovl_s16(vget_high_s16(u)), fu + 2);
+    v_to_f64(vmovl_s16(vget_low_s16(v)), fv);
+    v_to_f64(vmovl_s16(vget_high_s16(v)), fv + 2);
+
+    for (i = 0; i < 4; ++i) {
+        r[i] = vaddq_f64(fy[i], vmulq_f64(cr, fv[i]));
+        g[i] = vsubq_f64(vsubq_f64(fy[i], vmulq_f64(cgu, fu[i])), vmulq_f64(cgv, fv[i]));
+        b[i] = vaddq_f64(fy[i], vmulq_f64(cb, fu[i]));
+    }
+
+    x = vshlq_n_u16(v_rgba_component(r), 4);
+    x = vorrq_u16(x, vshrq_n_u16(v_rgba_component(g), 1));
+    x = vorrq_u16(x, vshrq_n_u16(v_rgba_component(b), 6));
+    x = vorrq_u16(x, vdupq_n_u16(1));
+    vst1q_u16(dst, x);
+}
+#endif
+#endif
+#endif
+
 
 /* global functions */
 
@@ -268,10 +617,12 @@ static void jpeg_decode_std(struct hle_t* hle,
     }
 }
 
+#ifndef HLE_SIMD
 static uint8_t clamp_u8(int16_t x)
 {
     return (x & (0xff00)) ? ((-x) >> 15) & 0xff : x;
 }
+#endif
 
 static int16_t clamp_s12(int16_t x)
 {
@@ -282,6 +633,7 @@ static int16_t clamp_s12(int16_t x)
     return x;
 }
 
+#ifndef HLE_JPEG_RGBA_SIMD
 static uint16_t clamp_RGBA_component(int16_t x)
 {
     if (x > 0xff0)
@@ -290,7 +642,9 @@ static uint16_t clamp_RGBA_component(int16_t x)
         x = 0;
     return (x & 0xf80);
 }
+#endif
 
+#ifndef HLE_SIMD
 static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v)
 {
     return (uint32_t)clamp_u8(u)  << 24 |
@@ -298,7 +652,9 @@ static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v)
            (uint32_t)clamp_u8(v)  << 8 |
            (uint32_t)clamp_u8(y2);
 }
+#endif
 
+#ifndef HLE_JPEG_RGBA_SIMD
 static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v)
 {
     const float fY = (float)y + 2048.0f;
@@ -311,6 +667,7 @@ static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v)
 
     return (r << 4) | (g >> 1) | (b >> 6) | 1;
 }
+#endif
 
 static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
 {
@@ -319,6 +676,9 @@ static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *
     const int16_t *const v  = u + SUBBLOCK_SIZE;
     const int16_t *const y2 = y + SUBBLOCK_SIZE;
 
+#ifdef HLE_SIMD
+    v_uyvy8(uyvy, v_load(y), v_load(y2), v_load(u), v_load(v));
+#else
     uyvy[0] = GetUYVY(y[0],  y[1],  u[0], v[0]);
     uyvy[1] = GetUYVY(y[2],  y[3],  u[1], v[1]);
     uyvy[2] = GetUYVY(y[4],  y[5],  u[2], v[2]);
@@ -327,6 +687,7 @@ static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *
     uyvy[5] = GetUYVY(y2[2], y2[3], u[5], v[5]);
     uyvy[6] = GetUYVY(y2[4], y2[5], u[6], v[6]);
     uyvy[7] = GetUYVY(y2[6], y2[7], u[7], v[7]);
+#endif
 
     dram_store_u32(hle, uyvy, address, 8);
 }
@@ -338,6 +699,13 @@ static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t
     const int16_t *const v  = u + SUBBLOCK_SIZE;
     const int16_t *const y2 = y + SUBBLOCK_SIZE;
 
+#ifdef HLE_JPEG_RGBA_SIMD
+    const v16x8 vu = v_load(u);
+    const v16x8 vv = v_load(v);
+
+    v_rgba8(rgba,     v_load(y),  v_dup_lo(vu), v_dup_lo(vv));
+    v_rgba8(rgba + 8, v_load(y2), v_dup_hi(vu), v_dup_hi(vv));
+#else
     rgba[0]  = GetRGBA(y[0],  u[0], v[0]);
     rgba[1]  = GetRGBA(y[1],  u[0], v[0]);
     rgba[2]  = GetRGBA(y[2],  u[1], v[1]);
@@ -354,6 +722,7 @@ static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t
     rgba[13] = GetRGBA(y2[5], u[6], v[6]);
     rgba[14] = GetRGBA(y2[6], u[7], v[7]);
     rgba[15] = GetRGBA(y2[7], u[7], v[7]);
+#endif
 
     dram_store_u16(hle, rgba, address, 16);
 }
@@ -462,7 +831,20 @@ static void decode_macroblock_std(const subblock_transform_t transform_luma,
 
 static void TransposeSubBlock(int16_t *dst, const int16_t *src)
 {
+#ifdef HLE_SIMD
+    v16x8 r[8];
+    unsigned int i;
+
+    for (i = 0; i < 8; ++i)
+        r[i] = v_load(src + i * 8);
+
+    v_transpose8(r);
+
+    for (i = 0; i < 8; ++i)
+        v_store(dst + i * 8, r[i]);
+#else
     ReorderSubBlock(dst, src, TRANSPOSE_TABLE);
+#endif
 }
 
 static void ZigZagSubBlock(int16_t *dst, const int16_t *src)
@@ -475,7 +857,7 @@ static void ReorderSubBlock(int16_t *dst, const int16_t *src, const unsigned int
     unsigned int i;
 
     /* source and destination sublocks cannot overlap */
-    assert(labs(dst - src) > SUBBLOCK_SIZE);
+    assert(labs(dst - src) >= SUBBLOCK_SIZE);
 
     for (i = 0; i < SUBBLOCK_SIZE; ++i)
         dst[i] = src[table[i]];
@@ -483,9 +865,14 @@ static void ReorderSubBlock(int16_t *dst, const int16_t *src, const unsigned int
 
 static void MultSubBlocks(int16_t *dst, const int16_t *src1, const int16_t *src2, unsigned int shift)
 {
-    unsigned int i;
+    unsigned int i = 0;
+
+#ifdef HLE_SIMD
+    for (; i + 8 <= SUBBLOCK_SIZE; i += 8)
+        v_store(dst + i, v_mul_shl(v_load(src1 + i), v_load(src2 + i), shift));
+#endif
 
-    for (i = 0; i < SUBBLOCK_SIZE; ++i) {
+    for (; i < SUBBLOCK_SIZE; ++i) {
         int32_t v = src1[i] * src2[i];
         dst[i] = clamp_s16(v) << shift;
     }
@@ -493,9 +880,16 @@ static void MultSubBlocks(int16_t *dst, const int16_t *src1, const int16_t *src2
 
 static void ScaleSubBlock(int16_t *dst, const int16_t *src, int16_t scale)
 {
-    unsigned int i;
+    unsigned int i = 0;
+
+#ifdef HLE_SIMD
+    const v16x8 vscale = v_set1(scale);
 
-    for (i = 0; i < SUBBLOCK_SIZE; ++i) {
+    for (; i + 8 <= SUBBLOCK_SIZE; i += 8)
+        v_store(dst + i, v_mul_shl(v_load(src + i), vscale, 0));
+#endif
+
+    for (; i < SUBBLOCK_SIZE; ++i) {
         int32_t v = src[i] * scale;
         dst[i] = clamp_s16(v);
     }
@@ -503,9 +897,14 @@ static void ScaleSubBlock(int16_t *dst, const int16_t *src, int16_t scale)
 
 static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift)
 {
-    unsigned int i;
+    unsigned int i = 0;
 
-    for (i = 0; i < SUBBLOCK_SIZE; ++i)
+#ifdef HLE_SIMD
+    for (; i + 8 <= SUBBLOCK_SIZE; i += 8)
+        v_store(dst + i, v_sar(v_load(src + i), shift));
+#endif
+
+    for (; i < SUBBLOCK_SIZE; ++i)
         dst[i] = src[i] >> shift;
 }
 
@@ -515,6 +914,7 @@ static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift)
  * Implementation based on Wikipedia :
  * http://fr.wikipedia.org/wiki/Transform%C3%A9e_en_cosinus_discr%C3%A8te
  **************************************************************************/
+#ifndef HLE_SIMD
 static void InverseDCT1D(const float *const x, float *dst, unsigned int stride)
 {
     float e[4];
@@ -555,8 +955,94 @@ static void InverseDCT1D(const float *const x, float *dst, unsigned int stride)
     *dst = f[0] + f[2] - e[0];
 }
 
+#else
+/* InverseDCT1D on 4 sets of coefficients at once, one per lane */
+static void InverseDCT1D_x4(const f32x4 *const x, f32x4 *dst)
+{
+    f32x4 e[4];
+    f32x4 f[4];
+    f32x4 x26, x1357, x15, x37, x17, x35;
+
+    x15   = vf_mul(vf_set1(IDCT_K[2]), vf_add(x[1], x[5]));
+    x37   = vf_mul(vf_set1(IDCT_K[3]), vf_add(x[3], x[7]));
+    x17   = vf_mul(vf_set1(IDCT_K[8]), vf_add(x[1], x[7]));
+    x35   = vf_mul(vf_set1(IDCT_K[9]), vf_add(x[3], x[5]));
+    x1357 = vf_mul(vf_set1(IDCT_C3),   vf_add(vf_add(vf_add(x[1], x[3]), x[5]), x[7]));
+    x26   = vf_mul(vf_set1(IDCT_C6),   vf_add(x[2], x[6]));
+
+    f[0] = vf_add(x[0], x[4]);
+    f[1] = vf_sub(x[0], x[4]);
+    f[2] = vf_add(x26, vf_mul(vf_set1(IDCT_K[0]), x[2]));
+    f[3] = vf_add(x26, vf_mul(vf_set1(IDCT_K[1]), x[6]));
+
+    e[0] = vf_add(vf_add(vf_add(x1357, x15), vf_mul(vf_set1(IDCT_K[4]), x[1])), x17);
+    e[1] = vf_add(vf_add(vf_add(x1357, x37), vf_mul(vf_set1(IDCT_K[6]), x[3])), x35);
+    e[2] = vf_add(vf_add(vf_add(x1357, x15), vf_mul(vf_set1(IDCT_K[5]), x[5])), x35);
+    e[3] = vf_add(vf_add(vf_add(x1357, x37), vf_mul(vf_set1(IDCT_K[7]), x[7])), x17);
+
+    dst[0] = vf_add(vf_add(f[0], f[2]), e[0]);
+    dst[1] = vf_add(vf_add(f[1], f[3]), e[1]);
+    dst[2] = vf_add(vf_sub(f[1], f[3]), e[2]);
+    dst[3] = vf_add(vf_sub(f[0], f[2]), e[3]);
+    dst[4] = vf_sub(vf_sub(f[0], f[2]), e[3]);
+    dst[5] = vf_sub(vf_sub(f[1], f[3]), e[2]);
+    dst[6] = vf_sub(vf_add(f[1], f[3]), e[1]);
+    dst[7] = vf_sub(vf_add(f[0], f[2]), e[0]);
+}
+
+/* InverseDCTSubBlock with the rows, then the columns, transformed 4 at a
+ * time: x[h][j] and y[h][j] hold coefficient j of rows (columns) 4h..4h+3 */
+static void InverseDCTSubBlock_x4(int16_t *dst, const int16_t *src)
+{
+    v16x8 r[8];
+    f32x4 x[2][8];
+    f32x4 y[2][8];
+    f32x4 t[4];
+    unsigned int h, k, j;
+
+    for (j = 0; j < 8; ++j)
+        r[j] = v_load(src + j * 8);
+
+    v_transpose8(r);
+
+    for (j = 0; j < 8; ++j) {
+        vf_from_s16(r[j], t);
+        x[0][j] = t[0];
+        x[1][j] = t[1];
+    }
+
+    /* idct 1d on rows */
+    InverseDCT1D_x4(x[0], y[0]);
+    InverseDCT1D_x4(x[1], y[1]);
+
+    /* transpose 4x4 blocks to get columns in lanes */
+    for (h = 0; h < 2; ++h) {
+        for (k = 0; k < 2; ++k) {
+            for (j = 0; j < 4; ++j)
+                t[j] = y[h][4 * k + j];
+
+            vf_transpose4(t);
+
+            for (j = 0; j < 4; ++j)
+                x[k][4 * h + j] = t[j];
+        }
+    }
+
+    /* idct 1d on columns */
+    InverseDCT1D_x4(x[0], y[0]);
+    InverseDCT1D_x4(x[1], y[1]);
+
+    /* C4 = 1 normalization implies a division by 8 */
+    for (j = 0; j < 8; ++j)
+        v_store(dst + j * 8, vf_to_s16_shr3(y[0][j], y[1][j]));
+}
+#endif
+
 static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
 {
+#ifdef HLE_SIMD
+    InverseDCTSubBlock_x4(dst, src);
+#else
     float x[8];
     float block[SUBBLOCK_SIZE];
     unsigned int i, j;
@@ -577,21 +1063,32 @@ static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
         for (j = 0; j < 8; ++j)
             dst[i + j * 8] = (int16_t)x[j] >> 3;
     }
+#endif
 }
 
 static void RescaleYSubBlock(int16_t *dst, const int16_t *src)
 {
-    unsigned int i;
+    unsigned int i = 0;
 
-    for (i = 0; i < SUBBLOCK_SIZE; ++i)
+#ifdef HLE_SIMD
+    for (; i + 8 <= SUBBLOCK_SIZE; i += 8)
+        v_store(dst + i, v_rescale_y(v_load(src + i)));
+#endif
+
+    for (; i < SUBBLOCK_SIZE; ++i)
         dst[i] = (((uint32_t)(clamp_s12(src[i]) + 0x800) * 0xdb0) >> 16) + 0x10;
 }
 
 static void RescaleUVSubBlock(int16_t *dst, const int16_t *src)
 {
-    unsigned int i;
+    unsigned int i = 0;
 
-    for (i = 0; i < SUBBLOCK_SIZE; ++i)
+#ifdef HLE_SIMD
+    for (; i + 8 <= SUBBLOCK_SIZE; i += 8)
+        v_store(dst + i, v_rescale_uv(v_load(src + i)));
+#endif
+
+    for (; i < SUBBLOCK_SIZE; ++i)
         dst[i] = (((int)clamp_s12(src[i]) * 0xe00) >> 16) + 0x80;
 }
 
@@ -24,6 +24,22 @@
 #include "memory.h"
 
 /* Global functions */
+void mark_dram_written(struct hle_t* hle, uint32_t address, size_t length)
+{
+    uint32_t page = (address & 0x7fffff) >> HLE_DRAM_PAGE_SHIFT;
+    uint32_t last = ((address + (uint32_t)length - 1) & 0x7fffff) >> HLE_DRAM_PAGE_SHIFT;
+
+    if (length == 0)
+        return;
+
+    for (;;) {
+        hle->dram_written[page >> 5] |= UINT32_C(1) << (page & 31);
+        if (page == last)
+            break;
+        page = (page + 1) & (HLE_DRAM_PAGES - 1);
+    }
+}
+
 void load_u8(uint8_t* dst, const unsigned char* buffer, unsigned address, size_t count)
 {
     while (count != 0) {
@@ -88,6 +88,9 @@ void store_u8 (unsigned char* buffer, unsigned address, const uint8_t*  src, siz
 void store_u16(unsigned char* buffer, unsigned address, const uint16_t* src, size_t count);
 void store_u32(unsigned char* buffer, unsigned address, const uint32_t* src, size_t count);
 
+/* every write to DRAM goes through this or through dram_store_* */
+void mark_dram_written(struct hle_t* hle, uint32_t address, size_t length);
+
 
 /* convenient functions for DMEM access */
 static inline uint8_t* dmem_u8(struct hle_t* hle, uint16_t address)
@@ -169,16 +172,19 @@ static inline void dram_load_u32(struct hle_t* hle, uint32_t* dst, uint32_t addr
 static inline void dram_store_u8(struct hle_t* hle, const uint8_t* src, uint32_t address, size_t count)
 {
     store_u8(hle->dram, address & 0xffffff, src, count);
+    mark_dram_written(hle, address, count);
 }
 
 static inline void dram_store_u16(struct hle_t* hle, const uint16_t* src, uint32_t address, size_t count)
 {
     store_u16(hle->dram, address & 0xffffff, src, count);
+    mark_dram_written(hle, address, count * 2);
 }
 
 static inline void dram_store_u32(struct hle_t* hle, const uint32_t* src, uint32_t address, size_t count)
 {
     store_u32(hle->dram, address & 0xffffff, src, count);
+    mark_dram_written(hle, address, count * 4);
 }
 
 #endif
@@ -26,6 +26,7 @@
 
 #include "arithmetics.h"
 #include "audio.h"
+#include "audio_simd.h"
 #include "common.h"
 #include "hle_external.h"
 #include "hle_internal.h"
@@ -175,6 +176,7 @@ static void mix_sfx_with_main_subframes_v2(musyx_t *musyx, const int16_t *subfra
                                            const uint16_t* gains);
 
 static void mix_samples(int16_t *y, int16_t x, int16_t hgain);
+static void mix_envelope(int16_t *y, const int16_t *x, const int16_t *gains);
 static void mix_subframes(int16_t *y, const int16_t *x, int16_t hgain);
 static void mix_fir4(int16_t *y, const int16_t *x, int16_t hgain, const int16_t *hcoeffs);
 
@@ -355,6 +357,8 @@ static void save_base_vol(struct hle_t* hle, const int32_t *base_vol, uint32_t a
 {
     unsigned k;
 
+    mark_dram_written(hle, address, 16);
+
     for (k = 0; k < 4; ++k) {
         *dram_u16(hle, address) = (uint16_t)(base_vol[k] >> 16);
         address += 2;
@@ -697,6 +701,8 @@ static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
     int16_t *v4_dst[4];
     int16_t  v4[4];
 
+    int16_t  resampled[SUBFRAME_SIZE];
+
     dram_load_u32(hle, (uint32_t *)v4_env,      voice_ptr + VOICE_ENV_BEGIN, 4);
     dram_load_u32(hle, (uint32_t *)v4_env_step, voice_ptr + VOICE_ENV_STEP,  4);
 
@@ -723,7 +729,6 @@ static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
         /* update sample and lut pointers and then pitch_accu */
         const int16_t *lut = (RESAMPLE_LUT + ((pitch_accu & 0xfc00) >> 8));
         int dist;
-        int16_t v;
 
         sample += (pitch_accu >> 16);
         pitch_accu &= 0xffff;
@@ -735,18 +740,23 @@ static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
             sample = sample_restart + dist;
 
         /* apply resample filter */
-        v = clamp_s16(dot4(sample, lut));
+        resampled[i] = clamp_s16(dot4(sample, lut));
+    }
 
-        for (k = 0; k < 4; ++k) {
-            /* envmix */
-            int32_t accu = (v * (v4_env[k] >> 16)) >> 15;
-            v4[k] = clamp_s16(accu);
-            *(v4_dst[k]) = clamp_s16(accu + *(v4_dst[k]));
+    /* envmix, one subframe at a time */
+    for (k = 0; k < 4; ++k) {
+        int16_t gains[SUBFRAME_SIZE];
+        int32_t accu;
 
-            /* update envelopes and dst pointers */
-            ++(v4_dst[k]);
+        for (i = 0; i < SUBFRAME_SIZE; ++i) {
+            gains[i] = v4_env[k] >> 16;
             v4_env[k] += v4_env_step[k];
         }
+
+        mix_envelope(v4_dst[k], resampled, gains);
+
+        accu = (resampled[SUBFRAME_SIZE - 1] * gains[SUBFRAME_SIZE - 1]) >> 15;
+        v4[k] = clamp_s16(accu);
     }
 
     /* save last resampled sample */
@@ -854,9 +864,17 @@ static void sfx_stage(struct hle_t* hle, mix_sfx_with_main_subframes_t mix_sfx_w
 static void mix_sfx_with_main_subframes_v1(musyx_t *musyx, const int16_t *subframe,
                                            const uint16_t* UNUSED(gains))
 {
-    unsigned i;
+    unsigned i = 0;
 
-    for (i = 0; i < SUBFRAME_SIZE; ++i) {
+#ifdef HLE_SIMD
+    for (; i < SUBFRAME_SIZE; i += 8) {
+        v16x8 v = v_load(subframe + i);
+        v_store(musyx->left + i,  v_adds(v_load(musyx->left + i),  v));
+        v_store(musyx->right + i, v_adds(v_load(musyx->right + i), v));
+    }
+#endif
+
+    for (; i < SUBFRAME_SIZE; ++i) {
         int16_t v = subframe[i];
         musyx->left[i]  = clamp_s16(musyx->left[i]  + v);
         musyx->right[i] = clamp_s16(musyx->right[i] + v);
@@ -866,9 +884,24 @@ static void mix_sfx_with_main_subframes_v1(musyx_t *musyx, const int16_t *subfra
 static void mix_sfx_with_main_subframes_v2(musyx_t *musyx, const int16_t *subframe,
                                            const uint16_t* gains)
 {
-    unsigned i;
+    unsigned i = 0;
 
-    for (i = 0; i < SUBFRAME_SIZE; ++i) {
+#ifdef HLE_SIMD
+    const v16x8 g1 = v_set1(gains[0]);
+    const v16x8 g2 = v_set1(gains[1]);
+
+    for (; i < SUBFRAME_SIZE; i += 8) {
+        v16x8 v  = v_load(subframe + i);
+        v16x8 v1 = v_mulhi_su(v, g1);
+        v16x8 v2 = v_mulhi_su(v, g2);
+
+        v_store(musyx->left + i,  v_adds(v_load(musyx->left + i),  v1));
+        v_store(musyx->right + i, v_adds(v_load(musyx->right + i), v1));
+        v_store(musyx->cc0 + i,   v_adds(v_load(musyx->cc0 + i),   v2));
+    }
+#endif
+
+    for (; i < SUBFRAME_SIZE; ++i) {
         int16_t v = subframe[i];
         int16_t v1 = (int32_t)(v * gains[0]) >> 16;
         int16_t v2 = (int32_t)(v * gains[1]) >> 16;
@@ -884,17 +917,37 @@ static void mix_samples(int16_t *y, int16_t x, int16_t hgain)
     *y = clamp_s16(*y + ((x * hgain + 0x4000) >> 15));
 }
 
+static void mix_envelope(int16_t *y, const int16_t *x, const int16_t *gains)
+{
+    unsigned int i = 0;
+
+#ifdef HLE_SIMD
+    for (; i < SUBFRAME_SIZE; i += 8)
+        v_store(y + i, v_mix(v_load(y + i), v_load(x + i), v_load(gains + i)));
+#endif
+
+    for (; i < SUBFRAME_SIZE; ++i)
+        y[i] = clamp_s16(y[i] + ((x[i] * gains[i]) >> 15));
+}
+
 static void mix_subframes(int16_t *y, const int16_t *x, int16_t hgain)
 {
-    unsigned int i;
+    unsigned int i = 0;
+
+#ifdef HLE_SIMD
+    const v16x8 g = v_set1(hgain);
 
-    for (i = 0; i < SUBFRAME_SIZE; ++i)
+    for (; i < SUBFRAME_SIZE; i += 8)
+        v_store(y + i, v_mix_round(v_load(y + i), v_load(x + i), g));
+#endif
+
+    for (; i < SUBFRAME_SIZE; ++i)
         mix_samples(&y[i], x[i], hgain);
 }
 
 static void mix_fir4(int16_t *y, const int16_t *x, int16_t hgain, const int16_t *hcoeffs)
 {
-    unsigned int i;
+    unsigned int i = 0;
     int32_t h[4];
 
     h[0] = (hgain * hcoeffs[0]) >> 15;
@@ -902,7 +955,23 @@ static void mix_fir4(int16_t *y, const int16_t *x, int16_t hgain, const int16_t
     h[2] = (hgain * hcoeffs[2]) >> 15;
     h[3] = (hgain * hcoeffs[3]) >> 15;
 
-    for (i = 0; i < SUBFRAME_SIZE; ++i) {
+#ifdef HLE_SIMD
+    /* the taps only leave the 16-bit range for hgain = hcoeff = -32768 */
+    if (h[0] == (int16_t)h[0] && h[1] == (int16_t)h[1] &&
+        h[2] == (int16_t)h[2] && h[3] == (int16_t)h[3]) {
+        v16x8 vh[4];
+
+        vh[0] = v_set1(h[0]);
+        vh[1] = v_set1(h[1]);
+        vh[2] = v_set1(h[2]);
+        vh[3] = v_set1(h[3]);
+
+        for (; i < SUBFRAME_SIZE; i += 8)
+            v_store(y + i, v_fir4(v_load(y + i), x + i, vh));
+    }
+#endif
+
+    for (; i < SUBFRAME_SIZE; ++i) {
         int32_t v = (h[0] * x[i] + h[1] * x[i + 1] + h[2] * x[i + 2] + h[3] * x[i + 3]) >> 15;
         y[i] = clamp_s16(y[i] + v);
     }
@@ -927,6 +996,7 @@ static void interleave_stage_v1(struct hle_t* hle, musyx_t *musyx, uint32_t outp
     left  = musyx->left;
     right = musyx->right;
     dst  = dram_u32(hle, output_ptr);
+    mark_dram_written(hle, output_ptr, SUBFRAME_SIZE * 4);
 
     for (i = 0; i < SUBFRAME_SIZE; ++i) {
         uint16_t l = clamp_s16(*(left++)  + base_left);
@@ -977,6 +1047,7 @@ static void interleave_stage_v2(struct hle_t* hle, musyx_t *musyx,
 
     /* interleave L_total and R_total */
     dst = dram_u32(hle, output_ptr);
+    mark_dram_written(hle, output_ptr, SUBFRAME_SIZE * 4);
     for(i = 0; i < SUBFRAME_SIZE; ++i) {
         uint16_t l = musyx->left[i];
         uint16_t r = musyx->right[i];
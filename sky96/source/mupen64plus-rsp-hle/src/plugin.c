@@ -76,6 +76,7 @@ static m64p_dynlib_handle l_RspFallback;
 static ptr_InitiateRSP l_InitiateRSP = NULL;
 static ptr_DoRspCycles l_DoRspCycles = NULL;
 static ptr_RomClosed l_RomClosed = NULL;
+static ptr_GetRdramWrites l_GetRdramWrites = NULL;
 static ptr_PluginShutdown l_PluginShutdown = NULL;
 
 /* definitions of pointers to Core functions */
@@ -105,6 +106,7 @@ static void teardown_rsp_fallback()
     l_DoRspCycles = NULL;
     l_InitiateRSP = NULL;
     l_RomClosed = NULL;
+    l_GetRdramWrites = NULL;
     l_PluginShutdown = NULL;
 }
 
@@ -172,6 +174,9 @@ static void setup_rsp_fallback(const char* rsp_fallback_path)
         goto close_handle;
     }
 
+    /* optional functions */
+    l_GetRdramWrites = (ptr_GetRdramWrites) osal_dynlib_getproc(handle, "GetRdramWrites");
+
     /* call the plugin's initialization function and make sure it starts okay */
     if ((*PluginStartup)(l_CoreHandle, l_DebugCallContext, l_DebugCallback) != M64ERR_SUCCESS) {
         HleErrorMessage(NULL, "Error: %s plugin library '%s' failed to start.", plugin_name, rsp_fallback_path);
@@ -279,6 +284,11 @@ int HleForwardTask(void* user_defined)
         return -1;
 
     (*l_DoRspCycles)(-1);
+
+    /* the fallback writes RDRAM on its own */
+    if (l_GetRdramWrites == NULL || !(*l_GetRdramWrites)(g_hle.dram_written, HLE_DRAM_PAGES / 32))
+        g_hle.dram_written_unknown = 1;
+
     return 0;
 }
 
@@ -470,6 +480,19 @@ EXPORT void CALL InitiateRSP(RSP_INFO Rsp_Info, unsigned int* CycleCount)
     }
 }
 
+EXPORT int CALL GetRdramWrites(unsigned int* Pages, unsigned int Count)
+{
+    unsigned int i;
+    int known = !g_hle.dram_written_unknown;
+
+    for (i = 0; i < Count && i < HLE_DRAM_PAGES / 32; ++i)
+        Pages[i] |= g_hle.dram_written[i];
+
+    memset(g_hle.dram_written, 0, sizeof(g_hle.dram_written));
+    g_hle.dram_written_unknown = 0;
+    return known;
+}
+
 EXPORT void CALL RomClosed(void)
 {
     g_hle.cached_ucodes.count = 0;
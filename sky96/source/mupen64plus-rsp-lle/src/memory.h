@@ -0,0 +1,105 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - memory.h                                        *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+#ifdef M64P_BIG_ENDIAN
+#define S 0
+#define S16 0
+#define S8 0
+#else
+#define S 1
+#define S16 2
+#define S8 3
+#endif
+
+enum {
+    TASK_TYPE               = 0xfc0,
+    TASK_UCODE_BOOT_SIZE    = 0xfcc,
+    TASK_UCODE              = 0xfd0
+};
+
+/* SP memory (DMEM or IMEM) is an array of native 32-bit words, like RDRAM.
+ * Scalar loads and stores may be unaligned and wrap around at 4KB. */
+static inline uint8_t* sp_u8(unsigned char* mem, uint32_t address)
+{
+    return (uint8_t*)(mem + ((address & 0xfff) ^ S8));
+}
+
+static inline uint32_t sp_read8(unsigned char* mem, uint32_t address)
+{
+    return *sp_u8(mem, address);
+}
+
+static inline uint32_t sp_read16(unsigned char* mem, uint32_t address)
+{
+    if ((address & 1) == 0)
+        return *(uint16_t*)(mem + ((address & 0xffe) ^ S16));
+
+    return (*sp_u8(mem, address) << 8) | *sp_u8(mem, address + 1);
+}
+
+static inline uint32_t sp_read32(unsigned char* mem, uint32_t address)
+{
+    if ((address & 3) == 0)
+        return *(uint32_t*)(mem + (address & 0xffc));
+
+    return ((uint32_t)*sp_u8(mem, address) << 24)
+         | (*sp_u8(mem, address + 1) << 16)
+         | (*sp_u8(mem, address + 2) << 8)
+         | *sp_u8(mem, address + 3);
+}
+
+static inline void sp_write8(unsigned char* mem, uint32_t address, uint32_t value)
+{
+    *sp_u8(mem, address) = (uint8_t)value;
+}
+
+static inline void sp_write16(unsigned char* mem, uint32_t address, uint32_t value)
+{
+    if ((address & 1) == 0) {
+        *(uint16_t*)(mem + ((address & 0xffe) ^ S16)) = (uint16_t)value;
+        return;
+    }
+
+    *sp_u8(mem, address) = (uint8_t)(value >> 8);
+    *sp_u8(mem, address + 1) = (uint8_t)value;
+}
+
+static inline void sp_write32(unsigned char* mem, uint32_t address, uint32_t value)
+{
+    if ((address & 3) == 0) {
+        *(uint32_t*)(mem + (address & 0xffc)) = value;
+        return;
+    }
+
+    *sp_u8(mem, address) = (uint8_t)(value >> 24);
+    *sp_u8(mem, address + 1) = (uint8_t)(value >> 16);
+    *sp_u8(mem, address + 2) = (uint8_t)(value >> 8);
+    *sp_u8(mem, address + 3) = (uint8_t)value;
+}
+
+#endif
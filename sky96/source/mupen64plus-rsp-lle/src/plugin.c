@@ -0,0 +1,331 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - plugin.c                                         *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "rsp.h"
+#include "rsp_internal.h"
+#include "rsp_external.h"
+
+#define M64P_PLUGIN_PROTOTYPES 1
+#include "m64p_common.h"
+#include "m64p_config.h"
+#include "m64p_frontend.h"
+#include "m64p_plugin.h"
+#include "m64p_types.h"
+
+#include "osal_dynamiclib.h"
+
+#define CONFIG_API_VERSION       0x020100
+#define CONFIG_PARAM_VERSION     1.00
+
+#define RSP_LLE_VERSION        0x020600
+#define RSP_PLUGIN_API_VERSION 0x020000
+
+#define RSP_LLE_CONFIG_SECTION "Rsp-LLE"
+#define RSP_LLE_CONFIG_VERSION "Version"
+#define RSP_LLE_CONFIG_HLE_GFX  "DisplayListToGraphicsPlugin"
+#define RSP_LLE_CONFIG_HLE_AUD  "AudioListToAudioPlugin"
+
+
+#define VERSION_PRINTF_SPLIT(x) (((x) >> 16) & 0xffff), (((x) >> 8) & 0xff), ((x) & 0xff)
+
+/* local variables */
+static struct rsp_t g_rsp;
+static void (*l_CheckInterrupts)(void) = NULL;
+static void (*l_ProcessDlistList)(void) = NULL;
+static void (*l_ProcessAlistList)(void) = NULL;
+static void (*l_ProcessRdpList)(void) = NULL;
+static void (*l_DebugCallback)(void *, int, const char *) = NULL;
+static void *l_DebugCallContext = NULL;
+static int l_PluginInit = 0;
+
+static m64p_handle l_ConfigRspLle;
+
+/* definitions of pointers to Core functions */
+static ptr_ConfigOpenSection      ConfigOpenSection = NULL;
+static ptr_ConfigDeleteSection    ConfigDeleteSection = NULL;
+static ptr_ConfigSetParameter     ConfigSetParameter = NULL;
+static ptr_ConfigGetParameter     ConfigGetParameter = NULL;
+static ptr_ConfigSetDefaultFloat  ConfigSetDefaultFloat = NULL;
+static ptr_ConfigSetDefaultBool   ConfigSetDefaultBool = NULL;
+static ptr_ConfigGetParamBool     ConfigGetParamBool = NULL;
+
+/* local function */
+static void DebugMessage(int level, const char *message, va_list args)
+{
+    char msgbuf[1024];
+
+    if (l_DebugCallback == NULL)
+        return;
+
+    vsprintf(msgbuf, message, args);
+
+    (*l_DebugCallback)(l_DebugCallContext, level, msgbuf);
+}
+
+/* Global functions needed by LLE core */
+void RspVerboseMessage(void* UNUSED(user_defined), const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    DebugMessage(M64MSG_VERBOSE, message, args);
+    va_end(args);
+}
+
+void RspInfoMessage(void* UNUSED(user_defined), const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    DebugMessage(M64MSG_INFO, message, args);
+    va_end(args);
+}
+
+void RspErrorMessage(void* UNUSED(user_defined), const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    DebugMessage(M64MSG_ERROR, message, args);
+    va_end(args);
+}
+
+void RspWarnMessage(void* UNUSED(user_defined), const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    DebugMessage(M64MSG_WARNING, message, args);
+    va_end(args);
+}
+
+void RspCheckInterrupts(void* UNUSED(user_defined))
+{
+    if (l_CheckInterrupts == NULL)
+        return;
+
+    (*l_CheckInterrupts)();
+}
+
+void RspProcessDlistList(void* UNUSED(user_defined))
+{
+    if (l_ProcessDlistList == NULL)
+        return;
+
+    (*l_ProcessDlistList)();
+}
+
+void RspProcessAlistList(void* UNUSED(user_defined))
+{
+    if (l_ProcessAlistList == NULL)
+        return;
+
+    (*l_ProcessAlistList)();
+}
+
+void RspProcessRdpList(void* UNUSED(user_defined))
+{
+    if (l_ProcessRdpList == NULL)
+        return;
+
+    (*l_ProcessRdpList)();
+}
+
+
+/* DLL-exported functions */
+EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle CoreLibHandle, void *Context,
+                                     void (*DebugCallback)(void *, int, const char *))
+{
+    ptr_CoreGetAPIVersions CoreAPIVersionFunc;
+    int ConfigAPIVersion, DebugAPIVersion, VidextAPIVersion;
+    float fConfigParamsVersion = 0.0f;
+
+    if (l_PluginInit)
+        return M64ERR_ALREADY_INIT;
+
+    /* first thing is to set the callback function for debug info */
+    l_DebugCallback = DebugCallback;
+    l_DebugCallContext = Context;
+
+    /* attach and call the CoreGetAPIVersions function, check Config API version for compatibility */
+    CoreAPIVersionFunc = (ptr_CoreGetAPIVersions) osal_dynlib_getproc(CoreLibHandle, "CoreGetAPIVersions");
+    if (CoreAPIVersionFunc == NULL)
+    {
+        RspErrorMessage(NULL, "Core emulator broken; no CoreAPIVersionFunc() function found.");
+        return M64ERR_INCOMPATIBLE;
+    }
+
+    (*CoreAPIVersionFunc)(&ConfigAPIVersion, &DebugAPIVersion, &VidextAPIVersion, NULL);
+    if ((ConfigAPIVersion & 0xffff0000) != (CONFIG_API_VERSION & 0xffff0000))
+    {
+        RspErrorMessage(NULL, "Emulator core Config API (v%i.%i.%i) incompatible with plugin (v%i.%i.%i)",
+                VERSION_PRINTF_SPLIT(ConfigAPIVersion), VERSION_PRINTF_SPLIT(CONFIG_API_VERSION));
+        return M64ERR_INCOMPATIBLE;
+    }
+
+    /* Get the core config function pointers from the library handle */
+    ConfigOpenSection = (ptr_ConfigOpenSection) osal_dynlib_getproc(CoreLibHandle, "ConfigOpenSection");
+    ConfigDeleteSection = (ptr_ConfigDeleteSection) osal_dynlib_getproc(CoreLibHandle, "ConfigDeleteSection");
+    ConfigSetParameter = (ptr_ConfigSetParameter) osal_dynlib_getproc(CoreLibHandle, "ConfigSetParameter");
+    ConfigGetParameter = (ptr_ConfigGetParameter) osal_dynlib_getproc(CoreLibHandle, "ConfigGetParameter");
+    ConfigSetDefaultFloat = (ptr_ConfigSetDefaultFloat) osal_dynlib_getproc(CoreLibHandle, "ConfigSetDefaultFloat");
+    ConfigSetDefaultBool = (ptr_ConfigSetDefaultBool) osal_dynlib_getproc(CoreLibHandle, "ConfigSetDefaultBool");
+    ConfigGetParamBool = (ptr_ConfigGetParamBool) osal_dynlib_getproc(CoreLibHandle, "ConfigGetParamBool");
+
+    if (!ConfigOpenSection || !ConfigDeleteSection || !ConfigSetParameter || !ConfigGetParameter ||
+        !ConfigSetDefaultFloat || !ConfigSetDefaultBool || !ConfigGetParamBool)
+        return M64ERR_INCOMPATIBLE;
+
+    /* get a configuration section handle */
+    if (ConfigOpenSection(RSP_LLE_CONFIG_SECTION, &l_ConfigRspLle) != M64ERR_SUCCESS)
+    {
+        RspErrorMessage(NULL, "Couldn't open config section '" RSP_LLE_CONFIG_SECTION "'");
+        return M64ERR_INPUT_NOT_FOUND;
+    }
+
+    /* check the section version number */
+    if (ConfigGetParameter(l_ConfigRspLle, RSP_LLE_CONFIG_VERSION, M64TYPE_FLOAT, &fConfigParamsVersion, sizeof(float)) != M64ERR_SUCCESS)
+    {
+        RspWarnMessage(NULL, "No version number in '" RSP_LLE_CONFIG_SECTION "' config section. Setting defaults.");
+        ConfigDeleteSection(RSP_LLE_CONFIG_SECTION);
+        ConfigOpenSection(RSP_LLE_CONFIG_SECTION, &l_ConfigRspLle);
+    }
+    else if (((int) fConfigParamsVersion) != ((int) CONFIG_PARAM_VERSION))
+    {
+        RspWarnMessage(NULL, "Incompatible version %.2f in '" RSP_LLE_CONFIG_SECTION "' config section: current is %.2f. Setting defaults.", fConfigParamsVersion, (float) CONFIG_PARAM_VERSION);
+        ConfigDeleteSection(RSP_LLE_CONFIG_SECTION);
+        ConfigOpenSection(RSP_LLE_CONFIG_SECTION, &l_ConfigRspLle);
+    }
+    else if ((CONFIG_PARAM_VERSION - fConfigParamsVersion) >= 0.0001f)
+    {
+        /* handle upgrades */
+        float fVersion = CONFIG_PARAM_VERSION;
+        ConfigSetParameter(l_ConfigRspLle, "Version", M64TYPE_FLOAT, &fVersion);
+        RspInfoMessage(NULL, "Updating parameter set version in '" RSP_LLE_CONFIG_SECTION "' config section to %.2f", fVersion);
+    }
+
+    /* set the default values for this plugin */
+    ConfigSetDefaultFloat(l_ConfigRspLle, RSP_LLE_CONFIG_VERSION, CONFIG_PARAM_VERSION,
+        "Mupen64Plus RSP LLE Plugin config parameter version number");
+    ConfigSetDefaultBool(l_ConfigRspLle, RSP_LLE_CONFIG_HLE_GFX, 1,
+        "Send display lists to the graphics plugin");
+    ConfigSetDefaultBool(l_ConfigRspLle, RSP_LLE_CONFIG_HLE_AUD, 0,
+        "Send audio lists to the audio plugin");
+
+    l_PluginInit = 1;
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL PluginShutdown(void)
+{
+    if (!l_PluginInit)
+        return M64ERR_NOT_INIT;
+
+    /* reset some local variable */
+    l_DebugCallback = NULL;
+    l_DebugCallContext = NULL;
+
+    l_PluginInit = 0;
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL PluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion, int *APIVersion, const char **PluginNamePtr, int *Capabilities)
+{
+    /* set version info */
+    if (PluginType != NULL)
+        *PluginType = M64PLUGIN_RSP;
+
+    if (PluginVersion != NULL)
+        *PluginVersion = RSP_LLE_VERSION;
+
+    if (APIVersion != NULL)
+        *APIVersion = RSP_PLUGIN_API_VERSION;
+
+    if (PluginNamePtr != NULL)
+        *PluginNamePtr = "Sky96 Low-Level Emulation RSP Plugin";
+
+    if (Capabilities != NULL)
+        *Capabilities = 0;
+
+    return M64ERR_SUCCESS;
+}
+
+EXPORT unsigned int CALL DoRspCycles(unsigned int Cycles)
+{
+    rsp_execute(&g_rsp);
+    return Cycles;
+}
+
+EXPORT void CALL InitiateRSP(RSP_INFO Rsp_Info, unsigned int* UNUSED(CycleCount))
+{
+    rsp_init(&g_rsp,
+             Rsp_Info.RDRAM,
+             Rsp_Info.DMEM,
+             Rsp_Info.IMEM,
+             Rsp_Info.MI_INTR_REG,
+             Rsp_Info.SP_MEM_ADDR_REG,
+             Rsp_Info.SP_DRAM_ADDR_REG,
+             Rsp_Info.SP_RD_LEN_REG,
+             Rsp_Info.SP_WR_LEN_REG,
+             Rsp_Info.SP_STATUS_REG,
+             Rsp_Info.SP_DMA_FULL_REG,
+             Rsp_Info.SP_DMA_BUSY_REG,
+             Rsp_Info.SP_PC_REG,
+             Rsp_Info.SP_SEMAPHORE_REG,
+             Rsp_Info.DPC_START_REG,
+             Rsp_Info.DPC_END_REG,
+             Rsp_Info.DPC_CURRENT_REG,
+             Rsp_Info.DPC_STATUS_REG,
+             Rsp_Info.DPC_CLOCK_REG,
+             Rsp_Info.DPC_BUFBUSY_REG,
+             Rsp_Info.DPC_PIPEBUSY_REG,
+             Rsp_Info.DPC_TMEM_REG,
+             NULL);
+
+    l_CheckInterrupts = Rsp_Info.CheckInterrupts;
+    l_ProcessDlistList = Rsp_Info.ProcessDlistList;
+    l_ProcessAlistList = Rsp_Info.ProcessAlistList;
+    l_ProcessRdpList = Rsp_Info.ProcessRdpList;
+
+    g_rsp.hle_gfx = ConfigGetParamBool(l_ConfigRspLle, RSP_LLE_CONFIG_HLE_GFX);
+    g_rsp.hle_aud = ConfigGetParamBool(l_ConfigRspLle, RSP_LLE_CONFIG_HLE_AUD);
+}
+
+EXPORT int CALL GetRdramWrites(unsigned int* Pages, unsigned int Count)
+{
+    unsigned int i;
+
+    for (i = 0; i < Count && i < RSP_DRAM_PAGES / 32; ++i)
+        Pages[i] |= g_rsp.dram_written[i];
+
+    memset(g_rsp.dram_written, 0, sizeof(g_rsp.dram_written));
+    return 1;
+}
+
+EXPORT void CALL RomClosed(void)
+{
+    /* registers and pending waits belong to the previous game */
+    memset(g_rsp.r, 0, sizeof(g_rsp.r));
+    memset(&g_rsp.vu, 0, sizeof(g_rsp.vu));
+    g_rsp.waiting = 0;
+}
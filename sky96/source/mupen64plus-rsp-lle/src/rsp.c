@@ -0,0 +1,314 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - rsp.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "memory.h"
+#include "rsp.h"
+#include "rsp_external.h"
+#include "rsp_internal.h"
+
+/* DPC status bits an RDP which completes every list at once reports as
+ * clear: tmem / pipe / cmd / dma busy, end and start valid */
+#define DPC_STATUS_BUSY_MASK       0x770
+#define DPC_STATUS_CBUF_READY      0x080
+
+/* local functions */
+static bool is_task(struct rsp_t* rsp)
+{
+    return (sp_read32(rsp->dmem, TASK_UCODE_BOOT_SIZE) <= 0x1000);
+}
+
+static void send_alist_to_audio_plugin(struct rsp_t* rsp)
+{
+    RspProcessAlistList(rsp->user_defined);
+    rsp_break(rsp, SP_STATUS_TASKDONE);
+}
+
+static void send_dlist_to_gfx_plugin(struct rsp_t* rsp)
+{
+    /* same protocol as the hle plugin: the bits are set before calling
+     * ProcessDlistList and the GFX plugin may unset them */
+    *rsp->sp_status |= SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT;
+
+    RspProcessDlistList(rsp->user_defined);
+
+    if ((*rsp->sp_status & SP_STATUS_INTR_ON_BREAK) && (*rsp->sp_status & (SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT))) {
+        *rsp->mi_intr |= MI_INTR_SP;
+        RspCheckInterrupts(rsp->user_defined);
+    }
+}
+
+static void mark_dram_written(struct rsp_t* rsp, uint32_t address, unsigned int length)
+{
+    uint32_t page = (address & 0x7fffff) >> RSP_DRAM_PAGE_SHIFT;
+    uint32_t last = ((address + length - 1) & 0x7fffff) >> RSP_DRAM_PAGE_SHIFT;
+
+    for (;;) {
+        rsp->dram_written[page >> 5] |= UINT32_C(1) << (page & 31);
+        if (page == last)
+            break;
+        page = (page + 1) & (RSP_DRAM_PAGES - 1);
+    }
+}
+
+/* same transfer as the core's SP DMA, done at once: length, count and skip
+ * are packed in the length register, both addresses are 8-byte aligned, so
+ * whole native words can be copied */
+static void do_dma(struct rsp_t* rsp, uint32_t l, bool to_dram)
+{
+    unsigned int length = ((l & 0xfff) | 7) + 1;
+    unsigned int count = ((l >> 12) & 0xff) + 1;
+    unsigned int skip = (l >> 20) & 0xfff;
+
+    unsigned int memaddr = *rsp->sp_mem_addr & 0xff8;
+    unsigned int dramaddr = *rsp->sp_dram_addr & 0xfffff8;
+
+    uint32_t* spmem = (uint32_t*)((*rsp->sp_mem_addr & 0x1000) ? rsp->imem : rsp->dmem);
+    uint32_t* dram = (uint32_t*)rsp->dram;
+    unsigned int i, j;
+
+    for (j = 0; j < count; ++j) {
+        if (to_dram)
+            mark_dram_written(rsp, dramaddr, length);
+
+        for (i = 0; i < length; i += 4) {
+            if (to_dram)
+                dram[(dramaddr & 0x7fffff) >> 2] = spmem[(memaddr & 0xfff) >> 2];
+            else
+                spmem[(memaddr & 0xfff) >> 2] = dram[(dramaddr & 0x7fffff) >> 2];
+
+            memaddr += 4;
+            dramaddr += 4;
+        }
+        dramaddr += skip;
+    }
+
+    *rsp->sp_mem_addr = memaddr & 0xfff;
+    *rsp->sp_dram_addr = dramaddr & 0xffffff;
+    *rsp->sp_rd_length = 0xff8;
+    *rsp->sp_wr_length = 0xff8;
+}
+
+static void update_sp_status(struct rsp_t* rsp, uint32_t w)
+{
+    unsigned int i;
+
+    /* clear / set halt */
+    if ((w & 0x3) == 0x1) *rsp->sp_status &= ~SP_STATUS_HALT;
+    if ((w & 0x3) == 0x2) {
+        *rsp->sp_status |= SP_STATUS_HALT;
+        rsp->stop = 1;
+    }
+
+    /* clear broke */
+    if (w & 0x4) *rsp->sp_status &= ~SP_STATUS_BROKE;
+
+    /* clear / set SP interrupt */
+    if ((w & 0x18) == 0x8) {
+        *rsp->mi_intr &= ~MI_INTR_SP;
+        RspCheckInterrupts(rsp->user_defined);
+    }
+    if ((w & 0x18) == 0x10) {
+        *rsp->mi_intr |= MI_INTR_SP;
+        RspCheckInterrupts(rsp->user_defined);
+    }
+
+    /* clear / set single step, interrupt on break and signals 0 to 7, each
+     * one being a clear bit and a set bit */
+    for (i = 0; i < 10; ++i) {
+        uint32_t clr = 0x20u << (2 * i);
+        uint32_t bit = 0x20u << i;
+
+        if ((w & (3 * clr)) == clr) *rsp->sp_status &= ~bit;
+        if ((w & (3 * clr)) == 2 * clr) *rsp->sp_status |= bit;
+    }
+}
+
+static void update_dpc_status(struct rsp_t* rsp, uint32_t w)
+{
+    /* clear / set xbus_dmem_dma, freeze and flush */
+    if (w & 0x01) *rsp->dpc_status &= ~0x1;
+    if (w & 0x02) *rsp->dpc_status |= 0x1;
+    if (w & 0x04) *rsp->dpc_status &= ~0x2;
+    if (w & 0x08) *rsp->dpc_status |= 0x2;
+    if (w & 0x10) *rsp->dpc_status &= ~0x4;
+    if (w & 0x20) *rsp->dpc_status |= 0x4;
+
+    /* clear clock counter */
+    if (w & 0x200) *rsp->dpc_clock = 0;
+}
+
+/* Global functions */
+void rsp_init(struct rsp_t* rsp,
+    unsigned char* dram,
+    unsigned char* dmem,
+    unsigned char* imem,
+    unsigned int* mi_intr,
+    unsigned int* sp_mem_addr,
+    unsigned int* sp_dram_addr,
+    unsigned int* sp_rd_length,
+    unsigned int* sp_wr_length,
+    unsigned int* sp_status,
+    unsigned int* sp_dma_full,
+    unsigned int* sp_dma_busy,
+    unsigned int* sp_pc,
+    unsigned int* sp_semaphore,
+    unsigned int* dpc_start,
+    unsigned int* dpc_end,
+    unsigned int* dpc_current,
+    unsigned int* dpc_status,
+    unsigned int* dpc_clock,
+    unsigned int* dpc_bufbusy,
+    unsigned int* dpc_pipebusy,
+    unsigned int* dpc_tmem,
+    void* user_defined)
+{
+    rsp->dram         = dram;
+    rsp->dmem         = dmem;
+    rsp->imem         = imem;
+    rsp->mi_intr      = mi_intr;
+    rsp->sp_mem_addr  = sp_mem_addr;
+    rsp->sp_dram_addr = sp_dram_addr;
+    rsp->sp_rd_length = sp_rd_length;
+    rsp->sp_wr_length = sp_wr_length;
+    rsp->sp_status    = sp_status;
+    rsp->sp_dma_full  = sp_dma_full;
+    rsp->sp_dma_busy  = sp_dma_busy;
+    rsp->sp_pc        = sp_pc;
+    rsp->sp_semaphore = sp_semaphore;
+    rsp->dpc_start    = dpc_start;
+    rsp->dpc_end      = dpc_end;
+    rsp->dpc_current  = dpc_current;
+    rsp->dpc_status   = dpc_status;
+    rsp->dpc_clock    = dpc_clock;
+    rsp->dpc_bufbusy  = dpc_bufbusy;
+    rsp->dpc_pipebusy = dpc_pipebusy;
+    rsp->dpc_tmem     = dpc_tmem;
+    rsp->user_defined = user_defined;
+
+    vu_init_tables();
+}
+
+void rsp_execute(struct rsp_t* rsp)
+{
+    /* a task resumed after waiting for the CPU has to go on running here,
+     * whatever its ucode left in the task header */
+    if (!rsp->waiting && is_task(rsp)) {
+        uint32_t type = sp_read32(rsp->dmem, TASK_TYPE);
+
+        if (type == 1 && rsp->hle_gfx) {
+            send_dlist_to_gfx_plugin(rsp);
+            return;
+        }
+
+        if (type == 2 && rsp->hle_aud) {
+            send_alist_to_audio_plugin(rsp);
+            return;
+        }
+    }
+
+    su_run(rsp);
+}
+
+void rsp_break(struct rsp_t* rsp, unsigned int setbits)
+{
+    *rsp->sp_status |= setbits | SP_STATUS_BROKE | SP_STATUS_HALT;
+    rsp->stop = 1;
+
+    if ((*rsp->sp_status & SP_STATUS_INTR_ON_BREAK)) {
+        *rsp->mi_intr |= MI_INTR_SP;
+        RspCheckInterrupts(rsp->user_defined);
+    }
+}
+
+uint32_t rsp_mfc0(struct rsp_t* rsp, unsigned int reg)
+{
+    uint32_t value;
+
+    switch (reg & 15) {
+    case 0: return *rsp->sp_mem_addr;
+    case 1: return *rsp->sp_dram_addr;
+    case 2: return *rsp->sp_rd_length;
+    case 3: return *rsp->sp_wr_length;
+    case 4: return *rsp->sp_status;
+    /* DMAs complete as soon as they are issued */
+    case 5: return 0;
+    case 6: return 0;
+    case 7:
+        value = *rsp->sp_semaphore;
+        *rsp->sp_semaphore = 1;
+        return value;
+    case 8: return *rsp->dpc_start;
+    case 9: return *rsp->dpc_end;
+    case 10: return *rsp->dpc_current;
+    case 11: return (*rsp->dpc_status & ~DPC_STATUS_BUSY_MASK) | DPC_STATUS_CBUF_READY;
+    case 12: return *rsp->dpc_clock;
+    case 13: return *rsp->dpc_bufbusy;
+    case 14: return *rsp->dpc_pipebusy;
+    default: return *rsp->dpc_tmem;
+    }
+}
+
+void rsp_mtc0(struct rsp_t* rsp, unsigned int reg, uint32_t value)
+{
+    switch (reg & 15) {
+    case 0:
+        *rsp->sp_mem_addr = value & 0x1ff8;
+        break;
+    case 1:
+        *rsp->sp_dram_addr = value & 0xfffff8;
+        break;
+    case 2:
+        *rsp->sp_rd_length = value;
+        do_dma(rsp, value, false);
+        break;
+    case 3:
+        *rsp->sp_wr_length = value;
+        do_dma(rsp, value, true);
+        break;
+    case 4:
+        update_sp_status(rsp, value);
+        break;
+    case 7:
+        *rsp->sp_semaphore = 0;
+        break;
+    case 8:
+        *rsp->dpc_start = value & 0xfffff8;
+        *rsp->dpc_current = *rsp->dpc_start;
+        break;
+    case 9:
+        *rsp->dpc_end = value & 0xfffff8;
+        RspProcessRdpList(rsp->user_defined);
+        break;
+    case 11:
+        update_dpc_status(rsp, value);
+        break;
+    default:
+        break;
+    }
+
+    /* the CPU side may have moved on */
+    rsp->poll_count = 0;
+}
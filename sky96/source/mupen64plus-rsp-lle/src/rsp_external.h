@@ -0,0 +1,44 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - rsp_external.h                                   *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef RSP_EXTERNAL_H
+#define RSP_EXTERNAL_H
+
+#if defined(__GNUC__)
+#define ATTR_FMT(fmtpos, attrpos) __attribute__ ((format (printf, fmtpos, attrpos)))
+#else
+#define ATTR_FMT(fmtpos, attrpos)
+#endif
+
+/* users of the lle core are expected to define these functions */
+
+void RspVerboseMessage(void* user_defined, const char *message, ...) ATTR_FMT(2, 3);
+void RspInfoMessage(void* user_defined, const char *message, ...) ATTR_FMT(2, 3);
+void RspErrorMessage(void* user_defined, const char *message, ...) ATTR_FMT(2, 3);
+void RspWarnMessage(void* user_defined, const char *message, ...) ATTR_FMT(2, 3);
+
+void RspCheckInterrupts(void* user_defined);
+void RspProcessDlistList(void* user_defined);
+void RspProcessAlistList(void* user_defined);
+void RspProcessRdpList(void* user_defined);
+
+#endif
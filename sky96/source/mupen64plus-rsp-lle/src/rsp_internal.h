@@ -0,0 +1,103 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - rsp_internal.h                                   *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef RSP_INTERNAL_H
+#define RSP_INTERNAL_H
+
+#include <stdint.h>
+
+#include "vu.h"
+
+/* 4KB pages of the 8MB RDRAM */
+#define RSP_DRAM_PAGE_SHIFT 12
+#define RSP_DRAM_PAGES      (0x800000 >> RSP_DRAM_PAGE_SHIFT)
+
+/* rsp lle internal state - internal usage only */
+struct rsp_t
+{
+    /* scalar and vector units */
+    uint32_t r[32];
+    struct vu_t vu;
+
+    unsigned char* dram;
+    unsigned char* dmem;
+    unsigned char* imem;
+
+    unsigned int* mi_intr;
+
+    unsigned int* sp_mem_addr;
+    unsigned int* sp_dram_addr;
+    unsigned int* sp_rd_length;
+    unsigned int* sp_wr_length;
+    unsigned int* sp_status;
+    unsigned int* sp_dma_full;
+    unsigned int* sp_dma_busy;
+    unsigned int* sp_pc;
+    unsigned int* sp_semaphore;
+
+    unsigned int* dpc_start;
+    unsigned int* dpc_end;
+    unsigned int* dpc_current;
+    unsigned int* dpc_status;
+    unsigned int* dpc_clock;
+    unsigned int* dpc_bufbusy;
+    unsigned int* dpc_pipebusy;
+    unsigned int* dpc_tmem;
+
+    /* for user convenience, this will be passed to "external" functions */
+    void* user_defined;
+
+    int hle_gfx;
+    int hle_aud;
+
+    /* set when the running task halts or has to wait for the CPU */
+    int stop;
+    int waiting;
+
+    /* same MFC0 read over and over: the task waits for the CPU */
+    uint32_t poll_pc;
+    uint32_t poll_value;
+    unsigned int poll_count;
+
+    /* pages written by SP DMAs since the core last asked, see
+     * GetRdramWrites */
+    uint32_t dram_written[RSP_DRAM_PAGES / 32];
+};
+
+/* some mips interface interrupt flags */
+#define MI_INTR_SP                  0x1
+
+/* some rsp status flags */
+#define SP_STATUS_HALT             0x1
+#define SP_STATUS_BROKE            0x2
+#define SP_STATUS_INTR_ON_BREAK    0x40
+#define SP_STATUS_TASKDONE         0x200
+
+/* rsp.c */
+void rsp_break(struct rsp_t* rsp, unsigned int setbits);
+uint32_t rsp_mfc0(struct rsp_t* rsp, unsigned int reg);
+void rsp_mtc0(struct rsp_t* rsp, unsigned int reg, uint32_t value);
+
+/* su.c */
+void su_run(struct rsp_t* rsp);
+
+#endif
@@ -0,0 +1,178 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - su.c                                             *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <stdint.h>
+
+#include "common.h"
+#include "memory.h"
+#include "rsp_internal.h"
+#include "vu.h"
+
+/* consecutive identical reads of one MFC0 before the task is considered to
+ * be spinning on something only the CPU can change */
+#define SU_POLL_LIMIT 0x10000
+
+/* Global functions */
+void su_run(struct rsp_t* rsp)
+{
+    uint32_t* r = rsp->r;
+    unsigned char* dmem = rsp->dmem;
+    uint32_t pc = *rsp->sp_pc & 0xffc;
+    uint32_t npc = (pc + 4) & 0xffc;
+
+    rsp->stop = 0;
+    rsp->waiting = 0;
+    rsp->poll_count = 0;
+
+    while (!rsp->stop) {
+        const uint32_t inst = *(const uint32_t*)(rsp->imem + pc);
+        const uint32_t cur = pc;
+        const unsigned rs = (inst >> 21) & 31;
+        const unsigned rt = (inst >> 16) & 31;
+        const unsigned rd = (inst >> 11) & 31;
+        const uint32_t simm = (uint32_t)(int32_t)(int16_t)inst;
+        const uint32_t target = (cur + 4 + (simm << 2)) & 0xffc;
+        uint32_t value;
+
+        pc = npc;
+        npc = (npc + 4) & 0xffc;
+
+        switch (inst >> 26) {
+        case 0x00: /* SPECIAL */
+            switch (inst & 0x3f) {
+            case 0x00: r[rd] = r[rt] << ((inst >> 6) & 31); break;
+            case 0x02: r[rd] = r[rt] >> ((inst >> 6) & 31); break;
+            case 0x03: r[rd] = (uint32_t)((int32_t)r[rt] >> ((inst >> 6) & 31)); break;
+            case 0x04: r[rd] = r[rt] << (r[rs] & 31); break;
+            case 0x06: r[rd] = r[rt] >> (r[rs] & 31); break;
+            case 0x07: r[rd] = (uint32_t)((int32_t)r[rt] >> (r[rs] & 31)); break;
+            case 0x08: /* JR */
+                npc = r[rs] & 0xffc;
+                break;
+            case 0x09: /* JALR */
+                value = r[rs] & 0xffc;
+                r[rd] = (cur + 8) & 0xffc;
+                npc = value;
+                break;
+            case 0x0d: /* BREAK */
+                rsp_break(rsp, 0);
+                break;
+            case 0x20: case 0x21: r[rd] = r[rs] + r[rt]; break;
+            case 0x22: case 0x23: r[rd] = r[rs] - r[rt]; break;
+            case 0x24: r[rd] = r[rs] & r[rt]; break;
+            case 0x25: r[rd] = r[rs] | r[rt]; break;
+            case 0x26: r[rd] = r[rs] ^ r[rt]; break;
+            case 0x27: r[rd] = ~(r[rs] | r[rt]); break;
+            case 0x2a: r[rd] = (int32_t)r[rs] < (int32_t)r[rt]; break;
+            case 0x2b: r[rd] = r[rs] < r[rt]; break;
+            default: break;
+            }
+            break;
+
+        case 0x01: /* REGIMM: BLTZ, BGEZ, BLTZAL, BGEZAL */
+            value = (rt & 1) ? ((int32_t)r[rs] >= 0) : ((int32_t)r[rs] < 0);
+            if (rt & 0x10)
+                r[31] = (cur + 8) & 0xffc;
+            if (value)
+                npc = target;
+            break;
+
+        case 0x03: /* JAL */
+            r[31] = (cur + 8) & 0xffc;
+            /* fall through */
+        case 0x02: /* J */
+            npc = (inst << 2) & 0xffc;
+            break;
+
+        case 0x04: if (r[rs] == r[rt]) npc = target; break;
+        case 0x05: if (r[rs] != r[rt]) npc = target; break;
+        case 0x06: if ((int32_t)r[rs] <= 0) npc = target; break;
+        case 0x07: if ((int32_t)r[rs] > 0) npc = target; break;
+
+        case 0x08: case 0x09: r[rt] = r[rs] + simm; break;
+        case 0x0a: r[rt] = (int32_t)r[rs] < (int32_t)simm; break;
+        case 0x0b: r[rt] = r[rs] < simm; break;
+        case 0x0c: r[rt] = r[rs] & (inst & 0xffff); break;
+        case 0x0d: r[rt] = r[rs] | (inst & 0xffff); break;
+        case 0x0e: r[rt] = r[rs] ^ (inst & 0xffff); break;
+        case 0x0f: r[rt] = inst << 16; break;
+
+        case 0x10: /* COP0 */
+            if (rs == 0x04) {
+                rsp_mtc0(rsp, rd, r[rt]);
+                break;
+            }
+            if (rs != 0x00)
+                break;
+
+            value = rsp_mfc0(rsp, rd);
+            r[rt] = value;
+
+            if (cur != rsp->poll_pc || value != rsp->poll_value) {
+                rsp->poll_pc = cur;
+                rsp->poll_value = value;
+                rsp->poll_count = 0;
+            }
+            else if (++rsp->poll_count >= SU_POLL_LIMIT) {
+                /* leave SP_STATUS alone, so that the core resumes the task
+                 * here once the CPU has written to it */
+                rsp->waiting = 1;
+                rsp->stop = 1;
+                pc = cur;
+            }
+            break;
+
+        case 0x12: /* COP2 */
+            if (inst & 0x02000000) {
+                vu_execute(&rsp->vu, inst);
+                break;
+            }
+            switch (rs) {
+            case 0x00: r[rt] = vu_mfc2(&rsp->vu, inst); break;
+            case 0x02: r[rt] = vu_cfc2(&rsp->vu, inst); break;
+            case 0x04: vu_mtc2(&rsp->vu, inst, r[rt]); break;
+            case 0x06: vu_ctc2(&rsp->vu, inst, r[rt]); break;
+            default: break;
+            }
+            break;
+
+        case 0x20: r[rt] = (uint32_t)(int32_t)(int8_t)sp_read8(dmem, r[rs] + simm); break;
+        case 0x21: r[rt] = (uint32_t)(int32_t)(int16_t)sp_read16(dmem, r[rs] + simm); break;
+        case 0x23: case 0x27: r[rt] = sp_read32(dmem, r[rs] + simm); break;
+        case 0x24: r[rt] = sp_read8(dmem, r[rs] + simm); break;
+        case 0x25: r[rt] = sp_read16(dmem, r[rs] + simm); break;
+        case 0x28: sp_write8(dmem, r[rs] + simm, r[rt]); break;
+        case 0x29: sp_write16(dmem, r[rs] + simm, r[rt]); break;
+        case 0x2b: sp_write32(dmem, r[rs] + simm, r[rt]); break;
+
+        case 0x32: vu_load(&rsp->vu, dmem, inst, r[rs]); break;
+        case 0x3a: vu_store(&rsp->vu, dmem, inst, r[rs]); break;
+
+        default:
+            break;
+        }
+
+        r[0] = 0;
+    }
+
+    *rsp->sp_pc = pc;
+}
@@ -0,0 +1,843 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - vu.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdint.h>
+
+#include "common.h"
+#include "memory.h"
+#include "vu.h"
+#include "vu_simd.h"
+
+/* reciprocal and inverse square root ROMs used by VRCP and VRSQ */
+static uint16_t rcp_rom[512];
+static uint16_t rsq_rom[512];
+
+#define DMEM8(address) (*sp_u8(dmem, (address)))
+
+/* local functions */
+static unsigned clz32(uint32_t x)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_clz(x);
+#else
+    unsigned n = 0;
+
+    while (!(x & 0x80000000)) {
+        x <<= 1;
+        ++n;
+    }
+
+    return n;
+#endif
+}
+
+static int64_t acc_get(const struct vu_t* vu, unsigned i)
+{
+    uint64_t acc = ((uint64_t)vu->acc_h.u[i] << 32)
+                 | ((uint64_t)vu->acc_m.u[i] << 16)
+                 | vu->acc_l.u[i];
+
+    return (int64_t)(acc << 16) >> 16;
+}
+
+static void acc_put(struct vu_t* vu, unsigned i, int64_t acc)
+{
+    vu->acc_h.u[i] = (uint16_t)((uint64_t)acc >> 32);
+    vu->acc_m.u[i] = (uint16_t)((uint64_t)acc >> 16);
+    vu->acc_l.u[i] = (uint16_t)acc;
+}
+
+static inline void acc_set(struct vu_t* vu, v16 h, v16 m, v16 l)
+{
+    v_st(&vu->acc_h, h);
+    v_st(&vu->acc_m, m);
+    v_st(&vu->acc_l, l);
+}
+
+/* 48-bit acc += h:m:l, wrapping */
+static inline void acc_add(struct vu_t* vu, v16 h, v16 m, v16 l)
+{
+    v16 lo = v_add(v_ld(&vu->acc_l), l);
+    v16 md = v_add(v_ld(&vu->acc_m), m);
+    v16 c0 = v_ltu(lo, l);
+    v16 c1 = v_ltu(md, m);
+
+    /* masks are -1, so subtracting them propagates the carries */
+    md = v_sub(md, c0);
+    c1 = v_or(c1, v_and(c0, v_eq(md, v_zero())));
+
+    acc_set(vu, v_sub(v_add(v_ld(&vu->acc_h), h), c1), md, lo);
+}
+
+/* clamp_s16 of acc bits 47..16: VMULF, VMACF, VMUDH, VMADM, VMADH */
+static inline v16 acc_sclamp(const struct vu_t* vu)
+{
+    return v_sat32(v_ld(&vu->acc_h), v_ld(&vu->acc_m));
+}
+
+/* VMULU, VMACU: 0 when negative, 0xffff when the middle slice overflows */
+static inline v16 acc_uclamp(const struct vu_t* vu)
+{
+    v16 m = v_ld(&vu->acc_m);
+
+    return v_andnot(v_srai(v_ld(&vu->acc_h), 15), v_or(m, v_srai(m, 15)));
+}
+
+/* VMADL, VMADN: low slice when acc bits 47..16 fit 16 bits, 0 or 0xffff
+ * otherwise */
+static inline v16 acc_lclamp(const struct vu_t* vu)
+{
+    v16 h = v_ld(&vu->acc_h);
+    v16 fits = v_eq(h, v_srai(v_ld(&vu->acc_m), 15));
+
+    return v_sel(fits, v_ld(&vu->acc_l), v_not(v_srai(h, 15)));
+}
+
+/* signed * signed * 2, as 48-bit h:m:l */
+static inline void product_f(v16 s, v16 t, v16* h, v16* m, v16* l)
+{
+    v16 lo = v_mullo(s, t);
+    v16 hi = v_mulhi(s, t);
+
+    *l = v_slli(lo, 1);
+    *m = v_or(v_slli(hi, 1), v_srli(lo, 15));
+    *h = v_srai(hi, 15);
+}
+
+/* VMULF, VMULU: acc = s * t * 2 + 0x8000 */
+static inline void vmulf(struct vu_t* vu, v16 s, v16 t)
+{
+    v16 h, m, l, c;
+
+    product_f(s, t, &h, &m, &l);
+
+    c = v_srai(l, 15);
+    l = v_xor(l, v_set1(-0x8000));
+    m = v_sub(m, c);
+    h = v_sub(h, v_and(c, v_eq(m, v_zero())));
+
+    acc_set(vu, h, m, l);
+}
+
+/* signed s * unsigned t (VMUDM, VMADM) */
+static inline v16 mulhi_su(v16 s, v16 t)
+{
+    return v_sub(v_mulhi_u(s, t), v_and(v_srai(s, 15), t));
+}
+
+static int32_t divide(int32_t input, int rsq)
+{
+    int32_t mask = input >> 31;
+    int32_t data = input ^ mask;
+    int32_t result;
+    unsigned shift, index;
+
+    if (input > -32768)
+        data -= mask;
+
+    if (data == 0)
+        return 0x7fffffff;
+
+    if (input == -32768)
+        return (int32_t)0xffff0000;
+
+    shift = clz32((uint32_t)data);
+    index = (((uint32_t)data << shift) & 0x7fc00000) >> 22;
+
+    if (rsq) {
+        result = (0x10000 | rsq_rom[(index & 0x1fe) | (shift & 1)]) << 14;
+        result >>= (31 - shift) >> 1;
+    }
+    else {
+        result = (0x10000 | rcp_rom[index]) << 14;
+        result >>= 31 - shift;
+    }
+
+    return result ^ mask;
+}
+
+/* VRCP, VRCPL, VRSQ, VRSQL */
+static void vdivide(struct vu_t* vu, unsigned vd, unsigned de, int16_t in, int low, int rsq)
+{
+    int32_t input = in;
+    int32_t result;
+
+    if (low && vu->div_dp)
+        input = (int32_t)((uint32_t)(uint16_t)vu->div_in << 16 | (uint16_t)in);
+
+    result = divide(input, rsq);
+
+    vu->div_dp = 0;
+    vu->div_out = (int16_t)(result >> 16);
+    vu->vr[vd].e[de] = (int16_t)result;
+}
+
+static void load_bytes(vreg_t* v, unsigned char* dmem, uint32_t address, unsigned e, unsigned count)
+{
+    unsigned end = e + count;
+    unsigned i;
+
+    if (end > 16)
+        end = 16;
+
+    for (i = e; i < end; ++i)
+        VREG_BYTE(v, i) = DMEM8(address++);
+}
+
+static void store_bytes(const vreg_t* v, unsigned char* dmem, uint32_t address, unsigned e, unsigned count)
+{
+    unsigned i;
+
+    for (i = e; i < e + count; ++i)
+        DMEM8(address++) = VREG_BYTE(v, i);
+}
+
+/* Global functions */
+void vu_init_tables(void)
+{
+    unsigned i;
+
+    for (i = 0; i < 512; ++i) {
+        uint64_t b = ((UINT64_C(1) << 34) / (i + 512) + 1) >> 8;
+        rcp_rom[i] = (uint16_t)(b > 0xffff ? 0xffff : b);
+    }
+
+    for (i = 0; i < 512; ++i) {
+        /* smallest k such that a * k^2 >= 2^44, the ROM holding (k - 1) / 2 */
+        uint64_t a = (i + 512) >> (i & 1);
+        uint64_t lo = 1 << 17, hi = 1 << 19;
+
+        while (lo < hi) {
+            uint64_t k = (lo + hi) / 2;
+
+            if (a * k * k >= (UINT64_C(1) << 44))
+                hi = k;
+            else
+                lo = k + 1;
+        }
+
+        rsq_rom[i] = (uint16_t)((lo - 1) >> 1);
+    }
+}
+
+void vu_execute(struct vu_t* vu, uint32_t inst)
+{
+    const unsigned e = (inst >> 21) & 15;
+    const unsigned vt = (inst >> 16) & 31;
+    const unsigned vs = (inst >> 11) & 31;
+    const unsigned vd = (inst >> 6) & 31;
+
+    const v16 zero = v_zero();
+    const v16 s = v_ld(&vu->vr[vs]);
+    const v16 t = v_elem(v_ld(&vu->vr[vt]), e);
+    v16 h, m, l, r;
+    vreg_t tmp;
+    unsigned i;
+
+    switch (inst & 0x3f) {
+    case 0x00: /* VMULF */
+        vmulf(vu, s, t);
+        r = acc_sclamp(vu);
+        break;
+
+    case 0x01: /* VMULU */
+        vmulf(vu, s, t);
+        r = acc_uclamp(vu);
+        break;
+
+    case 0x02: /* VRNDP */
+    case 0x0a: /* VRNDN */
+        v_st(&tmp, t);
+        for (i = 0; i < 8; ++i) {
+            int64_t acc = acc_get(vu, i);
+            int64_t product = tmp.e[i];
+
+            if (vs & 1)
+                product *= 65536;
+
+            if ((inst & 0x3f) == 0x02 ? acc >= 0 : acc < 0)
+                acc_put(vu, i, acc + product);
+
+            tmp.e[i] = clamp_s16((int32_t)(acc_get(vu, i) >> 16));
+        }
+        r = v_ld(&tmp);
+        break;
+
+    case 0x03: /* VMULQ */
+        v_st(&tmp, s);
+        v_st(&vu->acc_l, zero);
+        v_st(&vu->acc_h, t);
+        for (i = 0; i < 8; ++i) {
+            int32_t product = tmp.e[i] * vu->acc_h.e[i];
+
+            if (product < 0)
+                product += 31;
+
+            vu->acc_h.u[i] = (uint16_t)(product >> 16);
+            vu->acc_m.u[i] = (uint16_t)product;
+            tmp.e[i] = clamp_s16(product >> 1) & ~15;
+        }
+        r = v_ld(&tmp);
+        break;
+
+    case 0x04: /* VMUDL */
+        l = v_mulhi_u(s, t);
+        acc_set(vu, zero, zero, l);
+        r = l;
+        break;
+
+    case 0x05: /* VMUDM */
+        m = mulhi_su(s, t);
+        acc_set(vu, v_srai(m, 15), m, v_mullo(s, t));
+        r = m;
+        break;
+
+    case 0x06: /* VMUDN */
+        m = mulhi_su(t, s);
+        l = v_mullo(s, t);
+        acc_set(vu, v_srai(m, 15), m, l);
+        r = l;
+        break;
+
+    case 0x07: /* VMUDH */
+        h = v_mulhi(s, t);
+        m = v_mullo(s, t);
+        acc_set(vu, h, m, zero);
+        r = v_sat32(h, m);
+        break;
+
+    case 0x08: /* VMACF */
+        product_f(s, t, &h, &m, &l);
+        acc_add(vu, h, m, l);
+        r = acc_sclamp(vu);
+        break;
+
+    case 0x09: /* VMACU */
+        product_f(s, t, &h, &m, &l);
+        acc_add(vu, h, m, l);
+        r = acc_uclamp(vu);
+        break;
+
+    case 0x0b: /* VMACQ */
+        for (i = 0; i < 8; ++i) {
+            int32_t product = (int32_t)((uint32_t)vu->acc_h.u[i] << 16 | vu->acc_m.u[i]);
+
+            if (!(product & 0x20)) {
+                if (product < 0)
+                    product += 32;
+                else if (product >= 32)
+                    product -= 32;
+            }
+
+            vu->acc_h.u[i] = (uint16_t)(product >> 16);
+            vu->acc_m.u[i] = (uint16_t)product;
+            tmp.e[i] = clamp_s16(product >> 1) & ~15;
+        }
+        r = v_ld(&tmp);
+        break;
+
+    case 0x0c: /* VMADL */
+        acc_add(vu, zero, zero, v_mulhi_u(s, t));
+        r = acc_lclamp(vu);
+        break;
+
+    case 0x0d: /* VMADM */
+        m = mulhi_su(s, t);
+        acc_add(vu, v_srai(m, 15), m, v_mullo(s, t));
+        r = acc_sclamp(vu);
+        break;
+
+    case 0x0e: /* VMADN */
+        m = mulhi_su(t, s);
+        acc_add(vu, v_srai(m, 15), m, v_mullo(s, t));
+        r = acc_lclamp(vu);
+        break;
+
+    case 0x0f: /* VMADH */
+        acc_add(vu, v_mulhi(s, t), v_mullo(s, t), zero);
+        r = acc_sclamp(vu);
+        break;
+
+    case 0x10: /* VADD */
+        l = v_srli(v_ld(&vu->vco_c), 15);
+        v_st(&vu->acc_l, v_add(v_add(s, t), l));
+        v_st(&vu->vco_c, zero);
+        v_st(&vu->vco_ne, zero);
+        r = v_add3_sat(s, t, l);
+        break;
+
+    case 0x11: /* VSUB */
+        l = v_srli(v_ld(&vu->vco_c), 15);
+        v_st(&vu->acc_l, v_sub(v_sub(s, t), l));
+        v_st(&vu->vco_c, zero);
+        v_st(&vu->vco_ne, zero);
+        r = v_sub3_sat(s, t, l);
+        break;
+
+    case 0x13: /* VABS */
+        l = v_sign(t, s);
+        v_st(&vu->acc_l, l);
+        r = v_xor(l, v_and(v_srai(s, 15), v_eq(l, v_set1(-0x8000))));
+        break;
+
+    case 0x14: /* VADDC */
+        r = v_add(s, t);
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vco_c, v_ltu(r, s));
+        v_st(&vu->vco_ne, zero);
+        break;
+
+    case 0x15: /* VSUBC */
+        r = v_sub(s, t);
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vco_c, v_ltu(s, t));
+        v_st(&vu->vco_ne, v_not(v_eq(s, t)));
+        break;
+
+    case 0x1d: /* VSAR */
+        switch (e) {
+        case 8: r = v_ld(&vu->acc_h); break;
+        case 9: r = v_ld(&vu->acc_m); break;
+        case 10: r = v_ld(&vu->acc_l); break;
+        default: r = zero; break;
+        }
+        break;
+
+    case 0x20: /* VLT */
+    case 0x21: /* VEQ */
+    case 0x22: /* VNE */
+    case 0x23: /* VGE */
+        m = v_eq(s, t);
+        l = v_and(v_ld(&vu->vco_ne), v_ld(&vu->vco_c));
+
+        switch (inst & 0x3f) {
+        case 0x20: m = v_or(v_lt(s, t), v_and(m, l)); break;
+        case 0x21: m = v_andnot(v_ld(&vu->vco_ne), m); break;
+        case 0x22: m = v_or(v_not(m), v_ld(&vu->vco_ne)); break;
+        default: m = v_or(v_gt(s, t), v_andnot(l, m)); break;
+        }
+
+        r = v_sel(m, s, t);
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vcc_lo, m);
+        v_st(&vu->vcc_hi, zero);
+        v_st(&vu->vco_c, zero);
+        v_st(&vu->vco_ne, zero);
+        break;
+
+    case 0x24: /* VCL */
+    {
+        const v16 c = v_ld(&vu->vco_c);
+        const v16 ne = v_ld(&vu->vco_ne);
+        const v16 sum = v_add(s, t);
+        const v16 carry = v_ltu(sum, s);
+        const v16 sum_zero = v_eq(sum, zero);
+        v16 le = v_sel(v_ld(&vu->vce), v_or(sum_zero, v_not(carry)), v_andnot(carry, sum_zero));
+        v16 ge = v_not(v_ltu(s, t));
+
+        le = v_sel(v_andnot(ne, c), le, v_ld(&vu->vcc_lo));
+        ge = v_sel(v_not(v_or(c, ne)), ge, v_ld(&vu->vcc_hi));
+
+        r = v_sel(c, v_sel(le, v_sub(zero, t), s), v_sel(ge, t, s));
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vcc_lo, le);
+        v_st(&vu->vcc_hi, ge);
+        v_st(&vu->vco_c, zero);
+        v_st(&vu->vco_ne, zero);
+        v_st(&vu->vce, zero);
+        break;
+    }
+
+    case 0x25: /* VCH */
+    {
+        const v16 sign = v_srai(v_xor(s, t), 15);
+        const v16 nt = v_sub(v_xor(t, sign), sign);
+        const v16 diff = v_sub(s, nt);
+        const v16 t_neg = v_srai(t, 15);
+        const v16 ce = v_and(sign, v_eq(diff, v_set1(-1)));
+        const v16 le = v_sel(sign, v_not(v_gt(diff, zero)), t_neg);
+        const v16 ge = v_sel(sign, t_neg, v_not(v_lt(diff, zero)));
+
+        r = v_sel(v_sel(sign, le, ge), nt, s);
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vcc_lo, le);
+        v_st(&vu->vcc_hi, ge);
+        v_st(&vu->vco_c, sign);
+        v_st(&vu->vco_ne, v_not(v_or(v_eq(diff, zero), ce)));
+        v_st(&vu->vce, ce);
+        break;
+    }
+
+    case 0x26: /* VCR */
+    {
+        const v16 sign = v_srai(v_xor(s, t), 15);
+        const v16 le = v_srai(v_add(v_and(s, sign), t), 15);
+        const v16 ge = v_eq(v_min(v_or(s, sign), t), t);
+
+        r = v_sel(v_sel(sign, le, ge), v_xor(t, sign), s);
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vcc_lo, le);
+        v_st(&vu->vcc_hi, ge);
+        v_st(&vu->vco_c, zero);
+        v_st(&vu->vco_ne, zero);
+        v_st(&vu->vce, zero);
+        break;
+    }
+
+    case 0x27: /* VMRG */
+        r = v_sel(v_ld(&vu->vcc_lo), s, t);
+        v_st(&vu->acc_l, r);
+        v_st(&vu->vco_c, zero);
+        v_st(&vu->vco_ne, zero);
+        break;
+
+    case 0x28: /* VAND */
+        r = v_and(s, t);
+        v_st(&vu->acc_l, r);
+        break;
+
+    case 0x29: /* VNAND */
+        r = v_not(v_and(s, t));
+        v_st(&vu->acc_l, r);
+        break;
+
+    case 0x2a: /* VOR */
+        r = v_or(s, t);
+        v_st(&vu->acc_l, r);
+        break;
+
+    case 0x2b: /* VNOR */
+        r = v_not(v_or(s, t));
+        v_st(&vu->acc_l, r);
+        break;
+
+    case 0x2c: /* VXOR */
+        r = v_xor(s, t);
+        v_st(&vu->acc_l, r);
+        break;
+
+    case 0x2d: /* VNXOR */
+        r = v_not(v_xor(s, t));
+        v_st(&vu->acc_l, r);
+        break;
+
+    /* single lane instructions: vs holds the destination element */
+    case 0x30: /* VRCP */
+    case 0x31: /* VRCPL */
+    case 0x34: /* VRSQ */
+    case 0x35: /* VRSQL */
+        v_st(&vu->acc_l, t);
+        vdivide(vu, vd, vs & 7, vu->vr[vt].e[e & 7], inst & 1, inst & 4);
+        return;
+
+    case 0x32: /* VRCPH */
+    case 0x36: /* VRSQH */
+        v_st(&vu->acc_l, t);
+        vu->div_dp = 1;
+        vu->div_in = vu->vr[vt].e[e & 7];
+        vu->vr[vd].e[vs & 7] = vu->div_out;
+        return;
+
+    case 0x33: /* VMOV */
+        v_st(&vu->acc_l, t);
+        vu->vr[vd].e[vs & 7] = vu->acc_l.e[vs & 7];
+        return;
+
+    case 0x37: /* VNOP */
+    case 0x3f: /* VNULL */
+        return;
+
+    default:
+        /* reserved encodings still go through the adder */
+        v_st(&vu->acc_l, v_add(s, t));
+        r = zero;
+        break;
+    }
+
+    v_st(&vu->vr[vd], r);
+}
+
+uint32_t vu_mfc2(const struct vu_t* vu, uint32_t inst)
+{
+    const vreg_t* v = &vu->vr[(inst >> 11) & 31];
+    const unsigned e = (inst >> 7) & 15;
+
+    return (uint32_t)(int32_t)(int16_t)(VREG_BYTE(v, e) << 8 | VREG_BYTE(v, e + 1));
+}
+
+void vu_mtc2(struct vu_t* vu, uint32_t inst, uint32_t value)
+{
+    vreg_t* v = &vu->vr[(inst >> 11) & 31];
+    const unsigned e = (inst >> 7) & 15;
+
+    VREG_BYTE(v, e) = (uint8_t)(value >> 8);
+    if (e < 15)
+        VREG_BYTE(v, e + 1) = (uint8_t)value;
+}
+
+uint32_t vu_cfc2(const struct vu_t* vu, uint32_t inst)
+{
+    switch ((inst >> 11) & 3) {
+    case 0:
+        return (uint32_t)(int32_t)(int16_t)(v_tobits(v_ld(&vu->vco_c)) | v_tobits(v_ld(&vu->vco_ne)) << 8);
+    case 1:
+        return (uint32_t)(int32_t)(int16_t)(v_tobits(v_ld(&vu->vcc_lo)) | v_tobits(v_ld(&vu->vcc_hi)) << 8);
+    default:
+        return v_tobits(v_ld(&vu->vce));
+    }
+}
+
+void vu_ctc2(struct vu_t* vu, uint32_t inst, uint32_t value)
+{
+    switch ((inst >> 11) & 3) {
+    case 0:
+        v_st(&vu->vco_c, v_frombits(value & 0xff));
+        v_st(&vu->vco_ne, v_frombits((value >> 8) & 0xff));
+        break;
+    case 1:
+        v_st(&vu->vcc_lo, v_frombits(value & 0xff));
+        v_st(&vu->vcc_hi, v_frombits((value >> 8) & 0xff));
+        break;
+    default:
+        v_st(&vu->vce, v_frombits(value & 0xff));
+        break;
+    }
+}
+
+void vu_load(struct vu_t* vu, unsigned char* dmem, uint32_t inst, uint32_t base)
+{
+    const unsigned vt = (inst >> 16) & 31;
+    const unsigned e = (inst >> 7) & 15;
+    const int32_t offset = (int32_t)(inst << 25) >> 25;
+    vreg_t* v = &vu->vr[vt];
+    vreg_t tmp;
+    uint32_t address;
+    unsigned i, index, end;
+
+    switch ((inst >> 11) & 31) {
+    case 0x00: /* LBV */
+        VREG_BYTE(v, e) = DMEM8(base + offset);
+        break;
+
+    case 0x01: /* LSV */
+        load_bytes(v, dmem, base + offset * 2, e, 2);
+        break;
+
+    case 0x02: /* LLV */
+        load_bytes(v, dmem, base + offset * 4, e, 4);
+        break;
+
+    case 0x03: /* LDV */
+        load_bytes(v, dmem, base + offset * 8, e, 8);
+        break;
+
+    case 0x04: /* LQV */
+        address = base + offset * 16;
+        if (e == 0 && (address & 15) == 0) {
+            for (i = 0; i < 8; ++i)
+                v->u[i] = (uint16_t)sp_read16(dmem, address + 2 * i);
+            break;
+        }
+        load_bytes(v, dmem, address, e, 16 - (address & 15));
+        break;
+
+    case 0x05: /* LRV */
+        address = base + offset * 16;
+        i = e + 16 - (address & 15);
+        address &= ~15u;
+        for (; i < 16; ++i)
+            VREG_BYTE(v, i) = DMEM8(address++);
+        break;
+
+    case 0x06: /* LPV */
+    case 0x07: /* LUV */
+        address = base + offset * 8;
+        index = (address & 7) - e;
+        address &= ~7u;
+        for (i = 0; i < 8; ++i)
+            v->u[i] = (uint16_t)(DMEM8(address + ((index + i) & 15)) << ((inst & 0x800) ? 7 : 8));
+        break;
+
+    case 0x08: /* LHV */
+        address = base + offset * 16;
+        index = (address & 7) - e;
+        address &= ~7u;
+        for (i = 0; i < 8; ++i)
+            v->u[i] = (uint16_t)(DMEM8(address + ((index + 2 * i) & 15)) << 7);
+        break;
+
+    case 0x09: /* LFV */
+        address = base + offset * 16;
+        index = (address & 7) - e;
+        address &= ~7u;
+        for (i = 0; i < 4; ++i) {
+            tmp.u[i] = (uint16_t)(DMEM8(address + ((index + 4 * i) & 15)) << 7);
+            tmp.u[i + 4] = (uint16_t)(DMEM8(address + ((index + 4 * i + 8) & 15)) << 7);
+        }
+        end = (e + 8 > 16) ? 16 : e + 8;
+        for (i = e; i < end; ++i)
+            VREG_BYTE(v, i) = VREG_BYTE(&tmp, i);
+        break;
+
+    case 0x0b: /* LTV */
+    {
+        uint32_t begin;
+
+        address = base + offset * 16;
+        begin = address & ~7u;
+        address = begin + ((e + (address & 8)) & 15);
+        index = e >> 1;
+
+        for (i = 0; i < 8; ++i) {
+            v = &vu->vr[(vt & ~7u) + index];
+
+            VREG_BYTE(v, 2 * i) = DMEM8(address);
+            if (++address == begin + 16)
+                address = begin;
+            VREG_BYTE(v, 2 * i + 1) = DMEM8(address);
+            if (++address == begin + 16)
+                address = begin;
+
+            index = (index + 1) & 7;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void vu_store(const struct vu_t* vu, unsigned char* dmem, uint32_t inst, uint32_t base)
+{
+    static const int8_t sfv_elements[16][4] = {
+        { 0, 1, 2, 3 }, { 6, 7, 4, 5 }, { -1 }, { -1 },
+        { 1, 2, 3, 0 }, { 7, 4, 5, 6 }, { -1 }, { -1 },
+        { 4, 5, 6, 7 }, { -1 }, { -1 }, { 3, 0, 1, 2 },
+        { 5, 6, 7, 4 }, { -1 }, { -1 }, { 0, 1, 2, 3 },
+    };
+
+    const unsigned vt = (inst >> 16) & 31;
+    const unsigned e = (inst >> 7) & 15;
+    const int32_t offset = (int32_t)(inst << 25) >> 25;
+    const vreg_t* v = &vu->vr[vt];
+    uint32_t address;
+    unsigned i, index;
+
+    switch ((inst >> 11) & 31) {
+    case 0x00: /* SBV */
+        DMEM8(base + offset) = VREG_BYTE(v, e);
+        break;
+
+    case 0x01: /* SSV */
+        store_bytes(v, dmem, base + offset * 2, e, 2);
+        break;
+
+    case 0x02: /* SLV */
+        store_bytes(v, dmem, base + offset * 4, e, 4);
+        break;
+
+    case 0x03: /* SDV */
+        store_bytes(v, dmem, base + offset * 8, e, 8);
+        break;
+
+    case 0x04: /* SQV */
+        address = base + offset * 16;
+        if (e == 0 && (address & 15) == 0) {
+            for (i = 0; i < 8; ++i)
+                sp_write16(dmem, address + 2 * i, v->u[i]);
+            break;
+        }
+        store_bytes(v, dmem, address, e, 16 - (address & 15));
+        break;
+
+    case 0x05: /* SRV */
+        address = base + offset * 16;
+        index = 16 - (address & 15);
+        for (i = e; i < e + (address & 15); ++i)
+            DMEM8((address & ~15u) + i - e) = VREG_BYTE(v, i + index);
+        break;
+
+    case 0x06: /* SPV */
+    case 0x07: /* SUV */
+        address = base + offset * 8;
+        for (i = e; i < e + 8; ++i) {
+            /* SPV packs the upper bytes then the 7-bit fractions, SUV the
+             * other way around */
+            if (((i & 15) < 8) == !(inst & 0x800))
+                DMEM8(address++) = VREG_BYTE(v, (i & 7) << 1);
+            else
+                DMEM8(address++) = (uint8_t)(v->u[i & 7] >> 7);
+        }
+        break;
+
+    case 0x08: /* SHV */
+        address = base + offset * 16;
+        index = address & 7;
+        address &= ~7u;
+        for (i = 0; i < 8; ++i) {
+            unsigned b = e + 2 * i;
+
+            DMEM8(address + (index & 15)) = (uint8_t)(VREG_BYTE(v, b) << 1 | VREG_BYTE(v, b + 1) >> 7);
+            index += 2;
+        }
+        break;
+
+    case 0x09: /* SFV */
+        address = base + offset * 16;
+        index = address & 7;
+        address &= ~7u;
+        for (i = 0; i < 4; ++i) {
+            int element = sfv_elements[e][0] < 0 ? -1 : sfv_elements[e][i];
+
+            DMEM8(address + (index & 15)) = (element < 0) ? 0 : (uint8_t)(v->u[element] >> 7);
+            index += 4;
+        }
+        break;
+
+    case 0x0a: /* SWV */
+        address = base + offset * 16;
+        index = address & 7;
+        address &= ~7u;
+        for (i = e; i < e + 16; ++i)
+            DMEM8(address + (index++ & 15)) = VREG_BYTE(v, i);
+        break;
+
+    case 0x0b: /* STV */
+    {
+        unsigned element = 16 - (e & ~1u);
+        unsigned r;
+
+        address = base + offset * 16;
+        index = (address & 7) - (e & ~1u);
+        address &= ~7u;
+
+        for (r = vt & ~7u; r < (vt & ~7u) + 8; ++r) {
+            DMEM8(address + (index++ & 15)) = VREG_BYTE(&vu->vr[r], element++);
+            DMEM8(address + (index++ & 15)) = VREG_BYTE(&vu->vr[r], element++);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
@@ -0,0 +1,64 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - vu.h                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef VU_H
+#define VU_H
+
+#include <stdint.h>
+
+#include "vu_simd.h"
+
+/* vector unit state. The 48-bit accumulator is kept as three 16-bit
+ * slices, and every flag register as one lane mask per flag bit, so that
+ * all of them live in vector registers too. */
+struct vu_t
+{
+    vreg_t vr[32];
+
+    vreg_t acc_h;
+    vreg_t acc_m;
+    vreg_t acc_l;
+
+    vreg_t vco_c;   /* VCO low byte: carry */
+    vreg_t vco_ne;  /* VCO high byte: not equal */
+    vreg_t vcc_lo;  /* VCC low byte: less than / compare */
+    vreg_t vcc_hi;  /* VCC high byte: clip */
+    vreg_t vce;
+
+    int16_t div_in;
+    int16_t div_out;
+    int div_dp;
+};
+
+void vu_init_tables(void);
+
+/* COP2 computational instructions and moves */
+void vu_execute(struct vu_t* vu, uint32_t inst);
+uint32_t vu_mfc2(const struct vu_t* vu, uint32_t inst);
+void vu_mtc2(struct vu_t* vu, uint32_t inst, uint32_t value);
+uint32_t vu_cfc2(const struct vu_t* vu, uint32_t inst);
+void vu_ctc2(struct vu_t* vu, uint32_t inst, uint32_t value);
+
+/* LWC2 / SWC2, base being the value of the base register */
+void vu_load(struct vu_t* vu, unsigned char* dmem, uint32_t inst, uint32_t base);
+void vu_store(const struct vu_t* vu, unsigned char* dmem, uint32_t inst, uint32_t base);
+
+#endif
@@ -0,0 +1,274 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-lle - vu_simd.h                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Sky96 development team                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef VU_SIMD_H
+#define VU_SIMD_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+/* 8 x 16-bit lane primitives the vector unit is written in. A VU register
+ * maps onto one SSE2 register, element i in lane i. The scalar versions
+ * define the semantics; the SSE2 versions must match them bit for bit.
+ * SSSE3 is only used for the element selector and VABS, and only when the
+ * compiler targets it. Define RSP_NO_SIMD to keep the scalar loops only. */
+#if !defined(RSP_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RSP_SSE2
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define RSP_SSSE3
+#endif
+#endif
+#endif
+
+/* byte swizzle of the big-endian byte view of a vector register */
+#ifdef M64P_BIG_ENDIAN
+#define V8 0
+#else
+#define V8 1
+#endif
+
+static inline int16_t clamp_s16(int32_t x)
+{
+    return (int16_t)(x < -32768 ? -32768 : x > 32767 ? 32767 : x);
+}
+
+typedef union
+{
+    int16_t e[8];
+    uint16_t u[8];
+    uint8_t b[16];
+#ifdef RSP_SSE2
+    __m128i v;
+#endif
+} vreg_t;
+
+#define VREG_BYTE(r, i) ((r)->b[((i) & 15) ^ V8])
+
+#if defined(RSP_SSE2)
+typedef __m128i v16;
+
+static inline v16 v_ld(const vreg_t* r) { return r->v; }
+static inline void v_st(vreg_t* r, v16 a) { r->v = a; }
+static inline v16 v_zero(void) { return _mm_setzero_si128(); }
+static inline v16 v_set1(int16_t x) { return _mm_set1_epi16(x); }
+static inline v16 v_add(v16 a, v16 b) { return _mm_add_epi16(a, b); }
+static inline v16 v_sub(v16 a, v16 b) { return _mm_sub_epi16(a, b); }
+static inline v16 v_and(v16 a, v16 b) { return _mm_and_si128(a, b); }
+static inline v16 v_or(v16 a, v16 b) { return _mm_or_si128(a, b); }
+static inline v16 v_xor(v16 a, v16 b) { return _mm_xor_si128(a, b); }
+static inline v16 v_andnot(v16 a, v16 b) { return _mm_andnot_si128(a, b); }
+static inline v16 v_not(v16 a) { return _mm_xor_si128(a, _mm_set1_epi32(-1)); }
+static inline v16 v_eq(v16 a, v16 b) { return _mm_cmpeq_epi16(a, b); }
+static inline v16 v_lt(v16 a, v16 b) { return _mm_cmplt_epi16(a, b); }
+static inline v16 v_gt(v16 a, v16 b) { return _mm_cmpgt_epi16(a, b); }
+static inline v16 v_min(v16 a, v16 b) { return _mm_min_epi16(a, b); }
+static inline v16 v_srai(v16 a, int n) { return _mm_srai_epi16(a, n); }
+static inline v16 v_srli(v16 a, int n) { return _mm_srli_epi16(a, n); }
+static inline v16 v_slli(v16 a, int n) { return _mm_slli_epi16(a, n); }
+static inline v16 v_mullo(v16 a, v16 b) { return _mm_mullo_epi16(a, b); }
+static inline v16 v_mulhi(v16 a, v16 b) { return _mm_mulhi_epi16(a, b); }
+static inline v16 v_mulhi_u(v16 a, v16 b) { return _mm_mulhi_epu16(a, b); }
+
+static inline v16 v_ltu(v16 a, v16 b)
+{
+    const __m128i bias = _mm_set1_epi16(-0x8000);
+    return _mm_cmplt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+/* m ? a : b, m being a lane mask */
+static inline v16 v_sel(v16 m, v16 a, v16 b)
+{
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+/* clamp_s16((hi << 16) | lo) */
+static inline v16 v_sat32(v16 hi, v16 lo)
+{
+    return _mm_packs_epi32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi));
+}
+
+/* clamp_s16(a + b + c) and clamp_s16(a - b - c), c being 0 or 1 */
+static inline v16 v_add3_sat(v16 a, v16 b, v16 c)
+{
+    __m128i lo = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16), _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16));
+    __m128i hi = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16), _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16));
+
+    lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(c, _mm_setzero_si128()));
+    hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(c, _mm_setzero_si128()));
+    return _mm_packs_epi32(lo, hi);
+}
+
+static inline v16 v_sub3_sat(v16 a, v16 b, v16 c)
+{
+    __m128i lo = _mm_sub_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16), _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16));
+    __m128i hi = _mm_sub_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16), _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16));
+
+    lo = _mm_sub_epi32(lo, _mm_unpacklo_epi16(c, _mm_setzero_si128()));
+    hi = _mm_sub_epi32(hi, _mm_unpackhi_epi16(c, _mm_setzero_si128()));
+    return _mm_packs_epi32(lo, hi);
+}
+
+/* lane masks <-> 8-bit flag registers, lane i in bit i */
+static inline unsigned v_tobits(v16 m)
+{
+    return (unsigned)_mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128()));
+}
+
+static inline v16 v_frombits(unsigned bits)
+{
+    const __m128i lanes = _mm_setr_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16((int16_t)bits), lanes), lanes);
+}
+
+/* VU element selector: 0/1 whole vector, 2-3 quarters, 4-7 halves,
+ * 8-15 one element broadcast */
+static inline v16 v_elem(v16 a, unsigned e)
+{
+#if defined(RSP_SSSE3)
+    static const int8_t shuffle[16][16] = {
+        {  0, 1,  2, 3,  4, 5,  6, 7,  8, 9, 10,11, 12,13, 14,15 },
+        {  0, 1,  2, 3,  4, 5,  6, 7,  8, 9, 10,11, 12,13, 14,15 },
+        {  0, 1,  0, 1,  4, 5,  4, 5,  8, 9,  8, 9, 12,13, 12,13 },
+        {  2, 3,  2, 3,  6, 7,  6, 7, 10,11, 10,11, 14,15, 14,15 },
+        {  0, 1,  0, 1,  0, 1,  0, 1,  8, 9,  8, 9,  8, 9,  8, 9 },
+        {  2, 3,  2, 3,  2, 3,  2, 3, 10,11, 10,11, 10,11, 10,11 },
+        {  4, 5,  4, 5,  4, 5,  4, 5, 12,13, 12,13, 12,13, 12,13 },
+        {  6, 7,  6, 7,  6, 7,  6, 7, 14,15, 14,15, 14,15, 14,15 },
+        {  0, 1,  0, 1,  0, 1,  0, 1,  0, 1,  0, 1,  0, 1,  0, 1 },
+        {  2, 3,  2, 3,  2, 3,  2, 3,  2, 3,  2, 3,  2, 3,  2, 3 },
+        {  4, 5,  4, 5,  4, 5,  4, 5,  4, 5,  4, 5,  4, 5,  4, 5 },
+        {  6, 7,  6, 7,  6, 7,  6, 7,  6, 7,  6, 7,  6, 7,  6, 7 },
+        {  8, 9,  8, 9,  8, 9,  8, 9,  8, 9,  8, 9,  8, 9,  8, 9 },
+        { 10,11, 10,11, 10,11, 10,11, 10,11, 10,11, 10,11, 10,11 },
+        { 12,13, 12,13, 12,13, 12,13, 12,13, 12,13, 12,13, 12,13 },
+        { 14,15, 14,15, 14,15, 14,15, 14,15, 14,15, 14,15, 14,15 },
+    };
+
+    return _mm_shuffle_epi8(a, _mm_loadu_si128((const __m128i*)shuffle[e & 15]));
+#else
+    __m128i t;
+
+    switch (e & 15) {
+    case 2: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0xa0), 0xa0);
+    case 3: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0xf5), 0xf5);
+    case 4: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0x00), 0x00);
+    case 5: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0x55), 0x55);
+    case 6: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0xaa), 0xaa);
+    case 7: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0xff), 0xff);
+    case 8: t = _mm_shufflelo_epi16(a, 0x00); return _mm_unpacklo_epi64(t, t);
+    case 9: t = _mm_shufflelo_epi16(a, 0x55); return _mm_unpacklo_epi64(t, t);
+    case 10: t = _mm_shufflelo_epi16(a, 0xaa); return _mm_unpacklo_epi64(t, t);
+    case 11: t = _mm_shufflelo_epi16(a, 0xff); return _mm_unpacklo_epi64(t, t);
+    case 12: t = _mm_shufflehi_epi16(a, 0x00); return _mm_unpackhi_epi64(t, t);
+    case 13: t = _mm_shufflehi_epi16(a, 0x55); return _mm_unpackhi_epi64(t, t);
+    case 14: t = _mm_shufflehi_epi16(a, 0xaa); return _mm_unpackhi_epi64(t, t);
+    case 15: t = _mm_shufflehi_epi16(a, 0xff); return _mm_unpackhi_epi64(t, t);
+    default: return a;
+    }
+#endif
+}
+
+/* VABS: b negated, kept or zeroed after the sign of a, wrapping on -32768 */
+static inline v16 v_sign(v16 b, v16 a)
+{
+#if defined(RSP_SSSE3)
+    return _mm_sign_epi16(b, a);
+#else
+    __m128i neg = _mm_srai_epi16(a, 15);
+    __m128i zero = _mm_cmpeq_epi16(a, _mm_setzero_si128());
+
+    return _mm_andnot_si128(zero, _mm_sub_epi16(_mm_xor_si128(b, neg), neg));
+#endif
+}
+
+#else
+
+typedef struct { int16_t e[8]; } v16;
+
+#define V_LANES(expr) \
+    v16 r; \
+    unsigned i; \
+    for (i = 0; i < 8; ++i) \
+        r.e[i] = (int16_t)(expr); \
+    return r
+
+static inline v16 v_ld(const vreg_t* x) { V_LANES(x->e[i]); }
+static inline void v_st(vreg_t* x, v16 a) { unsigned i; for (i = 0; i < 8; ++i) x->e[i] = a.e[i]; }
+static inline v16 v_zero(void) { V_LANES(0); }
+static inline v16 v_set1(int16_t x) { V_LANES(x); }
+static inline v16 v_add(v16 a, v16 b) { V_LANES((uint16_t)a.e[i] + (uint16_t)b.e[i]); }
+static inline v16 v_sub(v16 a, v16 b) { V_LANES((uint16_t)a.e[i] - (uint16_t)b.e[i]); }
+static inline v16 v_and(v16 a, v16 b) { V_LANES(a.e[i] & b.e[i]); }
+static inline v16 v_or(v16 a, v16 b) { V_LANES(a.e[i] | b.e[i]); }
+static inline v16 v_xor(v16 a, v16 b) { V_LANES(a.e[i] ^ b.e[i]); }
+static inline v16 v_andnot(v16 a, v16 b) { V_LANES(~a.e[i] & b.e[i]); }
+static inline v16 v_not(v16 a) { V_LANES(~a.e[i]); }
+static inline v16 v_eq(v16 a, v16 b) { V_LANES(-(a.e[i] == b.e[i])); }
+static inline v16 v_lt(v16 a, v16 b) { V_LANES(-(a.e[i] < b.e[i])); }
+static inline v16 v_gt(v16 a, v16 b) { V_LANES(-(a.e[i] > b.e[i])); }
+static inline v16 v_min(v16 a, v16 b) { V_LANES(a.e[i] < b.e[i] ? a.e[i] : b.e[i]); }
+static inline v16 v_srai(v16 a, int n) { V_LANES(a.e[i] >> n); }
+static inline v16 v_srli(v16 a, int n) { V_LANES((uint16_t)a.e[i] >> n); }
+static inline v16 v_slli(v16 a, int n) { V_LANES((uint16_t)a.e[i] << n); }
+static inline v16 v_mullo(v16 a, v16 b) { V_LANES((int32_t)a.e[i] * b.e[i]); }
+static inline v16 v_mulhi(v16 a, v16 b) { V_LANES(((int32_t)a.e[i] * b.e[i]) >> 16); }
+static inline v16 v_mulhi_u(v16 a, v16 b) { V_LANES(((uint32_t)(uint16_t)a.e[i] * (uint16_t)b.e[i]) >> 16); }
+static inline v16 v_ltu(v16 a, v16 b) { V_LANES(-((uint16_t)a.e[i] < (uint16_t)b.e[i])); }
+static inline v16 v_sel(v16 m, v16 a, v16 b) { V_LANES(m.e[i] ? a.e[i] : b.e[i]); }
+
+static inline v16 v_sat32(v16 hi, v16 lo) { V_LANES(clamp_s16((int32_t)((uint32_t)(uint16_t)hi.e[i] << 16 | (uint16_t)lo.e[i]))); }
+static inline v16 v_add3_sat(v16 a, v16 b, v16 c) { V_LANES(clamp_s16(a.e[i] + b.e[i] + c.e[i])); }
+static inline v16 v_sub3_sat(v16 a, v16 b, v16 c) { V_LANES(clamp_s16(a.e[i] - b.e[i] - c.e[i])); }
+
+static inline unsigned v_tobits(v16 m)
+{
+    unsigned bits = 0;
+    unsigned i;
+
+    for (i = 0; i < 8; ++i)
+        bits |= (m.e[i] ? 1u : 0u) << i;
+
+    return bits;
+}
+
+static inline v16 v_frombits(unsigned bits) { V_LANES(-(int)((bits >> i) & 1)); }
+
+static inline v16 v_elem(v16 a, unsigned e)
+{
+    e &= 15;
+
+    if (e < 2) { V_LANES(a.e[i]); }
+    if (e < 4) { V_LANES(a.e[(i & ~1u) | (e & 1)]); }
+    if (e < 8) { V_LANES(a.e[(i & ~3u) | (e & 3)]); }
+    { V_LANES(a.e[e & 7]); }
+}
+
+static inline v16 v_sign(v16 b, v16 a) { V_LANES(a.e[i] < 0 ? -(uint16_t)b.e[i] : a.e[i] == 0 ? 0 : b.e[i]); }
+
+#undef V_LANES
+
+#endif
+
+#endif
@@ -115,6 +115,13 @@ ptr_DebugBreakpointCommand DebugBreakpointCommand = NULL;
 ptr_DebugBreakpointTriggeredBy DebugBreakpointTriggeredBy = NULL;
 ptr_DebugVirtualToPhysical     DebugVirtualToPhysical = NULL;
 
+ptr_DebugProfileStart           DebugProfileStart = NULL;
+ptr_DebugProfileStop            DebugProfileStop = NULL;
+ptr_DebugProfileReset           DebugProfileReset = NULL;
+ptr_DebugProfileGetHotFunctions DebugProfileGetHotFunctions = NULL;
+ptr_DebugProfileGetOpcodeCounts DebugProfileGetOpcodeCounts = NULL;
+ptr_DebugProfileGetOpcodeName   DebugProfileGetOpcodeName = NULL;
+
 /* global variables */
 m64p_dynlib_handle CoreHandle = NULL;
 
@@ -307,6 +314,13 @@ m64p_error AttachCoreLib(const char *CoreLibFilepath)
     DebugBreakpointTriggeredBy = (ptr_DebugBreakpointTriggeredBy) osal_dynlib_getproc(CoreHandle, "DebugBreakpointTriggeredBy");
     DebugVirtualToPhysical = (ptr_DebugVirtualToPhysical) osal_dynlib_getproc(CoreHandle, "DebugVirtualToPhysical");
 
+    DebugProfileStart = (ptr_DebugProfileStart) osal_dynlib_getproc(CoreHandle, "DebugProfileStart");
+    DebugProfileStop = (ptr_DebugProfileStop) osal_dynlib_getproc(CoreHandle, "DebugProfileStop");
+    DebugProfileReset = (ptr_DebugProfileReset) osal_dynlib_getproc(CoreHandle, "DebugProfileReset");
+    DebugProfileGetHotFunctions = (ptr_DebugProfileGetHotFunctions) osal_dynlib_getproc(CoreHandle, "DebugProfileGetHotFunctions");
+    DebugProfileGetOpcodeCounts = (ptr_DebugProfileGetOpcodeCounts) osal_dynlib_getproc(CoreHandle, "DebugProfileGetOpcodeCounts");
+    DebugProfileGetOpcodeName = (ptr_DebugProfileGetOpcodeName) osal_dynlib_getproc(CoreHandle, "DebugProfileGetOpcodeName");
+
     return M64ERR_SUCCESS;
 }
 
@@ -378,6 +392,13 @@ m64p_error DetachCoreLib(void)
     DebugBreakpointTriggeredBy = NULL;
     DebugVirtualToPhysical = NULL;
 
+    DebugProfileStart = NULL;
+    DebugProfileStop = NULL;
+    DebugProfileReset = NULL;
+    DebugProfileGetHotFunctions = NULL;
+    DebugProfileGetOpcodeCounts = NULL;
+    DebugProfileGetOpcodeName = NULL;
+
     /* detach the shared library */
     osal_dynlib_close(CoreHandle);
     CoreHandle = NULL;
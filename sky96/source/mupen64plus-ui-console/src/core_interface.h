@@ -108,5 +108,12 @@ extern ptr_DebugBreakpointCommand DebugBreakpointCommand;
 extern ptr_DebugBreakpointTriggeredBy DebugBreakpointTriggeredBy;
 extern ptr_DebugVirtualToPhysical     DebugVirtualToPhysical;
 
+extern ptr_DebugProfileStart           DebugProfileStart;
+extern ptr_DebugProfileStop            DebugProfileStop;
+extern ptr_DebugProfileReset           DebugProfileReset;
+extern ptr_DebugProfileGetHotFunctions DebugProfileGetHotFunctions;
+extern ptr_DebugProfileGetOpcodeCounts DebugProfileGetOpcodeCounts;
+extern ptr_DebugProfileGetOpcodeName   DebugProfileGetOpcodeName;
+
 #endif /* #define CORE_INTERFACE_H */
 
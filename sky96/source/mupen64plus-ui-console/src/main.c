@@ -26,6 +26,7 @@
  */
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,6 +48,12 @@
 #include "plugin.h"
 #include "version.h"
 
+#if defined(WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
 #ifdef VIDEXT_HEADER
 #define xstr(s) str(s)
 #define str(s) #s
@@ -86,6 +93,19 @@ static int   l_TestShotIdx = 0;          // index of next screenshot frame in li
 static int   l_SaveOptions = 1;          // save command-line options in configuration file (enabled by default)
 static int   l_CoreCompareMode = 0;      // 0 = disable, 1 = send, 2 = receive
 static int   l_LaunchDebugger = 0;
+static int   l_BenchmarkVIs = 0;         // run headless for this many VIs and print a JSON report, 0 = disabled
+
+/* totals of the per-VI timing records collected in --benchmark mode */
+static struct
+{
+    unsigned int next;          // sequence number of the next record to fetch
+    unsigned int vis;
+    uint64_t     total_ns;
+    uint64_t     compiler_ns;
+    uint64_t     rsp_gfx_ns;
+    uint64_t     rsp_audio_ns;
+    uint64_t     instructions;
+} l_Benchmark;
 
 static eCheatMode l_CheatMode = CHEAT_DISABLE;
 static char      *l_CheatNumList = NULL;
@@ -98,6 +118,15 @@ static void analysis_load(core_do_command_func cmd)
         fprintf(stderr, "Failed to load analysis tool: %s\n", dlerror());
         return;
     }
+    void (*profiler_fn)(const analysis_profiler_funcs*) = dlsym(g_analysis_lib, "analysis_window_set_profiler");
+    if (profiler_fn)
+    {
+        analysis_profiler_funcs profiler = {
+            DebugProfileStart, DebugProfileStop, DebugProfileReset,
+            DebugProfileGetHotFunctions, DebugProfileGetOpcodeCounts, DebugProfileGetOpcodeName
+        };
+        profiler_fn(&profiler);
+    }
     void (*start_fn)(core_do_command_func) = dlsym(g_analysis_lib, "analysis_window_start");
     if (start_fn)
         start_fn(cmd);
@@ -167,8 +196,111 @@ void DebugCallback(void *Context, int level, const char *message)
 #endif
 }
 
+/*********************************************************************************************************
+ *  Benchmark mode
+ */
+
+static void BenchmarkCollect(void)
+{
+    m64p_frame_timing timings[256];
+    m64p_frame_timing_query query;
+    unsigned int i;
+
+    do
+    {
+        query.timings = timings;
+        query.capacity = sizeof(timings) / sizeof(timings[0]);
+        query.first = l_Benchmark.next;
+        if ((*CoreDoCommand)(M64CMD_GET_FRAME_TIMINGS, sizeof(query), &query) != M64ERR_SUCCESS)
+            return;
+
+        for (i = 0; i < query.count && l_Benchmark.vis < (unsigned int) l_BenchmarkVIs; i++)
+        {
+            l_Benchmark.vis++;
+            l_Benchmark.total_ns += timings[i].total_ns;
+            l_Benchmark.compiler_ns += timings[i].compiler_ns;
+            l_Benchmark.rsp_gfx_ns += timings[i].rsp_gfx_ns;
+            l_Benchmark.rsp_audio_ns += timings[i].rsp_audio_ns;
+            l_Benchmark.instructions += timings[i].instructions;
+        }
+        l_Benchmark.next = query.first + query.count;
+    } while (query.count == query.capacity && l_Benchmark.vis < (unsigned int) l_BenchmarkVIs);
+}
+
+/* peak resident set size of the process, in kilobytes */
+static uint64_t BenchmarkPeakRSS(void)
+{
+#if defined(WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return (uint64_t) pmc.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return (uint64_t) usage.ru_maxrss / 1024; /* bytes on macOS */
+#else
+    return (uint64_t) usage.ru_maxrss;
+#endif
+#endif
+}
+
+static void BenchmarkPrintString(const char *str)
+{
+    putchar('"');
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            printf("\\%c", *str);
+        else if ((unsigned char) *str < 0x20)
+            printf("\\u%04x", (unsigned char) *str);
+        else
+            putchar(*str);
+    }
+    putchar('"');
+}
+
+static void BenchmarkReport(void)
+{
+    static const char *EmuModeNames[] = { "pure_interpreter", "cached_interpreter", "dynarec", "threaded_interpreter" };
+    double seconds = l_Benchmark.total_ns / 1e9;
+    int emumode = 0;
+
+    (*ConfigGetParameter)(l_ConfigCore, "R4300Emulator", M64TYPE_INT, &emumode, sizeof(int));
+    if (emumode < 0)
+        emumode = 0;
+    else if (emumode > 3)
+        emumode = 2;
+
+    if (l_Benchmark.vis < (unsigned int) l_BenchmarkVIs)
+        DebugMessage(M64MSG_WARNING, "emulation stopped after %u of %i VIs, benchmark report is partial", l_Benchmark.vis, l_BenchmarkVIs);
+
+    printf("{\n  \"rom\": ");
+    BenchmarkPrintString(l_ROMFilepath);
+    printf(",\n  \"emumode\": %i,\n  \"emumode_name\": \"%s\",\n", emumode, EmuModeNames[emumode]);
+    printf("  \"vis\": %u,\n  \"seconds\": %.6f,\n", l_Benchmark.vis, seconds);
+    printf("  \"vis_per_s\": %.3f,\n", seconds > 0.0 ? l_Benchmark.vis / seconds : 0.0);
+    printf("  \"instructions\": %llu,\n", (unsigned long long) l_Benchmark.instructions);
+    printf("  \"instructions_per_s\": %.0f,\n", seconds > 0.0 ? l_Benchmark.instructions / seconds : 0.0);
+    printf("  \"compiler_ms\": %.3f,\n", l_Benchmark.compiler_ns / 1e6);
+    printf("  \"rsp_gfx_ms\": %.3f,\n", l_Benchmark.rsp_gfx_ns / 1e6);
+    printf("  \"rsp_audio_ms\": %.3f,\n", l_Benchmark.rsp_audio_ns / 1e6);
+    printf("  \"peak_rss_kb\": %llu\n}\n", (unsigned long long) BenchmarkPeakRSS());
+    fflush(stdout);
+}
+
 static void FrameCallback(unsigned int FrameIndex)
 {
+    // stop once enough VIs have been timed; checked per frame since the core has no VI callback
+    if (l_BenchmarkVIs > 0 && l_Benchmark.vis < (unsigned int) l_BenchmarkVIs)
+    {
+        BenchmarkCollect();
+        if (l_Benchmark.vis >= (unsigned int) l_BenchmarkVIs)
+            (*CoreDoCommand)(M64CMD_STOP, 0, NULL);
+    }
+
     // take a screenshot if we need to
     if (l_TestShotList != NULL)
     {
@@ -407,8 +539,11 @@ static void printUsage(const char *progname)
            "    --input (plugin-spec)  : use input plugin given by (plugin-spec)\n"
            "    --rsp (plugin-spec)    : use rsp plugin given by (plugin-spec)\n"
            "    --emumode (mode)       : set emu mode to: 0=Pure Interpreter 1=Interpreter 2=DynaRec\n"
+           "                             3=Threaded Interpreter\n"
            "    --savestate (filepath) : savestate loaded at startup\n"
            "    --testshots (list)     : take screenshots at frames given in comma-separated (list), then quit\n"
+           "    --benchmark (N)        : run (N) VIs without speed limit on dummy video, audio and input plugins,\n"
+           "                             then print a JSON performance report and quit; implies --nosaveoptions\n"
            "    --set (param-spec)     : set a configuration variable, format: ParamSection[ParamName]=Value\n"
            "    --gb-rom-{1,2,3,4}     : define GB cart rom to load inside transferpak {1,2,3,4}\n"
            "    --gb-ram-{1,2,3,4}     : define GB cart ram to load inside transferpak {1,2,3,4}\n"
@@ -585,6 +720,14 @@ static int ParseCommandLineInitial(int argc, const char **argv)
         {
             l_SaveOptions = 0;
         }
+        else if (strcmp(argv[i], "--benchmark") == 0 && ArgsLeft >= 1)
+        {
+            /* don't let the dummy plugins and disabled speed limiter end up in the configuration file */
+            l_BenchmarkVIs = atoi(argv[i+1]);
+            if (l_BenchmarkVIs > 0)
+                l_SaveOptions = 0;
+            i++;
+        }
     }
 
     return 0;
@@ -639,6 +782,12 @@ static m64p_error ParseCommandLineMain(int argc, const char **argv)
         {   /* already handled in ParseCommandLineInitial (no value to skip) */
             ;
         }
+        else if (strcmp(argv[i], "--benchmark") == 0 && ArgsLeft >= 1)
+        {   /* already handled in ParseCommandLineInitial (skip the value) */
+            if (l_BenchmarkVIs <= 0)
+                DebugMessage(M64MSG_WARNING, "invalid --benchmark value '%s'", argv[i+1]);
+            i++;
+        }
         else if (strcmp(argv[i], "--resolution") == 0 && ArgsLeft >= 1)
         {
             const char *res = argv[i+1];
@@ -699,7 +848,7 @@ static m64p_error ParseCommandLineMain(int argc, const char **argv)
         {
             int emumode = atoi(argv[i+1]);
             i++;
-            if (emumode < 0 || emumode > 2)
+            if (emumode < 0 || emumode > 3)
             {
                 DebugMessage(M64MSG_WARNING, "invalid --emumode value '%i'", emumode);
                 continue;
@@ -1014,55 +1163,80 @@ int main(int argc, char *argv[])
         return 6;
     }
 
+    /* benchmark mode runs headless and as fast as possible */
+    if (l_BenchmarkVIs > 0)
+    {
+        int EnableSpeedLimit = 0;
+        g_GfxPlugin = "dummy";
+        g_AudioPlugin = "dummy";
+        g_InputPlugin = "dummy";
+        if ((*CoreDoCommand)(M64CMD_CORE_STATE_SET, M64CORE_SPEED_LIMITER, &EnableSpeedLimit) != M64ERR_SUCCESS)
+            DebugMessage(M64MSG_WARNING, "core gave error while disabling the speed limiter, benchmark will run at real-time speed");
+    }
+
     /* save the given command-line options in configuration file if requested */
     if (l_SaveOptions)
         SaveConfigurationOptions();
 
-    /* load ROM image */
-    FILE *fPtr = fopen(l_ROMFilepath, "rb");
-    if (fPtr == NULL)
+    if (g_CoreAPIVersion >= ROM_OPEN_FILE_API_VERSION)
     {
-        DebugMessage(M64MSG_ERROR, "couldn't open ROM file '%s' for reading.", l_ROMFilepath);
-        (*CoreShutdown)();
-        DetachCoreLib();
-        return 7;
-    }
-
-    /* get the length of the ROM, allocate memory buffer, load it from disk */
-    long romlength = 0;
-    fseek(fPtr, 0L, SEEK_END);
-    romlength = ftell(fPtr);
-    fseek(fPtr, 0L, SEEK_SET);
-    unsigned char *ROM_buffer = (unsigned char *) malloc(romlength);
-    if (ROM_buffer == NULL)
-    {
-        DebugMessage(M64MSG_ERROR, "couldn't allocate %li-byte buffer for ROM image file '%s'.", romlength, l_ROMFilepath);
-        fclose(fPtr);
-        (*CoreShutdown)();
-        DetachCoreLib();
-        return 8;
+        /* let the core load the ROM image straight from the file */
+        if ((*CoreDoCommand)(M64CMD_ROM_OPEN_FILE, 0, (void *) l_ROMFilepath) != M64ERR_SUCCESS)
+        {
+            DebugMessage(M64MSG_ERROR, "core failed to open ROM image file '%s'.", l_ROMFilepath);
+            (*CoreShutdown)();
+            DetachCoreLib();
+            return 10;
+        }
     }
-    else if (fread(ROM_buffer, 1, romlength, fPtr) != romlength)
+    else
     {
-        DebugMessage(M64MSG_ERROR, "couldn't read %li bytes from ROM image file '%s'.", romlength, l_ROMFilepath);
-        free(ROM_buffer);
+        /* load ROM image */
+        FILE *fPtr = fopen(l_ROMFilepath, "rb");
+        if (fPtr == NULL)
+        {
+            DebugMessage(M64MSG_ERROR, "couldn't open ROM file '%s' for reading.", l_ROMFilepath);
+            (*CoreShutdown)();
+            DetachCoreLib();
+            return 7;
+        }
+
+        /* get the length of the ROM, allocate memory buffer, load it from disk */
+        long romlength = 0;
+        fseek(fPtr, 0L, SEEK_END);
+        romlength = ftell(fPtr);
+        fseek(fPtr, 0L, SEEK_SET);
+        unsigned char *ROM_buffer = (unsigned char *) malloc(romlength);
+        if (ROM_buffer == NULL)
+        {
+            DebugMessage(M64MSG_ERROR, "couldn't allocate %li-byte buffer for ROM image file '%s'.", romlength, l_ROMFilepath);
+            fclose(fPtr);
+            (*CoreShutdown)();
+            DetachCoreLib();
+            return 8;
+        }
+        else if (fread(ROM_buffer, 1, romlength, fPtr) != romlength)
+        {
+            DebugMessage(M64MSG_ERROR, "couldn't read %li bytes from ROM image file '%s'.", romlength, l_ROMFilepath);
+            free(ROM_buffer);
+            fclose(fPtr);
+            (*CoreShutdown)();
+            DetachCoreLib();
+            return 9;
+        }
         fclose(fPtr);
-        (*CoreShutdown)();
-        DetachCoreLib();
-        return 9;
-    }
-    fclose(fPtr);
 
-    /* Try to load the ROM image into the core */
-    if ((*CoreDoCommand)(M64CMD_ROM_OPEN, (int) romlength, ROM_buffer) != M64ERR_SUCCESS)
-    {
-        DebugMessage(M64MSG_ERROR, "core failed to open ROM image file '%s'.", l_ROMFilepath);
-        free(ROM_buffer);
-        (*CoreShutdown)();
-        DetachCoreLib();
-        return 10;
+        /* Try to load the ROM image into the core */
+        if ((*CoreDoCommand)(M64CMD_ROM_OPEN, (int) romlength, ROM_buffer) != M64ERR_SUCCESS)
+        {
+            DebugMessage(M64MSG_ERROR, "core failed to open ROM image file '%s'.", l_ROMFilepath);
+            free(ROM_buffer);
+            (*CoreShutdown)();
+            DetachCoreLib();
+            return 10;
+        }
+        free(ROM_buffer); /* the core copies the ROM image, so we can release this buffer immediately */
     }
-    free(ROM_buffer); /* the core copies the ROM image, so we can release this buffer immediately */
 
     /* handle the cheat codes */
     CheatStart(l_CheatMode, l_CheatNumList);
@@ -1108,12 +1282,12 @@ int main(int argc, char *argv[])
         }
     }
 
-    /* set up Frame Callback if --testshots is enabled */
-    if (l_TestShotList != NULL)
+    /* set up Frame Callback if --testshots or --benchmark is enabled */
+    if (l_TestShotList != NULL || l_BenchmarkVIs > 0)
     {
         if ((*CoreDoCommand)(M64CMD_SET_FRAME_CALLBACK, 0, FrameCallback) != M64ERR_SUCCESS)
         {
-            DebugMessage(M64MSG_WARNING, "couldn't set frame callback, --testshots will not work.");
+            DebugMessage(M64MSG_WARNING, "couldn't set frame callback, --testshots and --benchmark will not work.");
         }
     }
 
@@ -1166,13 +1340,17 @@ int main(int argc, char *argv[])
     if (l_SaveOptions && (*ConfigHasUnsavedChanges)(NULL))
         (*ConfigSaveFile)();
 
-    analysis_load(CoreDoCommand);
+    if (l_BenchmarkVIs <= 0)
+        analysis_load(CoreDoCommand);
 
     /* run the game */
     (*CoreDoCommand)(M64CMD_EXECUTE, 0, NULL);
 
     analysis_unload();
 
+    if (l_BenchmarkVIs > 0)
+        BenchmarkCollect();
+
     /* detach plugins from core and unload them */
     for (i = 0; i < 4; i++)
         (*CoreDetachPlugin)(g_PluginMap[i].type);
@@ -1185,6 +1363,10 @@ int main(int argc, char *argv[])
     if (l_SaveOptions && (*ConfigHasUnsavedChanges)(NULL))
         (*ConfigSaveFile)();
 
+    /* print the report once the plugins are gone, while the core configuration is still open */
+    if (l_BenchmarkVIs > 0)
+        BenchmarkReport();
+
     /* Shut down and release the Core library */
     (*CoreShutdown)();
     DetachCoreLib();
@@ -32,6 +32,7 @@
 #define CONFIG_API_VERSION 0x020301
 
 #define MINIMUM_CORE_VERSION   0x016300
+#define ROM_OPEN_FILE_API_VERSION 0x020107  /* first core front-end API with M64CMD_ROM_OPEN_FILE */
 
 #define VERSION_PRINTF_SPLIT(x) (((x) >> 16) & 0xffff), (((x) >> 8) & 0xff), ((x) & 0xff)
 
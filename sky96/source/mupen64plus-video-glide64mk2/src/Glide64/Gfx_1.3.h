@@ -617,6 +617,17 @@ typedef struct
 *******************************************************************/
 EXPORT void CALL FBWList(FrameBufferModifyEntry *plist, wxUint32 size);
 
+/******************************************************************
+  Function: FrameBufferWriteList
+  Purpose:  This function is called to notify the dll that the
+            frame buffer has been modified by CPU or DMA over whole
+            ranges.
+  input:    ranges      rdram address and size in bytes of each write
+			count		number of ranges
+  output:   none
+*******************************************************************/
+EXPORT void CALL FBWriteList(const FrameBufferWriteRange *ranges, unsigned int count);
+
 /******************************************************************
   Function: FrameBufferRead
   Purpose:  This function is called to notify the dll that the
@@ -3305,6 +3305,55 @@ EXPORT void CALL FBWrite(wxUint32 addr, wxUint32 size)
   d_lr_y = max(d_lr_y, shift_r/rdp.ci_width);
 }
 
+/******************************************************************
+Function: FrameBufferWriteList
+Purpose:  This function is called to notify the dll that the
+frame buffer has been modified by CPU or DMA over whole ranges.
+input:    ranges        rdram address and size in bytes of each write
+count                   number of ranges
+output:   none
+*******************************************************************/
+EXPORT void CALL FBWriteList(const FrameBufferWriteRange *ranges, unsigned int count)
+{
+  LOG ("FBWriteList ()\n");
+  if (cpu_fb_ignore)
+    return;
+  if (cpu_fb_read_called)
+  {
+    cpu_fb_ignore = TRUE;
+    cpu_fb_write = FALSE;
+    return;
+  }
+  cpu_fb_write_called = TRUE;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    wxUint32 first = segoffset(ranges[i].addr);
+    wxUint32 last = first + ranges[i].size - 1;
+    FRDP("FBWriteList. addr: %08x, size: %d\n", first, ranges[i].size);
+    if (last < rdp.cimg || first > rdp.ci_end)
+      continue;
+    first = max(first, rdp.cimg);
+    last = min(last, rdp.ci_end);
+    cpu_fb_write = TRUE;
+    wxUint32 shift_l = (first-rdp.cimg) >> 1;
+    wxUint32 shift_r = ((last-rdp.cimg) >> 1) + 2;
+
+    d_ul_y = min(d_ul_y, shift_l/rdp.ci_width);
+    d_lr_y = max(d_lr_y, shift_r/rdp.ci_width);
+    if (shift_l/rdp.ci_width != shift_r/rdp.ci_width)
+    {
+      // spans several lines, so every column is touched
+      d_ul_x = 0;
+      d_lr_x = max(d_lr_x, rdp.ci_width - 1);
+    }
+    else
+    {
+      d_ul_x = min(d_ul_x, shift_l%rdp.ci_width);
+      d_lr_x = max(d_lr_x, shift_r%rdp.ci_width);
+    }
+  }
+}
+
 
 /************************************************************************
 Function: FBGetFrameBufferInfo